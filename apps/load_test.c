@@ -51,6 +51,8 @@ static int num_input_chans = 0;
 static int num_output_chans = 0;
 static int num_frames = DEFAULT_NUM_FRAMES;
 static int log_file_enabled = 0;
+static int session_capture_enabled = 0;
+static float deadline_runtime_fraction = 0.0f;
 static int input_channel = DEFAULT_INPUT_CHANNEL;
 static int output_channel = DEFAULT_OUTPUT_CHANNEL;
 static int num_biquad = DEFAULT_BIQUAD_NUM;
@@ -128,6 +130,10 @@ void print_usage(char *argv[])
            "                            power of 2.\n",
                                         DEFAULT_NUM_FRAMES);
     printf("    -l                    : Enable logging to %s\n", RASPA_DEFAULT_RUN_LOG_FILE);
+    printf("    -k                    : Enable session capture to %s\n", RASPA_DEFAULT_SESSION_CAPTURE_FILE);
+    printf("    -r <runtime_fraction> : Run under SCHED_DEADLINE with this share\n"
+           "                            of the buffer period reserved, raspa\n"
+           "                            built with RASPA_WITH_PREEMPT_RT only.\n");
     printf("    -i <input_channel>    : Specify the input channel index.\n"
            "                            0 is the 1st channel.\n"
            "                            Default is %d.\n",
@@ -341,7 +347,7 @@ int main(int argc, char *argv[])
     d_mem.biquad = NULL;
     d_mem.delay  = NULL;
 
-    while ((option = getopt(argc, argv,"hc:b:li:o:f:d:s:x:t:y:")) != -1)
+    while ((option = getopt(argc, argv,"hc:b:lkr:i:o:f:d:s:x:t:y:")) != -1)
     {
         switch (option)
         {
@@ -362,6 +368,14 @@ int main(int argc, char *argv[])
             log_file_enabled = 1;
             break;
 
+        case 'k' :
+            session_capture_enabled = 1;
+            break;
+
+        case 'r' :
+            deadline_runtime_fraction = atof(optarg);
+            break;
+
         case 'i' :
             input_channel = atoi(optarg);
             break;
@@ -424,7 +438,20 @@ int main(int argc, char *argv[])
         raspa_set_cpu_affinity(cpu);
     }
 
-    res = raspa_open(num_frames, process, 0, log_file_enabled ? RASPA_DEBUG_ENABLE_RUN_LOG_TO_FILE : 0);
+    if (deadline_runtime_fraction > 0.0f)
+    {
+        res = raspa_set_deadline_reservation(deadline_runtime_fraction);
+        if (res < 0)
+        {
+            fprintf(stderr, "Error setting the deadline reservation: %s\n", raspa_get_error_msg(-res));
+            free_mem();
+            exit(res);
+        }
+    }
+
+    res = raspa_open(num_frames, process, 0,
+                     (log_file_enabled ? RASPA_DEBUG_ENABLE_RUN_LOG_TO_FILE : 0) |
+                     (session_capture_enabled ? RASPA_DEBUG_ENABLE_SESSION_CAPTURE : 0));
     if (res < 0)
     {
         fprintf(stderr, "Error opening device: %s\n", raspa_get_error_msg(-res));
@@ -460,7 +487,14 @@ int main(int argc, char *argv[])
     }
 
     printf("Load test audio process started.\n");
-    raspa_start_realtime();
+    res = raspa_start_realtime();
+    if (res < 0)
+    {
+        fprintf(stderr, "Error starting the audio process: %s\n", raspa_get_error_msg(-res));
+        // raspa has already cleaned up after the failed start
+        free_mem();
+        exit(res);
+    }
 
     // Non-RT processing loop
     while (stop_flag == 0)
@@ -32,6 +32,7 @@
 
 static int num_frames = DEFAULT_NUM_FRAMES;
 static int log_file_enabled = 0;
+static int session_capture_enabled = 0;
 static int stop_flag = 0;
 static int num_input_chans = 0;
 static int num_output_chans = 0;
@@ -58,6 +59,7 @@ void print_usage(char *argv[])
            "                              Default is %d. Ideally should be a \n"
            "                              power of 2\n", DEFAULT_NUM_FRAMES);
     printf("    -l               : Enable logging to %s\n", RASPA_DEFAULT_RUN_LOG_FILE);
+    printf("    -k               : Enable session capture to %s\n", RASPA_DEFAULT_SESSION_CAPTURE_FILE);
     printf("    -m <mode>        : Specify the loopback mode: \n"
            "                              0 - Normal 1:1 loopback (Default).\n"
            "                              1 - Stereo mix loopback\n");
@@ -122,7 +124,7 @@ int main(int argc, char *argv[])
     RaspaProcessCallback raspa_callback = NULL;
 
     // Argument parsing
-    while ((option = getopt(argc, argv,":hb:lm:")) != -1)
+    while ((option = getopt(argc, argv,":hb:lkm:")) != -1)
     {
         switch (option)
         {
@@ -139,6 +141,10 @@ int main(int argc, char *argv[])
             log_file_enabled = 1;
             break;
 
+        case 'k' :
+            session_capture_enabled = 1;
+            break;
+
         case 'm' :
             mode = atoi(optarg);
             break;
@@ -174,7 +180,9 @@ int main(int argc, char *argv[])
 
     signal(SIGINT, sigint_handler);
 
-    res = raspa_open(num_frames, raspa_callback, 0, log_file_enabled ? RASPA_DEBUG_ENABLE_RUN_LOG_TO_FILE : 0);
+    res = raspa_open(num_frames, raspa_callback, 0,
+                     (log_file_enabled ? RASPA_DEBUG_ENABLE_RUN_LOG_TO_FILE : 0) |
+                     (session_capture_enabled ? RASPA_DEBUG_ENABLE_SESSION_CAPTURE : 0));
     if (res < 0)
     {
         fprintf(stderr, "Error opening device: %s\n", raspa_get_error_msg(-res));
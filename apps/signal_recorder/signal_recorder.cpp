@@ -18,6 +18,7 @@ enum class OPTION_STATE
     RECV_NUM_BUFFERS,
     RECV_AMPLITUDE,
     RECV_BUFFER_SIZE,
+    RECV_PATH,
 };
 
 bool stop_program_flag = false;
@@ -48,6 +49,10 @@ void print_usage()
     std::cout << "    -a  : amplitude of the tone generated. between 0 - 1\n ";
     std::cout << "    -n  : num audio buffers to record\n ";
     std::cout << "    -b  : The Rt audio buffer size\n ";
+    std::cout << "    -p  : Directory of the recordings. Default is " << DEFAULT_REC_PATH << "\n ";
+    std::cout << "    -s  : Streaming mode, all channels are written to a single multichannel\n"
+                 "          recording.wav while recording, so long takes do not need RAM.\n"
+                 "          With -n 0 it records until stopped with Ctrl-C\n ";
 }
 
 int main(int argc, char *argv[])
@@ -65,6 +70,7 @@ int main(int argc, char *argv[])
     int num_buffers_to_record = DEFAULT_NUM_BUFFERS_TO_RECORD;
     int num_frames = DEFAULT_NUM_FRAMES;
     std::string recording_path = DEFAULT_REC_PATH;
+    bool streaming = false;
 
     int num_input_chans = 0;
     int num_output_chans = 0;
@@ -111,6 +117,15 @@ int main(int argc, char *argv[])
             {
                 option_state = OPTION_STATE::RECV_BUFFER_SIZE;
             }
+            else if(std::strcmp(argv[i], "-p") == 0)
+            {
+                option_state = OPTION_STATE::RECV_PATH;
+            }
+            else if(std::strcmp(argv[i], "-s") == 0)
+            {
+                option_state = OPTION_STATE::NONE;
+                streaming = true;
+            }
             else if(option_state == OPTION_STATE::NONE)
             {
                 std::cout << "Error : Unknown option " << argv[i] << "\n\n";
@@ -142,6 +157,10 @@ int main(int argc, char *argv[])
             {
                 num_frames = atoi(argv[i]);
             }
+            else if(option_state == OPTION_STATE::RECV_PATH)
+            {
+                recording_path = argv[i];
+            }
         }
     }
 
@@ -150,6 +169,13 @@ int main(int argc, char *argv[])
     std::cout << "-> Output amplitude " << amplitude << std::endl;
     std::cout << "-> Num buffers to record " << num_buffers_to_record << std::endl;
     std::cout << "-> Path to files : " << recording_path << std::endl;
+    std::cout << "-> Streaming mode " << (streaming ? "on" : "off") << std::endl;
+
+    if (num_buffers_to_record <= 0 && !streaming)
+    {
+        std::cout << "-> Error : Recording until stopped needs streaming mode (-s)\n\n";
+        exit(0);
+    }
 
 
     SignalRecorder signal_recorder;
@@ -238,7 +264,19 @@ int main(int argc, char *argv[])
                         raspa_get_num_output_channels(),
                         raspa_get_sampling_rate(),
                         num_frames,
-                        recording_path);
+                        recording_path,
+                        streaming);
+
+    if (streaming)
+    {
+        res = signal_recorder.open_streaming_file();
+        if (res < 0)
+        {
+            std::cout << "-> Error opening recording file: " << raspa_get_error_msg(-res) << std::endl;
+            raspa_close();
+            exit(res);
+        }
+    }
 
     std::cout << "\nStarting ...\n";
     raspa_start_realtime();
@@ -248,9 +286,21 @@ int main(int argc, char *argv[])
         std::this_thread::sleep_for(std::chrono::milliseconds(50));
     }
 
+    if (streaming)
+    {
+        auto num_overruns = signal_recorder.close_streaming_file();
+        if (num_overruns > 0)
+        {
+            std::cout << "-> Warning : " << num_overruns << " buffers dropped, the disk did not keep up\n";
+        }
+    }
+
     raspa_close();
 
-    signal_recorder.write_recording_to_files();
+    if (!streaming)
+    {
+        signal_recorder.write_recording_to_files();
+    }
 
     std::cout << "-> Done! Exiting..\n";
 }
\ No newline at end of file
@@ -10,7 +10,10 @@
 #include <thread>
 #include <cmath>
 
+#include "raspa/raspa.h"
+
 constexpr int NUM_INTERRUPTS_TO_IGNORE = 1000;
+constexpr char STREAMING_FILE_NAME[] = "recording.wav";
 typedef std::vector<std::vector<float>> RecordingBuffer;
 
 class SignalRecorder
@@ -20,6 +23,7 @@ public:
                        _input_buffer_counter(0),
                        _interrupt_counter(0),
                        _done_recording(false),
+                       _streaming(false),
                        _num_frames(0),
                        _num_input_chans(0),
                        _num_output_chans(0),
@@ -35,7 +39,8 @@ public:
               int num_output_chans,
               int sampling_freq,
               int num_frames,
-              std::string recording_path)
+              std::string recording_path,
+              bool streaming = false)
     {
         _input_chan_list = input_chan_list;
         _output_chan_list = output_chan_list;
@@ -47,6 +52,7 @@ public:
         _sampling_freq = sampling_freq;
         _num_frames = num_frames;
         _recording_path = recording_path;
+        _streaming = streaming;
 
         // std::cout << output_freq << std::endl;
         // std::cout << amplitude << std::endl;
@@ -56,6 +62,12 @@ public:
         // std::cout << sampling_freq << std::endl;
         // std::cout << num_frames << std::endl;
 
+        // in streaming mode the samples go straight to the raspa disk recorder
+        if (_streaming)
+        {
+            return;
+        }
+
         // alloc recording buffer
         _recording_files.resize(_num_input_chans);
         _recording_buffer.resize(_num_input_chans);
@@ -71,6 +83,28 @@ public:
         return _done_recording;
     }
 
+    /**
+     * @brief Open the multichannel file of the streaming mode, to be called
+     *        before starting the rt thread.
+     * @return 0 upon success, negative raspa error code otherwise
+     */
+    int open_streaming_file()
+    {
+        std::string file_name = _recording_path + "/" + STREAMING_FILE_NAME;
+        return raspa_recorder_open(file_name.c_str(), _input_chan_list.data(), _input_chan_list.size());
+    }
+
+    /**
+     * @brief Stop the streaming mode writer, the file holds all the buffers
+     *        pushed until now.
+     * @return The number of buffers dropped because the disk did not keep up
+     */
+    int64_t close_streaming_file()
+    {
+        raspa_recorder_close();
+        return raspa_recorder_get_num_overruns();
+    }
+
     void write_recording_to_files()
     {
         std::memset(&_soundfile_info, 0, sizeof(_soundfile_info));
@@ -142,8 +176,20 @@ private:
             return;
         }
 
-        if (_input_buffer_counter >= _num_buffers_to_record)
+        // 0 buffers to record means until stopped, only in streaming mode
+        if (_input_buffer_counter >= _num_buffers_to_record && !(_streaming && _num_buffers_to_record == 0))
+        {
+            return;
+        }
+
+        if (_streaming)
         {
+            raspa_recorder_push(input);
+            _input_buffer_counter++;
+            if (_input_buffer_counter == _num_buffers_to_record)
+            {
+                _done_recording = true;
+            }
             return;
         }
 
@@ -174,6 +220,7 @@ private:
     int _input_buffer_counter;
     int _interrupt_counter;
     bool _done_recording;
+    bool _streaming;
 
     int _num_frames;
     int _num_input_chans;
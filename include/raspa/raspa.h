@@ -20,6 +20,7 @@
 #ifndef RASPA_H_
 #define RASPA_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -33,6 +34,15 @@ extern "C" {
 // default log file path
 #define RASPA_DEFAULT_RUN_LOG_FILE     "/tmp/raspa.log"
 
+// default session capture file path
+#define RASPA_DEFAULT_SESSION_CAPTURE_FILE     "/tmp/raspa_session.cap"
+
+// default servo trace file path
+#define RASPA_DEFAULT_SERVO_TRACE_FILE     "/tmp/raspa_servo.trace"
+
+// default control packet capture file path
+#define RASPA_DEFAULT_CTRL_PKT_CAPTURE_FILE     "/tmp/raspa_ctrl_pkt.cap"
+
 /**
  * @brief Convert error codes to human readable strings.
  *
@@ -46,12 +56,149 @@ const char* raspa_get_error_msg(int code);
 #define RASPA_DEBUG_SIGNAL_ON_MODE_SW   (1<<0)
 
 /**
- * @brief Debug flag, enable logging of the run period data to file
+ * @brief Debug flag, enable logging of the run period data to file. The page
+ *        faults of the rt thread, the frequency, temperature and interrupts
+ *        of its cpu are sampled by a non rt thread to a file next to it, with
+ *        the .sys suffix. See misc/run_log_parser.py.
  */
 #define RASPA_DEBUG_ENABLE_RUN_LOG_TO_FILE  (1<<1)
 
+/**
+ * @brief Debug flag, enable capture of the raw driver data of every period to
+ *        file, so that the session can be replayed offline by linking the
+ *        application with the raspa_replay library.
+ */
+#define RASPA_DEBUG_ENABLE_SESSION_CAPTURE  (1<<2)
+
+/**
+ * @brief Debug flag, count the calls to the allocator, to locks and to
+ *        blocking libc functions made from the process callback, and print
+ *        them with the backtrace of each call site on raspa_close(). Only
+ *        available if raspa is built with RASPA_WITH_RT_SANITIZER, link the
+ *        application with -rdynamic to get function names.
+ */
+#define RASPA_DEBUG_RT_SANITIZER            (1<<3)
+
+/**
+ * @brief Debug flag, look for denormal samples in the user input buffer
+ *        after conversion and in the user output buffer before conversion,
+ *        one period out of 16. The counts per channel are read with
+ *        raspa_get_denormal_report().
+ */
+#define RASPA_DEBUG_COUNT_DENORMALS         (1<<4)
+
+/**
+ * @brief Debug flag, record the timing error reported by the micro-controller
+ *        and the correction applied by the delay error filter on every period
+ *        to file. Only has an effect on sync platforms. The trace is replayed
+ *        through other filter settings with misc/servo_tuner.
+ */
+#define RASPA_DEBUG_ENABLE_SERVO_TRACE      (1<<5)
+
+/**
+ * @brief Debug flag, capture the type, payload size and header words of the
+ *        rx and tx audio control packets of every period to file. Only has
+ *        an effect on sync and async platforms. The capture is decoded with
+ *        misc/ctrl_pkt_decoder.
+ */
+#define RASPA_DEBUG_ENABLE_CTRL_PKT_CAPTURE (1<<6)
+
+/**
+ * @brief Debug flag, audit the isolation of the audio cpu in raspa_open()
+ *        and print the interrupts and threads found on it. See
+ *        raspa_audit_isolation().
+ */
+#define RASPA_DEBUG_AUDIT_ISOLATION         (1<<7)
+
+/**
+ * @brief Memory lock modes, see raspa_set_memory_lock_mode()
+ */
+#define RASPA_MEMORY_LOCK_ALL       0
+#define RASPA_MEMORY_LOCK_TARGETED  1
+
 typedef int64_t RaspaMicroSec;
 
+/**
+ * @brief Event types, see raspa_read_event()
+ */
+#define RASPA_EVENT_RT_LOOP_EXITED      1   // rt loop ended without raspa_close(), value is the error
+#define RASPA_EVENT_RT_LOOP_STALLED     2   // no period completed for a while, value is the time in us
+#define RASPA_EVENT_RT_LOOP_RESUMED     3   // periods complete again, value is the stall time in us
+#define RASPA_EVENT_OVERRUN             4   // rt thread woke up late, value is the number of periods lost
+#define RASPA_EVENT_USB_INPUT_LOST      5   // usb audio input stopped delivering, inputs are silenced
+#define RASPA_EVENT_USB_INPUT_RESTORED  6   // usb audio input delivers again
+#define RASPA_EVENT_GPIO_OVERFLOW       7   // gpio data from the device was lost, value is the number of blobs
+#define RASPA_EVENT_DROPPED             8   // events were lost before being read, value is their number
+#define RASPA_EVENT_BUFFER_SIZE_CHANGE  9   // the load policy asks for another buffer size, value is the size
+
+/**
+ * @brief Event record, see raspa_read_event()
+ */
+typedef struct
+{
+    int type;                   // one of RASPA_EVENT_*
+    int64_t value;              // type specific value
+    RaspaMicroSec timestamp;    // CLOCK_MONOTONIC time of the event in microseconds
+    int64_t period;             // period count of the rt thread when the event happened
+} RaspaEvent;
+
+/**
+ * @brief Locked memory report, see raspa_get_memory_report()
+ */
+typedef struct
+{
+    int64_t locked_bytes;           // total memory locked by the process
+    int num_unlocked_rt_mappings;   // mappings touched by the rt thread and not locked
+    int64_t unlocked_rt_bytes;      // resident size of those mappings
+} RaspaMemoryReport;
+
+/**
+ * @brief Denormal samples report, see raspa_get_denormal_report()
+ */
+typedef struct
+{
+    int64_t num_sampled_periods;    // periods the buffers were checked in
+    int64_t input_denormals;        // denormals found in the input buffers, all channels
+    int64_t output_denormals;       // denormals found in the output buffers, all channels
+} RaspaDenormalReport;
+
+/**
+ * @brief Audio cpu isolation report, see raspa_audit_isolation()
+ */
+typedef struct
+{
+    int cpu;                    // the audio cpu
+    int isolated;               // 1 if the cpu is in isolcpus
+    int nohz_full;              // 1 if the cpu is in nohz_full
+    int num_foreign_irqs;       // interrupts of other devices allowed on the cpu
+    int num_moved_irqs;         // of those, interrupts moved away by raspa
+    int num_user_threads;       // threads of other processes allowed on the cpu
+    int num_kernel_threads;     // kernel threads allowed on the cpu and on others
+} RaspaIsolationReport;
+
+/**
+ * @brief Highest factor accepted by raspa_set_decimation()
+ */
+#define RASPA_MAX_DECIMATION    4
+
+/**
+ * @brief Limits of the processing graph, see raspa_graph_add_node()
+ */
+#define RASPA_GRAPH_MAX_NODES   256
+#define RASPA_GRAPH_MAX_WORKERS 8
+
+/**
+ * @brief Processing graph node statistics, see raspa_graph_get_node_stats()
+ */
+typedef struct
+{
+    int64_t last_ns;            // duration of the node in the last period
+    int64_t avg_ns;             // average duration
+    int64_t max_ns;             // maximum duration since raspa_start_realtime()
+    int64_t critical_path_ns;   // average duration of the longest chain of nodes starting with this one
+    int last_worker;            // worker which ran the node in the last period, 0 is the rt thread
+} RaspaGraphNodeStats;
+
 /**
  * @brief Audio processing callback type
  *
@@ -61,6 +208,22 @@ typedef int64_t RaspaMicroSec;
  */
 typedef void (*RaspaProcessCallback)(float* input, float* output, void* data);
 
+/**
+ * @brief Audio processing callback type with one buffer per channel
+ *
+ * @param input Array of pointers to the buffers of each input channel
+ * @param output Array of pointers to the buffers of each output channel
+ * @param data Opaque pointer to user-provided data given during callback registration
+ */
+typedef void (*RaspaChannelProcessCallback)(float* const* input, float* const* output, void* data);
+
+/**
+ * @brief Processing graph node callback type
+ *
+ * @param data Opaque pointer given to raspa_graph_add_node()
+ */
+typedef void (*RaspaGraphNodeCallback)(void* data);
+
 /**
  * @brief Initialization function, setting up Xenomai and locking memory for the
  *        process. Must be called before any other raspa calls.
@@ -68,6 +231,47 @@ typedef void (*RaspaProcessCallback)(float* input, float* output, void* data);
  */
 int raspa_init();
 
+/**
+ * @brief Set how memory is locked against paging. Must be called before
+ *        raspa_init().
+ *        RASPA_MEMORY_LOCK_ALL (default): the whole process memory is locked
+ *        with mlockall() on Cobalt.
+ *        RASPA_MEMORY_LOCK_TARGETED: only the memory the rt thread is known
+ *        to use is locked: the raspa code and static data, the user and
+ *        driver buffers, the rt thread stack, the code of the process
+ *        callback, the decimation buffers and filters, and, when they are
+ *        opened, the buffers of the disk recorder and player, the audio tap
+ *        shared memory and the processing graph nodes. The user data passed
+ *        to raspa_open() and any memory it points to are not locked, give
+ *        them to raspa_lock_memory_region().
+ *
+ * @param mode One of RASPA_MEMORY_LOCK_ALL or RASPA_MEMORY_LOCK_TARGETED
+ */
+void raspa_set_memory_lock_mode(int mode);
+
+/**
+ * @brief Lock a memory region used by the process callback, e.g. a
+ *        preallocated arena. The region is rounded to whole pages and is
+ *        included in the memory report. Useful with RASPA_MEMORY_LOCK_TARGETED.
+ *
+ * @param address Start of the region
+ * @param size Size of the region in bytes
+ * @return 0 upon success, negative error code otherwise.
+ */
+int raspa_lock_memory_region(const void* address, size_t size);
+
+/**
+ * @brief Get the total locked memory and the memory touched by the rt thread
+ *        which is not locked: buffers, callback code and user data passed to
+ *        raspa_open(), and regions given to raspa_lock_memory_region().
+ *
+ * @param report Filled with the report
+ * @param print If non zero, also print the locked regions and the unlocked rt
+ *        mappings to stdout
+ * @return 0 upon success, negative error code otherwise.
+ */
+int raspa_get_memory_report(RaspaMemoryReport* report, int print);
+
 /**
  * @brief Set the run log file path. Path will be used by the open function to create
  *        a new run log file if logging is enabled with RASPA_DEBUG_ENABLE_RUN_LOG_TO_FILE
@@ -78,6 +282,36 @@ int raspa_init();
  */
 void raspa_set_run_log_file(const char *path);
 
+/**
+ * @brief Set the session capture file path. Path will be used by the open function
+ *        to create a new capture file if capture is enabled with
+ *        RASPA_DEBUG_ENABLE_SESSION_CAPTURE debug flag.
+ *        Default path is set by RASPA_DEFAULT_SESSION_CAPTURE_FILE.
+ *
+ * @param path Path of the capture file
+ */
+void raspa_set_session_capture_file(const char *path);
+
+/**
+ * @brief Set the servo trace file path. Path will be used by the open function
+ *        to create a new trace file if the trace is enabled with
+ *        RASPA_DEBUG_ENABLE_SERVO_TRACE debug flag.
+ *        Default path is set by RASPA_DEFAULT_SERVO_TRACE_FILE.
+ *
+ * @param path Path of the trace file
+ */
+void raspa_set_servo_trace_file(const char *path);
+
+/**
+ * @brief Set the control packet capture file path. Path will be used by the
+ *        open function to create a new capture file if the capture is enabled
+ *        with RASPA_DEBUG_ENABLE_CTRL_PKT_CAPTURE debug flag.
+ *        Default path is set by RASPA_DEFAULT_CTRL_PKT_CAPTURE_FILE.
+ *
+ * @param path Path of the capture file
+ */
+void raspa_set_ctrl_pkt_capture_file(const char *path);
+
 /**
  * @brief Set RASPA RT thread CPU affinity. This function must be called before calling raspa_open().
  *        Default affinity is 0.
@@ -101,6 +335,25 @@ int raspa_open(int buffer_size,
                RaspaProcessCallback process_callback,
                void* user_data, unsigned int debug_flags);
 
+/**
+ * @brief Same as raspa_open(), but the process callback is given an array of
+ *        pointers to the buffer of each channel. The channel buffers are laid
+ *        out with padding, so that they do not alias in the cache of the cpu,
+ *        and are aligned to the cache line. The same pointers are passed
+ *        to every call.
+ *
+ * @param buffer_size Number of frames in buffers processed at each interrupt
+ * @param process_callback Pointer to user processing callback
+ * @param user_data Opaque pointer of generic user data passed to callback during process
+ * @param debug_flags Bitwise combination of debug flags to use
+ *
+ * @return 0 in case of success, negative value otherwise. raspa_get_error_msg()
+ *         can be used to get a human readable string for the returned error code.
+ */
+int raspa_open_channels(int buffer_size,
+                        RaspaChannelProcessCallback process_callback,
+                        void* user_data, unsigned int debug_flags);
+
 /**
  * @brief Get the sampling rate of driver. Should be called after raspa_open().
  *
@@ -202,6 +455,363 @@ int raspa_set_gpio(int pin_num, int val);
  */
 int raspa_free_gpio(int pin_num);
 
+/**
+ * @brief Start recording input channels to a multichannel 32 bit float wav
+ *        file. The samples are streamed to disk by a non real-time thread, so
+ *        the length of the recording is only limited by the disk space. Must
+ *        be called after raspa_open().
+ *
+ * @param file_name Path of the wav file, overwritten if it exists
+ * @param channels Indices of the input channels to record, in file order
+ * @param num_channels Number of elements in channels
+ * @return 0 upon success, negative error code otherwise. raspa_get_error_msg()
+ *         can be used to get a human readable string for the returned error code.
+ */
+int raspa_recorder_open(const char* file_name, const int* channels, int num_channels);
+
+/**
+ * @brief Push the recorded channels of the current period. Intended to be
+ *        called from the process callback, it does not block.
+ *
+ * @param input The input buffer passed to the process callback, or the
+ *        first input channel pointer with raspa_open_channels()
+ */
+void raspa_recorder_push(const float* input);
+
+/**
+ * @brief Stop recording, write the pending samples and close the file.
+ *        Also done by raspa_close().
+ *
+ * @return 0 upon success, negative error code otherwise.
+ */
+int raspa_recorder_close();
+
+/**
+ * @brief Get the number of periods not recorded because the disk did not
+ *        keep up.
+ *
+ * @return The number of dropped periods since raspa_recorder_open()
+ */
+int64_t raspa_recorder_get_num_overruns();
+
+/**
+ * @brief Start playing a multichannel wav file (16, 24, 32 bit integer or 32
+ *        bit float, RIFF or RF64) to output channels. The file is read ahead
+ *        by a non real-time thread, so that its length is not limited by the
+ *        memory. The sample rate of the file must match the device one. Must
+ *        be called after raspa_open().
+ *
+ * @param file_name Path of the wav file
+ * @param channels Index of the output channel for each file channel, in file
+ *        order. Can be shorter than the number of channels of the file.
+ * @param num_channels Number of elements in channels
+ * @return 0 upon success, negative error code otherwise. raspa_get_error_msg()
+ *         can be used to get a human readable string for the returned error code.
+ */
+int raspa_player_open(const char* file_name, const int* channels, int num_channels);
+
+/**
+ * @brief Write the played channels of the current period to the output
+ *        buffer, overwriting them. Intended to be called from the process
+ *        callback, it does not block nor make system calls. Silence is written
+ *        at the end of the file or if the read-ahead did not keep up.
+ *
+ * @param output The output buffer passed to the process callback, or the
+ *        first output channel pointer with raspa_open_channels()
+ */
+void raspa_player_pull(float* output);
+
+/**
+ * @brief Seek to a frame of the file. Seek and loop commands are queued
+ *        without blocking, so they can be sent from the process callback, but
+ *        all of them must be sent from the same thread.
+ *
+ * @param frame The frame to continue playback from
+ * @return 0 upon success, -RASPA_EPLAYER_QUEUE_FULL if too many commands are
+ *         pending.
+ */
+int raspa_player_seek(int64_t frame);
+
+/**
+ * @brief Enable or disable looping at the end of the file, see
+ *        raspa_player_seek().
+ *
+ * @param enabled 1 to loop, 0 to stop at the end of the file
+ * @return 0 upon success, -RASPA_EPLAYER_QUEUE_FULL if too many commands are
+ *         pending.
+ */
+int raspa_player_set_loop(int enabled);
+
+/**
+ * @brief Stop playing and close the file. Also done by raspa_close().
+ *
+ * @return 0 upon success, negative error code otherwise.
+ */
+int raspa_player_close();
+
+/**
+ * @brief Get the number of periods which were not fully played because the
+ *        read-ahead did not keep up.
+ *
+ * @return The number of starved periods since raspa_player_open()
+ */
+int64_t raspa_player_get_num_starvations();
+
+/**
+ * @brief Start publishing selected channels of every period in POSIX shared
+ *        memory, after the process callback. Any number of non real-time
+ *        processes can read them with the functions in raspa/raspa_tap.h,
+ *        without affecting the real-time thread. Must be called after
+ *        raspa_open().
+ *
+ * @param name Shared memory name, e.g. RASPA_TAP_DEFAULT_NAME ("/raspa_tap")
+ * @param input_channels Indices of the input channels to publish
+ * @param num_inputs Number of elements in input_channels
+ * @param output_channels Indices of the output channels to publish
+ * @param num_outputs Number of elements in output_channels
+ * @return 0 upon success, negative error code otherwise. raspa_get_error_msg()
+ *         can be used to get a human readable string for the returned error code.
+ */
+int raspa_tap_open(const char* name,
+                   const int* input_channels,
+                   int num_inputs,
+                   const int* output_channels,
+                   int num_outputs);
+
+/**
+ * @brief Stop publishing and remove the shared memory name, attached readers
+ *        keep their mapping. Also done by raspa_close().
+ *
+ * @return 0 upon success, negative error code otherwise.
+ */
+int raspa_tap_close();
+
+/**
+ * @brief Get a file descriptor which is readable while there are events to
+ *        read with raspa_read_event(), so that supervisor threads can wait for
+ *        them with poll() or select(). The descriptor stays valid for the
+ *        lifetime of the process and must not be read, written or closed.
+ *        Events are delivered at most a few milliseconds after the rt thread
+ *        posts them, since the rt thread can not make linux system calls.
+ *
+ * @return The file descriptor upon success, negative error code otherwise.
+ */
+int raspa_get_event_fd();
+
+/**
+ * @brief Read the oldest pending event. Not to be called from the rt thread.
+ *
+ * @param event Where the event is stored
+ * @return 1 if an event was read, 0 if there are no pending events.
+ */
+int raspa_read_event(RaspaEvent* event);
+
+/**
+ * @brief Add a node to the processing graph, run by raspa_graph_process().
+ *        The graph can only be changed before raspa_start_realtime() or after
+ *        raspa_close().
+ *
+ * @param callback Called once per period when all the nodes the node depends
+ *        on have completed, from the rt thread or a graph worker thread
+ * @param data Opaque pointer passed to the callback
+ * @param name Name of the node, for debugging
+ * @return The node index upon success, negative error code otherwise.
+ */
+int raspa_graph_add_node(RaspaGraphNodeCallback callback, void* data, const char* name);
+
+/**
+ * @brief Make a node of the processing graph depend on another one, i.e.
+ *        to_node runs after from_node has completed. The graph must not
+ *        have cycles.
+ *
+ * @param from_node Index of the node to run first
+ * @param to_node Index of the node which depends on it
+ * @return 0 upon success, negative error code otherwise.
+ */
+int raspa_graph_add_edge(int from_node, int to_node);
+
+/**
+ * @brief Remove all the nodes of the processing graph.
+ *
+ * @return 0 upon success, negative error code otherwise.
+ */
+int raspa_graph_clear();
+
+/**
+ * @brief Set the cpus of the graph worker threads, one rt thread pinned to
+ *        each. The rt thread also runs nodes, so its cpu should not be
+ *        included. Without workers, the whole graph runs on the rt thread.
+ *        Must be called before raspa_start_realtime().
+ *
+ * @param cpus The cpu of each worker
+ * @param num_cpus The number of workers, up to RASPA_GRAPH_MAX_WORKERS
+ * @return 0 upon success, negative error code otherwise.
+ */
+int raspa_graph_set_worker_cpus(const int* cpus, int num_cpus);
+
+/**
+ * @brief Run the processing graph once. To be called from the process
+ *        callback, returns when all the nodes have completed. The timing of
+ *        each node is written to the run log, see raspa_set_run_log_file().
+ *
+ * @return 0 upon success, negative error code otherwise.
+ */
+int raspa_graph_process();
+
+/**
+ * @brief Get the timing statistics of a node of the processing graph.
+ *
+ * @param node The node index
+ * @param stats Filled with the statistics
+ * @return 0 upon success, negative error code otherwise.
+ */
+int raspa_graph_get_node_stats(int node, RaspaGraphNodeStats* stats);
+
+/**
+ * @brief Run the process callback at the driver sampling rate divided by an
+ *        integer factor. Inputs are low pass filtered and decimated before the
+ *        callback, and outputs interpolated after it. Must be called before
+ *        raspa_open(), whose buffer_size stays the driver buffer size and must
+ *        be a multiple of the factor. The callback then processes
+ *        buffer_size / factor frames, and raspa_get_sampling_rate(),
+ *        raspa_get_samplecount(), the recorder, the player and the tap all
+ *        use the decimated rate. Default factor is 1, i.e. no decimation.
+ *
+ * @param factor The decimation factor, from 1 to RASPA_MAX_DECIMATION
+ * @return 0 upon success, negative error code otherwise.
+ */
+int raspa_set_decimation(int factor);
+
+/**
+ * @brief Get the decimation factor set with raspa_set_decimation().
+ *
+ * @return The decimation factor, 1 without decimation.
+ */
+int raspa_get_decimation();
+
+/**
+ * @brief Get the number of frames in each channel of the buffers passed to
+ *        the process callback, i.e. the buffer size given to raspa_open()
+ *        divided by the decimation factor.
+ *
+ * @return The callback buffer size in frames, 0 if raspa is not open.
+ */
+int raspa_get_callback_buffer_size();
+
+/**
+ * @brief Get the distance in samples between the start of two consecutive
+ *        channels of the buffers passed to the process callback. It can be
+ *        larger than raspa_get_callback_buffer_size() when the channels are
+ *        padded for alignment.
+ *
+ * @return The channel stride in samples, 0 if raspa is not open.
+ */
+int raspa_get_callback_channel_stride();
+
+/**
+ * @brief Get the latency added by the decimation filters, from the codec
+ *        input through the callback to the codec output. Half of it is on
+ *        the output side and is included in raspa_get_output_latency().
+ *        Should be called after raspa_open().
+ *
+ * @return The latency in microseconds, 0 without decimation.
+ */
+RaspaMicroSec raspa_get_decimation_latency();
+
+/**
+ * @brief Enable the load policy, which watches the load of the process
+ *        callback and the missed periods over time. When the load stays above
+ *        high_load for hold_time_ms, or periods keep being missed, it asks for
+ *        the next larger supported buffer size with a
+ *        RASPA_EVENT_BUFFER_SIZE_CHANGE event. When the load stays below
+ *        low_load for 4 times as long, it asks for the next smaller size,
+ *        down to the size the device was first opened with.
+ *        The driver buffer size is a driver parameter, so the host makes the
+ *        switch by closing raspa, setting the driver parameter and opening
+ *        raspa again with the new size, then updates its latency compensation.
+ *        With the policy enabled, the outputs are faded out in
+ *        raspa_close() and faded in after raspa_start_realtime(), so that the
+ *        switch is muted. Must be called before raspa_open().
+ *
+ * @param high_load Load above which the buffer size is increased, in (0, 1]
+ * @param low_load Load below which the buffer size is decreased, lower than high_load
+ * @param hold_time_ms Time the load must stay high before a change is asked for
+ * @return 0 upon success, negative error code otherwise.
+ */
+int raspa_set_load_policy(float high_load, float low_load, int hold_time_ms);
+
+/**
+ * @brief Get the buffer size chosen by the load policy, i.e. the size of the
+ *        last RASPA_EVENT_BUFFER_SIZE_CHANGE event, or the current buffer size
+ *        if no change is pending or the policy is not enabled.
+ *
+ * @return The buffer size in frames, 0 if raspa is not open.
+ */
+int raspa_get_policy_buffer_size();
+
+/**
+ * @brief Set the denormal handling of the rt threads. When enabled (default),
+ *        the floating point unit flushes denormal results to zero, and on x86
+ *        also reads denormal operands as zero, so that decaying signals in
+ *        recursive filters and reverb tails do not slow down the callback.
+ *        Applies to the rt thread and to the graph workers. Must be called
+ *        before raspa_start_realtime().
+ *
+ * @param enabled 1 to flush denormals to zero, 0 to keep ieee behaviour
+ */
+void raspa_set_flush_denormals(int enabled);
+
+/**
+ * @brief Get the number of denormal samples found in the buffers exchanged
+ *        with the process callback. Needs the RASPA_DEBUG_COUNT_DENORMALS
+ *        debug flag in raspa_open().
+ *
+ * @param report Filled with the report
+ * @param print If non zero, also print the counts of each channel to stdout
+ * @return 0 upon success, -RASPA_EDENORMAL_COUNT if counting is not enabled.
+ */
+int raspa_get_denormal_report(RaspaDenormalReport* report, int print);
+
+/**
+ * @brief Run the rt thread under SCHED_DEADLINE instead of SCHED_FIFO, with a
+ *        reservation of runtime_fraction of the buffer period in every buffer
+ *        period. A callback which overruns its reservation is throttled by
+ *        the kernel until the next period. The rt thread is then not pinned
+ *        to the cpu set with raspa_set_cpu_affinity(), as the kernel only
+ *        accepts deadline threads whose affinity spans their root domain; put
+ *        the process in an exclusive cpuset partition to choose its cpus.
+ *        Only available when raspa is built with RASPA_WITH_PREEMPT_RT. Must
+ *        be called before raspa_start_realtime().
+ *
+ * @param runtime_fraction Share of the period reserved, in (0, 1], or 0 to
+ *        go back to SCHED_FIFO
+ * @return 0 upon success, negative error code otherwise.
+ */
+int raspa_set_deadline_reservation(float runtime_fraction);
+
+/**
+ * @brief Move the interrupts of other devices away from the audio cpu in
+ *        raspa_open(), by removing the cpu from their smp_affinity. Their
+ *        affinity is restored in raspa_close(). Interrupts pinned to the
+ *        audio cpu alone are left there. Needs write access to /proc/irq.
+ *        Must be called before raspa_open().
+ *
+ * @param enabled 1 to move the interrupts, 0 (default) to leave them
+ */
+void raspa_set_irq_steering(int enabled);
+
+/**
+ * @brief Check how well the audio cpu is shielded from the rest of the
+ *        system: isolcpus and nohz_full, the interrupts of other devices and
+ *        the threads of other processes allowed on the cpu. Must be called
+ *        after raspa_open(), not from the rt thread.
+ *
+ * @param report Filled with the report
+ * @param print If non zero, also print the interrupts and threads found
+ * @return 0 upon success, -RASPA_EISOLATION_AUDIT if /proc can't be read.
+ */
+int raspa_audit_isolation(RaspaIsolationReport* report, int print);
+
 #ifdef __cplusplus
 }
 #endif
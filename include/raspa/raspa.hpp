@@ -0,0 +1,318 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with RASPA.
+ * If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Header only C++ API on top of the C API in raspa.h. The process
+ *        callback is a functor which receives per channel views of the audio
+ *        buffers. The buffer size and the channel counts can be compile time
+ *        constants, so that the processing loops of the functor can be fully
+ *        unrolled and vectorized.
+ *
+ *        Example:
+ *
+ *        struct Gain
+ *        {
+ *            template<typename Input, typename Output>
+ *            void operator()(Input input, Output output)
+ *            {
+ *                for (int c = 0; c < output.num_channels(); c++)
+ *                {
+ *                    auto in = input.channel(c);
+ *                    auto out = output.channel(c);
+ *                    for (int i = 0; i < out.size(); i++)
+ *                    {
+ *                        out[i] = 0.5f * in[i];
+ *                    }
+ *                }
+ *            }
+ *        };
+ *
+ *        Gain gain;
+ *        raspa::ProcessorHost<Gain, 2, 2> host(gain);
+ *        host.open<32, 64, 128>(buffer_size);
+ *        host.start_realtime();
+ *
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+
+#ifndef RASPA_HPP_
+#define RASPA_HPP_
+
+#include "raspa/raspa.h"
+#include "raspa/raspa_error_list.h"
+
+namespace raspa {
+
+// Size or channel count known only at run time
+constexpr int DYNAMIC_SIZE = -1;
+
+namespace error_list {
+#define RASPA_HPP_ERROR_ENUM(ID, NAME, TEXT) NAME = ID,
+enum
+{
+    RASPA_ERROR_CODES_OP(RASPA_HPP_ERROR_ENUM)
+};
+#undef RASPA_HPP_ERROR_ENUM
+}  // namespace error_list
+
+// Error returned by ProcessorHost::open() when the device channel counts do
+// not match the compile time ones, raspa_get_error_msg() can be used on it.
+constexpr int ECHANNEL_COUNT_MISMATCH = error_list::RASPA_ECHANNEL_COUNT_MISMATCH;
+
+/**
+ * @brief Non owning view of the samples of one channel.
+ *
+ * @tparam T The sample type, float or const float
+ * @tparam Size The number of samples if known at compile time, DYNAMIC_SIZE
+ *         otherwise
+ */
+template<typename T, int Size = DYNAMIC_SIZE>
+class ChannelSpan
+{
+public:
+    static constexpr int SIZE = Size;
+
+    ChannelSpan(T* data, int size) : _data(data), _size(size) {}
+
+    constexpr int size() const
+    {
+        if constexpr (Size != DYNAMIC_SIZE)
+        {
+            return Size;
+        }
+        else
+        {
+            return _size;
+        }
+    }
+
+    T* data() const { return _data; }
+
+    T& operator[](int index) const { return _data[index]; }
+
+    T* begin() const { return _data; }
+
+    T* end() const { return _data + size(); }
+
+private:
+    T* _data;
+    int _size;
+};
+
+/**
+ * @brief Non owning view of a non-interleaved multichannel buffer as passed
+ *        to the process callback, whose channels start channel_stride
+ *        samples apart.
+ *
+ * @tparam T The sample type, float or const float
+ * @tparam BufferSize The buffer size in frames if known at compile time,
+ *         DYNAMIC_SIZE otherwise
+ * @tparam NumChannels The number of channels if known at compile time,
+ *         DYNAMIC_SIZE otherwise
+ */
+template<typename T, int BufferSize = DYNAMIC_SIZE, int NumChannels = DYNAMIC_SIZE>
+class ChannelBuffers
+{
+public:
+    static constexpr int BUFFER_SIZE = BufferSize;
+    static constexpr int NUM_CHANNELS = NumChannels;
+
+    ChannelBuffers(T* data, int buffer_size, int num_channels) : ChannelBuffers(data,
+                                                                                buffer_size,
+                                                                                num_channels,
+                                                                                buffer_size)
+    {}
+
+    ChannelBuffers(T* data, int buffer_size, int num_channels, int channel_stride) : _data(data),
+                                                                                     _buffer_size(buffer_size),
+                                                                                     _num_channels(num_channels),
+                                                                                     _channel_stride(channel_stride)
+    {}
+
+    constexpr int buffer_size() const
+    {
+        if constexpr (BufferSize != DYNAMIC_SIZE)
+        {
+            return BufferSize;
+        }
+        else
+        {
+            return _buffer_size;
+        }
+    }
+
+    constexpr int num_channels() const
+    {
+        if constexpr (NumChannels != DYNAMIC_SIZE)
+        {
+            return NumChannels;
+        }
+        else
+        {
+            return _num_channels;
+        }
+    }
+
+    ChannelSpan<T, BufferSize> channel(int channel) const
+    {
+        return ChannelSpan<T, BufferSize>(_data + channel * _channel_stride, buffer_size());
+    }
+
+    int channel_stride() const { return _channel_stride; }
+
+    T* data() const { return _data; }
+
+private:
+    T* _data;
+    int _buffer_size;
+    int _num_channels;
+    int _channel_stride;
+};
+
+/**
+ * @brief Registers a functor as the raspa process callback. The functor is
+ *        called from the rt thread as processor(input, output), where input
+ *        is a ChannelBuffers<const float, ...> and output a
+ *        ChannelBuffers<float, ...>. The functor call is inlined in a
+ *        callback which is specialized for the processor type, the channel
+ *        counts and, if one of the buffer sizes given to open() matches, the
+ *        callback buffer size, which is the driver buffer size divided by
+ *        the decimation factor, see raspa_set_decimation().
+ *
+ *        Only one ProcessorHost can be open at the same time, like the C API.
+ *
+ * @tparam Processor The functor type
+ * @tparam NumInputs The number of input channels expected from the device,
+ *         DYNAMIC_SIZE to accept any
+ * @tparam NumOutputs The number of output channels expected from the device,
+ *         DYNAMIC_SIZE to accept any
+ */
+template<typename Processor, int NumInputs = DYNAMIC_SIZE, int NumOutputs = DYNAMIC_SIZE>
+class ProcessorHost
+{
+public:
+    explicit ProcessorHost(Processor& processor) : _processor(&processor),
+                                                   _buffer_size(0),
+                                                   _channel_stride(0),
+                                                   _num_inputs(0),
+                                                   _num_outputs(0)
+    {}
+
+    /**
+     * @brief Open the device, see raspa_open(). The callback specialized for
+     *        the callback buffer size, buffer_size divided by the decimation
+     *        factor, is selected among BufferSizes, the dynamic buffer size
+     *        callback is used if none matches.
+     *
+     * @tparam BufferSizes The callback buffer sizes to generate specialized
+     *         callbacks for
+     * @param buffer_size The driver buffer size in frames
+     * @param debug_flags Debug flags, see raspa_open()
+     * @return 0 upon success, negative error code otherwise, which can be
+     *         passed to raspa_get_error_msg().
+     */
+    template<int... BufferSizes>
+    int open(int buffer_size, unsigned int debug_flags = 0)
+    {
+        // the decimation factor is fixed before raspa_open(), an invalid
+        // buffer size is rejected by raspa_open() itself
+        auto callback_buffer_size = buffer_size / raspa_get_decimation();
+        auto res = raspa_open(buffer_size,
+                              _select_callback<BufferSizes...>(callback_buffer_size),
+                              this,
+                              debug_flags);
+        if (res < 0)
+        {
+            return res;
+        }
+
+        _buffer_size = raspa_get_callback_buffer_size();
+        _channel_stride = raspa_get_callback_channel_stride();
+        _num_inputs = raspa_get_num_input_channels();
+        _num_outputs = raspa_get_num_output_channels();
+
+        if ((NumInputs != DYNAMIC_SIZE && NumInputs != _num_inputs) ||
+            (NumOutputs != DYNAMIC_SIZE && NumOutputs != _num_outputs))
+        {
+            raspa_close();
+            return -ECHANNEL_COUNT_MISMATCH;
+        }
+
+        return 0;
+    }
+
+    int start_realtime()
+    {
+        return raspa_start_realtime();
+    }
+
+    int close()
+    {
+        return raspa_close();
+    }
+
+    /**
+     * @brief The number of frames in each channel passed to the processor.
+     */
+    int buffer_size() const
+    {
+        return _buffer_size;
+    }
+
+    int num_input_channels() const
+    {
+        return _num_inputs;
+    }
+
+    int num_output_channels() const
+    {
+        return _num_outputs;
+    }
+
+private:
+    template<int BufferSize>
+    static void _callback(float* input, float* output, void* data)
+    {
+        auto host = static_cast<ProcessorHost*>(data);
+
+        ChannelBuffers<const float, BufferSize, NumInputs> input_buffers(input,
+                                                                         host->_buffer_size,
+                                                                         host->_num_inputs,
+                                                                         host->_channel_stride);
+        ChannelBuffers<float, BufferSize, NumOutputs> output_buffers(output,
+                                                                     host->_buffer_size,
+                                                                     host->_num_outputs,
+                                                                     host->_channel_stride);
+        (*host->_processor)(input_buffers, output_buffers);
+    }
+
+    template<int... BufferSizes>
+    static RaspaProcessCallback _select_callback(int buffer_size)
+    {
+        RaspaProcessCallback callback = &ProcessorHost::_callback<DYNAMIC_SIZE>;
+        // fold over the candidates, picking the one equal to buffer_size
+        ((buffer_size == BufferSizes ? (callback = &ProcessorHost::_callback<BufferSizes>, 0) : 0), ...);
+        return callback;
+    }
+
+    Processor* _processor;
+    int _buffer_size;
+    int _channel_stride;
+    int _num_inputs;
+    int _num_outputs;
+};
+
+}  // namespace raspa
+
+#endif // RASPA_HPP_
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with RASPA.
+ * If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief List of all the Raspa error codes. Shared by the library and by the
+ *        header only C++ API, so that both use the same values.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_ERROR_LIST_H_
+#define RASPA_ERROR_LIST_H_
+
+/**
+ * @brief Macro which will expand macro X on all possible error codes.
+ *        X should take 3 arguments
+ */
+#define RASPA_ERROR_CODES_OP(X)\
+    X(0,   RASPA_SUCCESS, "Raspa: No error.")\
+    X(100, RASPA_EBUFFER_SIZE_MISMATCH, "Raspa: Buffer size mismatch with driver.")\
+    X(101, RASPA_EVERSION, "Raspa: Version mismatch with driver.")\
+    X(102, RASPA_ENOMEM, "Raspa: Failed to get buffers from driver.")\
+    X(103, RASPA_EUSER_BUFFERS, "Raspa: Failed to allocate user audio buffers.")\
+    X(104, RASPA_ETASK_AFFINITY, "Raspa: Failed to set affinity for RT task.")\
+    X(105, RASPA_ETASK_CREATE, "Raspa: Failed to create RT task.")\
+    X(106, RASPA_ETASK_START, "Raspa: Failed to start RT task.")\
+    X(107, RASPA_ETASK_STOP, "Raspa: Failed to stop RT task.")\
+    X(108, RASPA_ETASK_CANCEL, "Raspa: Failed to cancel RT task.")\
+    X(109, RASPA_EUNMAP, "Raspa: Failed to unmap driver buffers.")\
+    X(110, RASPA_EDEVICE_OPEN, "Raspa: Failed to open driver.")\
+    X(111, RASPA_EDEVICE_CLOSE, "Raspa: Failed to close driver.")\
+    X(112, RASPA_ECODEC_FORMAT, "Raspa: Unsupported codec format.")\
+    X(113, RASPA_EPLATFORM_TYPE, "Raspa: Unsupported platform type.")\
+    X(114, RASPA_EDEVICE_FIRMWARE, "Raspa: Incorrect firmware on external micro-controller.")\
+    X(115, RASPA_EDEVICE_INACTIVE, "Raspa: External micro-controller not responding.")\
+    X(116, RASPA_EINSOCKET_CREATION, "Raspa: Failed to create input socket for gpio data communication.")\
+    X(117, RASPA_EOUTSOCKET_CREATION, "Raspa: Failed to create output socket for gpio data communication.")\
+    X(118, RASPA_EINSOCKET_BIND, "Raspa: Failed to bind input socket to address.")\
+    X(119, RASPA_EINSOCKET_TIMEOUT, "Raspa: Failed to set input socket to address.")\
+    X(120, RASPA_EMLOCKALL, "Raspa: Failed to lock memory needed to prevent page swapping.")\
+    X(121, RASPA_EBUFFER_SIZE_INVALID, "Raspa: driver configured with invalid buffer size.")\
+    X(122, RASPA_EBUFFER_SIZE_SC, "Raspa: sample converter does not suppot specified buffer size.")\
+    X(123, RASPA_ECHANNEL_COUNT_MISMATCH, "Raspa: Channel count mismatch with the processor.")\
+    X(200, RASPA_EPARAM, "Raspa: Unable to param from driver.")\
+    X(201, RASPA_EPARAM_SAMPLERATE, "Raspa: Unable to read sample rate param from driver.")\
+    X(202, RASPA_EPARAM_INPUTCHANS, "Raspa: Unable to read num input chans param from driver.")\
+    X(203, RASPA_EPARAM_OUTPUTCHANS, "Raspa: Unable to read num output chans param from driver.")\
+    X(204, RASPA_EPARAM_CODEC_FORMAT, "Raspa: Unable to read codec format param from driver.")\
+    X(205, RASPA_EPARAM_PLATFORM_TYPE, "Raspa: Unable to read platform type param from driver.")\
+    X(206, RASPA_EPARAM_VERSION, "Raspa: Unable to read driver version param from driver.")\
+    X(207, RASPA_EPARAM_BUFFER_SIZE, "Raspa: Unable to access buffer size param of driver.")\
+    X(208, RASPA_EALSA_INIT_FAILED, "Raspa: Alsa usb init failed.")\
+    X(209, RASPA_EGPIO_UNSUPPORTED, "Raspa: Unsupported gpio requested.")\
+    X(210, RASPA_EPARAM_USB_AUDIO_TYPE, "Raspa: Unable to read usb audio type param from driver.")\
+    X(211, RASPA_EUSBAUDIO_TYPE, "Raspa: Unsupported usb audio type.")\
+    X(212, RASPA_EDEVICE_INVALID_CONFIG_FILE, "Raspa: Driver cannot find one or more conf files. See dmesg.")\
+    X(213, RASPA_ERUNLOG_FILE_OPEN, "Raspa: Error opening the run log file.")\
+    X(214, RASPA_ERUNLOG_FILE_CLOSE, "Raspa: Error closing the run log file.")\
+    X(215, RASPA_EPARAM_INPUT_AUDIO_INFO, "Raspa: Unable to read input audio info from driver.")\
+    X(216, RASPA_EPARAM_OUTPUT_AUDIO_INFO, "Raspa: Unable to read output audio info from driver.")\
+    X(217, RASPA_ECAPTURE_FILE_OPEN, "Raspa: Error opening the session capture file.")\
+    X(218, RASPA_ECAPTURE_FILE_CLOSE, "Raspa: Error closing the session capture file.")\
+    X(219, RASPA_ECAPTURE_FILE_INVALID, "Raspa: Invalid or unsupported session capture file.")\
+    X(220, RASPA_ERECORDER_ALREADY_OPEN, "Raspa: Disk recorder is already open.")\
+    X(221, RASPA_ERECORDER_CHANNELS, "Raspa: Invalid disk recorder channel selection.")\
+    X(222, RASPA_ERECORDER_FILE_OPEN, "Raspa: Error opening the disk recorder file.")\
+    X(223, RASPA_ERECORDER_FILE_WRITE, "Raspa: Error writing the disk recorder file.")\
+    X(224, RASPA_EPLAYER_ALREADY_OPEN, "Raspa: Disk player is already open.")\
+    X(225, RASPA_EPLAYER_CHANNELS, "Raspa: Invalid disk player channel selection.")\
+    X(226, RASPA_EPLAYER_FILE_OPEN, "Raspa: Error opening the disk player file.")\
+    X(227, RASPA_EPLAYER_FILE_FORMAT, "Raspa: Unsupported disk player file format.")\
+    X(228, RASPA_EPLAYER_SAMPLE_RATE, "Raspa: Disk player file sample rate does not match the device.")\
+    X(229, RASPA_EPLAYER_QUEUE_FULL, "Raspa: Disk player command queue is full.")\
+    X(230, RASPA_EMLOCK, "Raspa: Failed to lock memory region.")\
+    X(231, RASPA_ETAP_ALREADY_OPEN, "Raspa: Audio tap is already open.")\
+    X(232, RASPA_ETAP_CHANNELS, "Raspa: Invalid audio tap channel selection.")\
+    X(233, RASPA_ETAP_SHM, "Raspa: Error creating the audio tap shared memory.")\
+    X(234, RASPA_EEVENT_FD, "Raspa: Error creating the event file descriptor.")\
+    X(235, RASPA_EGRAPH_NODE, "Raspa: Invalid processing graph node.")\
+    X(236, RASPA_EGRAPH_CYCLE, "Raspa: The processing graph has a cycle.")\
+    X(237, RASPA_EGRAPH_RUNNING, "Raspa: The processing graph can not be changed while running.")\
+    X(238, RASPA_EGRAPH_NOT_READY, "Raspa: The processing graph is not running.")\
+    X(239, RASPA_EGRAPH_WORKER, "Raspa: Error starting the processing graph worker threads.")\
+    X(240, RASPA_ERT_SANITIZER, "Raspa: The rt sanitizer is not available, raspa was built without RASPA_WITH_RT_SANITIZER.")\
+    X(241, RASPA_EDECIMATION, "Raspa: Invalid decimation factor, or not a divider of the buffer size.")\
+    X(242, RASPA_ELOAD_POLICY, "Raspa: Invalid load policy thresholds, or raspa is already open.")\
+    X(243, RASPA_EDENORMAL_COUNT, "Raspa: Denormal counting not enabled, see RASPA_DEBUG_COUNT_DENORMALS.")\
+    X(244, RASPA_ESERVO_TRACE_FILE_OPEN, "Raspa: Error opening the servo trace file.")\
+    X(245, RASPA_ESERVO_TRACE_FILE_CLOSE, "Raspa: Error closing the servo trace file.")\
+    X(246, RASPA_ECTRL_PKT_CAPTURE_FILE_OPEN, "Raspa: Error opening the control packet capture file.")\
+    X(247, RASPA_ECTRL_PKT_CAPTURE_FILE_CLOSE, "Raspa: Error closing the control packet capture file.")\
+    X(248, RASPA_EDEADLINE_RESERVATION, "Raspa: Invalid runtime fraction, raspa is already running or was built without RASPA_WITH_PREEMPT_RT.")\
+    X(249, RASPA_ESCHED_DEADLINE, "Raspa: Error moving the rt thread to SCHED_DEADLINE, check its affinity and the admission test of the kernel.")\
+    X(250, RASPA_EISOLATION_AUDIT, "Raspa: Error reading the cpu isolation state from /proc and /sys.")\
+
+#endif // RASPA_ERROR_LIST_H_
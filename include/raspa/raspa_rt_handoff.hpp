@@ -0,0 +1,307 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with RASPA.
+ * If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Header only utilities to hand objects over to the process callback
+ *        without locks, and to destroy the replaced ones outside of the rt
+ *        thread.
+ *
+ *        RtSlot holds the object used by the process callback. A non rt
+ *        thread publishes a new object, the process callback picks it up at
+ *        the start of the next period and retires the previous one to an
+ *        RtReclaimer, which destroys it from a non rt thread. Destructors and
+ *        free() never run on the rt thread.
+ *
+ *        Example:
+ *
+ *        raspa::RtReclaimer reclaimer;
+ *        raspa::RtSlot<Reverb> reverb(reclaimer, std::make_unique<Reverb>(ir));
+ *        reclaimer.start();
+ *
+ *        // process callback
+ *        Reverb* current = reverb.acquire();
+ *        current->process(input, output);
+ *
+ *        // any non rt thread
+ *        reverb.publish(std::make_unique<Reverb>(new_ir));
+ *
+ *        // after raspa_close()
+ *        reclaimer.stop();
+ *
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+
+#ifndef RASPA_RT_HANDOFF_HPP_
+#define RASPA_RT_HANDOFF_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace raspa {
+
+// Number of retired objects which can wait for destruction
+constexpr size_t RT_RECLAIMER_CAPACITY = 256;
+
+// Default period of the reclaimer thread
+constexpr std::chrono::milliseconds RT_RECLAIMER_DEFAULT_PERIOD(20);
+
+/**
+ * @brief Queue of objects retired by the rt thread, destroyed by a non rt
+ *        thread either with collect() or by the thread started with start().
+ *
+ *        Objects are retired by a single rt thread and collected by one non
+ *        rt thread at a time. The queue is bounded, can_retire() tells if
+ *        there is room left.
+ */
+class RtReclaimer
+{
+public:
+    RtReclaimer() : _write_index(0),
+                    _read_index(0),
+                    _is_running(false)
+    {}
+
+    ~RtReclaimer()
+    {
+        stop();
+        collect();
+    }
+
+    RtReclaimer(const RtReclaimer&) = delete;
+    RtReclaimer& operator=(const RtReclaimer&) = delete;
+
+    /**
+     * @brief Check if an object can be retired. Rt thread only.
+     */
+    bool can_retire() const
+    {
+        return _write_index.load(std::memory_order_relaxed) -
+               _read_index.load(std::memory_order_acquire) < RT_RECLAIMER_CAPACITY;
+    }
+
+    /**
+     * @brief Queue an object for destruction with delete. Rt thread only,
+     *        does not block nor allocate.
+     *
+     * @param object The object, can be nullptr
+     * @return true upon success, false if the queue is full, in which case
+     *         the object is still owned by the caller.
+     */
+    template<typename T>
+    bool retire(T* object)
+    {
+        if (object == nullptr)
+        {
+            return true;
+        }
+        if (!can_retire())
+        {
+            return false;
+        }
+
+        auto write_index = _write_index.load(std::memory_order_relaxed);
+        _entries[write_index % RT_RECLAIMER_CAPACITY] = {object, &_delete<T>};
+        _write_index.store(write_index + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Destroy the retired objects. Non rt threads only.
+     *
+     * @return The number of objects destroyed.
+     */
+    int collect()
+    {
+        std::lock_guard<std::mutex> lock(_collect_mutex);
+        auto read_index = _read_index.load(std::memory_order_relaxed);
+        auto write_index = _write_index.load(std::memory_order_acquire);
+
+        int num_destroyed = 0;
+        while (read_index != write_index)
+        {
+            auto& entry = _entries[read_index % RT_RECLAIMER_CAPACITY];
+            entry.deleter(entry.object);
+            read_index++;
+            num_destroyed++;
+            _read_index.store(read_index, std::memory_order_release);
+        }
+        return num_destroyed;
+    }
+
+    /**
+     * @brief Start a thread which calls collect() periodically.
+     *
+     * @param period The collection period
+     */
+    void start(std::chrono::milliseconds period = RT_RECLAIMER_DEFAULT_PERIOD)
+    {
+        if (_is_running)
+        {
+            return;
+        }
+        _is_running = true;
+        _thread = std::thread([this, period]()
+        {
+            while (_is_running)
+            {
+                collect();
+                std::this_thread::sleep_for(period);
+            }
+        });
+    }
+
+    /**
+     * @brief Stop the thread started with start(). Objects retired after the
+     *        last collection are destroyed by the next collect() or by the
+     *        destructor.
+     */
+    void stop()
+    {
+        if (_is_running)
+        {
+            _is_running = false;
+            if (_thread.joinable())
+            {
+                _thread.join();
+            }
+        }
+    }
+
+private:
+    struct Entry
+    {
+        void* object;
+        void (*deleter)(void*);
+    };
+
+    template<typename T>
+    static void _delete(void* object)
+    {
+        delete static_cast<T*>(object);
+    }
+
+    Entry _entries[RT_RECLAIMER_CAPACITY];
+    alignas(64) std::atomic<size_t> _write_index;
+    alignas(64) std::atomic<size_t> _read_index;
+
+    std::mutex _collect_mutex;
+    std::atomic<bool> _is_running;
+    std::thread _thread;
+};
+
+/**
+ * @brief Holds the object used by the rt thread and hands over new ones
+ *        published by non rt threads.
+ *
+ *        publish() can be called from any non rt thread, acquire() from the
+ *        rt thread only. If several objects are published between two calls
+ *        to acquire(), only the last one is handed over and the others are
+ *        destroyed by publish(), as the rt thread never saw them.
+ *
+ * @tparam T The object type
+ */
+template<typename T>
+class RtSlot
+{
+public:
+    /**
+     * @brief Construct the slot.
+     *
+     * @param reclaimer Where the replaced objects are retired
+     * @param initial The initial object, can be nullptr
+     */
+    explicit RtSlot(RtReclaimer& reclaimer, std::unique_ptr<T> initial = nullptr) :
+                    _reclaimer(reclaimer),
+                    _pending(nullptr),
+                    _current(initial.release())
+    {}
+
+    /**
+     * @brief Destroy the current and pending objects. Must not be called
+     *        while the rt thread can call acquire().
+     */
+    ~RtSlot()
+    {
+        _delete_pending(_pending.exchange(nullptr));
+        delete _current;
+    }
+
+    RtSlot(const RtSlot&) = delete;
+    RtSlot& operator=(const RtSlot&) = delete;
+
+    /**
+     * @brief Publish a new object, picked up by the next call to acquire().
+     *        Non rt threads only.
+     *
+     * @param object The new object, can be nullptr to release the current one
+     */
+    void publish(std::unique_ptr<T> object)
+    {
+        // nullptr in _pending means nothing published, so publishing no object uses a marker
+        T* published = object ? object.release() : _empty_marker();
+        _delete_pending(_pending.exchange(published, std::memory_order_acq_rel));
+    }
+
+    /**
+     * @brief Get the object to use in the current period, after taking over
+     *        the last published one. Rt thread only, does not block nor free
+     *        memory. If the reclaimer is full, the handover is postponed and
+     *        the previous object is returned.
+     *
+     * @return The current object, nullptr if there is none.
+     */
+    T* acquire()
+    {
+        if (_pending.load(std::memory_order_relaxed) != nullptr && _reclaimer.can_retire())
+        {
+            auto object = _pending.exchange(nullptr, std::memory_order_acq_rel);
+            if (object != nullptr)
+            {
+                _reclaimer.retire(_current);
+                _current = (object == _empty_marker()) ? nullptr : object;
+            }
+        }
+        return _current;
+    }
+
+private:
+    // stands for a published nullptr, never dereferenced
+    static T* _empty_marker()
+    {
+        return reinterpret_cast<T*>(&_empty);
+    }
+
+    // objects which were pending were never seen by the rt thread
+    static void _delete_pending(T* object)
+    {
+        if (object != _empty_marker())
+        {
+            delete object;
+        }
+    }
+
+    alignas(T) static inline char _empty;
+
+    RtReclaimer& _reclaimer;
+    std::atomic<T*> _pending;
+    T* _current;    // only accessed by the rt thread
+};
+
+}  // namespace raspa
+
+#endif // RASPA_RT_HANDOFF_HPP_
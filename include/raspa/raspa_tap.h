@@ -0,0 +1,261 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with RASPA.
+ * If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Layout of the shared memory audio tap enabled with raspa_tap_open(),
+ *        and header only reader functions for the processes analyzing it.
+ *        Readers do not need to link with raspa, only with librt on older
+ *        glibc versions.
+ *
+ *        The shared memory holds a RaspaTapHeader followed by num_slots
+ *        slots. Period n of the tap is written to slot n % num_slots, which
+ *        holds a RaspaTapSlot followed by the samples of the tapped input
+ *        channels and then the tapped output channels, non-interleaved, as in
+ *        the process callback buffers. Each slot is protected by a sequence
+ *        number, odd while the rt thread writes it, so any number of readers
+ *        can copy periods without affecting the rt thread.
+ *
+ *        Example:
+ *
+ *        RaspaTap tap;
+ *        raspa_tap_attach(&tap, RASPA_TAP_DEFAULT_NAME);
+ *        float* samples = malloc(raspa_tap_get_period_size(&tap));
+ *        uint64_t period = raspa_tap_get_write_count(&tap);
+ *        while (running)
+ *        {
+ *            int res = raspa_tap_read_period(&tap, period, samples);
+ *            if (res == RASPA_TAP_NOT_READY)
+ *            {
+ *                usleep(1000);
+ *                continue;
+ *            }
+ *            if (res == RASPA_TAP_OVERWRITTEN)
+ *            {
+ *                // too slow, skip to the latest period
+ *                period = raspa_tap_get_write_count(&tap);
+ *                continue;
+ *            }
+ *            analyze(samples);
+ *            period++;
+ *        }
+ *        raspa_tap_detach(&tap);
+ *
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+
+#ifndef RASPA_TAP_H_
+#define RASPA_TAP_H_
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RASPA_TAP_DEFAULT_NAME  "/raspa_tap"
+#define RASPA_TAP_MAGIC         0x50415452  // "RTAP"
+#define RASPA_TAP_VERSION       1
+#define RASPA_TAP_MAX_CHANNELS  64
+#define RASPA_TAP_HEADER_SIZE   4096
+
+// return values of raspa_tap_read_period()
+#define RASPA_TAP_OK            0
+#define RASPA_TAP_NOT_READY     (-1)
+#define RASPA_TAP_OVERWRITTEN   (-2)
+
+/**
+ * @brief Header at the start of the shared memory, padded to
+ *        RASPA_TAP_HEADER_SIZE. Written once before write_count is first
+ *        incremented.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sample_rate;
+    uint32_t buffer_size_in_frames;
+    uint32_t num_input_channels;
+    uint32_t num_output_channels;
+    uint32_t num_slots;
+    uint32_t slot_size_in_bytes;
+    int32_t input_channels[RASPA_TAP_MAX_CHANNELS];   // device channel index of each tapped input
+    int32_t output_channels[RASPA_TAP_MAX_CHANNELS];  // device channel index of each tapped output
+    uint64_t write_count;                             // number of periods written, atomic
+} RaspaTapHeader;
+
+/**
+ * @brief Header of each slot, followed by the samples.
+ */
+typedef struct
+{
+    uint64_t sequence;      // 2 * tap period + 1 while written, 2 * tap period + 2 when complete
+    uint64_t raspa_period;  // period count of raspa, gaps mean the tap was not written
+} RaspaTapSlot;
+
+/**
+ * @brief Reader side handle to an attached tap
+ */
+typedef struct
+{
+    int fd;
+    size_t size;
+    const uint8_t* memory;
+    const RaspaTapHeader* header;
+} RaspaTap;
+
+/**
+ * @brief Get the slot of a tap period.
+ */
+static inline const RaspaTapSlot* raspa_tap_get_slot(const RaspaTap* tap, uint64_t period)
+{
+    uint64_t slot = period % tap->header->num_slots;
+    return (const RaspaTapSlot*) (tap->memory + RASPA_TAP_HEADER_SIZE +
+                                  slot * tap->header->slot_size_in_bytes);
+}
+
+/**
+ * @brief Attach to a tap created by raspa_tap_open().
+ *
+ * @param tap The handle to initialize
+ * @param name Shared memory name, as passed to raspa_tap_open()
+ * @return 0 upon success, -1 if the tap does not exist or is invalid
+ */
+static inline int raspa_tap_attach(RaspaTap* tap, const char* name)
+{
+    struct stat stat_buf;
+    void* memory;
+
+    tap->fd = shm_open(name, O_RDONLY, 0);
+    if (tap->fd < 0)
+    {
+        return -1;
+    }
+
+    if (fstat(tap->fd, &stat_buf) < 0 || (size_t) stat_buf.st_size < RASPA_TAP_HEADER_SIZE)
+    {
+        close(tap->fd);
+        return -1;
+    }
+
+    tap->size = stat_buf.st_size;
+    memory = mmap(NULL, tap->size, PROT_READ, MAP_SHARED, tap->fd, 0);
+    if (memory == MAP_FAILED)
+    {
+        close(tap->fd);
+        return -1;
+    }
+
+    tap->memory = (const uint8_t*) memory;
+    tap->header = (const RaspaTapHeader*) memory;
+    if (tap->header->magic != RASPA_TAP_MAGIC || tap->header->version != RASPA_TAP_VERSION ||
+        RASPA_TAP_HEADER_SIZE + (size_t) tap->header->num_slots * tap->header->slot_size_in_bytes > tap->size)
+    {
+        munmap(memory, tap->size);
+        close(tap->fd);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Detach from the tap.
+ */
+static inline void raspa_tap_detach(RaspaTap* tap)
+{
+    munmap((void*) tap->memory, tap->size);
+    close(tap->fd);
+}
+
+/**
+ * @brief Get the number of periods written so far, i.e. the index of the
+ *        next period.
+ */
+static inline uint64_t raspa_tap_get_write_count(const RaspaTap* tap)
+{
+    return __atomic_load_n(&tap->header->write_count, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Get the size in bytes of the samples of one period.
+ */
+static inline size_t raspa_tap_get_period_size(const RaspaTap* tap)
+{
+    return (size_t) (tap->header->num_input_channels + tap->header->num_output_channels) *
+           tap->header->buffer_size_in_frames * sizeof(float);
+}
+
+/**
+ * @brief Copy the samples of a period, never blocks the rt thread.
+ *
+ * @param tap The tap
+ * @param period The tap period, between write count - num_slots and write
+ *        count - 1 to be available
+ * @param samples Where the samples are copied, raspa_tap_get_period_size()
+ *        bytes. Undefined if the call does not succeed.
+ * @param raspa_period If not NULL, set to the raspa period count of the period
+ * @return RASPA_TAP_OK upon success, RASPA_TAP_NOT_READY if the period is not
+ *         written yet, RASPA_TAP_OVERWRITTEN if it was overwritten by a later
+ *         one before or during the copy.
+ */
+static inline int raspa_tap_read_period_ex(const RaspaTap* tap, uint64_t period,
+                                           float* samples, uint64_t* raspa_period)
+{
+    const RaspaTapSlot* slot = raspa_tap_get_slot(tap, period);
+    uint64_t complete = 2 * period + 2;
+    uint64_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+
+    if (sequence < complete)
+    {
+        return RASPA_TAP_NOT_READY;
+    }
+    if (sequence != complete)
+    {
+        return RASPA_TAP_OVERWRITTEN;
+    }
+
+    memcpy(samples, slot + 1, raspa_tap_get_period_size(tap));
+    if (raspa_period)
+    {
+        *raspa_period = slot->raspa_period;
+    }
+
+    // the copy must be complete before checking the sequence again
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) != complete)
+    {
+        return RASPA_TAP_OVERWRITTEN;
+    }
+
+    return RASPA_TAP_OK;
+}
+
+/**
+ * @brief Same as raspa_tap_read_period_ex() without the raspa period count.
+ */
+static inline int raspa_tap_read_period(const RaspaTap* tap, uint64_t period, float* samples)
+{
+    return raspa_tap_read_period_ex(tap, period, samples, NULL);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RASPA_TAP_H_
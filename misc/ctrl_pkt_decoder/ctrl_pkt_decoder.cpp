@@ -0,0 +1,305 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Decoder of the audio control packet captures recorded with
+ *        RASPA_DEBUG_ENABLE_CTRL_PKT_CAPTURE. Prints the packets, and for
+ *        each direction the share of each packet type, the payload
+ *        utilization, the bandwidth of each type and the gaps in the
+ *        sequence of periods.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+
+#include <getopt.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "raspa_ctrl_pkt_capture.h"
+
+using namespace raspa;
+
+constexpr int NUM_DIRECTIONS = 2;
+
+// Longest gaps listed in the report
+constexpr size_t MAX_LISTED_GAPS = 10;
+
+struct TypeStats
+{
+    int64_t num_pkts{0};
+    int64_t payload_bytes{0};
+};
+
+struct Gap
+{
+    int64_t after_period;
+    int64_t num_periods;
+};
+
+struct DirectionStats
+{
+    TypeStats types[CTRL_PKT_NUM_TYPES];
+    int64_t num_pkts{0};
+    int64_t first_period{-1};
+    int64_t last_period{-1};
+    int64_t num_missing_periods{0};
+    std::vector<Gap> gaps;
+};
+
+struct Options
+{
+    std::string capture_file;
+    bool print_packets{false};
+    int64_t max_printed_packets{-1};
+};
+
+const char* type_name(int type)
+{
+    switch (type)
+    {
+    case CTRL_PKT_INVALID:
+        return "invalid";
+    case CTRL_PKT_DEFAULT:
+        return "default";
+    case CTRL_PKT_GPIO:
+        return "gpio";
+    case CTRL_PKT_MIDI:
+        return "midi";
+    case CTRL_PKT_CEASE:
+        return "cease";
+    default:
+        return "unknown";
+    }
+}
+
+const char* direction_name(int direction)
+{
+    return direction == CTRL_PKT_RX ? "rx" : "tx";
+}
+
+const char* platform_name(uint32_t platform_type)
+{
+    // values of driver_conf::PlatformType
+    switch (platform_type)
+    {
+    case 1:
+        return "native";
+    case 2:
+        return "sync";
+    case 3:
+        return "async";
+    default:
+        return "unknown";
+    }
+}
+
+void print_usage(char* argv[])
+{
+    printf("Decode a raspa audio control packet capture.\n\n");
+    printf("Usage: \n\n");
+    printf("%s OPTIONS <capture file>\n\n", argv[0]);
+    printf("Options:\n");
+    printf("    -h                  : Help for usage options.\n");
+    printf("    -p                  : Print every packet before the summary.\n");
+    printf("    -n <count>          : Print at most count packets.\n\n");
+}
+
+void print_packet(const CtrlPktCaptureRecord& record)
+{
+    printf("%10" PRId64 " %s %-8s %5u  ", record.period, direction_name(record.direction),
+           type_name(record.type), record.payload_bytes);
+    for (auto word : record.header_words)
+    {
+        printf(" %08x", word);
+    }
+    printf("\n");
+}
+
+void account(DirectionStats& stats, const CtrlPktCaptureRecord& record)
+{
+    if (stats.last_period >= 0 && record.period > stats.last_period + 1)
+    {
+        Gap gap = {stats.last_period, record.period - stats.last_period - 1};
+        stats.num_missing_periods += gap.num_periods;
+        stats.gaps.push_back(gap);
+    }
+    if (stats.first_period < 0)
+    {
+        stats.first_period = record.period;
+    }
+    stats.last_period = record.period;
+    stats.num_pkts++;
+
+    int type = record.type;
+    if (type >= CTRL_PKT_NUM_TYPES)
+    {
+        type = CTRL_PKT_INVALID;
+    }
+    stats.types[type].num_pkts++;
+    stats.types[type].payload_bytes += record.payload_bytes;
+}
+
+void print_summary(const DirectionStats& stats, int direction, const CtrlPktCaptureHeader& header)
+{
+    if (stats.num_pkts == 0)
+    {
+        printf("%s: no packets\n\n", direction_name(direction));
+        return;
+    }
+
+    double period_s = static_cast<double>(header.buffer_size_in_frames) / header.sample_rate;
+    double duration_s = (stats.last_period - stats.first_period + 1) * period_s;
+    printf("%s: %" PRId64 " packets, periods %" PRId64 " to %" PRId64 ", %.2f s\n",
+           direction_name(direction), stats.num_pkts, stats.first_period, stats.last_period, duration_s);
+
+    printf("  %-8s %10s %8s %14s %14s\n", "type", "packets", "share", "utilization", "bandwidth B/s");
+    int64_t total_payload_bytes = 0;
+    for (int type = 0; type < CTRL_PKT_NUM_TYPES; type++)
+    {
+        const auto& type_stats = stats.types[type];
+        if (type_stats.num_pkts == 0)
+        {
+            continue;
+        }
+        total_payload_bytes += type_stats.payload_bytes;
+        double utilization = header.payload_capacity_in_bytes > 0 ?
+                             100.0 * type_stats.payload_bytes /
+                             (static_cast<double>(type_stats.num_pkts) * header.payload_capacity_in_bytes) : 0.0;
+        printf("  %-8s %10" PRId64 " %7.2f%% %13.2f%% %14.1f\n",
+               type_name(type), type_stats.num_pkts, 100.0 * type_stats.num_pkts / stats.num_pkts,
+               utilization, type_stats.payload_bytes / duration_s);
+    }
+
+    double capacity_bytes = static_cast<double>(stats.num_pkts) * header.payload_capacity_in_bytes;
+    printf("  payload: %.1f B/s, %.2f%% of the capacity of %.1f B/s\n",
+           total_payload_bytes / duration_s,
+           capacity_bytes > 0 ? 100.0 * total_payload_bytes / capacity_bytes : 0.0,
+           header.payload_capacity_in_bytes / period_s);
+
+    printf("  sequence gaps: %zu, %" PRId64 " periods missing\n", stats.gaps.size(), stats.num_missing_periods);
+    auto gaps = stats.gaps;
+    std::sort(gaps.begin(), gaps.end(), [](const Gap& a, const Gap& b)
+    {
+        return a.num_periods > b.num_periods;
+    });
+    for (size_t i = 0; i < gaps.size() && i < MAX_LISTED_GAPS; i++)
+    {
+        printf("    %" PRId64 " periods missing after period %" PRId64 "\n",
+               gaps[i].num_periods, gaps[i].after_period);
+    }
+    printf("\n");
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    int option = 0;
+
+    while ((option = getopt(argc, argv, "hpn:")) != -1)
+    {
+        switch (option)
+        {
+        case 'p' :
+            options.print_packets = true;
+            break;
+
+        case 'n' :
+            options.print_packets = true;
+            options.max_printed_packets = std::atoll(optarg);
+            break;
+
+        case 'h' :
+        default:
+            print_usage(argv);
+            exit(1);
+            break;
+        }
+    }
+
+    if (optind >= argc)
+    {
+        print_usage(argv);
+        return 1;
+    }
+    options.capture_file = argv[optind];
+
+    std::ifstream stream(options.capture_file, std::ifstream::binary);
+    CtrlPktCaptureHeader header;
+    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        fprintf(stderr, "Error reading %s\n", options.capture_file.c_str());
+        return 1;
+    }
+    if (std::memcmp(header.magic, CTRL_PKT_CAPTURE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != CTRL_PKT_CAPTURE_VERSION || header.sample_rate == 0)
+    {
+        fprintf(stderr, "%s is not a supported control packet capture\n", options.capture_file.c_str());
+        return 1;
+    }
+
+    printf("%s platform, %u frames at %u Hz, packets of %u bytes with %u bytes of payload\n\n",
+           platform_name(header.platform_type), header.buffer_size_in_frames, header.sample_rate,
+           header.pkt_size_in_bytes, header.payload_capacity_in_bytes);
+
+    DirectionStats stats[NUM_DIRECTIONS];
+    int64_t num_overruns = 0;
+    int64_t num_printed = 0;
+    CtrlPktCaptureRecord record;
+    while (stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+    {
+        if (record.period < 0)
+        {
+            num_overruns++;
+            if (options.print_packets)
+            {
+                printf("  -- capture overrun, packets lost --\n");
+            }
+            continue;
+        }
+
+        if (options.print_packets &&
+            (options.max_printed_packets < 0 || num_printed < options.max_printed_packets))
+        {
+            print_packet(record);
+            num_printed++;
+        }
+
+        if (record.direction < NUM_DIRECTIONS)
+        {
+            account(stats[record.direction], record);
+        }
+    }
+    if (options.print_packets)
+    {
+        printf("\n");
+    }
+
+    for (int direction = 0; direction < NUM_DIRECTIONS; direction++)
+    {
+        print_summary(stats[direction], direction, header);
+    }
+    if (num_overruns > 0)
+    {
+        printf("Capture overruns: %" PRId64 ", gaps include packets lost by the capture\n", num_overruns);
+    }
+    return 0;
+}
@@ -0,0 +1,224 @@
+/**
+ * Throughput and latency benchmark of the SPSC queues used between the real
+ * time and the non real time threads: the third party CircularFifo and
+ * raspa::SpscRing, with single element and batched operations.
+ *
+ * Usage: fifo_benchmark [producer cpu] [consumer cpu]
+ *
+ * Pin the threads to two different cores for meaningful latency numbers,
+ * waiting threads yield so the benchmark also completes on a single core.
+ */
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+#include <fifo/circularfifo_memory_relaxed_aquire_release.h>
+
+#include "raspa_spsc_ring.h"
+
+constexpr size_t QUEUE_SIZE = 512;
+constexpr size_t BATCH_SIZE = 8;
+constexpr uint64_t THROUGHPUT_ITEMS = 20000000;
+constexpr int LATENCY_ITERATIONS = 100000;
+
+using CircularFifo = memory_relaxed_aquire_release::CircularFifo<uint64_t, QUEUE_SIZE>;
+using SpscRing = raspa::SpscRing<uint64_t, QUEUE_SIZE>;
+
+static int producer_cpu = -1;
+static int consumer_cpu = -1;
+
+void pin_to_cpu(int cpu)
+{
+    if (cpu < 0)
+    {
+        return;
+    }
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+}
+
+template<typename Fifo>
+size_t push_items(Fifo& fifo, const uint64_t* items, size_t num, bool batch)
+{
+    if constexpr (std::is_same<Fifo, SpscRing>::value)
+    {
+        if (batch)
+        {
+            return fifo.push(items, num);
+        }
+    }
+
+    size_t count = 0;
+    while (count < num && fifo.push(items[count]))
+    {
+        count++;
+    }
+    return count;
+}
+
+template<typename Fifo>
+size_t pop_items(Fifo& fifo, uint64_t* items, size_t max_num, bool batch)
+{
+    if constexpr (std::is_same<Fifo, SpscRing>::value)
+    {
+        if (batch)
+        {
+            return fifo.pop(items, max_num);
+        }
+    }
+
+    size_t count = 0;
+    while (count < max_num && fifo.pop(items[count]))
+    {
+        count++;
+    }
+    return count;
+}
+
+/**
+ * Producer pushes THROUGHPUT_ITEMS sequence numbers, consumer pops and checks
+ * them. Returns millions of items per second.
+ */
+template<typename Fifo>
+double run_throughput(bool batch)
+{
+    auto fifo = std::make_unique<Fifo>();
+    size_t chunk = batch ? BATCH_SIZE : 1;
+    bool order_error = false;
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::thread consumer([&]()
+    {
+        pin_to_cpu(consumer_cpu);
+        uint64_t items[BATCH_SIZE];
+        uint64_t expected = 0;
+        while (expected < THROUGHPUT_ITEMS)
+        {
+            auto count = pop_items(*fifo, items, chunk, batch);
+            if (count == 0)
+            {
+                std::this_thread::yield();
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                order_error |= (items[i] != expected++);
+            }
+        }
+    });
+
+    pin_to_cpu(producer_cpu);
+    uint64_t items[BATCH_SIZE];
+    uint64_t next = 0;
+    while (next < THROUGHPUT_ITEMS)
+    {
+        auto num = std::min<uint64_t>(chunk, THROUGHPUT_ITEMS - next);
+        for (size_t i = 0; i < num; i++)
+        {
+            items[i] = next + i;
+        }
+
+        size_t pushed = 0;
+        while (pushed < num)
+        {
+            auto count = push_items(*fifo, items + pushed, num - pushed, batch);
+            if (count == 0)
+            {
+                std::this_thread::yield();
+            }
+            pushed += count;
+        }
+        next += num;
+    }
+
+    consumer.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (order_error)
+    {
+        std::cout << "Error: items received out of order" << std::endl;
+    }
+    return THROUGHPUT_ITEMS / elapsed.count() / 1e6;
+}
+
+struct Latency
+{
+    int64_t avg_ns;
+    int64_t max_ns;
+};
+
+/**
+ * Ping pong of one element between two threads through two queues. Returns
+ * the round trip time.
+ */
+template<typename Fifo>
+Latency run_latency()
+{
+    auto ping = std::make_unique<Fifo>();
+    auto pong = std::make_unique<Fifo>();
+
+    std::thread echo([&]()
+    {
+        pin_to_cpu(consumer_cpu);
+        uint64_t item = 0;
+        for (int i = 0; i < LATENCY_ITERATIONS; i++)
+        {
+            while (!ping->pop(item)) { std::this_thread::yield(); }
+            while (!pong->push(item)) { std::this_thread::yield(); }
+        }
+    });
+
+    pin_to_cpu(producer_cpu);
+    int64_t max_ns = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < LATENCY_ITERATIONS; i++)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t item = i;
+        while (!ping->push(item)) { std::this_thread::yield(); }
+        while (!pong->pop(item)) { std::this_thread::yield(); }
+        auto round_trip = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::steady_clock::now() - t0).count();
+        max_ns = std::max<int64_t>(max_ns, round_trip);
+    }
+    auto total = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::steady_clock::now() - start).count();
+
+    echo.join();
+    return {total / LATENCY_ITERATIONS, max_ns};
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 2)
+    {
+        producer_cpu = std::atoi(argv[1]);
+        consumer_cpu = std::atoi(argv[2]);
+    }
+
+    std::cout << "Queue size: " << QUEUE_SIZE << ". Batch size: " << BATCH_SIZE << std::endl;
+
+    std::cout << "Throughput (M items/s)" << std::endl;
+    std::cout << "\t CircularFifo:        " << run_throughput<CircularFifo>(false) << std::endl;
+    std::cout << "\t SpscRing:            " << run_throughput<SpscRing>(false) << std::endl;
+    std::cout << "\t CircularFifo x" << BATCH_SIZE << ":     " << run_throughput<CircularFifo>(true) << std::endl;
+    std::cout << "\t SpscRing batch x" << BATCH_SIZE << ": " << run_throughput<SpscRing>(true) << std::endl;
+
+    auto fifo_latency = run_latency<CircularFifo>();
+    auto ring_latency = run_latency<SpscRing>();
+    std::cout << "Round trip latency (ns)" << std::endl;
+    std::cout << "\t CircularFifo: avg " << fifo_latency.avg_ns << ", max " << fifo_latency.max_ns << std::endl;
+    std::cout << "\t SpscRing:     avg " << ring_latency.avg_ns << ", max " << ring_latency.max_ns << std::endl;
+
+    return 0;
+}
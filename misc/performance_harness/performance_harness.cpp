@@ -0,0 +1,726 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Local performance regression harness. Runs raspa_load_test on the
+ *        machine under test for a matrix of buffer sizes, load profiles and
+ *        co-runner stress types, collects the raspa run logs, computes
+ *        processing time percentiles and compares them against a stored
+ *        baseline. Exits with a non-zero code if a regression is detected.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "raspa/raspa.h"
+
+constexpr int RUN_DURATION_NORMAL_S = 600;   // 10 mins run duration for each scenario
+constexpr int RUN_DURATION_QUICK_S = 30;     // 30 seconds run duration for each scenario
+
+// Time given to a co-runner to ramp up before the load test is started
+constexpr std::chrono::seconds CO_RUNNER_SETTLE_TIME(1);
+
+// Time given to a process to exit after being signalled, before it is killed
+constexpr std::chrono::seconds PROCESS_EXIT_TIMEOUT(5);
+constexpr std::chrono::milliseconds PROCESS_POLL_PERIOD(50);
+
+// Default tolerances used when comparing against the baseline
+constexpr float DEFAULT_PERCENTILE_TOLERANCE_PERCENT = 10.0f;
+constexpr float DEFAULT_MAX_TOLERANCE_PERCENT = 50.0f;
+constexpr int64_t DEFAULT_ABS_TOLERANCE_US = 5;
+
+constexpr char DEFAULT_LOAD_TEST_BINARY[] = "raspa_load_test";
+constexpr char STRESS_BINARY[] = "stress-ng";
+constexpr char NO_STRESS_NAME[] = "none";
+constexpr char RESULTS_FILE_NAME[] = "results.txt";
+
+enum ExitCode
+{
+    EXIT_PASS = 0,
+    EXIT_REGRESSION = 1,
+    EXIT_SETUP_ERROR = 2
+};
+
+struct NamedArgs
+{
+    std::string name;
+    std::vector<std::string> args;
+};
+
+struct Scenario
+{
+    std::string name;
+    int buffer_size;
+    std::vector<std::string> load_args;
+    std::vector<std::string> stress_args;
+};
+
+/**
+ * @brief Processing time statistics of a single scenario. All times are in
+ *        microseconds, as logged by raspa.
+ */
+struct Statistics
+{
+    int64_t num_periods = 0;
+    int64_t num_log_overruns = 0;
+    int64_t p50 = 0;
+    int64_t p99 = 0;
+    int64_t p999 = 0;
+    int64_t max = 0;
+};
+
+struct Options
+{
+    std::string scenario_file = "default_scenarios.conf";
+    std::string baseline_file;
+    std::string output_dir = "performance_results";
+    std::string load_test_binary = DEFAULT_LOAD_TEST_BINARY;
+    int run_duration_s = RUN_DURATION_NORMAL_S;
+    float percentile_tolerance = DEFAULT_PERCENTILE_TOLERANCE_PERCENT;
+    float max_tolerance = DEFAULT_MAX_TOLERANCE_PERCENT;
+    int64_t abs_tolerance_us = DEFAULT_ABS_TOLERANCE_US;
+    bool update_baseline = false;
+    bool parse_only = false;
+};
+
+static volatile sig_atomic_t stop_flag = 0;
+
+void sigint_handler(int __attribute__((unused)) sig)
+{
+    stop_flag = 1;
+}
+
+void print_usage(char* argv[])
+{
+    printf("Run a matrix of raspa performance scenarios locally and compare the\n"
+           "results against a stored baseline.\n\n");
+    printf("Usage: \n\n");
+    printf("%s OPTIONS\n\n", argv[0]);
+    printf("Options:\n");
+    printf("    -h                  : Help for usage options.\n");
+    printf("    -s <scenario file>  : Scenario matrix description.\n"
+           "                          Default is default_scenarios.conf.\n");
+    printf("    -b <baseline file>  : Baseline to compare against. Without a\n"
+           "                          baseline the results are only reported.\n");
+    printf("    -u                  : Write the results to the baseline file\n"
+           "                          instead of comparing against it.\n");
+    printf("    -o <output dir>     : Directory where run logs and results are\n"
+           "                          stored. Default is performance_results.\n");
+    printf("    -d <seconds>        : Run duration of each scenario.\n"
+           "                          Default is %d.\n", RUN_DURATION_NORMAL_S);
+    printf("    -q                  : Quick run, same as -d %d.\n", RUN_DURATION_QUICK_S);
+    printf("    -t <percent>        : Allowed increase of p50, p99 and p99.9.\n"
+           "                          Default is %.0f%%.\n", DEFAULT_PERCENTILE_TOLERANCE_PERCENT);
+    printf("    -m <percent>        : Allowed increase of the maximum.\n"
+           "                          Default is %.0f%%.\n", DEFAULT_MAX_TOLERANCE_PERCENT);
+    printf("    -a <microseconds>   : Absolute slack added to every limit.\n"
+           "                          Default is %ld.\n", static_cast<long>(DEFAULT_ABS_TOLERANCE_US));
+    printf("    -l <path>           : Path of the load test binary.\n"
+           "                          Default is %s.\n", DEFAULT_LOAD_TEST_BINARY);
+    printf("    -p                  : Parse the run logs already present in the\n"
+           "                          output directory without running anything.\n\n");
+    printf("Exit code is %d if all scenarios pass, %d on regression and %d on\n"
+           "setup errors.\n\n", EXIT_PASS, EXIT_REGRESSION, EXIT_SETUP_ERROR);
+}
+
+std::vector<std::string> split_args(const std::string& line)
+{
+    std::vector<std::string> args;
+    std::istringstream stream(line);
+    std::string arg;
+    while (stream >> arg)
+    {
+        args.push_back(arg);
+    }
+    return args;
+}
+
+/**
+ * @brief Parse the scenario file and expand it into the full scenario matrix.
+ *
+ * @return true upon success, false otherwise
+ */
+bool parse_scenario_file(const std::string& file_name,
+                         std::vector<Scenario>& scenarios,
+                         int& audio_cpu)
+{
+    std::ifstream file(file_name);
+    if (!file)
+    {
+        fprintf(stderr, "Unable to open scenario file %s\n", file_name.c_str());
+        return false;
+    }
+
+    std::vector<int> buffer_sizes;
+    std::vector<NamedArgs> loads;
+    std::vector<NamedArgs> stresses;
+
+    std::string line;
+    int line_num = 0;
+    while (std::getline(file, line))
+    {
+        line_num++;
+        auto comment = line.find('#');
+        if (comment != std::string::npos)
+        {
+            line.erase(comment);
+        }
+
+        auto tokens = split_args(line);
+        if (tokens.empty())
+        {
+            continue;
+        }
+
+        const auto& keyword = tokens[0];
+        if (keyword == "buffer_sizes" && tokens.size() > 1)
+        {
+            for (size_t i = 1; i < tokens.size(); i++)
+            {
+                buffer_sizes.push_back(std::atoi(tokens[i].c_str()));
+            }
+        }
+        else if (keyword == "cpu" && tokens.size() == 2)
+        {
+            audio_cpu = std::atoi(tokens[1].c_str());
+        }
+        else if ((keyword == "load" && tokens.size() > 2) ||
+                 (keyword == "stress" && tokens.size() > 1))
+        {
+            NamedArgs entry{tokens[1], {tokens.begin() + 2, tokens.end()}};
+            if (keyword == "load")
+            {
+                loads.push_back(entry);
+            }
+            else
+            {
+                stresses.push_back(entry);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "%s:%d: invalid line\n", file_name.c_str(), line_num);
+            return false;
+        }
+    }
+
+    if (buffer_sizes.empty() || loads.empty())
+    {
+        fprintf(stderr, "Scenario file needs at least one buffer size and one load\n");
+        return false;
+    }
+
+    if (stresses.empty())
+    {
+        stresses.push_back({NO_STRESS_NAME, {}});
+    }
+
+    for (auto buffer_size : buffer_sizes)
+    {
+        for (const auto& load : loads)
+        {
+            for (const auto& stress : stresses)
+            {
+                Scenario scenario;
+                scenario.name = load.name + "+" + stress.name + "@" +
+                                std::to_string(buffer_size);
+                scenario.buffer_size = buffer_size;
+                scenario.load_args = load.args;
+                scenario.stress_args = stress.args;
+                scenarios.push_back(scenario);
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Fork and exec a process with its output discarded.
+ *
+ * @return pid of the new process, negative value on failure
+ */
+pid_t spawn_process(const std::vector<std::string>& args)
+{
+    std::vector<char*> argv;
+    for (const auto& arg : args)
+    {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    auto pid = fork();
+    if (pid == 0)
+    {
+        auto dev_null = open("/dev/null", O_WRONLY);
+        if (dev_null >= 0)
+        {
+            dup2(dev_null, STDOUT_FILENO);
+            dup2(dev_null, STDERR_FILENO);
+            close(dev_null);
+        }
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+
+    return pid;
+}
+
+/**
+ * @brief Signal a process and wait for it to exit, killing it if it does not
+ *        exit within PROCESS_EXIT_TIMEOUT.
+ *
+ * @return The exit status of the process as given by waitpid()
+ */
+int stop_process(pid_t pid, int sig)
+{
+    int status = 0;
+    kill(pid, sig);
+
+    auto deadline = std::chrono::steady_clock::now() + PROCESS_EXIT_TIMEOUT;
+    while (waitpid(pid, &status, WNOHANG) == 0)
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            break;
+        }
+        std::this_thread::sleep_for(PROCESS_POLL_PERIOD);
+    }
+
+    return status;
+}
+
+bool copy_file(const std::string& src, const std::string& dst)
+{
+    std::ifstream in(src, std::ios::binary);
+    std::ofstream out(dst, std::ios::binary);
+    if (!in || !out)
+    {
+        return false;
+    }
+    out << in.rdbuf();
+    return static_cast<bool>(out);
+}
+
+std::string run_log_path(const Options& options, const Scenario& scenario)
+{
+    return options.output_dir + "/raspa_" + scenario.name + ".log";
+}
+
+/**
+ * @brief Run a single scenario and store its run log in the output directory.
+ *
+ * @return true upon success, false otherwise
+ */
+bool run_scenario(const Options& options, const Scenario& scenario, int audio_cpu)
+{
+    unlink(RASPA_DEFAULT_RUN_LOG_FILE);
+
+    pid_t stress_pid = -1;
+    if (!scenario.stress_args.empty())
+    {
+        std::vector<std::string> stress_cmd = {STRESS_BINARY};
+        stress_cmd.insert(stress_cmd.end(), scenario.stress_args.begin(),
+                          scenario.stress_args.end());
+        stress_pid = spawn_process(stress_cmd);
+        if (stress_pid < 0)
+        {
+            fprintf(stderr, "Unable to start %s\n", STRESS_BINARY);
+            return false;
+        }
+        std::this_thread::sleep_for(CO_RUNNER_SETTLE_TIME);
+    }
+
+    std::vector<std::string> load_cmd = {options.load_test_binary, "-l",
+                                         "-b", std::to_string(scenario.buffer_size)};
+    if (audio_cpu >= 0)
+    {
+        load_cmd.push_back("-c");
+        load_cmd.push_back(std::to_string(audio_cpu));
+    }
+    load_cmd.insert(load_cmd.end(), scenario.load_args.begin(),
+                    scenario.load_args.end());
+
+    auto load_pid = spawn_process(load_cmd);
+    bool ok = load_pid > 0;
+
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::seconds(options.run_duration_s);
+    while (ok && !stop_flag && std::chrono::steady_clock::now() < deadline)
+    {
+        int status;
+        if (waitpid(load_pid, &status, WNOHANG) == load_pid)
+        {
+            // load test exited by itself: it failed to open the device
+            fprintf(stderr, "%s exited prematurely with status %d\n",
+                    options.load_test_binary.c_str(), WEXITSTATUS(status));
+            load_pid = -1;
+            ok = false;
+        }
+        std::this_thread::sleep_for(PROCESS_POLL_PERIOD);
+    }
+
+    if (load_pid > 0)
+    {
+        stop_process(load_pid, SIGINT);
+    }
+    if (stress_pid > 0)
+    {
+        stop_process(stress_pid, SIGKILL);
+    }
+
+    if (!ok || stop_flag)
+    {
+        return false;
+    }
+
+    if (!copy_file(RASPA_DEFAULT_RUN_LOG_FILE, run_log_path(options, scenario)))
+    {
+        fprintf(stderr, "Raspa run log for %s not found\n", scenario.name.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Parse a raspa run log and compute the processing time statistics.
+ *        The log is a sequence of (start, end) pairs of 64 bit timestamps in
+ *        microseconds, where a (0, 0) pair marks a logger overrun.
+ *
+ * @return true upon success, false otherwise
+ */
+bool compute_statistics(const std::string& log_file, Statistics& stats)
+{
+    std::ifstream file(log_file, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    std::vector<int64_t> durations;
+    int64_t item[2];
+    while (file.read(reinterpret_cast<char*>(item), sizeof(item)))
+    {
+        if (item[0] == 0)
+        {
+            stats.num_log_overruns++;
+            continue;
+        }
+        durations.push_back(item[1] - item[0]);
+    }
+
+    if (durations.empty())
+    {
+        return false;
+    }
+
+    std::sort(durations.begin(), durations.end());
+    auto percentile = [&durations](double p)
+    {
+        auto rank = static_cast<size_t>(p * static_cast<double>(durations.size() - 1) + 0.5);
+        return durations[rank];
+    };
+
+    stats.num_periods = durations.size();
+    stats.p50 = percentile(0.5);
+    stats.p99 = percentile(0.99);
+    stats.p999 = percentile(0.999);
+    stats.max = durations.back();
+    return true;
+}
+
+bool read_baseline(const std::string& file_name, std::map<std::string, Statistics>& baseline)
+{
+    std::ifstream file(file_name);
+    if (!file)
+    {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+        std::istringstream stream(line);
+        std::string name;
+        Statistics stats;
+        if (stream >> name >> stats.p50 >> stats.p99 >> stats.p999 >> stats.max)
+        {
+            baseline[name] = stats;
+        }
+    }
+    return true;
+}
+
+bool write_results(const std::string& file_name,
+                   const std::vector<std::pair<std::string, Statistics>>& results)
+{
+    std::ofstream file(file_name);
+    if (!file)
+    {
+        return false;
+    }
+
+    file << "# scenario p50 p99 p99.9 max (processing time in us)\n";
+    for (const auto& [name, stats] : results)
+    {
+        file << name << " " << stats.p50 << " " << stats.p99 << " "
+             << stats.p999 << " " << stats.max << "\n";
+    }
+    return static_cast<bool>(file);
+}
+
+bool exceeds(int64_t value, int64_t reference, float tolerance_percent, int64_t abs_tolerance)
+{
+    auto limit = static_cast<double>(reference) * (1.0 + tolerance_percent / 100.0) +
+                 static_cast<double>(abs_tolerance);
+    return static_cast<double>(value) > limit;
+}
+
+/**
+ * @brief Compare a scenario result against its baseline and print the
+ *        outcome.
+ *
+ * @return true if the scenario has regressed
+ */
+bool check_regression(const Options& options,
+                      const std::string& name,
+                      const Statistics& stats,
+                      const Statistics& base)
+{
+    struct
+    {
+        const char* label;
+        int64_t value;
+        int64_t reference;
+        float tolerance;
+    } metrics[] = {{"p50", stats.p50, base.p50, options.percentile_tolerance},
+                   {"p99", stats.p99, base.p99, options.percentile_tolerance},
+                   {"p99.9", stats.p999, base.p999, options.percentile_tolerance},
+                   {"max", stats.max, base.max, options.max_tolerance}};
+
+    bool regression = false;
+    for (const auto& metric : metrics)
+    {
+        if (exceeds(metric.value, metric.reference, metric.tolerance, options.abs_tolerance_us))
+        {
+            printf("  REGRESSION %s: %s %ld us, baseline %ld us\n",
+                   name.c_str(), metric.label,
+                   static_cast<long>(metric.value), static_cast<long>(metric.reference));
+            regression = true;
+        }
+    }
+
+    return regression;
+}
+
+void warn_if_not_isolated(int audio_cpu)
+{
+    std::ifstream cmdline_file("/proc/cmdline");
+    std::string cmdline;
+    std::getline(cmdline_file, cmdline);
+    if (audio_cpu >= 0 && cmdline.find("isolcpus") == std::string::npos)
+    {
+        printf("Warning: no isolcpus in kernel cmdline, results may not be comparable.\n");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    int option = 0;
+
+    while ((option = getopt(argc, argv, "hs:b:uo:d:qt:m:a:l:p")) != -1)
+    {
+        switch (option)
+        {
+        case 's' :
+            options.scenario_file = optarg;
+            break;
+
+        case 'b' :
+            options.baseline_file = optarg;
+            break;
+
+        case 'u' :
+            options.update_baseline = true;
+            break;
+
+        case 'o' :
+            options.output_dir = optarg;
+            break;
+
+        case 'd' :
+            options.run_duration_s = std::atoi(optarg);
+            break;
+
+        case 'q' :
+            options.run_duration_s = RUN_DURATION_QUICK_S;
+            break;
+
+        case 't' :
+            options.percentile_tolerance = std::atof(optarg);
+            break;
+
+        case 'm' :
+            options.max_tolerance = std::atof(optarg);
+            break;
+
+        case 'a' :
+            options.abs_tolerance_us = std::atoll(optarg);
+            break;
+
+        case 'l' :
+            options.load_test_binary = optarg;
+            break;
+
+        case 'p' :
+            options.parse_only = true;
+            break;
+
+        case 'h' :
+        default:
+            print_usage(argv);
+            exit(EXIT_SETUP_ERROR);
+            break;
+        }
+    }
+
+    if (options.update_baseline && options.baseline_file.empty())
+    {
+        fprintf(stderr, "-u requires a baseline file (-b)\n");
+        return EXIT_SETUP_ERROR;
+    }
+
+    std::vector<Scenario> scenarios;
+    int audio_cpu = -1;
+    if (!parse_scenario_file(options.scenario_file, scenarios, audio_cpu))
+    {
+        return EXIT_SETUP_ERROR;
+    }
+
+    std::map<std::string, Statistics> baseline;
+    bool compare = !options.baseline_file.empty() && !options.update_baseline;
+    if (compare && !read_baseline(options.baseline_file, baseline))
+    {
+        fprintf(stderr, "Unable to read baseline %s\n", options.baseline_file.c_str());
+        return EXIT_SETUP_ERROR;
+    }
+
+    mkdir(options.output_dir.c_str(), 0755);
+    signal(SIGINT, sigint_handler);
+
+    if (!options.parse_only)
+    {
+        warn_if_not_isolated(audio_cpu);
+    }
+
+    std::vector<std::pair<std::string, Statistics>> results;
+    bool regression = false;
+    int index = 0;
+
+    for (const auto& scenario : scenarios)
+    {
+        index++;
+        if (!options.parse_only)
+        {
+            printf("Running scenario %d of %zu: %s\n", index, scenarios.size(),
+                   scenario.name.c_str());
+            fflush(stdout);
+
+            if (!run_scenario(options, scenario, audio_cpu))
+            {
+                fprintf(stderr, "Scenario %s failed to run\n", scenario.name.c_str());
+                return EXIT_SETUP_ERROR;
+            }
+        }
+
+        Statistics stats;
+        if (!compute_statistics(run_log_path(options, scenario), stats))
+        {
+            fprintf(stderr, "No run data for scenario %s\n", scenario.name.c_str());
+            return EXIT_SETUP_ERROR;
+        }
+
+        printf("  %-40s periods=%ld p50=%ld p99=%ld p99.9=%ld max=%ld us\n",
+               scenario.name.c_str(), static_cast<long>(stats.num_periods),
+               static_cast<long>(stats.p50), static_cast<long>(stats.p99),
+               static_cast<long>(stats.p999), static_cast<long>(stats.max));
+
+        if (stats.num_log_overruns > 0)
+        {
+            // The log lost data, so the percentiles can not be trusted
+            printf("  REGRESSION %s: %ld run log overruns\n", scenario.name.c_str(),
+                   static_cast<long>(stats.num_log_overruns));
+            regression = true;
+        }
+
+        if (compare)
+        {
+            auto base = baseline.find(scenario.name);
+            if (base == baseline.end())
+            {
+                printf("  Warning: no baseline for %s\n", scenario.name.c_str());
+            }
+            else
+            {
+                regression |= check_regression(options, scenario.name, stats, base->second);
+            }
+        }
+
+        results.push_back({scenario.name, stats});
+    }
+
+    write_results(options.output_dir + "/" + RESULTS_FILE_NAME, results);
+
+    if (options.update_baseline)
+    {
+        if (!write_results(options.baseline_file, results))
+        {
+            fprintf(stderr, "Unable to write baseline %s\n", options.baseline_file.c_str());
+            return EXIT_SETUP_ERROR;
+        }
+        printf("Baseline written to %s\n", options.baseline_file.c_str());
+        return EXIT_PASS;
+    }
+
+    printf("%s\n", regression ? "FAIL: performance regression detected" : "PASS");
+    return regression ? EXIT_REGRESSION : EXIT_PASS;
+}
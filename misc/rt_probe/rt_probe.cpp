@@ -0,0 +1,356 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Probe of the rt capabilities of a board and kernel, without the
+ *        audio driver. Runs a timer driven loop at the audio period on a
+ *        thread set up like the raspa rt thread, optionally with load on the
+ *        other cpus, and reports the wakeup latency histogram and the
+ *        smallest buffer size the measured latency leaves room for. The
+ *        interrupt path of the driver is not part of the measurement.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+
+#include <getopt.h>
+#include <signal.h>
+#include <sys/mman.h>
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "driver_config.h"
+#include "raspa_latency_histogram.h"
+#include "raspa_rt_thread.h"
+#include "raspa_sched_deadline.h"
+#include "sample_conversion.h"
+
+using namespace raspa;
+
+constexpr int DEFAULT_BUFFER_SIZE = 64;
+constexpr float DEFAULT_SAMPLE_RATE = 48000.0f;
+constexpr int DEFAULT_DURATION_S = 60;
+
+// raspa pins its rt thread here until the driver reports its irq affinity
+constexpr int DEFAULT_CPU = 0;
+
+// the wakeup latency may take this share of the period, the callback the rest
+constexpr float DEFAULT_MAX_PERIOD_SHARE = 0.25f;
+
+// larger than the caches of the targets, so that the load also evicts the rt thread
+constexpr size_t LOAD_BUFFER_SIZE = 16 * 1024 * 1024;
+
+struct Options
+{
+    int buffer_size{DEFAULT_BUFFER_SIZE};
+    float sample_rate{DEFAULT_SAMPLE_RATE};
+    int cpu{DEFAULT_CPU};
+    int duration_s{DEFAULT_DURATION_S};
+    int num_load_threads{0};
+    float max_period_share{DEFAULT_MAX_PERIOD_SHARE};
+    float deadline_runtime_fraction{0.0f};
+    bool print_histogram{false};
+};
+
+struct ProbeState
+{
+    Options options;
+    int64_t period_ns{0};
+    RaspaLatencyHistogram histogram;
+    int64_t num_missed_periods{0};
+    std::atomic<int> sched_res{0};
+    std::atomic<bool> stop{false};
+};
+
+static std::atomic<bool> stop_flag{false};
+
+void sigint_handler(int /*sig*/)
+{
+    stop_flag = true;
+}
+
+void print_usage(char* argv[])
+{
+    printf("Measure the wakeup latency of a thread set up like the raspa rt thread,\n"
+           "and the smallest buffer size it leaves room for.\n\n");
+    printf("Usage: \n\n");
+    printf("%s OPTIONS\n\n", argv[0]);
+    printf("Options:\n");
+    printf("    -h                    : Help for usage options.\n");
+    printf("    -b <buffer size>      : Buffer size setting the period of the loop.\n"
+           "                            Default is %d.\n", DEFAULT_BUFFER_SIZE);
+    printf("    -r <sample rate>      : Sampling rate in Hz. Default is %.0f.\n", DEFAULT_SAMPLE_RATE);
+    printf("    -c <cpu>              : CPU of the rt thread. Default is %d.\n", DEFAULT_CPU);
+    printf("    -d <duration>         : Duration of the measurement in seconds.\n"
+           "                            Default is %d.\n", DEFAULT_DURATION_S);
+    printf("    -l <num threads>      : Run this many memory bound load threads.\n"
+           "                            Default is 0.\n");
+    printf("    -m <share>            : Share of the period the latency may take.\n"
+           "                            Default is %.2f.\n", DEFAULT_MAX_PERIOD_SHARE);
+    printf("    -D <runtime_fraction> : Run under SCHED_DEADLINE with this share of\n"
+           "                            the period reserved, PREEMPT_RT builds only.\n");
+    printf("    -H                    : Print the latency histogram.\n");
+    printf("    - stop the measurement early with SIGINT\n\n");
+}
+
+void load_thread(ProbeState* state)
+{
+    std::vector<char> buffer(LOAD_BUFFER_SIZE);
+    char value = 0;
+    while (!state->stop)
+    {
+        std::memset(buffer.data(), value++, buffer.size());
+        std::memmove(buffer.data(), buffer.data() + buffer.size() / 2, buffer.size() / 2);
+    }
+}
+
+void* probe_thread(void* data)
+{
+    auto state = static_cast<ProbeState*>(data);
+
+#ifdef RASPA_WITH_EVL
+    auto res = attach_rt_thread("raspa_rt_probe");
+    if (res < 0)
+    {
+        state->sched_res = -res;
+        return nullptr;
+    }
+#endif
+#ifdef RASPA_WITH_PREEMPT_RT
+    if (state->options.deadline_runtime_fraction > 0.0f)
+    {
+        state->sched_res = set_thread_sched_deadline(get_sched_deadline_params(state->options.deadline_runtime_fraction,
+                                                                               state->period_ns));
+        if (state->sched_res != 0)
+        {
+            return nullptr;
+        }
+    }
+#endif
+
+    auto next_wakeup = get_rt_time_ns() + state->period_ns;
+    while (!state->stop)
+    {
+        sleep_rt_until_ns(next_wakeup);
+        auto now = get_rt_time_ns();
+        auto latency_ns = now - next_wakeup;
+        state->histogram.add(latency_ns);
+
+        next_wakeup += state->period_ns;
+        while (next_wakeup <= now)
+        {
+            next_wakeup += state->period_ns;
+            state->num_missed_periods++;
+        }
+    }
+    return nullptr;
+}
+
+void print_histogram(const RaspaLatencyHistogram& histogram)
+{
+    printf("%8s %12s\n", "us", "count");
+    for (int bin = 0; bin < LATENCY_HISTOGRAM_NUM_BINS; bin++)
+    {
+        if (histogram.get_bin(bin) > 0)
+        {
+            printf("%8d %12" PRId64 "\n", bin, histogram.get_bin(bin));
+        }
+    }
+    if (histogram.get_overflows() > 0)
+    {
+        printf("%7d+ %12" PRId64 "\n", LATENCY_HISTOGRAM_NUM_BINS, histogram.get_overflows());
+    }
+    printf("\n");
+}
+
+void print_report(const ProbeState& state)
+{
+    const auto& options = state.options;
+    const auto& histogram = state.histogram;
+    auto max_us = histogram.get_max_us();
+
+    printf("%" PRId64 " periods of %.1f us on cpu %d, %d load threads\n",
+           histogram.get_count(), state.period_ns / 1000.0, options.cpu, options.num_load_threads);
+    printf("wakeup latency: mean %" PRId64 " us, p99 %" PRId64 " us, p99.9 %" PRId64 " us, max %" PRId64 " us\n",
+           histogram.get_mean_us(), histogram.get_percentile_us(99.0), histogram.get_percentile_us(99.9), max_us);
+    printf("missed periods: %" PRId64 "\n\n", state.num_missed_periods);
+
+    std::vector<int> buffer_sizes(std::begin(SUPPORTED_BUFFER_SIZES), std::end(SUPPORTED_BUFFER_SIZES));
+    printf("%8s %12s %14s\n", "frames", "period us", "latency share");
+    for (auto size : buffer_sizes)
+    {
+        double period_us = size * 1000000.0 / options.sample_rate;
+        double share = max_us / period_us;
+        printf("%8d %12.1f %13.1f%%%s\n", size, period_us, 100.0 * share,
+               share <= options.max_period_share ? "" : "  unsafe");
+    }
+    printf("\n");
+
+    auto safe_size = get_smallest_safe_buffer_size(buffer_sizes, options.sample_rate, max_us,
+                                                   options.max_period_share);
+    if (safe_size == 0)
+    {
+        printf("No supported buffer size is safe, the max latency takes more than %.0f%% of every period.\n",
+               100.0 * options.max_period_share);
+    }
+    else
+    {
+        printf("Smallest safe buffer size: %d frames at %.0f Hz\n", safe_size, options.sample_rate);
+        if (safe_size < options.buffer_size)
+        {
+            printf("Measured with a longer period, confirm with -b %d.\n", safe_size);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    ProbeState state;
+    auto& options = state.options;
+    int option = 0;
+
+    while ((option = getopt(argc, argv, "hb:r:c:d:l:m:D:H")) != -1)
+    {
+        switch (option)
+        {
+        case 'b' :
+            options.buffer_size = std::atoi(optarg);
+            break;
+
+        case 'r' :
+            options.sample_rate = std::atof(optarg);
+            break;
+
+        case 'c' :
+            options.cpu = std::atoi(optarg);
+            break;
+
+        case 'd' :
+            options.duration_s = std::atoi(optarg);
+            break;
+
+        case 'l' :
+            options.num_load_threads = std::atoi(optarg);
+            break;
+
+        case 'm' :
+            options.max_period_share = std::atof(optarg);
+            break;
+
+        case 'D' :
+            options.deadline_runtime_fraction = std::atof(optarg);
+            break;
+
+        case 'H' :
+            options.print_histogram = true;
+            break;
+
+        case 'h' :
+        default:
+            print_usage(argv);
+            exit(1);
+            break;
+        }
+    }
+
+    if (options.buffer_size <= 0 || options.sample_rate <= 0.0f || options.duration_s <= 0)
+    {
+        print_usage(argv);
+        return 1;
+    }
+#ifdef RASPA_WITH_PREEMPT_RT
+    if (options.deadline_runtime_fraction != 0.0f && !is_valid_runtime_fraction(options.deadline_runtime_fraction))
+    {
+        fprintf(stderr, "The runtime fraction must be in (0, 1]\n");
+        return 1;
+    }
+#else
+    if (options.deadline_runtime_fraction != 0.0f)
+    {
+        fprintf(stderr, "SCHED_DEADLINE needs a build with RASPA_WITH_PREEMPT_RT\n");
+        return 1;
+    }
+#endif
+    state.period_ns = static_cast<int64_t>(options.buffer_size * 1000000000.0 / options.sample_rate);
+
+    signal(SIGINT, sigint_handler);
+
+    init_rt_core();
+#ifndef RASPA_WITH_EVL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0)
+    {
+        fprintf(stderr, "Error locking memory: %s\n", strerror(errno));
+        return 1;
+    }
+#endif
+
+    std::vector<std::thread> load_threads;
+    for (int i = 0; i < options.num_load_threads; i++)
+    {
+        load_threads.emplace_back(load_thread, &state);
+    }
+
+    // same attributes as the raspa rt thread, a deadline thread must span its root domain
+    pthread_attr_t task_attributes;
+    auto res = init_rt_thread_attributes(&task_attributes,
+                                         RASPA_PROCESSING_TASK_PRIO,
+                                         options.deadline_runtime_fraction == 0.0f ? options.cpu : -1);
+    pthread_t probe_task;
+    if (res == 0)
+    {
+        res = __RASPA(pthread_create(&probe_task, &task_attributes, &probe_thread, &state));
+    }
+    pthread_attr_destroy(&task_attributes);
+    if (res != 0)
+    {
+        fprintf(stderr, "Error creating the rt thread: %s\n", strerror(res));
+        state.stop = true;
+        for (auto& thread : load_threads)
+        {
+            thread.join();
+        }
+        return 1;
+    }
+
+    for (int i = 0; i < options.duration_s && !stop_flag && state.sched_res == 0; i++)
+    {
+        sleep(1);
+    }
+    state.stop = true;
+    __RASPA(pthread_join(probe_task, nullptr));
+    for (auto& thread : load_threads)
+    {
+        thread.join();
+    }
+
+    if (state.sched_res != 0)
+    {
+        fprintf(stderr, "Error setting up the rt thread: %s\n", strerror(state.sched_res));
+        return 1;
+    }
+
+    if (options.print_histogram)
+    {
+        print_histogram(state.histogram);
+    }
+    print_report(state);
+    return 0;
+}
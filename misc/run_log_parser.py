@@ -1,6 +1,7 @@
 import argparse
 import csv
 #import json
+from bisect import bisect_left
 from struct import iter_unpack
 
 def average(lst):
@@ -16,6 +17,9 @@ parser.add_argument('--csv', help='Export CSV data')
 parser.add_argument('--label', help='Plot label')
 parser.add_argument('--pdf', help='Export plot to PDF')
 parser.add_argument('--plot', help='Plot histogram to screen', action='store_true')
+parser.add_argument('--graph', help='Processing graph node file, by default the run log file name followed by .graph')
+parser.add_argument('--sys', help='System state samples file, by default the run log file name followed by .sys')
+parser.add_argument('--spikes', help='Number of longest periods to correlate with the system state', type=int, default=10)
 
 args = parser.parse_args()
 
@@ -46,6 +50,66 @@ t_avg=round(average(duration))
 
 print('Execution time: min=' + str(t_min) + ' max=' + str(t_max) + ' avg=' + str(round(t_avg)))
 
+# processing graph node timings, if raspa_graph_process() was used
+graph_filename = args.graph if args.graph else filename + '.graph'
+try:
+    with open(graph_filename, 'rb') as fp:
+        graph_bindata = fp.read()
+except FileNotFoundError:
+    graph_bindata = None
+
+if graph_bindata:
+    nodes = {}
+    for fields in iter_unpack('<qiiqq', graph_bindata):
+        period, node, worker, start, end = fields
+        if node < 0:
+            print('Graph log underrun detected at period ' + str(period) + ': data may not be reliable!')
+            continue
+        stats = nodes.setdefault(node, { 'duration': [], 'workers': set() })
+        stats['duration'].append(end - start)
+        stats['workers'].add(worker)
+
+    print('Graph node execution time in ns:')
+    for node in sorted(nodes):
+        node_duration = nodes[node]['duration']
+        print('  node ' + str(node) + ': min=' + str(min(node_duration)) + ' max=' + str(max(node_duration)) +
+              ' avg=' + str(round(average(node_duration))) + ' workers=' + str(sorted(nodes[node]['workers'])))
+
+# system state samples, correlated with the longest periods
+sys_filename = args.sys if args.sys else filename + '.sys'
+try:
+    with open(sys_filename, 'rb') as fp:
+        sys_bindata = fp.read()
+except FileNotFoundError:
+    sys_bindata = None
+
+if sys_bindata:
+    samples = list(iter_unpack('<qqqqiiq', sys_bindata))
+    sample_times = [sample[0] for sample in samples]
+
+    def delta(before, after, field):
+        if before[field] < 0 or after[field] < 0:
+            return 'n/a'
+        return str(after[field] - before[field])
+
+    print('System state around the ' + str(args.spikes) + ' longest periods:')
+    spikes = sorted(range(len(duration)), key=lambda i: duration[i], reverse=True)[:args.spikes]
+    for i in sorted(spikes):
+        start = data['start'][i]
+        after_index = bisect_left(sample_times, data['end'][i])
+        before_index = bisect_left(sample_times, start) - 1
+        if before_index < 0 or after_index >= len(samples):
+            continue
+        before = samples[before_index]
+        after = samples[after_index]
+        print('  period at ' + str(start) + ' us, ' + str(duration[i]) + ' us:' +
+              ' minor faults +' + delta(before, after, 1) +
+              ' major faults +' + delta(before, after, 2) +
+              ' interrupts +' + delta(before, after, 3) +
+              ' freq ' + str(before[4]) + '->' + str(after[4]) + ' kHz' +
+              ' temp ' + str(after[5] / 1000) + ' C' +
+              ' throttling +' + delta(before, after, 6))
+
 if args.csv:
     csv_columns=['start', 'end', 'duration']
     with open(args.csv, 'w') as csvfile:
@@ -0,0 +1,526 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Offline tuning tool for the delay error filter of sync platforms.
+ *        Reads a servo trace recorded with RASPA_DEBUG_ENABLE_SERVO_TRACE,
+ *        recovers the clock offset the servo was working against by adding
+ *        back the corrections it applied, and runs that offset through other
+ *        filter designs and settings in closed loop. Reports lock time,
+ *        residual jitter and correction effort of each.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+
+#include <getopt.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "raspa_delay_error_filter.h"
+#include "raspa_servo_trace.h"
+
+using namespace raspa;
+
+// Default error below which the servo is considered locked
+constexpr double DEFAULT_LOCK_THRESHOLD_NS = 1000.0;
+
+// Default number of periods between a correction and the first error it shows in
+constexpr int DEFAULT_ACTUATION_LATENCY = 1;
+
+// The error is averaged over windows of this many periods for the lock
+// detection, so that single jitter spikes do not count as loss of lock
+constexpr int LOCK_WINDOW_PERIODS = 64;
+
+enum class Design
+{
+    BIQUAD,     // second order low pass, as in RaspaDelayErrorFilter
+    ONE_POLE,   // first order low pass
+    PI          // proportional integral controller
+};
+
+struct Candidate
+{
+    Design design;
+    int t60_in_periods;
+    int downsample_rate;
+};
+
+struct Result
+{
+    bool locked;
+    int64_t lock_period;
+    double residual_rms_ns;
+    double residual_max_ns;
+    double effort_ns_per_s;
+    int64_t num_corrections;
+};
+
+struct Options
+{
+    std::string trace_file;
+    std::vector<int> t60_list;
+    std::vector<int> downsample_list;
+    std::vector<Design> designs{Design::BIQUAD, Design::ONE_POLE, Design::PI};
+    double lock_threshold_ns{DEFAULT_LOCK_THRESHOLD_NS};
+    int latency{DEFAULT_ACTUATION_LATENCY};
+};
+
+/**
+ * @brief Filter design interface, ticked once per period with the timing error.
+ */
+class Controller
+{
+public:
+    virtual ~Controller() = default;
+    virtual double tick(double error_ns) = 0;
+};
+
+class BiquadController : public Controller
+{
+public:
+    explicit BiquadController(int t60_in_periods) : _filter(t60_in_periods)
+    {}
+
+    double tick(double error_ns) override
+    {
+        return _filter.delay_error_filter_tick(static_cast<int>(lrint(error_ns)));
+    }
+
+private:
+    RaspaDelayErrorFilter _filter;
+};
+
+class OnePoleController : public Controller
+{
+public:
+    explicit OnePoleController(int t60_in_periods)
+    {
+        _coeff = 1.0 - std::exp(-std::log(1000.0) / t60_in_periods);
+    }
+
+    double tick(double error_ns) override
+    {
+        _state += _coeff * (error_ns - _state);
+        return _state;
+    }
+
+private:
+    double _coeff;
+    double _state{0.0};
+};
+
+/**
+ * @brief PI controller on the downsampled error. The clock offset integrates
+ *        the corrections, so the proportional term alone settles with time
+ *        constant t60 / ln(1000) and the integral term removes the offset
+ *        left by a constant frequency error. Gains are for critical damping.
+ */
+class PiController : public Controller
+{
+public:
+    PiController(int t60_in_periods, int downsample_rate) : _downsample_rate(downsample_rate)
+    {
+        double bandwidth = std::min(1.0, std::log(1000.0) * downsample_rate / t60_in_periods);
+        _kp = bandwidth;
+        _ki = 0.25 * bandwidth * bandwidth;
+    }
+
+    double tick(double error_ns) override
+    {
+        // only the value seen at the downsampled periods is applied
+        if (++_count < _downsample_rate)
+        {
+            return 0.0;
+        }
+        _count = 0;
+        _integral += _ki * error_ns;
+        return _kp * error_ns + _integral;
+    }
+
+private:
+    int _downsample_rate;
+    int _count{0};
+    double _kp;
+    double _ki;
+    double _integral{0.0};
+};
+
+const char* design_name(Design design)
+{
+    switch (design)
+    {
+    case Design::BIQUAD:
+        return "biquad";
+    case Design::ONE_POLE:
+        return "onepole";
+    case Design::PI:
+        return "pi";
+    }
+    return "";
+}
+
+std::unique_ptr<Controller> make_controller(const Candidate& candidate)
+{
+    switch (candidate.design)
+    {
+    case Design::ONE_POLE:
+        return std::make_unique<OnePoleController>(candidate.t60_in_periods);
+    case Design::PI:
+        return std::make_unique<PiController>(candidate.t60_in_periods, candidate.downsample_rate);
+    case Design::BIQUAD:
+    default:
+        return std::make_unique<BiquadController>(candidate.t60_in_periods);
+    }
+}
+
+void print_usage(char* argv[])
+{
+    printf("Replay a raspa servo trace through delay error filter designs and\n"
+           "report lock time, residual jitter and correction effort.\n\n");
+    printf("Usage: \n\n");
+    printf("%s OPTIONS <trace file>\n\n", argv[0]);
+    printf("Options:\n");
+    printf("    -h                  : Help for usage options.\n");
+    printf("    -t <list>           : Comma separated t60 values in periods.\n"
+           "                          Default is the recorded one, halved and doubled.\n");
+    printf("    -r <list>           : Comma separated downsample rates.\n"
+           "                          Default is the recorded one, 1 and 4.\n");
+    printf("    -d <list>           : Comma separated designs among biquad,\n"
+           "                          onepole and pi. Default is all.\n");
+    printf("    -l <ns>             : Mean error over %d periods below which the\n"
+           "                          servo is locked.\n", LOCK_WINDOW_PERIODS);
+    printf("                          Default is %.0f.\n", DEFAULT_LOCK_THRESHOLD_NS);
+    printf("    -a <periods>        : Periods between a correction and the first\n"
+           "                          error it affects. Default is %d.\n\n", DEFAULT_ACTUATION_LATENCY);
+    printf("The recorded setting is marked with *. Its replay must reproduce\n"
+           "the recorded corrections, or the trace is not self consistent.\n\n");
+}
+
+std::vector<std::string> split_list(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::istringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        if (!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+std::vector<int> parse_int_list(const std::string& list)
+{
+    std::vector<int> values;
+    for (const auto& item : split_list(list))
+    {
+        int value = std::atoi(item.c_str());
+        if (value > 0)
+        {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+bool parse_design_list(const std::string& list, std::vector<Design>& designs)
+{
+    designs.clear();
+    for (const auto& item : split_list(list))
+    {
+        if (item == "biquad")
+        {
+            designs.push_back(Design::BIQUAD);
+        }
+        else if (item == "onepole")
+        {
+            designs.push_back(Design::ONE_POLE);
+        }
+        else if (item == "pi")
+        {
+            designs.push_back(Design::PI);
+        }
+        else
+        {
+            fprintf(stderr, "Unknown design %s\n", item.c_str());
+            return false;
+        }
+    }
+    return !designs.empty();
+}
+
+/**
+ * @brief Read the header and the records up to the first gap, as the offset
+ *        can't be recovered across lost records.
+ */
+bool read_trace(const std::string& file_name, ServoTraceHeader& header, std::vector<ServoTraceRecord>& records)
+{
+    std::ifstream stream(file_name, std::ifstream::binary);
+    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        fprintf(stderr, "Error reading %s\n", file_name.c_str());
+        return false;
+    }
+    if (std::memcmp(header.magic, SERVO_TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SERVO_TRACE_VERSION)
+    {
+        fprintf(stderr, "%s is not a supported servo trace\n", file_name.c_str());
+        return false;
+    }
+
+    ServoTraceRecord record;
+    while (stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+    {
+        if (!records.empty() && record.period != records.back().period + 1)
+        {
+            fprintf(stderr, "Records lost after period %ld, using the %zu periods before\n",
+                    static_cast<long>(records.back().period), records.size());
+            break;
+        }
+        records.push_back(record);
+    }
+
+    if (records.empty() || header.sample_rate == 0 || header.buffer_size_in_frames == 0)
+    {
+        fprintf(stderr, "%s has no usable records\n", file_name.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Recover the offset the servo worked against, i.e. the error that
+ *        would have been measured without any correction.
+ */
+std::vector<double> recover_offset(const std::vector<ServoTraceRecord>& records, int latency)
+{
+    std::vector<double> offset(records.size());
+    double applied = 0.0;
+    for (size_t n = 0; n < records.size(); n++)
+    {
+        if (n >= static_cast<size_t>(latency))
+        {
+            applied += records[n - latency].correction_ns;
+        }
+        offset[n] = records[n].timing_error_ns + applied;
+    }
+    return offset;
+}
+
+/**
+ * @brief Run the offset through a candidate in closed loop.
+ * @param corrections Filled with the correction of each period
+ */
+Result simulate(const std::vector<double>& offset,
+                const Candidate& candidate,
+                const Options& options,
+                double period_s,
+                std::vector<double>& corrections)
+{
+    auto controller = make_controller(candidate);
+    std::vector<double> error(offset.size());
+    corrections.assign(offset.size(), 0.0);
+
+    // the low pass designs are ticked every period and applied when downsampled
+    bool downsample_output = candidate.design != Design::PI;
+    int count = 0;
+    double applied = 0.0;
+    Result result = {};
+
+    for (size_t n = 0; n < offset.size(); n++)
+    {
+        if (n >= static_cast<size_t>(options.latency))
+        {
+            applied += corrections[n - options.latency];
+        }
+        error[n] = offset[n] - applied;
+
+        // the driver takes an integer number of ns
+        double correction = std::round(controller->tick(error[n]));
+        if (downsample_output && ++count < candidate.downsample_rate)
+        {
+            correction = 0.0;
+        }
+        else
+        {
+            count = 0;
+        }
+        corrections[n] = correction;
+
+        if (correction != 0.0)
+        {
+            result.num_corrections++;
+            result.effort_ns_per_s += std::abs(correction);
+        }
+    }
+    result.effort_ns_per_s /= offset.size() * period_s;
+
+    // locked from the window after the last one with a mean error above the threshold
+    int64_t lock_period = 0;
+    for (size_t window = 0; window + LOCK_WINDOW_PERIODS <= error.size(); window += LOCK_WINDOW_PERIODS)
+    {
+        double mean = 0.0;
+        for (size_t n = window; n < window + LOCK_WINDOW_PERIODS; n++)
+        {
+            mean += std::abs(error[n]) / LOCK_WINDOW_PERIODS;
+        }
+        if (mean >= options.lock_threshold_ns)
+        {
+            lock_period = static_cast<int64_t>(window) + LOCK_WINDOW_PERIODS;
+        }
+    }
+    result.locked = lock_period + LOCK_WINDOW_PERIODS <= static_cast<int64_t>(error.size());
+    result.lock_period = lock_period;
+
+    // without lock, the second half gives an idea of the residual
+    size_t start = result.locked ? static_cast<size_t>(lock_period) : error.size() / 2;
+    double sum = 0.0;
+    for (size_t n = start; n < error.size(); n++)
+    {
+        sum += error[n] * error[n];
+        result.residual_max_ns = std::max(result.residual_max_ns, std::abs(error[n]));
+    }
+    result.residual_rms_ns = std::sqrt(sum / std::max<size_t>(1, error.size() - start));
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    int option = 0;
+
+    while ((option = getopt(argc, argv, "ht:r:d:l:a:")) != -1)
+    {
+        switch (option)
+        {
+        case 't' :
+            options.t60_list = parse_int_list(optarg);
+            break;
+
+        case 'r' :
+            options.downsample_list = parse_int_list(optarg);
+            break;
+
+        case 'd' :
+            if (!parse_design_list(optarg, options.designs))
+            {
+                return 1;
+            }
+            break;
+
+        case 'l' :
+            options.lock_threshold_ns = std::atof(optarg);
+            break;
+
+        case 'a' :
+            options.latency = std::max(0, std::atoi(optarg));
+            break;
+
+        case 'h' :
+        default:
+            print_usage(argv);
+            exit(1);
+            break;
+        }
+    }
+
+    if (optind >= argc)
+    {
+        print_usage(argv);
+        return 1;
+    }
+    options.trace_file = argv[optind];
+
+    ServoTraceHeader header;
+    std::vector<ServoTraceRecord> records;
+    if (!read_trace(options.trace_file, header, records))
+    {
+        return 1;
+    }
+
+    int recorded_t60 = static_cast<int>(header.t60_in_periods);
+    int recorded_rate = static_cast<int>(header.downsample_rate);
+    if (options.t60_list.empty())
+    {
+        options.t60_list = {std::max(1, recorded_t60 / 2), recorded_t60, recorded_t60 * 2};
+    }
+    if (options.downsample_list.empty())
+    {
+        options.downsample_list = {1, 4};
+        if (recorded_rate != 1 && recorded_rate != 4)
+        {
+            options.downsample_list.push_back(recorded_rate);
+        }
+    }
+
+    double period_s = static_cast<double>(header.buffer_size_in_frames) / header.sample_rate;
+    auto offset = recover_offset(records, options.latency);
+
+    printf("%zu periods of %.1f us, recorded filter: biquad, t60 %d, downsample %d\n\n",
+           records.size(), period_s * 1e6, recorded_t60, recorded_rate);
+
+    // the recorded setting must give back the recorded corrections
+    std::vector<double> corrections;
+    simulate(offset, {Design::BIQUAD, recorded_t60, recorded_rate}, options, period_s, corrections);
+    size_t num_mismatches = 0;
+    for (size_t n = 0; n < records.size(); n++)
+    {
+        num_mismatches += corrections[n] != records[n].correction_ns;
+    }
+    if (num_mismatches > 0)
+    {
+        printf("Warning: replay of the recorded setting differs in %zu periods, the trace\n"
+               "does not start with the session or the latency (-a) is wrong.\n\n", num_mismatches);
+    }
+
+    printf("  %-8s %6s %6s %10s %12s %12s %14s\n",
+           "design", "t60", "rate", "lock ms", "jitter ns", "max err ns", "effort ns/s");
+    for (auto design : options.designs)
+    {
+        for (auto t60 : options.t60_list)
+        {
+            for (auto rate : options.downsample_list)
+            {
+                Candidate candidate = {design, t60, rate};
+                auto result = simulate(offset, candidate, options, period_s, corrections);
+                bool recorded = design == Design::BIQUAD && t60 == recorded_t60 && rate == recorded_rate;
+
+                char lock_time[32];
+                if (result.locked)
+                {
+                    snprintf(lock_time, sizeof(lock_time), "%.1f", result.lock_period * period_s * 1e3);
+                }
+                else
+                {
+                    snprintf(lock_time, sizeof(lock_time), "no lock");
+                }
+                printf("%c %-8s %6d %6d %10s %12.1f %12.1f %14.1f\n",
+                       recorded ? '*' : ' ', design_name(design), t60, rate, lock_time,
+                       result.residual_rms_ns, result.residual_max_ns, result.effort_ns_per_s);
+            }
+        }
+    }
+    return 0;
+}
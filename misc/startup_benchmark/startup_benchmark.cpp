@@ -0,0 +1,84 @@
+/**
+ * Benchmark of the driver parameter queries done by raspa_open(): one sysfs
+ * read per parameter, as with older drivers, against a single read of the
+ * binary capabilities attribute. Run it on the target with the driver loaded.
+ *
+ * Usage: startup_benchmark [iterations]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "driver_config.h"
+
+constexpr int DEFAULT_ITERATIONS = 1000;
+
+struct Timing
+{
+    double avg_us;
+    double max_us;
+};
+
+template<typename Function>
+Timing run_benchmark(Function function, int iterations)
+{
+    double max_us = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - t0;
+        max_us = std::max(max_us, elapsed.count());
+    }
+    std::chrono::duration<double, std::micro> total = std::chrono::steady_clock::now() - start;
+    return {total.count() / iterations, max_us};
+}
+
+void print_capabilities(const driver_conf::DriverCapabilities& caps)
+{
+    std::cout << "\t version:         " << caps.ver_maj << "." << caps.ver_min << std::endl;
+    std::cout << "\t sample rate:     " << caps.sample_rate << std::endl;
+    std::cout << "\t channels in/out: " << caps.num_input_chans << "/" << caps.num_output_chans << std::endl;
+    std::cout << "\t platform type:   " << caps.platform_type << std::endl;
+    std::cout << "\t usb audio type:  " << caps.usb_audio_type << std::endl;
+    std::cout << "\t irq affinity:    " << caps.irq_affinity << std::endl;
+    std::cout << "\t buffer size:     " << caps.buffer_size << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    int iterations = DEFAULT_ITERATIONS;
+    if (argc > 1)
+    {
+        iterations = std::max(1, std::atoi(argv[1]));
+    }
+
+    driver_conf::DriverCapabilities caps;
+    driver_conf::read_driver_capabilities_per_param(caps);
+    if (caps.ver_maj < 0)
+    {
+        std::cout << "Error: unable to read the driver parameters from " << driver_conf::PARAM_ROOT_PATH << std::endl;
+        return 1;
+    }
+
+    std::cout << "Driver parameters" << std::endl;
+    print_capabilities(caps);
+
+    auto per_param = run_benchmark([&]() { driver_conf::read_driver_capabilities_per_param(caps); }, iterations);
+    std::cout << "Per parameter reads (us): avg " << per_param.avg_us << ", max " << per_param.max_us << std::endl;
+
+    if (!driver_conf::read_driver_capabilities_binary(caps))
+    {
+        std::cout << "Capabilities attribute not supported by the driver, raspa_open() uses the per parameter reads"
+                  << std::endl;
+        return 0;
+    }
+
+    auto binary = run_benchmark([&]() { driver_conf::read_driver_capabilities_binary(caps); }, iterations);
+    std::cout << "Capabilities read (us):   avg " << binary.avg_us << ", max " << binary.max_us << std::endl;
+    std::cout << "Speedup: " << per_param.avg_us / binary.avg_us << "x" << std::endl;
+
+    return 0;
+}
@@ -25,7 +25,13 @@
 
 #include <fcntl.h>
 
+#include <unistd.h>
+
 #include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 #include <utility>
 
@@ -59,15 +65,19 @@ constexpr int REQUIRED_MIN_VER = 1;
 /**
  * device paths
  */
-#ifdef RASPA_WITH_EVL
+#if defined(RASPA_WITH_EVL)
 constexpr char DEVICE_NAME[] = "/dev/audio_evl";
+#elif defined(RASPA_WITH_PREEMPT_RT)
+constexpr char DEVICE_NAME[] = "/dev/audio_rt";
 #else
 constexpr char DEVICE_NAME[] = "/dev/rtdm/audio_rtdm";
 #endif
 
 // Driver parameter definitions
-#ifdef RASPA_WITH_EVL
+#if defined(RASPA_WITH_EVL)
 constexpr char PARAM_ROOT_PATH[] = "/sys/class/audio_evl/";
+#elif defined(RASPA_WITH_PREEMPT_RT)
+constexpr char PARAM_ROOT_PATH[] = "/sys/class/audio_rt/";
 #else
 constexpr char PARAM_ROOT_PATH[] = "/sys/class/audio_rtdm/";
 #endif
@@ -82,6 +92,10 @@ constexpr char MAJ_VER_PARAM[] = "audio_ver_maj";
 constexpr char MIN_VER_PARAM[] = "audio_ver_min";
 constexpr char USB_AUDIO_TYPE_PARAM[] = "usb_audio_type";
 constexpr char IRQ_AFFINITY[] = "audio_irq_affinity";
+constexpr char CAPABILITIES_PARAM[] = "audio_capabilities";
+
+// Max size of the binary capabilities attribute, newer drivers can append fields
+constexpr size_t CAPABILITIES_MAX_SIZE = 256;
 
 /**
  * @brief Enumeration to denote various codec sample formats
@@ -166,6 +180,27 @@ enum class UsbAudioType : int
     EXTERNAL_UC
 };
 
+/**
+ * @brief All the driver parameters needed by raspa_open(), as returned by the
+ *        binary sysfs attribute CAPABILITIES_PARAM. The driver fills size with
+ *        the size of its own struct, fields are only appended in later
+ *        versions. When read with the per parameter fallback, each field holds
+ *        the value or the negative error of its own sysfs file.
+ */
+struct DriverCapabilities
+{
+    uint32_t size;
+    int32_t ver_maj;
+    int32_t ver_min;
+    int32_t sample_rate;
+    int32_t num_input_chans;
+    int32_t num_output_chans;
+    int32_t platform_type;
+    int32_t usb_audio_type;
+    int32_t irq_affinity;
+    int32_t buffer_size;
+};
+
 /**
  * @brief Read driver params as int value
  *
@@ -174,17 +209,18 @@ enum class UsbAudioType : int
  */
 int read_driver_param(const char* param_name)
 {
-    auto param_path = std::string(PARAM_ROOT_PATH) + param_name;
-    std::string param_str(PARAM_VAL_STR_LEN, '\0');
+    char param_path[256];
+    char param_str[PARAM_VAL_STR_LEN + 1] = {};
+    std::snprintf(param_path, sizeof(param_path), "%s%s", PARAM_ROOT_PATH, param_name);
 
-    auto fd = open(param_path.c_str(), O_RDONLY);
+    auto fd = open(param_path, O_RDONLY);
     if (fd < 0)
     {
         // failed to open
         return fd;
     }
 
-    auto res = read(fd, param_str.data(), PARAM_VAL_STR_LEN);
+    auto res = read(fd, param_str, PARAM_VAL_STR_LEN);
     close(fd);
 
     if (res < 0)
@@ -194,7 +230,73 @@ int read_driver_param(const char* param_name)
     }
 
     // Using atoi for no exception guarantee
-    return std::atoi(param_str.c_str());
+    return std::atoi(param_str);
+}
+
+/**
+ * @brief Read all the parameters with a single read of the binary
+ *        capabilities attribute.
+ *
+ * @param caps Filled with the parameters upon success
+ * @return true upon success, false if the driver does not provide the
+ *         attribute or it is too short.
+ */
+bool read_driver_capabilities_binary(DriverCapabilities& caps)
+{
+    char path[256];
+    std::snprintf(path, sizeof(path), "%s%s", PARAM_ROOT_PATH, CAPABILITIES_PARAM);
+
+    auto fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    uint8_t buffer[CAPABILITIES_MAX_SIZE];
+    auto res = read(fd, buffer, sizeof(buffer));
+    close(fd);
+
+    if (res < static_cast<ssize_t>(sizeof(DriverCapabilities)))
+    {
+        return false;
+    }
+
+    std::memcpy(&caps, buffer, sizeof(caps));
+    return caps.size >= sizeof(DriverCapabilities);
+}
+
+/**
+ * @brief Read all the parameters, one sysfs file each. Used with drivers
+ *        which do not provide the capabilities attribute.
+ *
+ * @param caps Filled with the parameters, or their negative error codes
+ */
+void read_driver_capabilities_per_param(DriverCapabilities& caps)
+{
+    caps.size = sizeof(DriverCapabilities);
+    caps.ver_maj = read_driver_param(MAJ_VER_PARAM);
+    caps.ver_min = read_driver_param(MIN_VER_PARAM);
+    caps.sample_rate = read_driver_param(SAMPLE_RATE_PARAM);
+    caps.num_input_chans = read_driver_param(NUM_INPUT_CHANS_PARAM);
+    caps.num_output_chans = read_driver_param(NUM_OUTPUT_CHANS_PARAM);
+    caps.platform_type = read_driver_param(PLATFORM_TYPE_PARAM);
+    caps.usb_audio_type = read_driver_param(USB_AUDIO_TYPE_PARAM);
+    caps.irq_affinity = read_driver_param(IRQ_AFFINITY);
+    caps.buffer_size = read_driver_param(BUFFER_SIZE_PARAM);
+}
+
+/**
+ * @brief Read all the parameters needed to open the device, with a single
+ *        read if the driver supports it and one read per parameter otherwise.
+ *
+ * @param caps Filled with the parameters
+ */
+void read_driver_capabilities(DriverCapabilities& caps)
+{
+    if (!read_driver_capabilities_binary(caps))
+    {
+        read_driver_capabilities_per_param(caps);
+    }
 }
 
 /**
@@ -292,13 +394,14 @@ std::pair<bool, CodecFormat> check_codec_format(int codec_format)
 /**
  * @brief Check the driver version.
  *
+ * @param caps The driver capabilities
  * @return std::pair<bool, int> false if version mismatches along with the
            mismatched version, true upon success
  */
-std::pair<bool, int> check_driver_version()
+std::pair<bool, int> check_driver_version(const DriverCapabilities& caps)
 {
-    auto major_ver = read_driver_param(MAJ_VER_PARAM);
-    auto minor_ver = read_driver_param(MIN_VER_PARAM);
+    auto major_ver = caps.ver_maj;
+    auto minor_ver = caps.ver_min;
 
     if (major_ver < 0)
     {
@@ -21,9 +21,9 @@
 
 #include <pthread.h>
 #include <alsa/asoundlib.h>
-#include <fifo/circularfifo_memory_relaxed_aquire_release.h>
 
 #include "driver_config.h"
+#include "raspa_spsc_ring.h"
 
 namespace {
     // Device name of the USB audio gadget listed by ALSA
@@ -166,8 +166,16 @@ public:
     int close()
     {
         _is_usb_running = false;
-        snd_pcm_close(_pcm_playback_handle);
-        snd_pcm_close(_pcm_capture_handle);
+        if (_pcm_playback_handle)
+        {
+            snd_pcm_close(_pcm_playback_handle);
+            _pcm_playback_handle = nullptr;
+        }
+        if (_pcm_capture_handle)
+        {
+            snd_pcm_close(_pcm_capture_handle);
+            _pcm_capture_handle = nullptr;
+        }
         return 0;
     }
 
@@ -493,10 +501,10 @@ private:
     snd_pcm_hw_params_t *_snd_hw_params = nullptr;
     snd_pcm_sw_params_t *_snd_sw_params = nullptr;
     snd_output_t *_snd_output = NULL;
-    snd_pcm_t *_pcm_playback_handle;
-    snd_pcm_t *_pcm_capture_handle;
-    CircularFifo<int32_t*, RASPA_TO_USB_IO_BUFFER_RATIO>_input_usb_fifo;
-    CircularFifo<int32_t*, RASPA_TO_USB_IO_BUFFER_RATIO>_output_usb_fifo;
+    snd_pcm_t *_pcm_playback_handle = nullptr;
+    snd_pcm_t *_pcm_capture_handle = nullptr;
+    SpscRing<int32_t*, RASPA_TO_USB_IO_BUFFER_RATIO> _input_usb_fifo;
+    SpscRing<int32_t*, RASPA_TO_USB_IO_BUFFER_RATIO> _output_usb_fifo;
 };
 
 }
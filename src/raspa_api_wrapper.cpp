@@ -15,14 +15,21 @@
 
 /**
  * @brief Wrapper around RaspaInterface to map it to the public C API defined in
- *        raspa.h
+ *        raspa.h. Built with RASPA_REPLAY defined, it wraps RaspaReplayPimpl
+ *        instead, for the raspa_replay library.
  * @copyright 2017-2021 Modern Ancient Instruments Networked AB, dba Elk,
  * Stockholm
  */
 #include "raspa/raspa.h"
-#include "raspa_pimpl.h"
+#ifdef RASPA_REPLAY
+    #include "raspa_replay_pimpl.h"
+using RaspaPimplType = raspa::RaspaReplayPimpl;
+#else
+    #include "raspa_pimpl.h"
+using RaspaPimplType = raspa::RaspaPimpl;
+#endif
 
-static raspa::RaspaPimpl raspa_pimpl;
+static RaspaPimplType raspa_pimpl;
 
 const char* raspa_get_error_msg(int code)
 {
@@ -34,11 +41,41 @@ int raspa_init()
     return raspa_pimpl.init();
 }
 
+void raspa_set_memory_lock_mode(int mode)
+{
+    raspa_pimpl.set_memory_lock_mode(mode);
+}
+
+int raspa_lock_memory_region(const void* address, size_t size)
+{
+    return raspa_pimpl.lock_memory_region(address, size);
+}
+
+int raspa_get_memory_report(RaspaMemoryReport* report, int print)
+{
+    return raspa_pimpl.get_memory_report(report, print != 0);
+}
+
 void raspa_set_run_log_file(const char *path)
 {
     raspa_pimpl.set_run_log_file(path);
 }
 
+void raspa_set_session_capture_file(const char *path)
+{
+    raspa_pimpl.set_session_capture_file(path);
+}
+
+void raspa_set_servo_trace_file(const char *path)
+{
+    raspa_pimpl.set_servo_trace_file(path);
+}
+
+void raspa_set_ctrl_pkt_capture_file(const char *path)
+{
+    raspa_pimpl.set_ctrl_pkt_capture_file(path);
+}
+
 void raspa_set_cpu_affinity(int affinity)
 {
     raspa_pimpl.set_cpu_affinity(affinity);
@@ -55,6 +92,17 @@ int raspa_open(int buffer_size,
                             debug_flags);
 }
 
+int raspa_open_channels(int buffer_size,
+                        RaspaChannelProcessCallback process_callback,
+                        void* user_data,
+                        unsigned int debug_flags)
+{
+    return raspa_pimpl.open_device_channels(buffer_size,
+                                            process_callback,
+                                            user_data,
+                                            debug_flags);
+}
+
 float raspa_get_sampling_rate()
 {
     return raspa_pimpl.get_sampling_rate();
@@ -119,3 +167,167 @@ int raspa_free_gpio(int pin_num)
 {
     return raspa_pimpl.free_gpio(pin_num);
 }
+
+int raspa_recorder_open(const char* file_name, const int* channels, int num_channels)
+{
+    return raspa_pimpl.recorder_open(file_name, channels, num_channels);
+}
+
+void raspa_recorder_push(const float* input)
+{
+    raspa_pimpl.recorder_push(input);
+}
+
+int raspa_recorder_close()
+{
+    return raspa_pimpl.recorder_close();
+}
+
+int64_t raspa_recorder_get_num_overruns()
+{
+    return raspa_pimpl.recorder_get_num_overruns();
+}
+
+int raspa_player_open(const char* file_name, const int* channels, int num_channels)
+{
+    return raspa_pimpl.player_open(file_name, channels, num_channels);
+}
+
+void raspa_player_pull(float* output)
+{
+    raspa_pimpl.player_pull(output);
+}
+
+int raspa_player_seek(int64_t frame)
+{
+    return raspa_pimpl.player_seek(frame);
+}
+
+int raspa_player_set_loop(int enabled)
+{
+    return raspa_pimpl.player_set_loop(enabled);
+}
+
+int raspa_player_close()
+{
+    return raspa_pimpl.player_close();
+}
+
+int64_t raspa_player_get_num_starvations()
+{
+    return raspa_pimpl.player_get_num_starvations();
+}
+
+int raspa_tap_open(const char* name,
+                   const int* input_channels,
+                   int num_inputs,
+                   const int* output_channels,
+                   int num_outputs)
+{
+    return raspa_pimpl.tap_open(name, input_channels, num_inputs, output_channels, num_outputs);
+}
+
+int raspa_tap_close()
+{
+    return raspa_pimpl.tap_close();
+}
+
+int raspa_get_event_fd()
+{
+    return raspa_pimpl.get_event_fd();
+}
+
+int raspa_read_event(RaspaEvent* event)
+{
+    return raspa_pimpl.read_event(event);
+}
+
+int raspa_graph_add_node(RaspaGraphNodeCallback callback, void* data, const char* name)
+{
+    return raspa_pimpl.graph_add_node(callback, data, name);
+}
+
+int raspa_graph_add_edge(int from_node, int to_node)
+{
+    return raspa_pimpl.graph_add_edge(from_node, to_node);
+}
+
+int raspa_graph_clear()
+{
+    return raspa_pimpl.graph_clear();
+}
+
+int raspa_graph_set_worker_cpus(const int* cpus, int num_cpus)
+{
+    return raspa_pimpl.graph_set_worker_cpus(cpus, num_cpus);
+}
+
+int raspa_graph_process()
+{
+    return raspa_pimpl.graph_process();
+}
+
+int raspa_graph_get_node_stats(int node, RaspaGraphNodeStats* stats)
+{
+    return raspa_pimpl.graph_get_node_stats(node, stats);
+}
+
+int raspa_set_decimation(int factor)
+{
+    return raspa_pimpl.set_decimation(factor);
+}
+
+int raspa_get_decimation()
+{
+    return raspa_pimpl.get_decimation();
+}
+
+int raspa_get_callback_buffer_size()
+{
+    return raspa_pimpl.get_callback_buffer_size();
+}
+
+int raspa_get_callback_channel_stride()
+{
+    return raspa_pimpl.get_callback_channel_stride();
+}
+
+RaspaMicroSec raspa_get_decimation_latency()
+{
+    return raspa_pimpl.get_decimation_latency();
+}
+
+int raspa_set_load_policy(float high_load, float low_load, int hold_time_ms)
+{
+    return raspa_pimpl.set_load_policy(high_load, low_load, hold_time_ms);
+}
+
+int raspa_get_policy_buffer_size()
+{
+    return raspa_pimpl.get_policy_buffer_size();
+}
+
+void raspa_set_flush_denormals(int enabled)
+{
+    raspa_pimpl.set_flush_denormals(enabled != 0);
+}
+
+int raspa_get_denormal_report(RaspaDenormalReport* report, int print)
+{
+    return raspa_pimpl.get_denormal_report(report, print != 0);
+}
+
+int raspa_set_deadline_reservation(float runtime_fraction)
+{
+    return raspa_pimpl.set_deadline_reservation(runtime_fraction);
+}
+
+void raspa_set_irq_steering(int enabled)
+{
+    raspa_pimpl.set_irq_steering(enabled != 0);
+}
+
+int raspa_audit_isolation(RaspaIsolationReport* report, int print)
+{
+    return raspa_pimpl.audit_isolation(report, print != 0);
+}
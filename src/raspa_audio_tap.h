@@ -0,0 +1,265 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class RaspaAudioTap, which publishes selected channels
+ *        of every period in POSIX shared memory for external analyzers.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_AUDIO_TAP_H
+#define RASPA_AUDIO_TAP_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "raspa/raspa_tap.h"
+#include "raspa_error_codes.h"
+#include "raspa_rt_section.h"
+#include "raspa_spsc_ring.h"
+
+namespace raspa {
+
+// Minimum length of audio the tap slots hold, in milliseconds
+constexpr int TAP_MIN_HISTORY_MS = 500;
+
+// Slots are padded to a cache line
+constexpr size_t TAP_SLOT_ALIGNMENT = 64;
+
+/**
+ * @brief Internal class used by raspa to write the tap. The shared memory is
+ *        created, sized and touched by start(), so that write() only copies
+ *        samples and updates sequence numbers, without system calls.
+ *
+ *        terminate() waits for the rt thread to leave write(), the mapping
+ *        is then kept until the next start() or destruction. Readers keep
+ *        their own mapping after the tap is terminated.
+ */
+class RaspaAudioTap
+{
+public:
+    RaspaAudioTap() : _memory(nullptr),
+                      _size(0),
+                      _header(nullptr),
+                      _buffer_size_in_frames(0),
+                      _chan_stride(0),
+                      _write_count(0)
+    {}
+
+    ~RaspaAudioTap()
+    {
+        terminate();
+        _unmap();
+    }
+
+    /**
+     * @brief Create the shared memory and start tapping.
+     *
+     * @param name Shared memory name, e.g. RASPA_TAP_DEFAULT_NAME
+     * @param input_channels Indices of the input channels to tap
+     * @param output_channels Indices of the output channels to tap
+     * @param buffer_size_in_frames The buffer size in frames
+     * @param chan_stride The distance in samples between the start of
+     *        consecutive channels in the process callback buffers
+     * @param sample_rate The sample rate in Hz
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise.
+     */
+    int start(const std::string& name,
+              const std::vector<int>& input_channels,
+              const std::vector<int>& output_channels,
+              int buffer_size_in_frames,
+              int chan_stride,
+              int sample_rate)
+    {
+        if (_rt_section.is_enabled())
+        {
+            return -RASPA_ETAP_ALREADY_OPEN;
+        }
+
+        if (input_channels.size() > RASPA_TAP_MAX_CHANNELS ||
+            output_channels.size() > RASPA_TAP_MAX_CHANNELS ||
+            input_channels.size() + output_channels.size() == 0)
+        {
+            return -RASPA_ETAP_CHANNELS;
+        }
+
+        _unmap();
+
+        size_t num_channels = input_channels.size() + output_channels.size();
+        size_t slot_size = sizeof(RaspaTapSlot) + num_channels * buffer_size_in_frames * sizeof(float);
+        slot_size = (slot_size + TAP_SLOT_ALIGNMENT - 1) & ~(TAP_SLOT_ALIGNMENT - 1);
+        size_t min_slots = static_cast<size_t>(sample_rate) * TAP_MIN_HISTORY_MS / 1000 / buffer_size_in_frames;
+        size_t num_slots = next_power_of_two(std::max<size_t>(min_slots, 2));
+
+        // a previous instance may have crashed without unlinking it
+        shm_unlink(name.c_str());
+        auto fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0)
+        {
+            return -RASPA_ETAP_SHM;
+        }
+
+        _size = RASPA_TAP_HEADER_SIZE + num_slots * slot_size;
+        void* memory = MAP_FAILED;
+        if (ftruncate(fd, _size) == 0)
+        {
+            memory = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+
+        if (memory == MAP_FAILED)
+        {
+            shm_unlink(name.c_str());
+            _size = 0;
+            return -RASPA_ETAP_SHM;
+        }
+
+        // touch all the pages now, not from the rt thread
+        _memory = static_cast<uint8_t*>(memory);
+        std::memset(_memory, 0, _size);
+
+        _header = reinterpret_cast<RaspaTapHeader*>(_memory);
+        _header->sample_rate = sample_rate;
+        _header->buffer_size_in_frames = buffer_size_in_frames;
+        _header->num_input_channels = input_channels.size();
+        _header->num_output_channels = output_channels.size();
+        _header->num_slots = num_slots;
+        _header->slot_size_in_bytes = slot_size;
+        std::copy(input_channels.begin(), input_channels.end(), _header->input_channels);
+        std::copy(output_channels.begin(), output_channels.end(), _header->output_channels);
+        _header->version = RASPA_TAP_VERSION;
+
+        // readers check the magic last
+        __atomic_store_n(&_header->magic, RASPA_TAP_MAGIC, __ATOMIC_RELEASE);
+
+        _name = name;
+        _input_channels = input_channels;
+        _output_channels = output_channels;
+        _buffer_size_in_frames = buffer_size_in_frames;
+        _chan_stride = chan_stride;
+        _write_count = 0;
+        _rt_section.enable();
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Stop tapping, wait for the rt thread to leave write() and remove
+     *        the shared memory name. It is always safe to call this function.
+     *
+     * @return RASPA_SUCCESS
+     */
+    int terminate()
+    {
+        if (_rt_section.is_enabled())
+        {
+            _rt_section.disable();
+            shm_unlink(_name.c_str());
+        }
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Publish one period. Called from the rt thread, does not block nor
+     *        make system calls.
+     *
+     * @param input The non-interleaved input buffer of the period
+     * @param output The non-interleaved output buffer of the period
+     * @param raspa_period The period count of raspa
+     */
+    void write(const float* input, const float* output, uint64_t raspa_period)
+    {
+        if (!_rt_section.enter())
+        {
+            return;
+        }
+
+        auto slot = reinterpret_cast<RaspaTapSlot*>(_memory + RASPA_TAP_HEADER_SIZE +
+                                                   (_write_count % _header->num_slots) *
+                                                   _header->slot_size_in_bytes);
+
+        __atomic_store_n(&slot->sequence, 2 * _write_count + 1, __ATOMIC_RELAXED);
+        // the odd sequence must be visible before the samples change
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+
+        slot->raspa_period = raspa_period;
+        auto samples = reinterpret_cast<float*>(slot + 1);
+        for (auto channel : _input_channels)
+        {
+            std::memcpy(samples, input + channel * _chan_stride, _buffer_size_in_frames * sizeof(float));
+            samples += _buffer_size_in_frames;
+        }
+        for (auto channel : _output_channels)
+        {
+            std::memcpy(samples, output + channel * _chan_stride, _buffer_size_in_frames * sizeof(float));
+            samples += _buffer_size_in_frames;
+        }
+
+        __atomic_store_n(&slot->sequence, 2 * _write_count + 2, __ATOMIC_RELEASE);
+        _write_count++;
+        __atomic_store_n(&_header->write_count, _write_count, __ATOMIC_RELEASE);
+        _rt_section.leave();
+    }
+
+    bool is_running() const
+    {
+        return _rt_section.is_enabled();
+    }
+
+    /**
+     * @brief Call function(address, size) on each allocation the rt thread
+     *        touches, so that the targeted memory lock mode can lock them.
+     */
+    template<typename Function>
+    void for_each_rt_region(Function function) const
+    {
+        function(_memory, _size);
+        function(_input_channels.data(), _input_channels.size() * sizeof(int));
+        function(_output_channels.data(), _output_channels.size() * sizeof(int));
+    }
+
+private:
+    void _unmap()
+    {
+        if (_memory)
+        {
+            munmap(_memory, _size);
+            _memory = nullptr;
+            _header = nullptr;
+            _size = 0;
+        }
+    }
+
+    RtSection _rt_section;
+    uint8_t* _memory;
+    size_t _size;
+    RaspaTapHeader* _header;
+
+    std::string _name;
+    std::vector<int> _input_channels;
+    std::vector<int> _output_channels;
+    int _buffer_size_in_frames;
+    int _chan_stride;
+    uint64_t _write_count;
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_AUDIO_TAP_H
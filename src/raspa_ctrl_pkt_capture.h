@@ -0,0 +1,136 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class RaspaCtrlPktCapture, which records a summary of
+ *        the audio control packets exchanged with the micro-controller on
+ *        every period of sync and async platforms. Decoded offline with
+ *        misc/ctrl_pkt_decoder.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_CTRL_PKT_CAPTURE_H
+#define RASPA_CTRL_PKT_CAPTURE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "raspa_error_codes.h"
+#include "raspa_trace_writer.h"
+
+namespace raspa {
+
+// number of packets buffered between two writes, two per period
+constexpr size_t CTRL_PKT_CAPTURE_RING_SIZE = 16384;
+
+// number of words copied verbatim from the start of each packet
+constexpr int CTRL_PKT_CAPTURE_HEADER_WORDS = 4;
+
+/**
+ * Packet capture file format: a CtrlPktCaptureHeader followed by one
+ * CtrlPktCaptureRecord per packet, the rx packet then the tx packet of each
+ * period. A record with period -1 marks records lost because the writer
+ * thread fell behind. All the fields are in the native byte order of the
+ * target.
+ */
+constexpr char CTRL_PKT_CAPTURE_MAGIC[8] = {'R', 'A', 'S', 'P', 'A', 'C', 'T', 'L'};
+constexpr uint32_t CTRL_PKT_CAPTURE_VERSION = 1;
+
+enum CtrlPktDirection : uint8_t
+{
+    CTRL_PKT_RX = 0,
+    CTRL_PKT_TX = 1
+};
+
+enum CtrlPktType : uint8_t
+{
+    CTRL_PKT_INVALID = 0,   // magic words not found
+    CTRL_PKT_DEFAULT = 1,   // no payload
+    CTRL_PKT_GPIO = 2,
+    CTRL_PKT_MIDI = 3,
+    CTRL_PKT_CEASE = 4,
+    CTRL_PKT_NUM_TYPES
+};
+
+struct CtrlPktCaptureHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t sample_rate;
+    uint32_t buffer_size_in_frames;
+    uint32_t platform_type;
+    uint32_t pkt_size_in_bytes;
+    uint32_t payload_capacity_in_bytes;
+};
+
+struct CtrlPktCaptureRecord
+{
+    int64_t period;             // value of the interrupt counter
+    uint8_t direction;          // one of CtrlPktDirection
+    uint8_t type;               // one of CtrlPktType
+    uint16_t payload_bytes;     // bytes of the payload in use
+    uint32_t reserved;
+    uint32_t header_words[CTRL_PKT_CAPTURE_HEADER_WORDS];
+};
+
+/**
+ * @brief Internal class used by raspa to capture the audio control packets.
+ *        The packets are classified by the caller, this class only copies
+ *        the start of each one and is independent of the protocol version.
+ */
+class RaspaCtrlPktCapture : public RaspaTraceWriter<CtrlPktCaptureHeader,
+                                                    CtrlPktCaptureRecord,
+                                                    CTRL_PKT_CAPTURE_RING_SIZE>
+{
+public:
+    RaspaCtrlPktCapture() : RaspaTraceWriter(RASPA_ECTRL_PKT_CAPTURE_FILE_OPEN,
+                                             RASPA_ECTRL_PKT_CAPTURE_FILE_CLOSE)
+    {}
+
+    /**
+     * @brief Write the header and start the writer thread.
+     * @param file_name The file the capture is written to
+     * @param header The header, magic and version are filled in here
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise.
+     */
+    int start(const std::string& file_name, CtrlPktCaptureHeader header)
+    {
+        std::memcpy(header.magic, CTRL_PKT_CAPTURE_MAGIC, sizeof(header.magic));
+        header.version = CTRL_PKT_CAPTURE_VERSION;
+        return RaspaTraceWriter::start(file_name, header);
+    }
+
+    /**
+     * @brief Record one packet. Rt safe.
+     * @param pkt The packet, at least CTRL_PKT_CAPTURE_HEADER_WORDS words long
+     */
+    void put(int64_t period, CtrlPktDirection direction, CtrlPktType type, int payload_bytes, const void* pkt)
+    {
+        if (is_running())
+        {
+            CtrlPktCaptureRecord record = {};
+            record.period = period;
+            record.direction = direction;
+            record.type = type;
+            record.payload_bytes = static_cast<uint16_t>(payload_bytes);
+            std::memcpy(record.header_words, pkt, sizeof(record.header_words));
+            RaspaTraceWriter::put(record);
+        }
+    }
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_CTRL_PKT_CAPTURE_H
@@ -0,0 +1,648 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class RaspaDiskPlayer, which streams a multichannel
+ *        wav file from disk to the real time thread.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_DISK_PLAYER_H
+#define RASPA_DISK_PLAYER_H
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "raspa_error_codes.h"
+#include "raspa_rt_section.h"
+#include "raspa_spsc_ring.h"
+
+namespace raspa {
+
+// Size of the file reads, in frames
+constexpr int PLAYER_READ_BLOCK_FRAMES = 16 * 1024;
+
+// Minimum length of audio the read-ahead ring holds, in seconds
+constexpr int PLAYER_RING_SECONDS = 4;
+
+// Size of the control queue
+constexpr size_t PLAYER_COMMAND_QUEUE_SIZE = 16;
+
+// Reader thread sleep period when the ring is full
+constexpr std::chrono::milliseconds PLAYER_READER_SLEEP(10);
+
+/**
+ * @brief Sample formats of the wav files the player can read
+ */
+enum class WavSampleFormat
+{
+    INT16,
+    INT24,
+    INT32,
+    FLOAT32
+};
+
+/**
+ * @brief Description of the audio data of a wav file
+ */
+struct WavInfo
+{
+    int num_channels;
+    int sample_rate;
+    WavSampleFormat format;
+    int bytes_per_sample;
+    off_t data_offset;
+    uint64_t num_frames;
+};
+
+/**
+ * @brief Parse the header of a RIFF or RF64 wav file.
+ *
+ * @param fd File descriptor of the wav file
+ * @param info Filled with the description of the audio data
+ * @return true if the file is a supported wav file, false otherwise.
+ */
+inline bool parse_wav_header(int fd, WavInfo& info)
+{
+    uint8_t riff[12];
+    if (pread(fd, riff, sizeof(riff), 0) != sizeof(riff) ||
+        (std::memcmp(riff, "RIFF", 4) != 0 && std::memcmp(riff, "RF64", 4) != 0) ||
+        std::memcmp(riff + 8, "WAVE", 4) != 0)
+    {
+        return false;
+    }
+
+    uint64_t ds64_data_size = 0;
+    bool fmt_found = false;
+    off_t offset = sizeof(riff);
+    uint8_t chunk_header[8];
+
+    while (pread(fd, chunk_header, sizeof(chunk_header), offset) == sizeof(chunk_header))
+    {
+        uint32_t chunk_size;
+        std::memcpy(&chunk_size, chunk_header + 4, sizeof(chunk_size));
+        off_t chunk_data = offset + sizeof(chunk_header);
+
+        if (std::memcmp(chunk_header, "ds64", 4) == 0)
+        {
+            if (pread(fd, &ds64_data_size, sizeof(ds64_data_size), chunk_data + 8) != sizeof(ds64_data_size))
+            {
+                return false;
+            }
+        }
+        else if (std::memcmp(chunk_header, "fmt ", 4) == 0)
+        {
+            uint8_t fmt[40] = {};
+            if (chunk_size < 16 ||
+                pread(fd, fmt, std::min<size_t>(chunk_size, sizeof(fmt)), chunk_data) < 16)
+            {
+                return false;
+            }
+
+            uint16_t format_tag;
+            uint16_t num_channels;
+            uint32_t sample_rate;
+            uint16_t bits_per_sample;
+            std::memcpy(&format_tag, fmt, 2);
+            std::memcpy(&num_channels, fmt + 2, 2);
+            std::memcpy(&sample_rate, fmt + 4, 4);
+            std::memcpy(&bits_per_sample, fmt + 14, 2);
+
+            // WAVE_FORMAT_EXTENSIBLE, the format tag is the start of the sub format
+            if (format_tag == 0xfffe && chunk_size >= 40)
+            {
+                std::memcpy(&format_tag, fmt + 24, 2);
+            }
+
+            info.num_channels = num_channels;
+            info.sample_rate = sample_rate;
+            info.bytes_per_sample = bits_per_sample / 8;
+            if (format_tag == 1 && bits_per_sample == 16)
+            {
+                info.format = WavSampleFormat::INT16;
+            }
+            else if (format_tag == 1 && bits_per_sample == 24)
+            {
+                info.format = WavSampleFormat::INT24;
+            }
+            else if (format_tag == 1 && bits_per_sample == 32)
+            {
+                info.format = WavSampleFormat::INT32;
+            }
+            else if (format_tag == 3 && bits_per_sample == 32)
+            {
+                info.format = WavSampleFormat::FLOAT32;
+            }
+            else
+            {
+                return false;
+            }
+            fmt_found = num_channels > 0;
+        }
+        else if (std::memcmp(chunk_header, "data", 4) == 0)
+        {
+            if (!fmt_found)
+            {
+                return false;
+            }
+
+            uint64_t data_size = chunk_size;
+            if (chunk_size == UINT32_MAX && ds64_data_size > 0)
+            {
+                data_size = ds64_data_size;
+            }
+
+            // clamp to the actual file size, for unfinished recordings
+            off_t file_size = lseek(fd, 0, SEEK_END);
+            data_size = std::min<uint64_t>(data_size, std::max<off_t>(file_size - chunk_data, 0));
+
+            info.data_offset = chunk_data;
+            info.num_frames = data_size / (info.num_channels * info.bytes_per_sample);
+            return true;
+        }
+
+        // chunks are padded to an even size
+        offset = chunk_data + chunk_size + (chunk_size & 1);
+    }
+
+    return false;
+}
+
+/**
+ * @brief Internal class used by raspa to play a multichannel wav file. A non
+ *        rt reader thread reads ahead from the file, converts the samples to
+ *        float and stores them into a preallocated lock-free ring. The rt
+ *        thread pulls exactly one period per callback, without locks nor
+ *        system calls. If the ring does not hold a full period the missing
+ *        frames are silent and the period is counted as a starvation.
+ *
+ *        Seek and loop commands are passed to the reader thread through a
+ *        lock-free queue, they must all be sent from the same thread. After a
+ *        seek, the reader marks the data still in the ring as stale and the rt
+ *        side skips it on its next pull.
+ */
+class RaspaDiskPlayer
+{
+public:
+    RaspaDiskPlayer() : _is_running(false),
+                        _fd(-1),
+                        _wav_info{},
+                        _buffer_size_in_frames(0),
+                        _chan_stride(0),
+                        _ring(nullptr),
+                        _ring_size(0),
+                        _file_position(0),
+                        _loop(false),
+                        _write_count(0),
+                        _read_count(0),
+                        _flush_count(0),
+                        _flush_generation(0),
+                        _rt_flush_generation(0),
+                        _end_of_file(false),
+                        _num_starvations(0)
+    {}
+
+    ~RaspaDiskPlayer()
+    {
+        terminate();
+        free(_ring);
+    }
+
+    /**
+     * @brief Open the file and start the reader thread.
+     *
+     * @param file_name Path of the wav file
+     * @param channels Output channel index for each file channel, in file
+     *        order. Can be shorter than the number of channels of the file,
+     *        the remaining file channels are not played.
+     * @param num_output_channels The number of output channels of the device
+     * @param buffer_size_in_frames The buffer size in frames
+     * @param chan_stride The distance in samples between the start of
+     *        consecutive channels in the process callback buffers
+     * @param sample_rate The sample rate in Hz, must match the file one
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise.
+     */
+    int start(const std::string& file_name,
+              const std::vector<int>& channels,
+              int num_output_channels,
+              int buffer_size_in_frames,
+              int chan_stride,
+              int sample_rate)
+    {
+        if (_is_running)
+        {
+            return -RASPA_EPLAYER_ALREADY_OPEN;
+        }
+
+        _fd = open(file_name.c_str(), O_RDONLY);
+        if (_fd < 0)
+        {
+            return -RASPA_EPLAYER_FILE_OPEN;
+        }
+
+        // the members are only replaced once the file is accepted
+        WavInfo wav_info = {};
+        if (!parse_wav_header(_fd, wav_info))
+        {
+            _close_file();
+            return -RASPA_EPLAYER_FILE_FORMAT;
+        }
+
+        if (wav_info.sample_rate != sample_rate)
+        {
+            _close_file();
+            return -RASPA_EPLAYER_SAMPLE_RATE;
+        }
+
+        if (channels.empty() || channels.size() > static_cast<size_t>(wav_info.num_channels))
+        {
+            _close_file();
+            return -RASPA_EPLAYER_CHANNELS;
+        }
+        for (auto channel : channels)
+        {
+            if (channel < 0 || channel >= num_output_channels)
+            {
+                _close_file();
+                return -RASPA_EPLAYER_CHANNELS;
+            }
+        }
+
+        _wav_info = wav_info;
+        _channels = channels;
+        _buffer_size_in_frames = buffer_size_in_frames;
+        _chan_stride = chan_stride;
+
+        // ring of interleaved frames, power of two
+        size_t min_ring_size = static_cast<size_t>(sample_rate) * PLAYER_RING_SECONDS;
+        _ring_size = PLAYER_READ_BLOCK_FRAMES;
+        while (_ring_size < min_ring_size)
+        {
+            _ring_size *= 2;
+        }
+
+        free(_ring);
+        _ring = static_cast<float*>(malloc(_ring_size * _wav_info.num_channels * sizeof(float)));
+        _read_buffer.resize(PLAYER_READ_BLOCK_FRAMES * _wav_info.num_channels * _wav_info.bytes_per_sample);
+        if (_ring == nullptr)
+        {
+            _close_file();
+            return -RASPA_EUSER_BUFFERS;
+        }
+        // touch all the pages now, not from the rt thread
+        std::fill_n(_ring, _ring_size * _wav_info.num_channels, 0.0f);
+
+        PlayerCommand command;
+        while (_commands.pop(command)) {}
+
+        _file_position = 0;
+        _loop = false;
+        _write_count = 0;
+        _read_count = 0;
+        _flush_count = 0;
+        _flush_generation = 0;
+        _rt_flush_generation = 0;
+        _end_of_file = false;
+        _num_starvations = 0;
+        _is_running = true;
+        _thread = std::thread(&RaspaDiskPlayer::_run, this);
+        _rt_section.enable();
+
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Wait for the rt thread to leave pull(), stop the reader thread
+     *        and close the file. It is always safe to call this function.
+     *
+     * @return RASPA_SUCCESS
+     */
+    int terminate()
+    {
+        _rt_section.disable();
+        if (_is_running)
+        {
+            _is_running = false;
+            if (_thread.joinable())
+            {
+                _thread.join();
+            }
+        }
+
+        _close_file();
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Write one period of the file to the output buffer. Called from
+     *        the rt thread, does not block nor make system calls. Only the
+     *        output channels the file is mapped to are written.
+     *
+     * @param output The non-interleaved output buffer of the period, as passed
+     *        to the process callback
+     */
+    void pull(float* output)
+    {
+        if (!_rt_section.enter())
+        {
+            return;
+        }
+
+        // skip the data made stale by a seek
+        auto flush_generation = _flush_generation.load(std::memory_order_acquire);
+        if (flush_generation != _rt_flush_generation)
+        {
+            _read_count.store(_flush_count.load(std::memory_order_relaxed), std::memory_order_release);
+            _rt_flush_generation = flush_generation;
+        }
+
+        // end of file must be read before the write count
+        bool end_of_file = _end_of_file.load(std::memory_order_acquire);
+        auto read_count = _read_count.load(std::memory_order_relaxed);
+        auto available = _write_count.load(std::memory_order_acquire) - read_count;
+        auto num_frames = static_cast<int>(std::min<uint64_t>(available, _buffer_size_in_frames));
+
+        if (num_frames < _buffer_size_in_frames && !end_of_file)
+        {
+            _num_starvations.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        size_t mask = _ring_size - 1;
+        int num_file_channels = _wav_info.num_channels;
+        for (size_t c = 0; c < _channels.size(); c++)
+        {
+            float* channel = output + _channels[c] * _chan_stride;
+            for (int frame = 0; frame < num_frames; frame++)
+            {
+                channel[frame] = _ring[((read_count + frame) & mask) * num_file_channels + c];
+            }
+            std::fill(channel + num_frames, channel + _buffer_size_in_frames, 0.0f);
+        }
+
+        _read_count.store(read_count + num_frames, std::memory_order_release);
+        _rt_section.leave();
+    }
+
+    /**
+     * @brief Request a seek to the given frame of the file.
+     * @return true upon success, false if the control queue is full.
+     */
+    bool seek(int64_t frame)
+    {
+        return _commands.push({PlayerCommandType::SEEK, frame});
+    }
+
+    /**
+     * @brief Enable or disable looping at the end of the file.
+     * @return true upon success, false if the control queue is full.
+     */
+    bool set_loop(bool enabled)
+    {
+        return _commands.push({PlayerCommandType::SET_LOOP, enabled ? 1 : 0});
+    }
+
+    /**
+     * @brief Get the number of periods where the ring did not hold enough
+     *        data, because the reader thread did not keep up.
+     */
+    uint64_t get_num_starvations() const
+    {
+        return _num_starvations;
+    }
+
+    /**
+     * @brief Get the number of frames read ahead and not yet played.
+     */
+    uint64_t get_num_buffered_frames() const
+    {
+        auto read_count = std::max(_read_count.load(), _flush_count.load());
+        return _write_count.load() - read_count;
+    }
+
+    /**
+     * @brief Call function(address, size) on each allocation the rt thread
+     *        touches, so that the targeted memory lock mode can lock them.
+     */
+    template<typename Function>
+    void for_each_rt_region(Function function) const
+    {
+        function(_ring, _ring_size * _wav_info.num_channels * sizeof(float));
+        function(_channels.data(), _channels.size() * sizeof(int));
+    }
+
+    bool is_running() const
+    {
+        return _is_running;
+    }
+
+private:
+    enum class PlayerCommandType
+    {
+        SEEK,
+        SET_LOOP
+    };
+
+    struct PlayerCommand
+    {
+        PlayerCommandType type;
+        int64_t value;
+    };
+
+    void _run()
+    {
+        while (_is_running)
+        {
+            _process_commands();
+            if (!_read_block())
+            {
+                std::this_thread::sleep_for(PLAYER_READER_SLEEP);
+            }
+        }
+    }
+
+    void _process_commands()
+    {
+        PlayerCommand command;
+        while (_commands.pop(command))
+        {
+            switch (command.type)
+            {
+            case PlayerCommandType::SEEK:
+                _file_position = std::clamp<int64_t>(command.value, 0, _wav_info.num_frames);
+                // everything written so far is stale
+                _flush_count.store(_write_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                _flush_generation.fetch_add(1, std::memory_order_release);
+                _end_of_file.store(false, std::memory_order_release);
+                break;
+
+            case PlayerCommandType::SET_LOOP:
+                _loop = command.value != 0;
+                if (_loop)
+                {
+                    _end_of_file.store(false, std::memory_order_release);
+                }
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief Read the next block of the file into the ring, if there is space.
+     * @return true if something was read
+     */
+    bool _read_block()
+    {
+        if (_file_position >= _wav_info.num_frames)
+        {
+            if (!_loop || _wav_info.num_frames == 0)
+            {
+                _end_of_file.store(true, std::memory_order_release);
+                return false;
+            }
+            _file_position = 0;
+        }
+
+        auto write_count = _write_count.load(std::memory_order_relaxed);
+        auto used = write_count - _read_count.load(std::memory_order_acquire);
+        auto free_frames = _ring_size - std::min<uint64_t>(used, _ring_size);
+        if (free_frames < static_cast<uint64_t>(PLAYER_READ_BLOCK_FRAMES))
+        {
+            return false;
+        }
+
+        auto num_frames = std::min<uint64_t>(PLAYER_READ_BLOCK_FRAMES,
+                                             _wav_info.num_frames - _file_position);
+        size_t frame_bytes = _wav_info.num_channels * _wav_info.bytes_per_sample;
+        auto res = pread(_fd,
+                         _read_buffer.data(),
+                         num_frames * frame_bytes,
+                         _wav_info.data_offset + _file_position * frame_bytes);
+        if (res <= 0)
+        {
+            // treat read errors as the end of the file
+            _file_position = _wav_info.num_frames;
+            return false;
+        }
+
+        num_frames = res / frame_bytes;
+        _convert_to_ring(write_count, num_frames);
+        _file_position += num_frames;
+        _write_count.store(write_count + num_frames, std::memory_order_release);
+        return true;
+    }
+
+    void _convert_to_ring(uint64_t write_count, size_t num_frames)
+    {
+        size_t mask = _ring_size - 1;
+        int num_channels = _wav_info.num_channels;
+        const uint8_t* data = _read_buffer.data();
+
+        for (size_t frame = 0; frame < num_frames; frame++)
+        {
+            float* ring_frame = _ring + ((write_count + frame) & mask) * num_channels;
+            for (int c = 0; c < num_channels; c++)
+            {
+                ring_frame[c] = _to_float(data);
+                data += _wav_info.bytes_per_sample;
+            }
+        }
+    }
+
+    float _to_float(const uint8_t* data) const
+    {
+        switch (_wav_info.format)
+        {
+        case WavSampleFormat::INT16:
+        {
+            int16_t sample;
+            std::memcpy(&sample, data, sizeof(sample));
+            return sample / 32768.0f;
+        }
+        case WavSampleFormat::INT24:
+        {
+            auto sample = static_cast<int32_t>((static_cast<uint32_t>(data[0]) << 8) |
+                                               (static_cast<uint32_t>(data[1]) << 16) |
+                                               (static_cast<uint32_t>(data[2]) << 24));
+            return (sample >> 8) / 8388608.0f;
+        }
+        case WavSampleFormat::INT32:
+        {
+            int32_t sample;
+            std::memcpy(&sample, data, sizeof(sample));
+            return sample / 2147483648.0f;
+        }
+        case WavSampleFormat::FLOAT32:
+        {
+            float sample;
+            std::memcpy(&sample, data, sizeof(sample));
+            return sample;
+        }
+        }
+        return 0.0f;
+    }
+
+    void _close_file()
+    {
+        if (_fd >= 0)
+        {
+            close(_fd);
+            _fd = -1;
+        }
+    }
+
+    std::atomic<bool> _is_running;
+    RtSection _rt_section;
+    std::thread _thread;
+    int _fd;
+    WavInfo _wav_info;
+
+    std::vector<int> _channels;
+    int _buffer_size_in_frames;
+    int _chan_stride;
+
+    // ring of interleaved frames
+    float* _ring;
+    size_t _ring_size;
+
+    // reader thread state
+    std::vector<uint8_t> _read_buffer;
+    uint64_t _file_position;
+    bool _loop;
+
+    SpscRing<PlayerCommand, PLAYER_COMMAND_QUEUE_SIZE> _commands;
+
+    std::atomic<uint64_t> _write_count;
+    std::atomic<uint64_t> _read_count;
+
+    // write count at the last seek and its generation number
+    std::atomic<uint64_t> _flush_count;
+    std::atomic<uint32_t> _flush_generation;
+    uint32_t _rt_flush_generation;
+
+    std::atomic<bool> _end_of_file;
+    std::atomic<uint64_t> _num_starvations;
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_DISK_PLAYER_H
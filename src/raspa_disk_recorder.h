@@ -0,0 +1,447 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class RaspaDiskRecorder, which streams selected audio
+ *        channels from the real time thread to a multichannel wav file.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_DISK_RECORDER_H
+#define RASPA_DISK_RECORDER_H
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "raspa_error_codes.h"
+#include "raspa_rt_section.h"
+
+namespace raspa {
+
+// Size of the wav header. The sample data starts at this offset in the file,
+// so that all the writes of the writer thread are block aligned.
+constexpr size_t RECORDER_WAV_HEADER_SIZE = 4096;
+
+// Size of the writes to the file, in samples
+constexpr size_t RECORDER_WRITE_BLOCK_SAMPLES = 64 * 1024;
+
+// Minimum length of audio the ring buffer can hold, in seconds
+constexpr int RECORDER_RING_SECONDS = 4;
+
+// The file is preallocated in steps of this size
+constexpr off_t RECORDER_PREALLOCATION_STEP_BYTES = 64 * 1024 * 1024;
+
+// Writer thread sleep period when there is less than a block to write
+constexpr std::chrono::milliseconds RECORDER_WRITER_SLEEP(10);
+
+/**
+ * @brief Fill a wav header for a 32 bit float multichannel file with
+ *        num_frames frames. The header is RECORDER_WAV_HEADER_SIZE bytes:
+ *        a RIFF header, a JUNK chunk padding the header to its full size, a
+ *        WAVE_FORMAT_EXTENSIBLE fmt chunk, a fact chunk and the data chunk
+ *        header. If the data does not fit in a RIFF file the header is turned
+ *        into a RF64 one, with the JUNK chunk replaced by a ds64 chunk.
+ *        All fields are little endian, as the target.
+ *
+ * @param header Buffer of RECORDER_WAV_HEADER_SIZE bytes
+ * @param num_channels The number of channels
+ * @param sample_rate The sample rate in Hz
+ * @param num_frames The number of frames in the data chunk
+ */
+inline void build_wav_header(uint8_t* header, int num_channels, int sample_rate, uint64_t num_frames)
+{
+    constexpr uint32_t FMT_CHUNK_SIZE = 40;
+    constexpr uint32_t FACT_CHUNK_SIZE = 4;
+    constexpr uint32_t JUNK_CHUNK_SIZE = RECORDER_WAV_HEADER_SIZE - 12 - 8 - (8 + FMT_CHUNK_SIZE) -
+                                         (8 + FACT_CHUNK_SIZE) - 8;
+    constexpr uint8_t FLOAT_SUBFORMAT[16] = {0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+                                             0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71};
+
+    uint64_t data_size = num_frames * num_channels * sizeof(float);
+    uint64_t riff_size = RECORDER_WAV_HEADER_SIZE - 8 + data_size;
+    bool rf64 = riff_size > UINT32_MAX;
+
+    auto put = [&](size_t& offset, const void* data, size_t size)
+    {
+        std::memcpy(header + offset, data, size);
+        offset += size;
+    };
+    auto put_u16 = [&](size_t& offset, uint16_t value) { put(offset, &value, sizeof(value)); };
+    auto put_u32 = [&](size_t& offset, uint32_t value) { put(offset, &value, sizeof(value)); };
+    auto put_u64 = [&](size_t& offset, uint64_t value) { put(offset, &value, sizeof(value)); };
+
+    std::memset(header, 0, RECORDER_WAV_HEADER_SIZE);
+    size_t offset = 0;
+
+    put(offset, rf64 ? "RF64" : "RIFF", 4);
+    put_u32(offset, rf64 ? UINT32_MAX : static_cast<uint32_t>(riff_size));
+    put(offset, "WAVE", 4);
+
+    put(offset, rf64 ? "ds64" : "JUNK", 4);
+    put_u32(offset, JUNK_CHUNK_SIZE);
+    size_t ds64_offset = offset;
+    if (rf64)
+    {
+        put_u64(ds64_offset, riff_size);
+        put_u64(ds64_offset, data_size);
+        put_u64(ds64_offset, num_frames);
+        put_u32(ds64_offset, 0);        // table length
+    }
+    offset += JUNK_CHUNK_SIZE;
+
+    put(offset, "fmt ", 4);
+    put_u32(offset, FMT_CHUNK_SIZE);
+    put_u16(offset, 0xfffe);            // WAVE_FORMAT_EXTENSIBLE
+    put_u16(offset, num_channels);
+    put_u32(offset, sample_rate);
+    put_u32(offset, sample_rate * num_channels * sizeof(float));
+    put_u16(offset, num_channels * sizeof(float));
+    put_u16(offset, 32);                // bits per sample
+    put_u16(offset, 22);                // extension size
+    put_u16(offset, 32);                // valid bits per sample
+    put_u32(offset, 0);                 // channel mask
+    put(offset, FLOAT_SUBFORMAT, sizeof(FLOAT_SUBFORMAT));
+
+    put(offset, "fact", 4);
+    put_u32(offset, FACT_CHUNK_SIZE);
+    put_u32(offset, rf64 ? UINT32_MAX : static_cast<uint32_t>(num_frames));
+
+    put(offset, "data", 4);
+    put_u32(offset, rf64 ? UINT32_MAX : static_cast<uint32_t>(data_size));
+}
+
+/**
+ * @brief Internal class used by raspa to record selected input channels to
+ *        disk. The rt thread interleaves the selected channels of each period
+ *        into a preallocated lock-free ring, a non rt writer thread streams
+ *        the ring to a single multichannel wav file with large block aligned
+ *        writes. The file is preallocated ahead of the write position. If the
+ *        ring is full the period is dropped and counted as an overrun.
+ */
+class RaspaDiskRecorder
+{
+public:
+    RaspaDiskRecorder() : _is_running(false),
+                          _fd(-1),
+                          _buffer_size_in_frames(0),
+                          _chan_stride(0),
+                          _sample_rate(0),
+                          _ring(nullptr),
+                          _ring_size(0),
+                          _allocated_bytes(0),
+                          _written_bytes(0),
+                          _write_error(false),
+                          _write_count(0),
+                          _read_count(0),
+                          _num_overruns(0)
+    {}
+
+    ~RaspaDiskRecorder()
+    {
+        terminate();
+        _free_ring();
+    }
+
+    /**
+     * @brief Open the file and start the writer thread.
+     *
+     * @param file_name Path of the wav file, overwritten if it exists
+     * @param channels Indices of the channels to record, in the order they
+     *        are written to the file
+     * @param buffer_size_in_frames The buffer size in frames
+     * @param chan_stride The distance in samples between the start of
+     *        consecutive channels in the process callback buffers
+     * @param sample_rate The sample rate in Hz
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise.
+     */
+    int start(const std::string& file_name,
+              const std::vector<int>& channels,
+              int buffer_size_in_frames,
+              int chan_stride,
+              int sample_rate)
+    {
+        if (_is_running)
+        {
+            return -RASPA_ERECORDER_ALREADY_OPEN;
+        }
+
+        _channels = channels;
+        _buffer_size_in_frames = buffer_size_in_frames;
+        _chan_stride = chan_stride;
+        _sample_rate = sample_rate;
+
+        // ring of samples, power of two and multiple of the write block size
+        size_t min_ring_size = static_cast<size_t>(sample_rate) * RECORDER_RING_SECONDS *
+                               _channels.size();
+        _ring_size = RECORDER_WRITE_BLOCK_SAMPLES;
+        while (_ring_size < min_ring_size)
+        {
+            _ring_size *= 2;
+        }
+
+        _free_ring();
+        if (posix_memalign(reinterpret_cast<void**>(&_ring),
+                           RECORDER_WAV_HEADER_SIZE,
+                           _ring_size * sizeof(float)) != 0)
+        {
+            _ring = nullptr;
+            return -RASPA_EUSER_BUFFERS;
+        }
+        // touch all the pages now, not from the rt thread
+        std::fill_n(_ring, _ring_size, 0.0f);
+
+        _fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (_fd < 0)
+        {
+            return -RASPA_ERECORDER_FILE_OPEN;
+        }
+
+        _allocated_bytes = RECORDER_WAV_HEADER_SIZE;
+        _written_bytes = 0;
+        _write_error = false;
+        _preallocate(0);
+
+        uint8_t header[RECORDER_WAV_HEADER_SIZE];
+        build_wav_header(header, _channels.size(), _sample_rate, 0);
+        if (pwrite(_fd, header, sizeof(header), 0) != sizeof(header))
+        {
+            close(_fd);
+            _fd = -1;
+            return -RASPA_ERECORDER_FILE_WRITE;
+        }
+
+        _write_count = 0;
+        _read_count = 0;
+        _num_overruns = 0;
+        _is_running = true;
+        _thread = std::thread(&RaspaDiskRecorder::_run, this);
+        _rt_section.enable();
+
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Wait for the rt thread to leave push(), stop the writer thread
+     *        after writing the pending samples, update the wav header and
+     *        close the file. It is always safe to call this function.
+     *
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise.
+     */
+    int terminate()
+    {
+        if (!_is_running)
+        {
+            return RASPA_SUCCESS;
+        }
+
+        // the last period pushed is written too
+        _rt_section.disable();
+        _is_running = false;
+        if (_thread.joinable())
+        {
+            _thread.join();
+        }
+
+        // drop the preallocated space past the end of the data
+        uint64_t num_frames = _written_bytes / (_channels.size() * sizeof(float));
+        uint64_t data_size = num_frames * _channels.size() * sizeof(float);
+        bool error = _write_error ||
+                     ftruncate(_fd, RECORDER_WAV_HEADER_SIZE + data_size) != 0;
+
+        uint8_t header[RECORDER_WAV_HEADER_SIZE];
+        build_wav_header(header, _channels.size(), _sample_rate, num_frames);
+        error |= pwrite(_fd, header, sizeof(header), 0) != sizeof(header);
+        error |= close(_fd) != 0;
+        _fd = -1;
+
+        return error ? -RASPA_ERECORDER_FILE_WRITE : RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Push the selected channels of one period. Called from the rt
+     *        thread, does not block nor make system calls.
+     *
+     * @param input The non-interleaved input buffer of the period, as passed
+     *        to the process callback
+     */
+    void push(const float* input)
+    {
+        if (!_rt_section.enter())
+        {
+            return;
+        }
+
+        size_t num_channels = _channels.size();
+        size_t period_samples = _buffer_size_in_frames * num_channels;
+        auto write_count = _write_count.load(std::memory_order_relaxed);
+        if (_ring_size - (write_count - _read_count.load(std::memory_order_acquire)) < period_samples)
+        {
+            _num_overruns.fetch_add(1, std::memory_order_relaxed);
+            _rt_section.leave();
+            return;
+        }
+
+        size_t mask = _ring_size - 1;
+        for (size_t c = 0; c < num_channels; c++)
+        {
+            const float* channel = input + _channels[c] * _chan_stride;
+            for (int frame = 0; frame < _buffer_size_in_frames; frame++)
+            {
+                _ring[(write_count + frame * num_channels + c) & mask] = channel[frame];
+            }
+        }
+
+        _write_count.store(write_count + period_samples, std::memory_order_release);
+        _rt_section.leave();
+    }
+
+    /**
+     * @brief Get the number of periods dropped because the disk did not
+     *        keep up.
+     */
+    uint64_t get_num_overruns() const
+    {
+        return _num_overruns;
+    }
+
+    /**
+     * @brief Call function(address, size) on each allocation the rt thread
+     *        touches, so that the targeted memory lock mode can lock them.
+     */
+    template<typename Function>
+    void for_each_rt_region(Function function) const
+    {
+        function(_ring, _ring_size * sizeof(float));
+        function(_channels.data(), _channels.size() * sizeof(int));
+    }
+
+    bool is_running() const
+    {
+        return _is_running;
+    }
+
+private:
+    void _run()
+    {
+        while (_is_running)
+        {
+            if (!_write_ring_to_file(RECORDER_WRITE_BLOCK_SAMPLES))
+            {
+                std::this_thread::sleep_for(RECORDER_WRITER_SLEEP);
+            }
+        }
+
+        // write the remaining samples
+        while (_write_ring_to_file(1)) {}
+    }
+
+    /**
+     * @brief Write one contiguous chunk of the ring to file, in multiples of
+     *        min_samples samples.
+     * @return true if something was written
+     */
+    bool _write_ring_to_file(size_t min_samples)
+    {
+        auto read_count = _read_count.load(std::memory_order_relaxed);
+        auto available = _write_count.load(std::memory_order_acquire) - read_count;
+        auto index = read_count & (_ring_size - 1);
+        auto chunk = std::min(available, _ring_size - index);
+        chunk -= chunk % min_samples;
+        if (chunk == 0)
+        {
+            return false;
+        }
+
+        size_t chunk_bytes = chunk * sizeof(float);
+        _preallocate(chunk_bytes);
+
+        auto data = reinterpret_cast<const uint8_t*>(_ring + index);
+        size_t done = 0;
+        while (done < chunk_bytes && !_write_error)
+        {
+            auto res = pwrite(_fd, data + done, chunk_bytes - done,
+                              RECORDER_WAV_HEADER_SIZE + _written_bytes + done);
+            if (res <= 0)
+            {
+                fprintf(stderr, "Raspa disk recorder write error\n");
+                _write_error = true;
+            }
+            done += std::max<ssize_t>(res, 0);
+        }
+        _written_bytes += done;
+
+        // release the samples even on error, so that the rt side keeps going
+        _read_count.store(read_count + chunk, std::memory_order_release);
+        return !_write_error;
+    }
+
+    /**
+     * @brief Extend the file allocation if the next write of size bytes goes
+     *        past it.
+     */
+    void _preallocate(size_t size)
+    {
+        off_t end = RECORDER_WAV_HEADER_SIZE + _written_bytes + size;
+        if (end > _allocated_bytes)
+        {
+            auto new_size = _allocated_bytes + std::max<off_t>(RECORDER_PREALLOCATION_STEP_BYTES,
+                                                               end - _allocated_bytes);
+            // not all file systems support it, it is only an optimization
+            posix_fallocate(_fd, _allocated_bytes, new_size - _allocated_bytes);
+            _allocated_bytes = new_size;
+        }
+    }
+
+    void _free_ring()
+    {
+        free(_ring);
+        _ring = nullptr;
+    }
+
+    std::atomic<bool> _is_running;
+    RtSection _rt_section;
+    std::thread _thread;
+    int _fd;
+
+    std::vector<int> _channels;
+    int _buffer_size_in_frames;
+    int _chan_stride;
+    int _sample_rate;
+
+    float* _ring;
+    size_t _ring_size;
+
+    // writer thread state
+    off_t _allocated_bytes;
+    uint64_t _written_bytes;
+    bool _write_error;
+
+    std::atomic<uint64_t> _write_count;
+    std::atomic<uint64_t> _read_count;
+    std::atomic<uint64_t> _num_overruns;
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_DISK_RECORDER_H
@@ -0,0 +1,301 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class RaspaEventQueue, which delivers the events posted
+ *        by the rt thread to non rt supervisor threads through a pollable file
+ *        descriptor.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_EVENT_QUEUE_H
+#define RASPA_EVENT_QUEUE_H
+
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "raspa/raspa.h"
+#include "raspa_error_codes.h"
+#include "raspa_spsc_ring.h"
+
+namespace raspa {
+
+// Number of events the rt thread can post before the relay thread drains them
+constexpr size_t EVENT_RING_SIZE = 128;
+
+// Maximum number of events waiting to be read, the oldest are dropped
+constexpr size_t EVENT_QUEUE_MAX_SIZE = 1024;
+
+// Relay thread sleep period, i.e. the maximum event delivery latency
+constexpr std::chrono::milliseconds EVENT_RELAY_SLEEP(2);
+
+// Time without new periods after which the rt loop is reported as stalled
+constexpr int64_t EVENT_RT_STALL_TIMEOUT_US = 200000;
+
+/**
+ * @brief Internal class used by raspa for the event descriptor.
+ *
+ *        The rt thread posts events into a wait free ring. Writing the
+ *        eventfd is a regular linux system call, which would make the rt
+ *        thread switch to secondary mode, so a relay thread drains the ring
+ *        every EVENT_RELAY_SLEEP into a queue read by the supervisors, and
+ *        signals the eventfd. The eventfd is readable as long as the queue
+ *        holds events.
+ *
+ *        The relay thread also watches the period counter of the rt thread
+ *        and reports when it stops and restarts advancing, which catches an
+ *        rt loop blocked or dead without having posted anything.
+ */
+class RaspaEventQueue
+{
+public:
+    RaspaEventQueue() : _fd(-1),
+                        _is_running(false),
+                        _num_dropped(0)
+    {}
+
+    ~RaspaEventQueue()
+    {
+        terminate();
+        if (_fd >= 0)
+        {
+            close(_fd);
+        }
+    }
+
+    /**
+     * @brief Get the event file descriptor, created on the first call. It
+     *        stays valid until the process exits, across raspa_open() and
+     *        raspa_close().
+     *
+     * @return The file descriptor upon success, -RASPA_EEVENT_FD otherwise.
+     */
+    int get_fd()
+    {
+        std::lock_guard<std::mutex> lock(_queue_mutex);
+        if (_fd < 0)
+        {
+            _fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (_fd < 0)
+            {
+                return -RASPA_EEVENT_FD;
+            }
+        }
+        return _fd;
+    }
+
+    /**
+     * @brief Start the relay thread.
+     *
+     * @param get_period_count Returns the current period count of the rt
+     *        thread, or a negative value if it should not be watched.
+     *        Called from the relay thread.
+     */
+    void start(std::function<int64_t()> get_period_count)
+    {
+        if (_is_running)
+        {
+            return;
+        }
+        _get_period_count = get_period_count;
+        _is_running = true;
+        _relay_thread = std::thread(&RaspaEventQueue::_relay_loop, this);
+    }
+
+    /**
+     * @brief Stop the relay thread after delivering the pending events. It
+     *        is always safe to call this function.
+     */
+    void terminate()
+    {
+        if (_is_running)
+        {
+            _is_running = false;
+            if (_relay_thread.joinable())
+            {
+                _relay_thread.join();
+            }
+        }
+    }
+
+    /**
+     * @brief Post an event. Called from the rt thread, does not block nor
+     *        make system calls. Events are dropped if the ring is full, which
+     *        is reported with a RASPA_EVENT_DROPPED event.
+     */
+    void post(int type, int64_t value, RaspaMicroSec timestamp, int64_t period)
+    {
+        if (!_ring.push({type, value, timestamp, period}))
+        {
+            _num_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Read the oldest event, from a non rt thread.
+     *
+     * @param event Where the event is stored
+     * @return 1 if an event was read, 0 if there are no events.
+     */
+    int read(RaspaEvent* event)
+    {
+        std::lock_guard<std::mutex> lock(_queue_mutex);
+        if (_queue.empty())
+        {
+            return 0;
+        }
+
+        *event = _queue.front();
+        _queue.pop_front();
+        if (_queue.empty())
+        {
+            _clear_fd();
+        }
+        return 1;
+    }
+
+private:
+    static RaspaMicroSec _get_time()
+    {
+        struct timespec tp;
+        clock_gettime(CLOCK_MONOTONIC, &tp);
+        return static_cast<RaspaMicroSec>(tp.tv_sec) * 1000000 + tp.tv_nsec / 1000;
+    }
+
+    void _relay_loop()
+    {
+        int64_t last_period_count = -1;
+        RaspaMicroSec last_period_time = 0;
+        bool stalled = false;
+
+        while (true)
+        {
+            // read before draining, so the last events are delivered on exit
+            bool is_running = _is_running;
+
+            RaspaEvent events[EVENT_RING_SIZE];
+            auto num_events = _ring.pop(events, EVENT_RING_SIZE);
+            auto num_dropped = _num_dropped.exchange(0, std::memory_order_relaxed);
+
+            // watchdog, armed once the rt thread has completed a period
+            auto now = _get_time();
+            auto period_count = _get_period_count();
+            RaspaEvent watchdog_event{};
+            bool has_watchdog_event = false;
+            if (period_count < 0)
+            {
+                last_period_count = -1;
+                stalled = false;
+            }
+            else if (period_count != last_period_count)
+            {
+                if (stalled)
+                {
+                    watchdog_event = {RASPA_EVENT_RT_LOOP_RESUMED, now - last_period_time, now, period_count};
+                    has_watchdog_event = true;
+                    stalled = false;
+                }
+                last_period_count = period_count;
+                last_period_time = now;
+            }
+            else if (!stalled && period_count > 0 && now - last_period_time > EVENT_RT_STALL_TIMEOUT_US)
+            {
+                watchdog_event = {RASPA_EVENT_RT_LOOP_STALLED, now - last_period_time, now, period_count};
+                has_watchdog_event = true;
+                stalled = true;
+            }
+
+            if (num_events > 0 || num_dropped > 0 || has_watchdog_event)
+            {
+                std::lock_guard<std::mutex> lock(_queue_mutex);
+                for (size_t i = 0; i < num_events; i++)
+                {
+                    num_dropped += _enqueue(events[i]);
+                }
+                if (has_watchdog_event)
+                {
+                    num_dropped += _enqueue(watchdog_event);
+                }
+                if (num_dropped > 0)
+                {
+                    _enqueue({RASPA_EVENT_DROPPED, num_dropped, now, period_count});
+                }
+                _signal_fd();
+            }
+
+            if (!is_running)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(EVENT_RELAY_SLEEP);
+        }
+    }
+
+    // must be called with _queue_mutex held, returns the number of events dropped to make room
+    int _enqueue(const RaspaEvent& event)
+    {
+        int num_dropped = 0;
+        if (_queue.size() == EVENT_QUEUE_MAX_SIZE)
+        {
+            _queue.pop_front();
+            num_dropped = 1;
+        }
+        _queue.push_back(event);
+        return num_dropped;
+    }
+
+    // must be called with _queue_mutex held
+    void _signal_fd()
+    {
+        if (_fd >= 0)
+        {
+            uint64_t value = 1;
+            [[maybe_unused]] auto res = ::write(_fd, &value, sizeof(value));
+        }
+    }
+
+    // must be called with _queue_mutex held
+    void _clear_fd()
+    {
+        if (_fd >= 0)
+        {
+            uint64_t value;
+            [[maybe_unused]] auto res = ::read(_fd, &value, sizeof(value));
+        }
+    }
+
+    int _fd;
+    std::atomic<bool> _is_running;
+    std::thread _relay_thread;
+    std::function<int64_t()> _get_period_count;
+
+    SpscRing<RaspaEvent, EVENT_RING_SIZE> _ring;
+    std::atomic<int64_t> _num_dropped;
+
+    std::mutex _queue_mutex;
+    std::deque<RaspaEvent> _queue;
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_EVENT_QUEUE_H
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Floating point mode of the rt threads, and class RaspaDenormalCounter
+ *        which looks for denormal samples in the user buffers.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_FPU_MODE_H
+#define RASPA_FPU_MODE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <xmmintrin.h>
+#endif
+
+#include "raspa/raspa.h"
+
+namespace raspa {
+
+// Denormals are looked for in one period out of this many
+constexpr int DENORMAL_SAMPLE_INTERVAL = 16;
+
+/**
+ * @brief Set the denormal handling of the floating point unit for the calling
+ *        thread. When flushing, denormal results are replaced by zero (FTZ),
+ *        and on x86 denormal operands are read as zero too (DAZ). Only sets a
+ *        cpu register, so it is safe to call from a rt thread.
+ * @param flush True to flush denormals to zero, false for ieee behaviour
+ * @return true if the mode was set, false if not supported on this cpu
+ */
+inline bool set_thread_flush_denormals(bool flush)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    constexpr unsigned int MXCSR_FTZ_DAZ = 0x8040;
+    auto mxcsr = _mm_getcsr();
+    _mm_setcsr(flush ? (mxcsr | MXCSR_FTZ_DAZ) : (mxcsr & ~MXCSR_FTZ_DAZ));
+    return true;
+#elif defined(__aarch64__)
+    constexpr uint64_t FPCR_FZ = 1ull << 24;
+    uint64_t fpcr;
+    asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+    fpcr = flush ? (fpcr | FPCR_FZ) : (fpcr & ~FPCR_FZ);
+    asm volatile("msr fpcr, %0" : : "r"(fpcr));
+    return true;
+#elif defined(__arm__) && defined(__ARM_FP)
+    // neon arithmetic always flushes, this covers the vfp instructions
+    constexpr uint32_t FPSCR_FZ = 1u << 24;
+    uint32_t fpscr;
+    asm volatile("vmrs %0, fpscr" : "=r"(fpscr));
+    fpscr = flush ? (fpscr | FPSCR_FZ) : (fpscr & ~FPSCR_FZ);
+    asm volatile("vmsr fpscr, %0" : : "r"(fpscr));
+    return true;
+#else
+    return flush == false;
+#endif
+}
+
+/**
+ * @brief Check for a denormal without the floating point unit, so that the
+ *        result does not depend on its mode or on -ffast-math.
+ */
+inline bool is_denormal(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x7f800000u) == 0 && (bits & 0x007fffffu) != 0;
+}
+
+/**
+ * @brief Internal class used by raspa for the RASPA_DEBUG_COUNT_DENORMALS
+ *        debug flag. The rt thread calls count_inputs() on the user input
+ *        buffer before the process callback and count_outputs() on the user
+ *        output buffer after it, one period out of DENORMAL_SAMPLE_INTERVAL.
+ *        Counts are kept per channel, and read from a non rt thread with
+ *        get_report(). They are atomic so that the 64 bit reads don't tear
+ *        on 32 bit cpus, the rt thread being the only writer.
+ */
+class RaspaDenormalCounter
+{
+public:
+    RaspaDenormalCounter() = default;
+
+    /**
+     * @brief Allocate the counters and clear them. Not rt safe.
+     */
+    void init(int num_input_chans, int num_output_chans)
+    {
+        _clear(_input_counts, num_input_chans);
+        _clear(_output_counts, num_output_chans);
+        _num_sampled_periods.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Check whether the given period is sampled.
+     */
+    static bool is_sampled(int64_t period)
+    {
+        return period % DENORMAL_SAMPLE_INTERVAL == 0;
+    }
+
+    /**
+     * @brief Count the denormals of the input buffer. Rt safe.
+     */
+    void count_inputs(const float* buffer, int chan_stride, int num_frames)
+    {
+        _count(_input_counts, buffer, chan_stride, num_frames);
+        _add(_num_sampled_periods, 1);
+    }
+
+    /**
+     * @brief Count the denormals of the output buffer. Rt safe.
+     */
+    void count_outputs(const float* buffer, int chan_stride, int num_frames)
+    {
+        _count(_output_counts, buffer, chan_stride, num_frames);
+    }
+
+    /**
+     * @brief Fill the report, and optionally print the counts per channel.
+     */
+    void get_report(RaspaDenormalReport* report, bool print) const
+    {
+        report->num_sampled_periods = _num_sampled_periods.load(std::memory_order_relaxed);
+        report->input_denormals = _sum(_input_counts);
+        report->output_denormals = _sum(_output_counts);
+
+        if (print)
+        {
+            printf("Raspa denormal report, %lld periods sampled\n",
+                   static_cast<long long>(report->num_sampled_periods));
+            _print("input", _input_counts);
+            _print("output", _output_counts);
+        }
+    }
+
+private:
+    using Counts = std::vector<std::atomic<int64_t>>;
+
+    static void _clear(Counts& counts, int num_chans)
+    {
+        Counts(num_chans).swap(counts);
+        for (auto& count : counts)
+        {
+            count.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // single writer, so a relaxed load and store replace the read-modify-write
+    static void _add(std::atomic<int64_t>& count, int64_t value)
+    {
+        count.store(count.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static void _count(Counts& counts, const float* buffer, int chan_stride, int num_frames)
+    {
+        for (size_t c = 0; c < counts.size(); c++)
+        {
+            const float* channel = buffer + c * chan_stride;
+            int num_denormals = 0;
+            for (int i = 0; i < num_frames; i++)
+            {
+                num_denormals += is_denormal(channel[i]);
+            }
+            _add(counts[c], num_denormals);
+        }
+    }
+
+    static int64_t _sum(const Counts& counts)
+    {
+        int64_t total = 0;
+        for (const auto& count : counts)
+        {
+            total += count.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    static void _print(const char* direction, const Counts& counts)
+    {
+        for (size_t c = 0; c < counts.size(); c++)
+        {
+            auto count = counts[c].load(std::memory_order_relaxed);
+            if (count > 0)
+            {
+                printf("  %s channel %d: %lld denormals\n", direction, static_cast<int>(c),
+                       static_cast<long long>(count));
+            }
+        }
+    }
+
+    Counts _input_counts;
+    Counts _output_counts;
+    std::atomic<int64_t> _num_sampled_periods{0};
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_FPU_MODE_H
@@ -23,19 +23,20 @@
 
 #include <sys/un.h>
 #include <sys/socket.h>
+#include <cerrno>
 #include <utility>
 #include <thread>
 #include <chrono>
 
-#include <fifo/circularfifo_memory_relaxed_aquire_release.h>
-
 #include "audio_control_protocol/audio_control_protocol.h"
+#include "raspa_spsc_ring.h"
 
 namespace {
     // Address of raspa socket
     constexpr char RASPA_SOCKET[] = "/tmp/raspa";
 
     // Size of the fifos in between the real time thread and non real time.
+    // Rounded up to the next power of two by SpscRing.
     constexpr size_t GPIO_PACKET_Q_SIZE = 100;
 
     // Blocking timeout period of the socket
@@ -50,8 +51,6 @@ namespace {
 
 namespace raspa {
 
-using namespace memory_relaxed_aquire_release;
-
 /**
  * Class which is responsible for the tx/rx of GPIO data from
  * the real time thread and transfering that data over UNIX sockets in a real
@@ -61,13 +60,11 @@ using namespace memory_relaxed_aquire_release;
 class RaspaGpioCom
 {
 public:
-    RaspaGpioCom(const std::string& gpio_host_socket_name,
-                 RaspaErrorCode* raspa_error_code) :
+    explicit RaspaGpioCom(const std::string& gpio_host_socket_name) :
                                   _in_socket(0),
                                   _out_socket(0),
                                   _gpio_host_socket_name(gpio_host_socket_name),
-                                  _is_running(false),
-                                  _raspa_error_code(raspa_error_code)
+                                  _is_running(false)
     {}
 
     ~RaspaGpioCom()
@@ -79,23 +76,25 @@ public:
      * @brief Initialize the GPIO com and all of its internals i.e the queues,
      *        sockets and the non real time communication thread.
      *
+     *        May run on a helper thread of raspa_open(), so the linux error
+     *        is returned to the caller instead of being stored here.
+     *
+     * @param error_val Set to the linux error code upon failure
      * @return int RASPA_SUCCESS on success, different error code otherwise
      */
-    int init()
+    int init(int& error_val)
     {
         _in_socket = socket(AF_UNIX, SOCK_DGRAM, 0);
         if (_in_socket < 0)
         {
-            _raspa_error_code->set_error_val(RASPA_EINSOCKET_CREATION,
-                                             _in_socket);
+            error_val = errno;
             return -RASPA_EINSOCKET_CREATION;
         }
 
         _out_socket = socket(AF_UNIX, SOCK_DGRAM, 0);
         if (_out_socket < 0)
         {
-            _raspa_error_code->set_error_val(RASPA_EOUTSOCKET_CREATION,
-                                             _out_socket);
+            error_val = errno;
             return -RASPA_EOUTSOCKET_CREATION;
         }
 
@@ -110,7 +109,7 @@ public:
         auto res = bind(_in_socket, reinterpret_cast<sockaddr*>(&address), sizeof(sockaddr_un));
         if (res < 0)
         {
-            _raspa_error_code->set_error_val(RASPA_EINSOCKET_BIND, res);
+            error_val = errno;
             return -RASPA_EINSOCKET_BIND;
         }
 
@@ -121,7 +120,7 @@ public:
         res = setsockopt(_in_socket, SOL_SOCKET, SO_RCVTIMEO, &time, sizeof(time));
         if (res != 0)
         {
-            _raspa_error_code->set_error_val(RASPA_EINSOCKET_TIMEOUT, res);
+            error_val = errno;
             return -RASPA_EINSOCKET_TIMEOUT;
         }
 
@@ -164,23 +163,26 @@ public:
     /**
      * @brief Function called by a real time thread to send gpio data.
      *
-     * @param gpio_data data blob containing the gpio data
-     * @return true upon success, false otherwise.
+     * @param gpio_data Array of data blobs containing the gpio data
+     * @param num_blobs The number of data blobs in gpio_data
+     * @return The number of data blobs sent, less than num_blobs if the fifo
+     *         is full.
      */
-    bool send_gpio_data_to_nrt(const struct audio_ctrl::GpioDataBlob& gpio_data)
+    int send_gpio_data_to_nrt(const struct audio_ctrl::GpioDataBlob* gpio_data, int num_blobs)
     {
-        return _from_rt_gpio_data_fifo.push(gpio_data);
+        return _from_rt_gpio_data_fifo.push(gpio_data, num_blobs);
     }
 
     /**
      * @brief Function called by a real time thread to rx gpio data.
      *
-     * @param gpio_data data blob to store the rx gpio data
-     * @return true upon success. False when there is no rx data.
+     * @param gpio_data Array of data blobs to store the rx gpio data
+     * @param max_num_blobs The maximum number of data blobs to get
+     * @return The number of data blobs received, 0 when there is no rx data.
      */
-    bool get_gpio_data_from_nrt(struct audio_ctrl::GpioDataBlob& gpio_data)
+    int get_gpio_data_from_nrt(struct audio_ctrl::GpioDataBlob* gpio_data, int max_num_blobs)
     {
-        return _to_rt_gpio_data_fifo.pop(gpio_data);
+        return _to_rt_gpio_data_fifo.pop(gpio_data, max_num_blobs);
     }
 
     /**
@@ -190,7 +192,7 @@ public:
      */
     bool rx_gpio_data_available()
     {
-        return !_to_rt_gpio_data_fifo.wasEmpty();
+        return !_to_rt_gpio_data_fifo.was_empty();
     }
 
 private:
@@ -337,13 +339,11 @@ private:
 
     bool _is_running;
 
-    CircularFifo<struct audio_ctrl::GpioDataBlob, GPIO_PACKET_Q_SIZE> _to_rt_gpio_data_fifo;
-    CircularFifo<struct audio_ctrl::GpioDataBlob, GPIO_PACKET_Q_SIZE> _from_rt_gpio_data_fifo;
+    SpscRing<struct audio_ctrl::GpioDataBlob, GPIO_PACKET_Q_SIZE> _to_rt_gpio_data_fifo;
+    SpscRing<struct audio_ctrl::GpioDataBlob, GPIO_PACKET_Q_SIZE> _from_rt_gpio_data_fifo;
 
     std::thread _write_thread;
     std::thread _read_thread;
-
-    RaspaErrorCode* _raspa_error_code;
 };
 
 }
@@ -0,0 +1,642 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class RaspaGraphExecutor, which runs a dependency graph
+ *        of processing nodes every period across the rt thread and a set of
+ *        worker threads, using work stealing deques.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_GRAPH_EXECUTOR_H
+#define RASPA_GRAPH_EXECUTOR_H
+
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "raspa/raspa.h"
+#include "raspa_error_codes.h"
+
+namespace raspa {
+
+// Periods between updates of the critical path priorities
+constexpr int64_t GRAPH_PRIORITY_UPDATE_PERIODS = 256;
+
+// Polls of an idle worker before it calls the idle function between polls
+constexpr int GRAPH_WORKER_SPIN_COUNT = 20000;
+
+// Weight of a new duration in the average node duration, as a power of two
+constexpr int GRAPH_AVERAGE_SHIFT = 3;
+
+/**
+ * @brief Bounded Chase-Lev work stealing deque of node indices. The owner
+ *        pushes and pops at the bottom, other workers steal from the top.
+ *        Indices only increase, so the deque needs no reset between periods.
+ */
+class GraphWorkDeque
+{
+public:
+    static constexpr int64_t CAPACITY = RASPA_GRAPH_MAX_NODES;
+
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "Capacity must be a power of two");
+
+    GraphWorkDeque() : _top(0),
+                       _bottom(0)
+    {}
+
+    /**
+     * @brief Push a node, owner only.
+     *
+     * @return false if the deque is full
+     */
+    bool push(int node)
+    {
+        auto bottom = _bottom.load(std::memory_order_relaxed);
+        auto top = _top.load(std::memory_order_acquire);
+        if (bottom - top >= CAPACITY)
+        {
+            return false;
+        }
+        _buffer[bottom & (CAPACITY - 1)].store(node, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Pop the most recently pushed node, owner only.
+     *
+     * @return false if the deque is empty or the last node was stolen
+     */
+    bool pop(int& node)
+    {
+        auto bottom = _bottom.load(std::memory_order_relaxed) - 1;
+        _bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto top = _top.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            _bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        node = _buffer[bottom & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (top == bottom)
+        {
+            // last node, race against the thieves
+            bool won = _top.compare_exchange_strong(top, top + 1,
+                                                    std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+            _bottom.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Steal the oldest node, any thread.
+     *
+     * @return false if the deque is empty or another thread took the node
+     */
+    bool steal(int& node)
+    {
+        auto top = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto bottom = _bottom.load(std::memory_order_acquire);
+        if (top >= bottom)
+        {
+            return false;
+        }
+
+        node = _buffer[top & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        return _top.compare_exchange_strong(top, top + 1,
+                                            std::memory_order_seq_cst,
+                                            std::memory_order_relaxed);
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> _top;
+    alignas(64) std::atomic<int64_t> _bottom;
+    std::atomic<int> _buffer[CAPACITY];
+};
+
+/**
+ * @brief Internal class used by raspa to run the processing graph.
+ *
+ *        The graph is built from non rt threads with add_node() and
+ *        add_edge(), then frozen by prepare(). Every period, process() is
+ *        called from the rt thread, which runs nodes itself as worker 0 while
+ *        the threads calling run_worker() take part as workers 1 to
+ *        num_workers. The owner creates those threads, so that they can be rt
+ *        threads of the right kind, pinned to their cores.
+ *
+ *        A node becomes ready when all its predecessors have completed, and
+ *        is pushed to the deque of the worker which completed the last of
+ *        them. Ready nodes are pushed by increasing critical path length, so
+ *        each worker first runs the node with the longest chain of work left
+ *        behind it, while idle workers steal the others. Critical paths are
+ *        computed from the average measured node durations, and updated every
+ *        GRAPH_PRIORITY_UPDATE_PERIODS periods.
+ */
+class RaspaGraphExecutor
+{
+public:
+    RaspaGraphExecutor() : _get_time_ns(&_default_get_time_ns),
+                           _idle_function(&_default_idle),
+                           _is_prepared(false),
+                           _num_workers(0),
+                           _remaining(0),
+                           _epoch(0),
+                           _stop_workers(false),
+                           _period_count(0)
+    {}
+
+    ~RaspaGraphExecutor() = default;
+
+    /**
+     * @brief Set the clock used to time the nodes and the function called by
+     *        idle workers between polls, e.g. a short sleep of the rt kernel.
+     *        Must not be called while prepared.
+     */
+    void set_platform_functions(int64_t (*get_time_ns)(), void (*idle_function)())
+    {
+        _get_time_ns = get_time_ns;
+        _idle_function = idle_function;
+    }
+
+    /**
+     * @brief Add a node.
+     *
+     * @return The node index upon success, different raspa error code otherwise.
+     */
+    int add_node(RaspaGraphNodeCallback callback, void* data, const char* name)
+    {
+        if (_is_prepared)
+        {
+            return -RASPA_EGRAPH_RUNNING;
+        }
+        if (callback == nullptr || _nodes.size() >= RASPA_GRAPH_MAX_NODES)
+        {
+            return -RASPA_EGRAPH_NODE;
+        }
+
+        auto node = std::make_unique<Node>();
+        node->callback = callback;
+        node->data = data;
+        node->name = name ? name : "";
+        _nodes.push_back(std::move(node));
+        return static_cast<int>(_nodes.size()) - 1;
+    }
+
+    /**
+     * @brief Make a node depend on another one.
+     *
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise.
+     */
+    int add_edge(int from_node, int to_node)
+    {
+        if (_is_prepared)
+        {
+            return -RASPA_EGRAPH_RUNNING;
+        }
+        if (!_is_valid(from_node) || !_is_valid(to_node) || from_node == to_node)
+        {
+            return -RASPA_EGRAPH_NODE;
+        }
+
+        _nodes[from_node]->successors.push_back(to_node);
+        _nodes[to_node]->num_predecessors++;
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Remove all the nodes.
+     *
+     * @return RASPA_SUCCESS upon success, -RASPA_EGRAPH_RUNNING if prepared.
+     */
+    int clear()
+    {
+        if (_is_prepared)
+        {
+            return -RASPA_EGRAPH_RUNNING;
+        }
+        _nodes.clear();
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Check the graph and allocate what process() needs. The graph
+     *        can not be changed until release() is called.
+     *
+     * @param num_workers The number of threads which will call run_worker()
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise.
+     */
+    int prepare(int num_workers)
+    {
+        if (_is_prepared)
+        {
+            return -RASPA_EGRAPH_RUNNING;
+        }
+        if (num_workers < 0 || num_workers > RASPA_GRAPH_MAX_WORKERS)
+        {
+            return -RASPA_EGRAPH_WORKER;
+        }
+
+        // topological sort, also rejects cycles
+        std::vector<int> num_pending(_nodes.size());
+        _topological_order.clear();
+        _roots.clear();
+        for (size_t i = 0; i < _nodes.size(); i++)
+        {
+            num_pending[i] = _nodes[i]->num_predecessors;
+            if (num_pending[i] == 0)
+            {
+                _topological_order.push_back(i);
+                _roots.push_back(i);
+            }
+        }
+        for (size_t i = 0; i < _topological_order.size(); i++)
+        {
+            for (auto successor : _nodes[_topological_order[i]]->successors)
+            {
+                if (--num_pending[successor] == 0)
+                {
+                    _topological_order.push_back(successor);
+                }
+            }
+        }
+        if (_topological_order.size() != _nodes.size())
+        {
+            return -RASPA_EGRAPH_CYCLE;
+        }
+
+        _deques.clear();
+        for (int i = 0; i <= num_workers; i++)
+        {
+            _deques.push_back(std::make_unique<GraphWorkDeque>());
+        }
+
+        for (auto& node : _nodes)
+        {
+            node->avg_ns = 0;
+            node->max_ns.store(0, std::memory_order_relaxed);
+        }
+        _update_priorities();
+
+        _num_workers = num_workers;
+        _period_count = 0;
+        _stop_workers = false;
+        _is_prepared = true;
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Make the workers return from run_worker(). The owner joins them
+     *        before calling release().
+     */
+    void stop_workers()
+    {
+        _stop_workers = true;
+    }
+
+    /**
+     * @brief Unfreeze the graph once process() and the workers have returned.
+     */
+    void release()
+    {
+        _is_prepared = false;
+    }
+
+    bool is_prepared() const
+    {
+        return _is_prepared;
+    }
+
+    int get_num_nodes() const
+    {
+        return static_cast<int>(_nodes.size());
+    }
+
+    /**
+     * @brief Call function(address, size) on each allocation process() and
+     *        the workers touch, so that the targeted memory lock mode can
+     *        lock them. Only complete once prepared.
+     */
+    template<typename Function>
+    void for_each_rt_region(Function function) const
+    {
+        function(_nodes.data(), _nodes.size() * sizeof(_nodes[0]));
+        for (const auto& node : _nodes)
+        {
+            function(node.get(), sizeof(Node));
+            function(node->successors.data(), node->successors.size() * sizeof(int));
+        }
+        function(_topological_order.data(), _topological_order.size() * sizeof(int));
+        function(_roots.data(), _roots.size() * sizeof(int));
+        function(_deques.data(), _deques.size() * sizeof(_deques[0]));
+        for (const auto& deque : _deques)
+        {
+            function(deque.get(), sizeof(GraphWorkDeque));
+        }
+    }
+
+    /**
+     * @brief Run all the nodes once, from the rt thread. Returns when all
+     *        the nodes have completed. Does not block nor make system calls,
+     *        besides those of the nodes and of the clock.
+     *
+     * @return RASPA_SUCCESS upon success, -RASPA_EGRAPH_NOT_READY if the graph
+     *         is not prepared.
+     */
+    int process()
+    {
+        if (!_is_prepared)
+        {
+            return -RASPA_EGRAPH_NOT_READY;
+        }
+        if (_nodes.empty())
+        {
+            return RASPA_SUCCESS;
+        }
+
+        for (auto& node : _nodes)
+        {
+            node->pending.store(node->num_predecessors, std::memory_order_relaxed);
+        }
+        _remaining.store(static_cast<int>(_nodes.size()), std::memory_order_relaxed);
+        for (auto root : _roots)
+        {
+            _deques[0]->push(root);
+        }
+
+        // wakes up the workers
+        _epoch.fetch_add(1, std::memory_order_release);
+        _run_until_done(0);
+
+        if (++_period_count % GRAPH_PRIORITY_UPDATE_PERIODS == 0)
+        {
+            _update_priorities();
+        }
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Worker thread body, returns after stop_workers() is called.
+     *
+     * @param worker The worker index, from 1 to the number of workers given
+     *        to prepare()
+     */
+    void run_worker(int worker)
+    {
+        if (!_is_prepared || worker < 1 || worker > _num_workers)
+        {
+            return;
+        }
+
+        auto epoch = _epoch.load(std::memory_order_acquire);
+        int num_polls = 0;
+        while (!_stop_workers.load(std::memory_order_relaxed))
+        {
+            auto current_epoch = _epoch.load(std::memory_order_acquire);
+            if (current_epoch != epoch)
+            {
+                epoch = current_epoch;
+                _run_until_done(worker);
+                num_polls = 0;
+            }
+            else if (num_polls < GRAPH_WORKER_SPIN_COUNT)
+            {
+                num_polls++;
+                _cpu_relax();
+            }
+            else
+            {
+                _idle_function();
+            }
+        }
+    }
+
+    /**
+     * @brief Get the timing statistics of a node. Any thread.
+     *
+     * @return RASPA_SUCCESS upon success, -RASPA_EGRAPH_NODE otherwise.
+     */
+    int get_node_stats(int node, RaspaGraphNodeStats* stats) const
+    {
+        if (!_is_valid(node) || stats == nullptr)
+        {
+            return -RASPA_EGRAPH_NODE;
+        }
+
+        const auto& n = *_nodes[node];
+        auto start = n.last_start_ns.load(std::memory_order_relaxed);
+        auto end = n.last_end_ns.load(std::memory_order_relaxed);
+        stats->last_ns = end > start ? end - start : 0;
+        stats->avg_ns = n.avg_ns_shared.load(std::memory_order_relaxed);
+        stats->max_ns = n.max_ns.load(std::memory_order_relaxed);
+        stats->critical_path_ns = n.priority_ns.load(std::memory_order_relaxed);
+        stats->last_worker = n.last_worker.load(std::memory_order_relaxed);
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Get the timing of a node in the last period, for the run log.
+     *        Only meaningful from the rt thread after process() returned.
+     */
+    void get_last_timing(int node, int64_t& start_ns, int64_t& end_ns, int& worker) const
+    {
+        const auto& n = *_nodes[node];
+        start_ns = n.last_start_ns.load(std::memory_order_relaxed);
+        end_ns = n.last_end_ns.load(std::memory_order_relaxed);
+        worker = n.last_worker.load(std::memory_order_relaxed);
+    }
+
+    const char* get_node_name(int node) const
+    {
+        return _is_valid(node) ? _nodes[node]->name.c_str() : nullptr;
+    }
+
+private:
+    struct Node
+    {
+        RaspaGraphNodeCallback callback{nullptr};
+        void* data{nullptr};
+        std::string name;
+        std::vector<int> successors;
+        int num_predecessors{0};
+
+        std::atomic<int> pending{0};
+
+        // average duration, only accessed by the rt thread outside of process()
+        int64_t avg_ns{0};
+
+        std::atomic<int64_t> avg_ns_shared{0};
+        std::atomic<int64_t> priority_ns{0};
+        std::atomic<int64_t> max_ns{0};
+        std::atomic<int64_t> last_start_ns{0};
+        std::atomic<int64_t> last_end_ns{0};
+        std::atomic<int> last_worker{0};
+    };
+
+    static int64_t _default_get_time_ns()
+    {
+        struct timespec tp;
+        clock_gettime(CLOCK_MONOTONIC, &tp);
+        return static_cast<int64_t>(tp.tv_sec) * 1000000000 + tp.tv_nsec;
+    }
+
+    static void _default_idle()
+    {
+        std::this_thread::yield();
+    }
+
+    static void _cpu_relax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield");
+#endif
+    }
+
+    bool _is_valid(int node) const
+    {
+        return node >= 0 && node < static_cast<int>(_nodes.size());
+    }
+
+    void _run_until_done(int worker)
+    {
+        // also left on stop, in case the rt thread was cancelled in the middle of a period
+        while (_remaining.load(std::memory_order_acquire) > 0 && !_stop_workers.load(std::memory_order_relaxed))
+        {
+            int node;
+            if (_deques[worker]->pop(node) || _steal(worker, node))
+            {
+                _execute(node, worker);
+            }
+            else
+            {
+                _cpu_relax();
+            }
+        }
+    }
+
+    bool _steal(int worker, int& node)
+    {
+        for (int i = 1; i <= _num_workers; i++)
+        {
+            if (_deques[(worker + i) % (_num_workers + 1)]->steal(node))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void _execute(int node, int worker)
+    {
+        auto& n = *_nodes[node];
+        auto start = _get_time_ns();
+        n.callback(n.data);
+        auto end = _get_time_ns();
+
+        n.last_start_ns.store(start, std::memory_order_relaxed);
+        n.last_end_ns.store(end, std::memory_order_relaxed);
+        n.last_worker.store(worker, std::memory_order_relaxed);
+        if (end - start > n.max_ns.load(std::memory_order_relaxed))
+        {
+            n.max_ns.store(end - start, std::memory_order_relaxed);
+        }
+
+        // successors are sorted by increasing critical path, the longest is popped first
+        for (auto successor : n.successors)
+        {
+            if (_nodes[successor]->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                _deques[worker]->push(successor);
+            }
+        }
+
+        // last, the period is complete once all nodes are
+        _remaining.fetch_sub(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Update the average durations and the critical path lengths, and
+     *        sort the successors and roots accordingly. Called while no node
+     *        runs, sorting in place does not allocate.
+     */
+    void _update_priorities()
+    {
+        for (auto it = _topological_order.rbegin(); it != _topological_order.rend(); it++)
+        {
+            auto& n = *_nodes[*it];
+            auto start = n.last_start_ns.load(std::memory_order_relaxed);
+            auto end = n.last_end_ns.load(std::memory_order_relaxed);
+            if (end > start)
+            {
+                n.avg_ns += (end - start - n.avg_ns) >> GRAPH_AVERAGE_SHIFT;
+                n.avg_ns_shared.store(n.avg_ns, std::memory_order_relaxed);
+            }
+
+            int64_t longest_successor = 0;
+            for (auto successor : n.successors)
+            {
+                longest_successor = std::max(longest_successor,
+                                             _nodes[successor]->priority_ns.load(std::memory_order_relaxed));
+            }
+            // unmeasured nodes count as 1 ns, so the path with more nodes goes first
+            n.priority_ns.store(std::max<int64_t>(n.avg_ns, 1) + longest_successor,
+                                std::memory_order_relaxed);
+        }
+
+        auto by_priority = [this](int a, int b)
+        {
+            return _nodes[a]->priority_ns.load(std::memory_order_relaxed) <
+                   _nodes[b]->priority_ns.load(std::memory_order_relaxed);
+        };
+        for (auto& node : _nodes)
+        {
+            std::sort(node->successors.begin(), node->successors.end(), by_priority);
+        }
+        std::sort(_roots.begin(), _roots.end(), by_priority);
+    }
+
+    int64_t (*_get_time_ns)();
+    void (*_idle_function)();
+
+    std::vector<std::unique_ptr<Node>> _nodes;
+    std::vector<int> _topological_order;
+    std::vector<int> _roots;
+    std::vector<std::unique_ptr<GraphWorkDeque>> _deques;
+
+    std::atomic<bool> _is_prepared;
+    int _num_workers;
+    alignas(64) std::atomic<int> _remaining;
+    alignas(64) std::atomic<uint64_t> _epoch;
+    std::atomic<bool> _stop_workers;
+    int64_t _period_count;
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_GRAPH_EXECUTOR_H
@@ -0,0 +1,454 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class RaspaIsolationAudit, which checks how well the
+ *        audio cpu is shielded from the rest of the system: isolcpus and
+ *        nohz_full, the interrupts of other devices and the threads of other
+ *        processes allowed on it. Optionally moves those interrupts away.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_ISOLATION_AUDIT_H
+#define RASPA_ISOLATION_AUDIT_H
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/sysinfo.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "raspa/raspa.h"
+#include "raspa_error_codes.h"
+
+namespace raspa {
+
+constexpr char CPU_ISOLATED_FILE[] = "/sys/devices/system/cpu/isolated";
+constexpr char CPU_NOHZ_FULL_FILE[] = "/sys/devices/system/cpu/nohz_full";
+constexpr char PROC_DIR[] = "/proc";
+constexpr char PROC_IRQ_DIR[] = "/proc/irq";
+
+// the irq handlers of the audio drivers are named after their audio_* sysfs class
+constexpr char AUDIO_IRQ_NAME[] = "audio";
+
+// parent of all the kernel threads
+constexpr int KTHREADD_PID = 2;
+
+// findings listed by the printed report, of each kind
+constexpr size_t ISOLATION_AUDIT_MAX_LISTED = 10;
+
+/**
+ * @brief One flag per cpu.
+ */
+using CpuSet = std::vector<bool>;
+
+/**
+ * @brief Parse a cpu list as found in sysfs, e.g. "1-3,6". Cpus from
+ *        num_cpus on are ignored.
+ */
+inline CpuSet parse_cpu_list(const std::string& list, int num_cpus)
+{
+    CpuSet cpus(num_cpus, false);
+    const char* pos = list.c_str();
+    while (*pos)
+    {
+        char* end;
+        long first = std::strtol(pos, &end, 10);
+        if (end == pos)
+        {
+            break;
+        }
+        long last = first;
+        if (*end == '-')
+        {
+            pos = end + 1;
+            last = std::strtol(pos, &end, 10);
+        }
+        for (long cpu = first; cpu <= last && cpu < num_cpus; cpu++)
+        {
+            cpus[cpu] = true;
+        }
+        pos = *end == ',' ? end + 1 : end;
+    }
+    return cpus;
+}
+
+/**
+ * @brief Parse a hex cpu mask as found in /proc/irq/N/smp_affinity, e.g.
+ *        "ff,fffffff0". Cpus from num_cpus on are ignored.
+ */
+inline CpuSet parse_cpu_mask(const std::string& mask, int num_cpus)
+{
+    CpuSet cpus(num_cpus, false);
+    int cpu = 0;
+    for (auto digit = mask.rbegin(); digit != mask.rend(); digit++)
+    {
+        if (!std::isxdigit(static_cast<unsigned char>(*digit)))
+        {
+            continue;
+        }
+        int value = std::isdigit(static_cast<unsigned char>(*digit)) ?
+                    *digit - '0' : std::tolower(static_cast<unsigned char>(*digit)) - 'a' + 10;
+        for (int bit = 0; bit < 4; bit++, cpu++)
+        {
+            if ((value & (1 << bit)) && cpu < num_cpus)
+            {
+                cpus[cpu] = true;
+            }
+        }
+    }
+    return cpus;
+}
+
+/**
+ * @brief Format a cpu set as a hex mask in groups of 32 cpus, as written to
+ *        /proc/irq/N/smp_affinity.
+ */
+inline std::string format_cpu_mask(const CpuSet& cpus)
+{
+    int num_groups = std::max<int>((static_cast<int>(cpus.size()) + 31) / 32, 1);
+    std::string mask;
+    for (int group = num_groups - 1; group >= 0; group--)
+    {
+        uint32_t bits = 0;
+        for (int bit = 0; bit < 32; bit++)
+        {
+            size_t cpu = group * 32 + bit;
+            if (cpu < cpus.size() && cpus[cpu])
+            {
+                bits |= 1u << bit;
+            }
+        }
+        char text[9];
+        std::snprintf(text, sizeof(text), "%08x", bits);
+        mask += text;
+        mask += group > 0 ? "," : "";
+    }
+    return mask;
+}
+
+inline int count_cpus(const CpuSet& cpus)
+{
+    int count = 0;
+    for (auto cpu : cpus)
+    {
+        count += cpu ? 1 : 0;
+    }
+    return count;
+}
+
+/**
+ * @brief Internal class used by raspa to audit the isolation of the audio
+ *        cpu. Reads /proc and /sys, it must not be used from the rt thread.
+ */
+class RaspaIsolationAudit
+{
+public:
+    /**
+     * @param root Prefix of the /proc and /sys paths, for tests
+     * @param num_cpus Number of cpus of the system
+     */
+    explicit RaspaIsolationAudit(const std::string& root = "", int num_cpus = get_nprocs_conf()) : _root(root),
+                                                                                                  _num_cpus(num_cpus)
+    {}
+
+    ~RaspaIsolationAudit()
+    {
+        restore_irqs();
+    }
+
+    /**
+     * @brief Check the isolation of a cpu.
+     * @param cpu The audio cpu
+     * @param steer_irqs If true, remove the cpu from the affinity of the
+     *        interrupts of other devices. Interrupts pinned to the cpu alone
+     *        are left there, as they were put there on purpose.
+     *        restore_irqs() puts them back.
+     * @param report Filled with the counts of findings
+     * @param print If true, also print the findings to stdout
+     * @return RASPA_SUCCESS upon success, -RASPA_EISOLATION_AUDIT if the
+     *         interrupts can't be listed.
+     */
+    int audit(int cpu, bool steer_irqs, RaspaIsolationReport* report, bool print)
+    {
+        *report = {};
+        report->cpu = cpu;
+        _foreign_irqs.clear();
+        _foreign_threads.clear();
+        if (cpu < 0 || cpu >= _num_cpus)
+        {
+            return -RASPA_EISOLATION_AUDIT;
+        }
+
+        report->isolated = parse_cpu_list(_read_line(CPU_ISOLATED_FILE), _num_cpus)[cpu] ? 1 : 0;
+        report->nohz_full = parse_cpu_list(_read_line(CPU_NOHZ_FULL_FILE), _num_cpus)[cpu] ? 1 : 0;
+
+        auto res = _audit_irqs(cpu, steer_irqs, report);
+        if (res != RASPA_SUCCESS)
+        {
+            return res;
+        }
+        _audit_threads(cpu, report);
+
+        if (print)
+        {
+            _print_report(*report);
+        }
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Put back the affinity of the interrupts moved by audit(). It is
+     *        always safe to call this function.
+     * @return Number of interrupts which could not be restored.
+     */
+    int restore_irqs()
+    {
+        int failures = 0;
+        for (const auto& irq : _moved_irqs)
+        {
+            failures += _write_irq_affinity(irq.first, irq.second) ? 0 : 1;
+        }
+        _moved_irqs.clear();
+        return failures;
+    }
+
+private:
+    std::string _path(const std::string& path) const
+    {
+        return _root + path;
+    }
+
+    std::string _read_line(const std::string& path) const
+    {
+        std::string line;
+        auto file = std::fopen(_path(path).c_str(), "r");
+        if (file)
+        {
+            char buffer[512];
+            if (std::fgets(buffer, sizeof(buffer), file))
+            {
+                line = buffer;
+            }
+            std::fclose(file);
+        }
+        return line;
+    }
+
+    bool _write_irq_affinity(int irq, const std::string& mask)
+    {
+        auto path = _path(PROC_IRQ_DIR) + "/" + std::to_string(irq) + "/smp_affinity";
+        int fd = open(path.c_str(), O_WRONLY | O_TRUNC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        // per cpu interrupts refuse the new affinity here
+        bool written = write(fd, mask.c_str(), mask.size()) == static_cast<ssize_t>(mask.size());
+        return close(fd) == 0 && written;
+    }
+
+    static std::vector<std::string> _list_dir(const std::string& path, bool numeric_only, bool dirs_only)
+    {
+        std::vector<std::string> entries;
+        auto dir = opendir(path.c_str());
+        if (!dir)
+        {
+            return entries;
+        }
+        while (auto entry = readdir(dir))
+        {
+            if (entry->d_name[0] == '.' ||
+                (numeric_only && !std::isdigit(static_cast<unsigned char>(entry->d_name[0]))) ||
+                (dirs_only && entry->d_type != DT_DIR))
+            {
+                continue;
+            }
+            entries.emplace_back(entry->d_name);
+        }
+        closedir(dir);
+        return entries;
+    }
+
+    int _audit_irqs(int cpu, bool steer_irqs, RaspaIsolationReport* report)
+    {
+        auto irq_dir = _path(PROC_IRQ_DIR);
+        if (access(irq_dir.c_str(), R_OK) != 0)
+        {
+            return -RASPA_EISOLATION_AUDIT;
+        }
+
+        for (const auto& irq_name : _list_dir(irq_dir, true, true))
+        {
+            // the handlers are the subdirectories, interrupts without one are not in use
+            auto handlers = _list_dir(irq_dir + "/" + irq_name, false, true);
+            if (handlers.empty())
+            {
+                continue;
+            }
+            std::string names;
+            bool is_audio = false;
+            for (const auto& handler : handlers)
+            {
+                is_audio |= handler.find(AUDIO_IRQ_NAME) != std::string::npos;
+                names += names.empty() ? handler : "," + handler;
+            }
+
+            auto mask = _read_line(std::string(PROC_IRQ_DIR) + "/" + irq_name + "/smp_affinity");
+            auto affinity = parse_cpu_mask(mask, _num_cpus);
+            if (is_audio || !affinity[cpu])
+            {
+                continue;
+            }
+
+            report->num_foreign_irqs++;
+            bool pinned = count_cpus(affinity) == 1;
+            bool moved = false;
+            if (steer_irqs && !pinned)
+            {
+                auto new_affinity = affinity;
+                new_affinity[cpu] = false;
+                int irq = std::atoi(irq_name.c_str());
+                if (_write_irq_affinity(irq, format_cpu_mask(new_affinity)))
+                {
+                    // keep the mask as read, minus the line end
+                    mask.erase(mask.find_last_not_of(" \n") + 1);
+                    _moved_irqs.emplace_back(irq, mask);
+                    report->num_moved_irqs++;
+                    moved = true;
+                }
+            }
+            _foreign_irqs.push_back("irq " + irq_name + " (" + names + ")" +
+                                    (pinned ? " pinned to the cpu" : "") + (moved ? " moved" : ""));
+        }
+        return RASPA_SUCCESS;
+    }
+
+    void _audit_threads(int cpu, RaspaIsolationReport* report)
+    {
+        auto own_pid = std::to_string(getpid());
+        auto proc_dir = _path(PROC_DIR);
+        for (const auto& pid : _list_dir(proc_dir, true, false))
+        {
+            if (pid == own_pid)
+            {
+                continue;
+            }
+            auto task_dir = proc_dir + "/" + pid + "/task";
+            for (const auto& tid : _list_dir(task_dir, true, false))
+            {
+                std::string name;
+                int parent_pid = -1;
+                std::string allowed;
+                if (!_read_status(task_dir + "/" + tid + "/status", name, parent_pid, allowed))
+                {
+                    continue;
+                }
+
+                auto cpus = parse_cpu_list(allowed, _num_cpus);
+                if (!cpus[cpu])
+                {
+                    continue;
+                }
+                bool is_kernel_thread = std::atoi(pid.c_str()) == KTHREADD_PID || parent_pid == KTHREADD_PID;
+                if (is_kernel_thread)
+                {
+                    // per cpu kernel threads can't be moved and are expected
+                    if (count_cpus(cpus) == 1)
+                    {
+                        continue;
+                    }
+                    report->num_kernel_threads++;
+                }
+                else
+                {
+                    report->num_user_threads++;
+                }
+                _foreign_threads.push_back((is_kernel_thread ? "kthread " : "thread ") + tid + " (" + name + ")");
+            }
+        }
+    }
+
+    static bool _read_status(const std::string& path, std::string& name, int& parent_pid, std::string& allowed)
+    {
+        auto file = std::fopen(path.c_str(), "r");
+        if (!file)
+        {
+            return false;
+        }
+        char line[512];
+        char text[256];
+        while (std::fgets(line, sizeof(line), file))
+        {
+            if (std::sscanf(line, "Name: %255s", text) == 1)
+            {
+                name = text;
+            }
+            else if (std::sscanf(line, "Cpus_allowed_list: %255s", text) == 1)
+            {
+                allowed = text;
+            }
+            else
+            {
+                std::sscanf(line, "PPid: %d", &parent_pid);
+            }
+        }
+        std::fclose(file);
+        return !allowed.empty();
+    }
+
+    void _print_report(const RaspaIsolationReport& report) const
+    {
+        printf("Raspa isolation audit of cpu %d\n", report.cpu);
+        printf("isolcpus: %s, nohz_full: %s\n", report.isolated ? "yes" : "NO", report.nohz_full ? "yes" : "NO");
+        printf("Interrupts of other devices allowed on the cpu: %d, moved: %d\n",
+               report.num_foreign_irqs, report.num_moved_irqs);
+        _print_list(_foreign_irqs);
+        printf("Threads of other processes allowed on the cpu: %d, unbound kernel threads: %d\n",
+               report.num_user_threads, report.num_kernel_threads);
+        _print_list(_foreign_threads);
+    }
+
+    static void _print_list(const std::vector<std::string>& findings)
+    {
+        for (size_t i = 0; i < findings.size() && i < ISOLATION_AUDIT_MAX_LISTED; i++)
+        {
+            printf("  %s\n", findings[i].c_str());
+        }
+        if (findings.size() > ISOLATION_AUDIT_MAX_LISTED)
+        {
+            printf("  and %zu more\n", findings.size() - ISOLATION_AUDIT_MAX_LISTED);
+        }
+    }
+
+    std::string _root;
+    int _num_cpus;
+    std::vector<std::pair<int, std::string>> _moved_irqs;
+    std::vector<std::string> _foreign_irqs;
+    std::vector<std::string> _foreign_threads;
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_ISOLATION_AUDIT_H
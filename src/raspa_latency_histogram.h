@@ -0,0 +1,158 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class RaspaLatencyHistogram, which collects the wakeup
+ *        latencies measured by misc/rt_probe, and of the buffer size
+ *        recommendation made from them.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_LATENCY_HISTOGRAM_H
+#define RASPA_LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace raspa {
+
+// 1 us bins, latencies above the last bin are counted as overflows
+constexpr int LATENCY_HISTOGRAM_NUM_BINS = 2000;
+
+/**
+ * @brief Histogram of latencies with a resolution of 1 us. add() is rt safe,
+ *        the rest is meant to be called once the measurement is over.
+ */
+class RaspaLatencyHistogram
+{
+public:
+    RaspaLatencyHistogram() : _bins(LATENCY_HISTOGRAM_NUM_BINS, 0)
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(_bins.begin(), _bins.end(), 0);
+        _count = 0;
+        _overflows = 0;
+        _sum_ns = 0;
+        _max_ns = 0;
+    }
+
+    /**
+     * @brief Add one latency. Rt safe.
+     */
+    void add(int64_t latency_ns)
+    {
+        latency_ns = std::max<int64_t>(latency_ns, 0);
+        auto bin = latency_ns / 1000;
+        if (bin < LATENCY_HISTOGRAM_NUM_BINS)
+        {
+            _bins[bin]++;
+        }
+        else
+        {
+            _overflows++;
+        }
+        _count++;
+        _sum_ns += latency_ns;
+        _max_ns = std::max(_max_ns, latency_ns);
+    }
+
+    int64_t get_count() const
+    {
+        return _count;
+    }
+
+    int64_t get_overflows() const
+    {
+        return _overflows;
+    }
+
+    /**
+     * @brief Number of latencies from bin_us to bin_us + 1 us.
+     */
+    int64_t get_bin(int bin_us) const
+    {
+        return _bins[bin_us];
+    }
+
+    int64_t get_max_us() const
+    {
+        return (_max_ns + 999) / 1000;
+    }
+
+    int64_t get_mean_us() const
+    {
+        return _count > 0 ? _sum_ns / _count / 1000 : 0;
+    }
+
+    /**
+     * @brief Get a percentile, rounded up to the end of its bin.
+     * @param percentile The percentile, from 0 to 100
+     * @return The latency in us, the max latency if it is in the overflows.
+     */
+    int64_t get_percentile_us(double percentile) const
+    {
+        auto threshold = static_cast<int64_t>(_count * percentile / 100.0);
+        int64_t accumulated = 0;
+        for (int bin = 0; bin < LATENCY_HISTOGRAM_NUM_BINS; bin++)
+        {
+            accumulated += _bins[bin];
+            if (accumulated > threshold || (accumulated == _count && accumulated > 0))
+            {
+                return bin + 1;
+            }
+        }
+        return get_max_us();
+    }
+
+private:
+    std::vector<int64_t> _bins;
+    int64_t _count;
+    int64_t _overflows;
+    int64_t _sum_ns;
+    int64_t _max_ns;
+};
+
+/**
+ * @brief Get the smallest buffer size whose period can absorb a wakeup
+ *        latency and still leave the process callback most of the period.
+ * @param buffer_sizes The candidate sizes, in increasing order
+ * @param sample_rate The sampling rate in Hz
+ * @param latency_us The worst wakeup latency
+ * @param max_period_share The share of the period the latency may take
+ * @return The buffer size, 0 if none of the candidates is safe.
+ */
+inline int get_smallest_safe_buffer_size(const std::vector<int>& buffer_sizes,
+                                         float sample_rate,
+                                         int64_t latency_us,
+                                         float max_period_share)
+{
+    for (auto size : buffer_sizes)
+    {
+        double period_us = size * 1000000.0 / sample_rate;
+        if (latency_us <= period_us * max_period_share)
+        {
+            return size;
+        }
+    }
+    return 0;
+}
+
+}  // namespace raspa
+
+#endif  // RASPA_LATENCY_HISTOGRAM_H
@@ -0,0 +1,296 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class RaspaLoadPolicy, which watches the load of the
+ *        process callback and picks the buffer size the session should run
+ *        with, among the supported ones.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_LOAD_POLICY_H
+#define RASPA_LOAD_POLICY_H
+
+#include <algorithm>
+#include <vector>
+
+#include "raspa/raspa.h"
+#include "raspa_error_codes.h"
+
+namespace raspa {
+
+// Length of the windows the load is averaged over
+constexpr RaspaMicroSec LOAD_POLICY_WINDOW_US = 100000;
+
+// Going back to a smaller buffer size needs this many times the hold time of low load
+constexpr int LOAD_POLICY_DOWN_HOLD_MULTIPLIER = 4;
+
+// Number of periods the outputs are faded over, around a buffer size change
+constexpr int LOAD_POLICY_FADE_PERIODS = 4;
+
+/**
+ * @brief Load adaptive buffer size selection. update() is called by the rt
+ *        thread at the end of every period. The load of each window is the
+ *        callback time over the window time; a window is high if its load is
+ *        above the high threshold or a period was missed, low if its load is
+ *        below the low threshold. After enough consecutive high windows the
+ *        next larger supported size is asked for, and after a longer run of
+ *        low windows the next smaller one, never below the size the session
+ *        was first opened with. Only one change is pending at a time, until
+ *        the device is opened again with the new size.
+ */
+class RaspaLoadPolicy
+{
+public:
+    /**
+     * @brief Construct the policy.
+     * @param buffer_sizes The buffer sizes the policy can choose, in increasing order
+     */
+    explicit RaspaLoadPolicy(std::vector<int> buffer_sizes) : _buffer_sizes(std::move(buffer_sizes))
+    {}
+
+    /**
+     * @brief Set the thresholds. Not rt safe.
+     * @param high_load Load above which the buffer size is increased, in (0, 1]
+     * @param low_load Load below which the buffer size is decreased, in [0, high_load)
+     * @param hold_time_ms Time the load must stay high before changing
+     * @return RASPA_SUCCESS upon success, -RASPA_ELOAD_POLICY if invalid
+     */
+    int configure(float high_load, float low_load, int hold_time_ms)
+    {
+        if (!(high_load > 0.0f && high_load <= 1.0f && low_load >= 0.0f && low_load < high_load) ||
+            hold_time_ms <= 0)
+        {
+            return -RASPA_ELOAD_POLICY;
+        }
+
+        _high_load = high_load;
+        _low_load = low_load;
+        auto hold_time_us = static_cast<RaspaMicroSec>(hold_time_ms) * 1000;
+        _up_hold_windows = std::max(1, static_cast<int>(hold_time_us / LOAD_POLICY_WINDOW_US));
+        _down_hold_windows = _up_hold_windows * LOAD_POLICY_DOWN_HOLD_MULTIPLIER;
+        _min_buffer_size = 0;
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Start watching a session. Not rt safe.
+     * @param buffer_size_in_frames The buffer size the device was opened with
+     * @param period_time_us The duration of a period
+     */
+    void start(int buffer_size_in_frames, RaspaMicroSec period_time_us)
+    {
+        // the first size opened is the lowest the policy goes back to
+        if (_min_buffer_size == 0)
+        {
+            _min_buffer_size = buffer_size_in_frames;
+        }
+        _buffer_size = buffer_size_in_frames;
+        _requested_buffer_size = buffer_size_in_frames;
+        _period_time_us = period_time_us;
+        _window_periods = std::max<int>(1, period_time_us > 0 ? LOAD_POLICY_WINDOW_US / period_time_us : 1);
+        _num_window_periods = 0;
+        _window_time_us = 0;
+        _window_missed = false;
+        _num_high_windows = 0;
+        _num_low_windows = 0;
+    }
+
+    /**
+     * @brief Account for one period. Rt safe.
+     * @param callback_time_us Time spent processing the period
+     * @param num_missed_periods Periods lost before this one
+     * @return The new buffer size asked for, 0 if no change
+     */
+    int update(RaspaMicroSec callback_time_us, int64_t num_missed_periods)
+    {
+        if (_period_time_us <= 0)
+        {
+            return 0;
+        }
+
+        _window_time_us += callback_time_us;
+        _window_missed |= num_missed_periods > 0;
+        if (++_num_window_periods < _window_periods)
+        {
+            return 0;
+        }
+
+        _last_load = static_cast<float>(_window_time_us) / (_window_periods * _period_time_us);
+        if (_window_missed || _last_load > _high_load)
+        {
+            _num_high_windows++;
+            _num_low_windows = 0;
+        }
+        else if (_last_load < _low_load)
+        {
+            _num_low_windows++;
+            _num_high_windows = 0;
+        }
+        else
+        {
+            _num_high_windows = 0;
+            _num_low_windows = 0;
+        }
+        _num_window_periods = 0;
+        _window_time_us = 0;
+        _window_missed = false;
+
+        if (_requested_buffer_size != _buffer_size)
+        {
+            return 0;
+        }
+
+        int new_size = 0;
+        if (_num_high_windows >= _up_hold_windows)
+        {
+            new_size = get_next_buffer_size(_buffer_size, true);
+        }
+        else if (_num_low_windows >= _down_hold_windows && _buffer_size > _min_buffer_size)
+        {
+            new_size = std::max(get_next_buffer_size(_buffer_size, false), _min_buffer_size);
+        }
+
+        if (new_size > 0 && new_size != _buffer_size)
+        {
+            _requested_buffer_size = new_size;
+            return new_size;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Get the buffer size the session should run with.
+     */
+    int get_requested_buffer_size() const
+    {
+        return _requested_buffer_size;
+    }
+
+    /**
+     * @brief Get the load of the last complete window, in [0, 1] unless overloaded.
+     */
+    float get_last_load() const
+    {
+        return _last_load;
+    }
+
+    /**
+     * @brief Get the supported buffer size next to a given one.
+     * @param buffer_size_in_frames The current buffer size
+     * @param larger Look for the next larger size if true, smaller otherwise
+     * @return The next size, or buffer_size_in_frames if there is none
+     */
+    int get_next_buffer_size(int buffer_size_in_frames, bool larger) const
+    {
+        auto begin = _buffer_sizes.begin();
+        auto end = _buffer_sizes.end();
+        if (larger)
+        {
+            auto next = std::upper_bound(begin, end, buffer_size_in_frames);
+            return next != end ? *next : buffer_size_in_frames;
+        }
+        auto next = std::lower_bound(begin, end, buffer_size_in_frames);
+        return next != begin ? *std::prev(next) : buffer_size_in_frames;
+    }
+
+private:
+    std::vector<int> _buffer_sizes;
+    float _high_load{1.0f};
+    float _low_load{0.0f};
+    int _up_hold_windows{1};
+    int _down_hold_windows{LOAD_POLICY_DOWN_HOLD_MULTIPLIER};
+    int _min_buffer_size{0};
+
+    int _buffer_size{0};
+    int _requested_buffer_size{0};
+    RaspaMicroSec _period_time_us{0};
+    int _window_periods{1};
+    int _num_window_periods{0};
+    RaspaMicroSec _window_time_us{0};
+    bool _window_missed{false};
+    int _num_high_windows{0};
+    int _num_low_windows{0};
+    float _last_load{0.0f};
+};
+
+/**
+ * @brief Gain ramp applied to the outputs, so that the restart of the device
+ *        with a new buffer size is muted instead of clicking. Rt safe.
+ */
+class RaspaOutputFade
+{
+public:
+    /**
+     * @brief Start fading in from silence, or out to silence.
+     * @param num_frames The total length of the fade in frames
+     */
+    void start(bool fade_in, int num_frames)
+    {
+        _step = 1.0f / std::max(1, num_frames);
+        _gain = fade_in ? 0.0f : 1.0f;
+        _target = fade_in ? 1.0f : 0.0f;
+        _active = true;
+    }
+
+    /**
+     * @brief Apply the fade to one period of the output buffer.
+     */
+    void process(float* buffer, int num_chans, int chan_stride, int num_frames)
+    {
+        if (!_active)
+        {
+            if (_target == 0.0f)
+            {
+                for (int c = 0; c < num_chans; c++)
+                {
+                    std::fill_n(buffer + c * chan_stride, num_frames, 0.0f);
+                }
+            }
+            return;
+        }
+
+        float direction = _target > _gain ? _step : -_step;
+        for (int c = 0; c < num_chans; c++)
+        {
+            float gain = _gain;
+            float* channel = buffer + c * chan_stride;
+            for (int i = 0; i < num_frames; i++)
+            {
+                gain = std::clamp(gain + direction, 0.0f, 1.0f);
+                channel[i] *= gain;
+            }
+        }
+        _gain = std::clamp(_gain + direction * num_frames, 0.0f, 1.0f);
+        _active = _gain != _target;
+    }
+
+    /**
+     * @brief True once a fade out is complete and the outputs are silent.
+     */
+    bool is_muted() const
+    {
+        return !_active && _target == 0.0f;
+    }
+
+private:
+    float _gain{1.0f};
+    float _target{1.0f};
+    float _step{1.0f};
+    bool _active{false};
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_LOAD_POLICY_H
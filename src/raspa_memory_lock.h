@@ -0,0 +1,371 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class RaspaMemoryLock, which locks selected memory
+ *        regions instead of the whole process address space, and reports
+ *        which pages touched by the rt thread are not locked.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_MEMORY_LOCK_H
+#define RASPA_MEMORY_LOCK_H
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "raspa/raspa.h"
+#include "raspa_error_codes.h"
+
+namespace raspa {
+
+/**
+ * @brief A mapping of the process, as listed in /proc/self/smaps
+ */
+struct MemoryMapping
+{
+    uintptr_t start;
+    uintptr_t end;
+    int64_t rss_bytes;
+    bool locked;
+    std::string path;
+};
+
+/**
+ * @brief Read the mappings of the process from /proc/self/smaps.
+ *
+ * @param mappings Filled with the mappings
+ * @return true upon success
+ */
+inline bool read_memory_mappings(std::vector<MemoryMapping>& mappings)
+{
+    auto file = std::fopen("/proc/self/smaps", "r");
+    if (!file)
+    {
+        return false;
+    }
+
+    mappings.clear();
+    char line[512];
+    while (std::fgets(line, sizeof(line), file))
+    {
+        unsigned long start;
+        unsigned long end;
+        char path[256] = {};
+        long value;
+
+        // mapping header: "start-end perms offset dev inode path"
+        if (std::sscanf(line, "%lx-%lx %*s %*s %*s %*s %255s", &start, &end, path) >= 2)
+        {
+            mappings.push_back({start, end, 0, false, path});
+        }
+        else if (mappings.empty())
+        {
+            continue;
+        }
+        else if (std::sscanf(line, "Rss: %ld kB", &value) == 1)
+        {
+            mappings.back().rss_bytes = value * 1024;
+        }
+        else if (std::strncmp(line, "VmFlags:", 8) == 0)
+        {
+            mappings.back().locked = std::strstr(line, " lo") != nullptr;
+        }
+    }
+
+    std::fclose(file);
+    return true;
+}
+
+/**
+ * @brief Read the amount of locked memory of the process.
+ *
+ * @return The locked memory in bytes, negative if not available
+ */
+inline int64_t read_locked_memory_bytes()
+{
+    auto file = std::fopen("/proc/self/status", "r");
+    if (!file)
+    {
+        return -1;
+    }
+
+    int64_t locked_bytes = -1;
+    char line[256];
+    long value;
+    while (std::fgets(line, sizeof(line), file))
+    {
+        if (std::sscanf(line, "VmLck: %ld kB", &value) == 1)
+        {
+            locked_bytes = static_cast<int64_t>(value) * 1024;
+            break;
+        }
+    }
+
+    std::fclose(file);
+    return locked_bytes;
+}
+
+/**
+ * @brief Internal class used by raspa for the targeted memory lock mode. It
+ *        locks the regions it is given and keeps track of them, and of the
+ *        addresses the rt thread is known to touch, so that a report can show
+ *        the mappings holding them which are not locked.
+ *
+ *        Regions are rounded to whole pages. Regions sharing a page with
+ *        other data should not be unlocked, as that unlocks the whole page.
+ */
+class RaspaMemoryLock
+{
+public:
+    RaspaMemoryLock() = default;
+
+    ~RaspaMemoryLock() = default;
+
+    /**
+     * @brief Lock a region and track it.
+     *
+     * @param address Start of the region
+     * @param size Size of the region in bytes
+     * @param name Name of the region in the report
+     * @return RASPA_SUCCESS upon success, -RASPA_EMLOCK otherwise.
+     */
+    int lock(const void* address, size_t size, const char* name)
+    {
+        if (address == nullptr || size == 0)
+        {
+            return -RASPA_EMLOCK;
+        }
+
+        uintptr_t page_size = getpagesize();
+        auto start = reinterpret_cast<uintptr_t>(address) & ~(page_size - 1);
+        auto end = (reinterpret_cast<uintptr_t>(address) + size + page_size - 1) & ~(page_size - 1);
+
+        if (mlock(reinterpret_cast<void*>(start), end - start) < 0)
+        {
+            return -RASPA_EMLOCK;
+        }
+
+        _regions.push_back({start, end, name});
+        add_rt_address(address, name);
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Lock all the mappings of the binary or shared library holding
+     *        the given address, i.e. its code and static data.
+     *
+     * @param address An address in the binary, e.g. a function
+     * @param name Name of the region in the report
+     * @return RASPA_SUCCESS upon success, -RASPA_EMLOCK otherwise.
+     */
+    int lock_object_file(const void* address, const char* name)
+    {
+        std::vector<MemoryMapping> mappings;
+        if (!read_memory_mappings(mappings))
+        {
+            return -RASPA_EMLOCK;
+        }
+
+        auto path = _find_mapping(mappings, reinterpret_cast<uintptr_t>(address));
+        if (path == nullptr || path->path.empty() || path->path[0] != '/')
+        {
+            return -RASPA_EMLOCK;
+        }
+
+        for (const auto& mapping : mappings)
+        {
+            if (mapping.path == path->path &&
+                mlock(reinterpret_cast<void*>(mapping.start), mapping.end - mapping.start) == 0)
+            {
+                _regions.push_back({mapping.start, mapping.end, name});
+            }
+        }
+
+        add_rt_address(address, name);
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Unlock a region previously locked with lock() and stop tracking
+     *        it. Only for regions which do not share pages with other data.
+     *
+     * @param address Start of the region, as passed to lock()
+     */
+    void unlock(const void* address)
+    {
+        uintptr_t page_size = getpagesize();
+        auto start = reinterpret_cast<uintptr_t>(address) & ~(page_size - 1);
+        for (auto region = _regions.begin(); region != _regions.end(); region++)
+        {
+            if (region->start == start)
+            {
+                munlock(reinterpret_cast<void*>(region->start), region->end - region->start);
+                _regions.erase(region);
+                break;
+            }
+        }
+        _remove_rt_address(address);
+    }
+
+    /**
+     * @brief Stop tracking the regions and the rt addresses with the given
+     *        name, when their memory is about to be freed or replaced. The
+     *        pages are not unlocked, as they may be shared with other data.
+     *        Memory given back to the system is unlocked by the kernel.
+     */
+    void forget(const char* name)
+    {
+        for (auto region = _regions.begin(); region != _regions.end();)
+        {
+            region = (region->name == name) ? _regions.erase(region) : region + 1;
+        }
+        remove_rt_addresses(name);
+    }
+
+    /**
+     * @brief Register an address the rt thread touches, to be checked by the
+     *        report.
+     */
+    void add_rt_address(const void* address, const char* name)
+    {
+        if (address != nullptr)
+        {
+            _rt_addresses.push_back({reinterpret_cast<uintptr_t>(address), name});
+        }
+    }
+
+    /**
+     * @brief Stop checking the rt addresses with the given name.
+     */
+    void remove_rt_addresses(const char* name)
+    {
+        for (auto address = _rt_addresses.begin(); address != _rt_addresses.end();)
+        {
+            address = (address->name == name) ? _rt_addresses.erase(address) : address + 1;
+        }
+    }
+
+    /**
+     * @brief Fill the memory report.
+     *
+     * @param report The report
+     * @param print If true, print the locked regions and the unlocked rt
+     *        mappings to stdout
+     * @return RASPA_SUCCESS upon success, -RASPA_EMLOCK if the process
+     *         mappings are not available.
+     */
+    int get_report(RaspaMemoryReport* report, bool print)
+    {
+        std::vector<MemoryMapping> mappings;
+        if (!read_memory_mappings(mappings))
+        {
+            return -RASPA_EMLOCK;
+        }
+
+        report->locked_bytes = read_locked_memory_bytes();
+        report->num_unlocked_rt_mappings = 0;
+        report->unlocked_rt_bytes = 0;
+
+        if (print)
+        {
+            printf("Raspa memory report\n");
+            printf("Locked memory: %lld kB\n", static_cast<long long>(report->locked_bytes / 1024));
+            for (const auto& region : _regions)
+            {
+                printf("  locked   %lx-%lx %s\n", static_cast<unsigned long>(region.start),
+                       static_cast<unsigned long>(region.end), region.name.c_str());
+            }
+        }
+
+        // each unlocked mapping is reported once, even if it holds several rt addresses
+        std::vector<const MemoryMapping*> unlocked;
+        for (const auto& address : _rt_addresses)
+        {
+            auto mapping = _find_mapping(mappings, address.address);
+            if (mapping == nullptr || mapping->locked ||
+                std::find(unlocked.begin(), unlocked.end(), mapping) != unlocked.end())
+            {
+                continue;
+            }
+
+            unlocked.push_back(mapping);
+            report->num_unlocked_rt_mappings++;
+            report->unlocked_rt_bytes += mapping->rss_bytes;
+            if (print)
+            {
+                printf("  UNLOCKED %lx-%lx %s (%s, %lld kB resident)\n",
+                       static_cast<unsigned long>(mapping->start),
+                       static_cast<unsigned long>(mapping->end),
+                       address.name.c_str(),
+                       mapping->path.empty() ? "anonymous" : mapping->path.c_str(),
+                       static_cast<long long>(mapping->rss_bytes / 1024));
+            }
+        }
+
+        return RASPA_SUCCESS;
+    }
+
+private:
+    struct LockedRegion
+    {
+        uintptr_t start;
+        uintptr_t end;
+        std::string name;
+    };
+
+    struct RtAddress
+    {
+        uintptr_t address;
+        std::string name;
+    };
+
+    static const MemoryMapping* _find_mapping(const std::vector<MemoryMapping>& mappings, uintptr_t address)
+    {
+        for (const auto& mapping : mappings)
+        {
+            if (address >= mapping.start && address < mapping.end)
+            {
+                return &mapping;
+            }
+        }
+        return nullptr;
+    }
+
+    void _remove_rt_address(const void* address)
+    {
+        for (auto rt_address = _rt_addresses.begin(); rt_address != _rt_addresses.end(); rt_address++)
+        {
+            if (rt_address->address == reinterpret_cast<uintptr_t>(address))
+            {
+                _rt_addresses.erase(rt_address);
+                break;
+            }
+        }
+    }
+
+    std::vector<LockedRegion> _regions;
+    std::vector<RtAddress> _rt_addresses;
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_MEMORY_LOCK_H
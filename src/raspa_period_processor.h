@@ -0,0 +1,287 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class RaspaPeriodProcessor, the per period processing
+ *        shared by RaspaPimpl and RaspaReplayPimpl, from the driver samples
+ *        of a period to the driver samples sent back.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_PERIOD_PROCESSOR_H
+#define RASPA_PERIOD_PROCESSOR_H
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "raspa/raspa.h"
+#include "raspa_audio_tap.h"
+#include "raspa_event_queue.h"
+#include "raspa_fpu_mode.h"
+#include "raspa_graph_executor.h"
+#include "raspa_load_policy.h"
+#include "raspa_resampler.h"
+#include "raspa_run_logger.h"
+#include "sample_conversion.h"
+
+#ifdef RASPA_WITH_RT_SANITIZER
+    #include "raspa_rt_sanitizer.h"
+#endif
+
+namespace raspa {
+
+/**
+ * @brief Base class of the pimpls, which owns the state used by the process
+ *        callback of each period: sample converters, user buffers, resampler,
+ *        denormal counter, load policy and output fade, run logger and tap.
+ *        The pimpl fills it when opening, then calls _process_period() and
+ *        _end_period() once per period from its rt loop.
+ */
+class RaspaPeriodProcessor
+{
+public:
+    void set_run_log_file(const char* path)
+    {
+        _run_logger_file_name = path;
+    }
+
+protected:
+    RaspaPeriodProcessor() :
+            _user_audio_in{nullptr},
+            _user_audio_out{nullptr},
+            _user_chan_stride(0),
+            _user_buffer_size_in_frames(0),
+            _num_input_chans(0),
+            _num_output_chans(0),
+            _converter_audio_in{nullptr},
+            _converter_audio_out{nullptr},
+            _decimation_factor(1),
+            _user_data(nullptr),
+            _user_callback(nullptr),
+            _user_channel_callback(nullptr),
+            _rt_sanitizer_enable(false),
+            _denormal_count_enable(false),
+            _run_logger_enable(false),
+            _run_logger_file_name(RASPA_DEFAULT_RUN_LOG_FILE),
+            _load_policy_enable(false),
+            _fade_out_request(false),
+            _load_policy(std::vector<int>(std::begin(SUPPORTED_BUFFER_SIZES), std::end(SUPPORTED_BUFFER_SIZES)))
+    {}
+
+    ~RaspaPeriodProcessor() = default;
+
+    /**
+     * @brief Convert the driver input samples, run the process callback and
+     *        convert its output to driver samples. Rt safe.
+     *
+     * @param input_samples The driver input buffer of the period
+     * @param output_samples The driver output buffer of the period
+     * @param period_count The period count, used to sample the denormals
+     */
+    void _process_period(const int32_t* input_samples, int32_t* output_samples, int64_t period_count)
+    {
+        for (auto& converter : _input_sample_converter)
+        {
+            converter->codec_format_to_float32n(_converter_audio_in, input_samples);
+        }
+
+        if (_decimation_factor > 1)
+        {
+            _resampler.decimate(_user_audio_in, _user_chan_stride);
+        }
+
+        bool count_denormals = _denormal_count_enable && RaspaDenormalCounter::is_sampled(period_count);
+        if (count_denormals)
+        {
+            _denormal_counter.count_inputs(_user_audio_in, _user_chan_stride, _user_buffer_size_in_frames);
+        }
+
+#ifdef RASPA_WITH_RT_SANITIZER
+        if (_rt_sanitizer_enable)
+        {
+            RaspaRtSanitizer::arm();
+        }
+#endif
+
+        if (_user_channel_callback)
+        {
+            _user_channel_callback(_user_audio_in_channels.data(), _user_audio_out_channels.data(), _user_data);
+        }
+        else
+        {
+            _user_callback(_user_audio_in, _user_audio_out, _user_data);
+        }
+
+#ifdef RASPA_WITH_RT_SANITIZER
+        RaspaRtSanitizer::disarm();
+#endif
+
+        if (count_denormals)
+        {
+            _denormal_counter.count_outputs(_user_audio_out, _user_chan_stride, _user_buffer_size_in_frames);
+        }
+
+        if (_load_policy_enable)
+        {
+            if (_fade_out_request && !_output_fade.is_muted())
+            {
+                _fade_out_request = false;
+                _output_fade.start(false, LOAD_POLICY_FADE_PERIODS * _user_buffer_size_in_frames);
+            }
+            _output_fade.process(_user_audio_out, _num_output_chans, _user_chan_stride, _user_buffer_size_in_frames);
+        }
+
+        if (_decimation_factor > 1)
+        {
+            _resampler.interpolate(_user_audio_out, _user_chan_stride);
+        }
+
+        for (auto& converter : _output_sample_converter)
+        {
+            converter->float32n_to_codec_format(output_samples, _converter_audio_out);
+        }
+    }
+
+    /**
+     * @brief Log the period timing, update the load policy and publish the
+     *        period to the tap. Rt safe.
+     *
+     * @param t_start The start time of the period processing
+     * @param t_end The end time of the period processing
+     * @param num_lost_periods The number of periods lost before this one
+     * @param period_count The period count
+     */
+    void _end_period(RaspaMicroSec t_start, RaspaMicroSec t_end, int64_t num_lost_periods, int64_t period_count)
+    {
+        if (_run_logger_enable)
+        {
+            _run_logger.put(t_start, t_end);
+        }
+
+        if (_load_policy_enable)
+        {
+            auto new_buffer_size = _load_policy.update(t_end - t_start, num_lost_periods);
+            if (new_buffer_size > 0)
+            {
+                _event_queue.post(RASPA_EVENT_BUFFER_SIZE_CHANGE, new_buffer_size, t_end, period_count);
+            }
+        }
+
+        _audio_tap.write(_user_audio_in, _user_audio_out, period_count);
+    }
+
+    /**
+     * @brief Log the node timings of the last processing graph run. Rt safe.
+     */
+    void _log_graph_nodes(const RaspaGraphExecutor& graph, int64_t period_count)
+    {
+        if (_run_logger_enable)
+        {
+            for (int node = 0; node < graph.get_num_nodes(); node++)
+            {
+                int64_t start_ns;
+                int64_t end_ns;
+                int worker;
+                graph.get_last_timing(node, start_ns, end_ns, worker);
+                _run_logger.put_graph_node(period_count, node, worker, start_ns, end_ns);
+            }
+        }
+    }
+
+    /**
+     * @brief Start the load policy and fade the outputs in, before the rt
+     *        loop starts.
+     */
+    void _start_load_policy(int buffer_size_in_frames, RaspaMicroSec period_time_us)
+    {
+        if (_load_policy_enable)
+        {
+            _load_policy.start(buffer_size_in_frames, period_time_us);
+            _output_fade.start(true, LOAD_POLICY_FADE_PERIODS * _user_buffer_size_in_frames);
+            _fade_out_request = false;
+        }
+    }
+
+    /**
+     * @brief Mute the outputs before stopping, so that a reopen with the
+     *        buffer size chosen by the load policy does not click. Must only
+     *        be called while the rt loop runs.
+     */
+    void _fade_out_outputs(RaspaMicroSec period_time_us)
+    {
+        if (_load_policy_enable)
+        {
+            _fade_out_request = true;
+            usleep((LOAD_POLICY_FADE_PERIODS + 1) * period_time_us);
+        }
+    }
+
+    // User buffers for audio
+    float* _user_audio_in;
+    float* _user_audio_out;
+    std::vector<float*> _user_audio_in_channels;
+    std::vector<float*> _user_audio_out_channels;
+    int _user_chan_stride;          // distance between the channels of the user buffers
+    int _user_buffer_size_in_frames; // the buffer size in frames of the callback
+    int _num_input_chans;           // total num of input chans
+    int _num_output_chans;          // total num of output chans
+
+    // Buffers the sample converters work on, the user buffers unless decimating
+    float* _converter_audio_in;
+    float* _converter_audio_out;
+    std::vector<std::unique_ptr<BaseSampleConverter>> _input_sample_converter;
+    std::vector<std::unique_ptr<BaseSampleConverter>> _output_sample_converter;
+
+    int _decimation_factor;         // ratio of the driver rate to the callback rate
+    RaspaResampler _resampler;
+
+    // process callback
+    void* _user_data;
+    RaspaProcessCallback _user_callback;
+    RaspaChannelProcessCallback _user_channel_callback;
+
+    // rt sanitizer debug mode
+    bool _rt_sanitizer_enable;
+
+    // denormal counting debug mode
+    bool _denormal_count_enable;
+    RaspaDenormalCounter _denormal_counter;
+
+    // flag to enable logging of run data to file
+    bool _run_logger_enable;
+    std::string _run_logger_file_name;
+    RaspaRunLogger _run_logger;
+
+    // load adaptive buffer size selection and the output fade around a switch
+    bool _load_policy_enable;
+    std::atomic<bool> _fade_out_request;
+    RaspaLoadPolicy _load_policy;
+    RaspaOutputFade _output_fade;
+
+    // shared memory audio tap instance
+    RaspaAudioTap _audio_tap;
+
+    // events for supervisor threads
+    RaspaEventQueue _event_queue;
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_PERIOD_PROCESSOR_H
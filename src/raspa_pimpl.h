@@ -28,35 +28,20 @@
 #include <sched.h>
 #include <sys/mman.h>
 #include <sys/sysinfo.h>
+#include <sys/syscall.h>
 #include <error.h>
 #include <errno.h>
 
-#pragma GCC diagnostic ignored "-Wunused-parameter"
-
-#ifdef RASPA_WITH_EVL
-    #include <unistd.h>
-    #include <evl/evl.h>
-    #include <sys/ioctl.h>
-    #include <evl/syscall.h>
-    #include <evl/clock.h>
-    #include <evl/thread.h>
-#else
-    #include <cobalt/pthread.h>
-    #include <cobalt/sys/ioctl.h>
-    #include <cobalt/time.h>
-    #include <rtdm/rtdm.h>
-    #include <xenomai/init.h>
-#endif
-
-#pragma GCC diagnostic pop
-
 #include <cerrno>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 #include <algorithm>
+#include <atomic>
 
 #include "audio_control_protocol/audio_control_protocol.h"
 #include "audio_control_protocol/audio_packet_helper.h"
@@ -64,31 +49,37 @@
 #include "driver_config.h"
 #include "raspa/raspa.h"
 #include "raspa_delay_error_filter.h"
+#include "raspa_disk_player.h"
+#include "raspa_disk_recorder.h"
 #include "raspa_error_codes.h"
+#include "raspa_event_queue.h"
+#include "raspa_fpu_mode.h"
 #include "raspa_gpio_com.h"
+#include "raspa_graph_executor.h"
+#include "raspa_isolation_audit.h"
+#include "raspa_load_policy.h"
+#include "raspa_memory_lock.h"
+#include "raspa_period_processor.h"
+#include "raspa_resampler.h"
+#include "raspa_rt_thread.h"
 #include "sample_conversion.h"
 #include "raspa_alsa_usb.h"
+#include "raspa_audio_tap.h"
+#include "raspa_ctrl_pkt_capture.h"
 #include "raspa_run_logger.h"
+#include "raspa_sched_deadline.h"
+#include "raspa_servo_trace.h"
+#include "raspa_session_capture.h"
+#include "raspa_system_sampler.h"
 
-#ifdef RASPA_DEBUG_PRINT
-    #include <stdio.h>
+#ifdef RASPA_WITH_RT_SANITIZER
+    #include "raspa_rt_sanitizer.h"
 #endif
 
-#ifdef RASPA_WITH_EVL
-    #define __RASPA_IOCTL_RT(call)		oob_ ## call
-    #define __RASPA(call)		        call
-#else
-    #define __RASPA_IOCTL_RT(call)		__cobalt_ ## call
-    #define __RASPA(call)		        __cobalt_ ## call
+#ifdef RASPA_DEBUG_PRINT
+    #include <stdio.h>
 #endif
 
-/*
- * This variable is defined by xenomai init. It is used to index the number
- * of command line arguments passed to xenomai. Since these arguments are passed
- * manually, this variable is incremented in the init() function.
- */
-extern int optind;
-
 namespace raspa {
 
 /**
@@ -110,6 +101,12 @@ constexpr int STOP_REQUEST_DELAY_US = 10000;
 
 constexpr int THREAD_CREATE_DELAY_US = 10000;
 
+// Max number of THREAD_CREATE_DELAY_US waits for the rt thread to take its deadline reservation
+constexpr int SCHED_DEADLINE_MAX_WAITS = 100;
+
+// Value of the deadline reservation result until the rt thread has set it
+constexpr int SCHED_DEADLINE_PENDING = -1;
+
 // Number of kernel memory pages raspa allocates
 constexpr int NUM_PAGES_KERNEL_MEM = 20;
 
@@ -125,17 +122,34 @@ constexpr int DELAY_FILTER_DOWNSAMPLE_RATE = 16;
 // SENSEI socket address
 constexpr char SENSEI_SOCKET[] = "/tmp/sensei";
 
-// manually passed "commandline args" to xenomai
-constexpr char XENOMAI_ARG_APP_NAME[] = "raspa";
-constexpr char XENOMAI_ARG_CPU_AFFINITY_DUAL_CORE[] = "--cpu-affinity=0,1";
-constexpr char XENOMAI_ARG_CPU_AFFINITY_QUAD_CORE[] = "--cpu-affinity=0,1,2,3";
-
 // Default usb audio type is none
 constexpr driver_conf::UsbAudioType DEFAULT_USB_AUDIO_TYPE = driver_conf::UsbAudioType::NONE;
 
 // Default cpu affinity
 constexpr int DEFAULT_CPU_AFFINITY = 0;
 
+// Stack size of the rt thread in targeted memory lock mode, where raspa
+// allocates and locks it
+constexpr size_t RT_THREAD_STACK_SIZE = 1024 * 1024;
+
+// Names of the memory of the subsystems locked in targeted memory lock mode
+constexpr char RESAMPLER_MEMORY_NAME[] = "resampler";
+constexpr char RECORDER_MEMORY_NAME[] = "disk recorder";
+constexpr char PLAYER_MEMORY_NAME[] = "disk player";
+constexpr char TAP_MEMORY_NAME[] = "audio tap";
+constexpr char GRAPH_MEMORY_NAME[] = "processing graph";
+
+// Sleep of an idle processing graph worker between polls
+constexpr int64_t GRAPH_WORKER_IDLE_SLEEP_NS = 50000;
+
+// State of the usb audio input, for the lost and restored events
+enum class UsbInputState
+{
+    WAITING,    // no input received yet since start
+    RUNNING,
+    LOST
+};
+
 /**
  * @brief Entry point for the real time thread
  * @param data Contains pointer to an instance of RaspaPimpl
@@ -143,6 +157,31 @@ constexpr int DEFAULT_CPU_AFFINITY = 0;
  */
 static void* raspa_pimpl_task_entry(void* data);
 
+class RaspaPimpl;
+
+/**
+ * @brief Arguments of a processing graph worker thread
+ */
+struct GraphWorkerArgs
+{
+    RaspaPimpl* pimpl;
+    int worker;
+};
+
+/**
+ * @brief Entry point for the processing graph worker threads
+ * @param data Contains pointer to a GraphWorkerArgs
+ * @return nullptr
+ */
+static void* raspa_graph_worker_entry(void* data);
+
+/**
+ * @brief Clock and idle functions of the processing graph workers, which do
+ *        not leave the rt domain
+ */
+static int64_t raspa_graph_get_time_ns();
+static void raspa_graph_worker_idle();
+
 /**
  * @brief Interface to a audio rtdm driver that directly interfaces with a
  *        coded. It handles all low level access and is responsible for querying
@@ -151,7 +190,7 @@ static void* raspa_pimpl_task_entry(void* data);
  *        of audio samples. All public functions follow the same api as defined
  *        raspa.h
  */
-class RaspaPimpl
+class RaspaPimpl : public RaspaPeriodProcessor
 {
 public:
     RaspaPimpl() :
@@ -163,22 +202,28 @@ public:
             _tx_pkt{nullptr, nullptr},
             _rx_pkt{nullptr, nullptr},
             _kernel_buffer_mem_size(0),
-            _user_audio_in{nullptr},
-            _user_audio_out{nullptr},
             _user_audio_in_usb{nullptr},
             _user_audio_out_usb{nullptr},
             _user_gate_in(0),
             _user_gate_out(0),
+            _converter_audio_in_usb{nullptr},
+            _converter_audio_out_usb{nullptr},
+            _converter_chan_stride(0),
             _device_handle(-1),
             _interrupts_counter(0),
             _stop_request_flag(false),
             _detect_mode_sw(false),
-            _run_logger_enable(false),
-            _run_logger_file_name(RASPA_DEFAULT_RUN_LOG_FILE),
+            _session_capture_enable(false),
+            _session_capture_file_name(RASPA_DEFAULT_SESSION_CAPTURE_FILE),
+            _servo_trace_enable(false),
+            _servo_trace_file_name(RASPA_DEFAULT_SERVO_TRACE_FILE),
+            _ctrl_pkt_capture_enable(false),
+            _ctrl_pkt_capture_file_name(RASPA_DEFAULT_CTRL_PKT_CAPTURE_FILE),
+            _isolation_audit_enable(false),
+            _irq_steering_enable(false),
+            _flush_denormals(true),
             _cpu_affinity(DEFAULT_CPU_AFFINITY),
             _sample_rate(0.0),
-            _num_input_chans(0),
-            _num_output_chans(0),
             _num_driver_input_chans(0),
             _num_driver_output_chans(0),
             _buffer_size_in_frames(0),
@@ -187,13 +232,19 @@ public:
             _user_buffers_allocated(false),
             _mmap_initialized(false),
             _task_started(false),
-            _user_data(nullptr),
-            _user_callback(nullptr),
             _platform_type(driver_conf::PlatformType::NATIVE),
             _error_filter_process_count(0),
             _usb_audio_type(DEFAULT_USB_AUDIO_TYPE),
             _audio_packet_seq_num(0),
-            _rt_task_id(0)
+            _last_period_start_time(0),
+            _period_time_us(0),
+            _usb_input_state(UsbInputState::WAITING),
+            _memory_lock_mode(RASPA_MEMORY_LOCK_ALL),
+            _rt_thread_stack(nullptr),
+            _rt_task_id(0),
+            _deadline_runtime_fraction(0.0f),
+            _deadline_res(0),
+            _num_graph_workers_started(0)
     {}
 
     ~RaspaPimpl()
@@ -203,66 +254,64 @@ public:
 
     int init()
     {
+        init_rt_core();
+
 #ifndef RASPA_WITH_EVL
-        /*
-         * Fake command line arguments to pass to xenomai_init(). For some
-         * obscure reasons, xenomai_init() crashes if argv is allocated here on
-         * the stack, so we alloc it beforehand.
-         */
-        int argc = 2;
-        auto argv = new char*[argc + 1];
-        for (int i = 0; i < argc; i++)
+        if (_memory_lock_mode == RASPA_MEMORY_LOCK_ALL)
         {
-            argv[i] = new char[32];
+            auto res = mlockall(MCL_CURRENT | MCL_FUTURE);
+            if (res < 0)
+            {
+                _raspa_error_code.set_error_val(RASPA_EMLOCKALL, res);
+                return -RASPA_EMLOCKALL;
+            }
         }
-        argv[argc] = nullptr;
-
-        std::snprintf(argv[0],
-                      sizeof(XENOMAI_ARG_APP_NAME),
-                      XENOMAI_ARG_APP_NAME);
+#endif
+        _kernel_buffer_mem_size = NUM_PAGES_KERNEL_MEM * getpagesize();
 
-        // dual core
-        if (get_nprocs() == 2)
-        {
-            std::snprintf(argv[1],
-                          sizeof(XENOMAI_ARG_CPU_AFFINITY_DUAL_CORE),
-                          XENOMAI_ARG_CPU_AFFINITY_DUAL_CORE);
-        }
-        // quad core
-        else if (get_nprocs() == 4)
+        if (_memory_lock_mode == RASPA_MEMORY_LOCK_TARGETED)
         {
-            std::snprintf(argv[1],
-                          sizeof(XENOMAI_ARG_CPU_AFFINITY_QUAD_CORE),
-                          XENOMAI_ARG_CPU_AFFINITY_QUAD_CORE);
+            // raspa code and static data, this instance included
+            auto res = _memory_lock.lock_object_file(reinterpret_cast<const void*>(&raspa_pimpl_task_entry),
+                                                     "raspa");
+            if (res < 0)
+            {
+                _raspa_error_code.set_error_val(RASPA_EMLOCK, errno);
+                return res;
+            }
         }
 
-        optind = 1;
+        return RASPA_SUCCESS;
+    }
 
-        xenomai_init(&argc, (char* const**) &argv);
+    void set_memory_lock_mode(int mode)
+    {
+        _memory_lock_mode = mode;
+    }
 
-        for (int i = 0; i < argc; i++)
-        {
-            free(argv[i]);
-        }
-        free(argv);
+    int lock_memory_region(const void* address, size_t size)
+    {
+        return _memory_lock.lock(address, size, "user region");
+    }
 
+    int get_memory_report(RaspaMemoryReport* report, bool print)
+    {
+        return _memory_lock.get_report(report, print);
+    }
 
-        auto res = mlockall(MCL_CURRENT | MCL_FUTURE);
-        if (res < 0)
-        {
-            _raspa_error_code.set_error_val(RASPA_EMLOCKALL, res);
-            return -RASPA_EMLOCKALL;
-        }
-#endif
-        evl_init();
-        _kernel_buffer_mem_size = NUM_PAGES_KERNEL_MEM * getpagesize();
+    void set_session_capture_file(const char *path)
+    {
+        _session_capture_file_name = path;
+    }
 
-        return RASPA_SUCCESS;
+    void set_servo_trace_file(const char *path)
+    {
+        _servo_trace_file_name = path;
     }
 
-    void set_run_log_file(const char *path)
+    void set_ctrl_pkt_capture_file(const char *path)
     {
-        _run_logger_file_name = path;
+        _ctrl_pkt_capture_file_name = path;
     }
 
     void set_cpu_affinity(int affinity)
@@ -270,140 +319,130 @@ public:
         _cpu_affinity = affinity;
     }
 
-    int open_device(int buffer_size,
-             RaspaProcessCallback process_callback,
-             void* user_data,
-             unsigned int debug_flags)
+    int set_decimation(int factor)
     {
-        // check if driver version is ok
-        auto ver_check = driver_conf::check_driver_version();
-        if (!ver_check.first)
+        if (_device_opened || factor < 1 || factor > RASPA_MAX_DECIMATION)
         {
-            // if unable to read parameter
-            if (ver_check.second < 0)
-            {
-                _raspa_error_code.set_error_val(RASPA_EPARAM_VERSION,
-                                            ver_check.second);
-                return -RASPA_EPARAM_VERSION;
-            }
-
-            // version mismatch
-            return -RASPA_EVERSION;
+            return -RASPA_EDECIMATION;
         }
+        _decimation_factor = factor;
+        return RASPA_SUCCESS;
+    }
 
-        auto res = _get_audio_info_from_driver();
-        if (res != RASPA_SUCCESS)
-        {
-            return res;
-        }
+    int get_decimation() const
+    {
+        return _decimation_factor;
+    }
 
-        // check driver buffer size
-        _buffer_size_in_frames = buffer_size;
-        res = _validate_buffer_size();
-        if (res != RASPA_SUCCESS)
-        {
-            return res;
-        }
+    int get_callback_buffer_size() const
+    {
+        return _device_opened ? _user_buffer_size_in_frames : 0;
+    }
 
-        if (debug_flags & RASPA_DEBUG_SIGNAL_ON_MODE_SW)
-        {
-            _detect_mode_sw = true;
-        }
+    int get_callback_channel_stride() const
+    {
+        return _device_opened ? _user_chan_stride : 0;
+    }
 
-        if (debug_flags & RASPA_DEBUG_ENABLE_RUN_LOG_TO_FILE)
+    int set_load_policy(float high_load, float low_load, int hold_time_ms)
+    {
+        if (_device_opened)
         {
-            _run_logger_enable = true;
+            return -RASPA_ELOAD_POLICY;
         }
 
-        res = _open_device();
-        if (res < 0)
-        {
-            return res;
-        }
+        auto res = _load_policy.configure(high_load, low_load, hold_time_ms);
+        _load_policy_enable = res == RASPA_SUCCESS;
+        return res;
+    }
 
-        res = _get_driver_buffers();
-        if (res < 0)
+    int get_policy_buffer_size()
+    {
+        if (!_device_opened)
         {
-            _cleanup();
-            return res;
+            return 0;
         }
+        return _load_policy_enable ? _load_policy.get_requested_buffer_size() : _buffer_size_in_frames;
+    }
 
-        _init_driver_buffers();
+    void set_flush_denormals(bool enabled)
+    {
+        _flush_denormals = enabled;
+    }
 
-        res = _init_user_buffers();
-        if (res < 0)
+    int set_deadline_reservation(float runtime_fraction)
+    {
+        if (_task_started || (runtime_fraction != 0.0f && !is_valid_runtime_fraction(runtime_fraction)))
         {
-            _cleanup();
-            return res;
+            return -RASPA_EDEADLINE_RESERVATION;
         }
-
-        res = _init_sample_converter();
-        if (res != RASPA_SUCCESS)
+#ifndef RASPA_WITH_PREEMPT_RT
+        // only SCHED_FIFO outside of PREEMPT_RT kernels
+        if (runtime_fraction != 0.0f)
         {
-            return res;
+            return -RASPA_EDEADLINE_RESERVATION;
         }
+#endif
+        _deadline_runtime_fraction = runtime_fraction;
+        return RASPA_SUCCESS;
+    }
 
-        // Delay filter is needed for synchronization
-        if (_platform_type == driver_conf::PlatformType::SYNC)
-        {
-            _init_delay_error_filter();
-        }
+    void set_irq_steering(bool enabled)
+    {
+        _irq_steering_enable = enabled;
+    }
 
-        if (_platform_type != driver_conf::PlatformType::NATIVE)
-        {
-            res = _init_gpio_com();
-            if (res != RASPA_SUCCESS)
-            {
-                return res;
-            }
-        }
+    int audit_isolation(RaspaIsolationReport* report, bool print)
+    {
+        return _isolation_audit.audit(_cpu_affinity, false, report, print);
+    }
 
-        // init alsa usb if driver says UsbAudioType is NATIVE_ALSA
-        if (_usb_audio_type == driver_conf::UsbAudioType::NATIVE_ALSA)
+    int get_denormal_report(RaspaDenormalReport* report, bool print)
+    {
+        if (!_denormal_count_enable)
         {
-            res = _init_alsa_usb();
-            if (res)
-            {
-                return -RASPA_EALSA_INIT_FAILED;
-            }
+            return -RASPA_EDENORMAL_COUNT;
         }
+        _denormal_counter.get_report(report, print);
+        return RASPA_SUCCESS;
+    }
 
-        if (_run_logger_enable)
+    RaspaMicroSec get_decimation_latency()
+    {
+        if (_sample_rate > 0)
         {
-            auto res = _run_logger.start(_run_logger_file_name);
-            if (res != RASPA_SUCCESS)
-            {
-                return res;
-            }
+            return (RaspaResampler::get_delay_in_frames(_decimation_factor) * 1000000) / _sample_rate;
         }
 
-        _user_data = user_data;
-        _interrupts_counter = 0;
-        _user_callback = process_callback;
-        return RASPA_SUCCESS;
+        return 0;
+    }
+
+    int open_device(int buffer_size,
+             RaspaProcessCallback process_callback,
+             void* user_data,
+             unsigned int debug_flags)
+    {
+        return _open_device(buffer_size, process_callback, nullptr, user_data, debug_flags);
+    }
+
+    int open_device_channels(int buffer_size,
+                             RaspaChannelProcessCallback process_callback,
+                             void* user_data,
+                             unsigned int debug_flags)
+    {
+        return _open_device(buffer_size, nullptr, process_callback, user_data, debug_flags);
     }
 
     int start_realtime()
     {
         // Initialize RT task
         _task_started = false;
-        struct sched_param rt_params = {
-                            .sched_priority = RASPA_PROCESSING_TASK_PRIO};
         pthread_attr_t task_attributes;
-        pthread_attr_init(&task_attributes);
-
-        pthread_attr_setdetachstate(&task_attributes, PTHREAD_CREATE_JOINABLE);
-        pthread_attr_setinheritsched(&task_attributes, PTHREAD_EXPLICIT_SCHED);
-        pthread_attr_setschedpolicy(&task_attributes, SCHED_FIFO);
-        pthread_attr_setschedparam(&task_attributes, &rt_params);
 
-        // Force affinity on first thread
-        cpu_set_t cpuset;
-        CPU_ZERO(&cpuset);
-        CPU_SET(_cpu_affinity, &cpuset);
-        auto res = pthread_attr_setaffinity_np(&task_attributes,
-                                               sizeof(cpu_set_t),
-                                               &cpuset);
+        // Force affinity on first thread, a deadline thread must span its root domain
+        auto res = init_rt_thread_attributes(&task_attributes,
+                                             RASPA_PROCESSING_TASK_PRIO,
+                                             _deadline_runtime_fraction == 0.0f ? _cpu_affinity : -1);
         if (res != 0)
         {
             _cleanup();
@@ -411,7 +450,36 @@ public:
             return -RASPA_ETASK_AFFINITY;
         }
 
+        if (_memory_lock_mode == RASPA_MEMORY_LOCK_TARGETED)
+        {
+            res = _alloc_rt_thread_stack(&task_attributes);
+            if (res != RASPA_SUCCESS)
+            {
+                _cleanup();
+                return res;
+            }
+        }
+
+        // the watchdog stops watching once a stop is requested
+        _last_period_start_time = 0;
+        _period_time_us = _sample_rate > 0 ?
+                          static_cast<RaspaMicroSec>(_buffer_size_in_frames * 1000000 / _sample_rate) : 0;
+        _usb_input_state = UsbInputState::WAITING;
+        _start_load_policy(_buffer_size_in_frames, _period_time_us);
+        _event_queue.start([this]() -> int64_t
+        {
+            return _stop_request_flag ? -1 : _interrupts_counter.load();
+        });
+
+        res = _start_graph_workers();
+        if (res != RASPA_SUCCESS)
+        {
+            _cleanup();
+            return res;
+        }
+
         // Create rt thread
+        _deadline_res = SCHED_DEADLINE_PENDING;
         res = __RASPA(pthread_create(&_processing_task,
                                       &task_attributes,
                                       &raspa_pimpl_task_entry,
@@ -426,9 +494,17 @@ public:
         _task_started = true;
         usleep(THREAD_CREATE_DELAY_US);
 
+        res = _wait_for_deadline_reservation();
+        if (res != RASPA_SUCCESS)
+        {
+            _cleanup();
+            return res;
+        }
+
         /* After Xenomai init + RT thread creation, all non-RT threads have the
          * affinity restricted to one single core. This reverts back to the
          * default of using all cores */
+        cpu_set_t cpuset;
         CPU_ZERO(&cpuset);
         for (int i = 0; i < get_nprocs(); i++)
         {
@@ -457,34 +533,52 @@ public:
      */
     void rt_loop()
     {
+        // the only linux call of the rt thread, made before the loop starts
+        if (_run_logger_enable)
+        {
+            _system_sampler.set_rt_thread_id(static_cast<int>(syscall(SYS_gettid)));
+        }
+        set_thread_flush_denormals(_flush_denormals);
+
 #ifdef RASPA_WITH_EVL
-        _rt_task_id = evl_attach_self("/raspa_pimpl_task:%d", getpid());
+        _rt_task_id = attach_rt_thread("raspa_pimpl_task");
         if (_rt_task_id < 0)
         {
             error(1, -_rt_task_id, "evl_attach_self() failed");
         }
 #endif
+        _deadline_res = _set_deadline_reservation();
+        if (_deadline_res != 0)
+        {
+            return;
+        }
+        int res = RASPA_SUCCESS;
         switch (_platform_type)
         {
         case driver_conf::PlatformType::NATIVE:
-            _rt_loop_native();
+            res = _rt_loop_native();
             break;
 
         case driver_conf::PlatformType::SYNC:
-            _rt_loop_sync();
+            res = _rt_loop_sync();
             break;
 
         case driver_conf::PlatformType::ASYNC:
-            _rt_loop_async();
+            res = _rt_loop_async();
             break;
         }
 
+        if (!_stop_request_flag)
+        {
+            _event_queue.post(RASPA_EVENT_RT_LOOP_EXITED, res, get_time(), _interrupts_counter);
+        }
+
         pthread_exit(nullptr);
     }
 
     float get_sampling_rate()
     {
-        return _sample_rate;
+        return _sample_rate / _decimation_factor;
     }
 
     int get_num_input_channels()
@@ -514,25 +608,12 @@ public:
 
     RaspaMicroSec get_time()
     {
-        RaspaMicroSec time = 0;
-        struct timespec tp;
-
-#ifdef RASPA_WITH_EVL
-        auto res = evl_read_clock(EVL_CLOCK_MONOTONIC, &tp);
-#else
-        auto res = __cobalt_clock_gettime(CLOCK_MONOTONIC, &tp);
-#endif
-        if (res == 0)
-        {
-            time = (RaspaMicroSec) tp.tv_sec * 1000000 + tp.tv_nsec / 1000;
-        }
-
-        return time;
+        return get_rt_time_ns() / 1000;
     }
 
     int64_t get_samplecount()
     {
-        return _interrupts_counter * _buffer_size_in_frames;
+        return _interrupts_counter * _user_buffer_size_in_frames;
     }
 
     RaspaMicroSec get_output_latency()
@@ -540,7 +621,9 @@ public:
         // TODO - really crude approximation
         if (_sample_rate > 0)
         {
-            return (_driver_buffer_size_in_samples * 1000000) / _sample_rate;
+            // the interpolator adds half of the decimation filters delay
+            int resampler_delay = RaspaResampler::get_delay_in_frames(_decimation_factor) / 2;
+            return ((_driver_buffer_size_in_samples + resampler_delay) * 1000000) / _sample_rate;
         }
 
         return 0;
@@ -548,6 +631,11 @@ public:
 
     int close_device()
     {
+        if (_task_started)
+        {
+            _fade_out_outputs(_period_time_us);
+        }
+
         _stop_request_flag = true;  // this will also trigger audio buffers clear
 
         if (_usb_audio_type == driver_conf::UsbAudioType::NATIVE_ALSA)
@@ -571,69 +659,718 @@ public:
             _raspa_error_code.set_error_val(RASPA_ETASK_STOP, res);
             return -RASPA_ETASK_STOP;
         }
-
-        return _cleanup();
+
+        return _cleanup();
+    }
+
+    int request_out_gpio(int pin_num)
+    {
+        RtGpio rtgpio_requested;
+        rtgpio_requested.num = pin_num;
+        rtgpio_requested.val = 0;
+
+        auto res = __RASPA(ioctl(_device_handle, RASPA_GPIO_GET_PIN,
+                                    &rtgpio_requested));
+        if (res)
+        {
+            return -RASPA_EGPIO_UNSUPPORTED;
+        }
+        res = __RASPA(ioctl(_device_handle, RASPA_GPIO_SET_DIR_OUT,
+                                &rtgpio_requested));
+        return 0;
+    }
+
+    int set_gpio(int pin_num, int val)
+    {
+        RtGpio rtgpio_requested;
+        rtgpio_requested.num = pin_num;
+        rtgpio_requested.val = val;
+
+        auto res = __RASPA_IOCTL_RT(ioctl(_device_handle, RASPA_GPIO_SET_VAL,
+                                    &rtgpio_requested));
+        if (res)
+        {
+            return -RASPA_EGPIO_UNSUPPORTED;
+        }
+        return 0;
+    }
+
+    int free_gpio(int pin_num)
+    {
+        RtGpio rtgpio_requested;
+        rtgpio_requested.num = pin_num;
+        auto res = __RASPA(ioctl(_device_handle, RASPA_GPIO_RELEASE,
+                                    &rtgpio_requested));
+        if (res)
+        {
+            printf("RASPA_GPIO_RELEASE ret = %d\n", res);
+            return -RASPA_EGPIO_UNSUPPORTED;
+        }
+        return 0;
+    }
+
+    int recorder_open(const char* file_name, const int* channels, int num_channels)
+    {
+        if (!_device_opened || num_channels <= 0)
+        {
+            return -RASPA_ERECORDER_CHANNELS;
+        }
+
+        std::vector<int> channel_list(channels, channels + num_channels);
+        for (auto channel : channel_list)
+        {
+            if (channel < 0 || channel >= _num_input_chans)
+            {
+                return -RASPA_ERECORDER_CHANNELS;
+            }
+        }
+
+        _memory_lock.forget(RECORDER_MEMORY_NAME);
+        auto res = _disk_recorder.start(file_name,
+                                        channel_list,
+                                        _user_buffer_size_in_frames,
+                                        _user_chan_stride,
+                                        static_cast<int>(get_sampling_rate()));
+        if (res == RASPA_SUCCESS)
+        {
+            res = _lock_rt_regions(_disk_recorder, RECORDER_MEMORY_NAME);
+            if (res != RASPA_SUCCESS)
+            {
+                _disk_recorder.terminate();
+            }
+        }
+        return res;
+    }
+
+    void recorder_push(const float* input)
+    {
+        _disk_recorder.push(input);
+    }
+
+    int recorder_close()
+    {
+        _memory_lock.forget(RECORDER_MEMORY_NAME);
+        return _disk_recorder.terminate();
+    }
+
+    int64_t recorder_get_num_overruns()
+    {
+        return _disk_recorder.get_num_overruns();
+    }
+
+    int player_open(const char* file_name, const int* channels, int num_channels)
+    {
+        if (!_device_opened || num_channels <= 0)
+        {
+            return -RASPA_EPLAYER_CHANNELS;
+        }
+
+        _memory_lock.forget(PLAYER_MEMORY_NAME);
+        auto res = _disk_player.start(file_name,
+                                      std::vector<int>(channels, channels + num_channels),
+                                      _num_output_chans,
+                                      _user_buffer_size_in_frames,
+                                      _user_chan_stride,
+                                      static_cast<int>(get_sampling_rate()));
+        if (res == RASPA_SUCCESS)
+        {
+            res = _lock_rt_regions(_disk_player, PLAYER_MEMORY_NAME);
+            if (res != RASPA_SUCCESS)
+            {
+                _disk_player.terminate();
+            }
+        }
+        return res;
+    }
+
+    void player_pull(float* output)
+    {
+        _disk_player.pull(output);
+    }
+
+    int player_seek(int64_t frame)
+    {
+        return _disk_player.seek(frame) ? RASPA_SUCCESS : -RASPA_EPLAYER_QUEUE_FULL;
+    }
+
+    int player_set_loop(int enabled)
+    {
+        return _disk_player.set_loop(enabled != 0) ? RASPA_SUCCESS : -RASPA_EPLAYER_QUEUE_FULL;
+    }
+
+    int player_close()
+    {
+        _memory_lock.forget(PLAYER_MEMORY_NAME);
+        return _disk_player.terminate();
+    }
+
+    int64_t player_get_num_starvations()
+    {
+        return _disk_player.get_num_starvations();
+    }
+
+    int tap_open(const char* name,
+                 const int* input_channels,
+                 int num_inputs,
+                 const int* output_channels,
+                 int num_outputs)
+    {
+        if (!_device_opened || num_inputs < 0 || num_outputs < 0)
+        {
+            return -RASPA_ETAP_CHANNELS;
+        }
+
+        std::vector<int> input_list(input_channels, input_channels + num_inputs);
+        std::vector<int> output_list(output_channels, output_channels + num_outputs);
+        for (auto channel : input_list)
+        {
+            if (channel < 0 || channel >= _num_input_chans)
+            {
+                return -RASPA_ETAP_CHANNELS;
+            }
+        }
+        for (auto channel : output_list)
+        {
+            if (channel < 0 || channel >= _num_output_chans)
+            {
+                return -RASPA_ETAP_CHANNELS;
+            }
+        }
+
+        _memory_lock.forget(TAP_MEMORY_NAME);
+        auto res = _audio_tap.start(name, input_list, output_list, _user_buffer_size_in_frames, _user_chan_stride,
+                                    static_cast<int>(get_sampling_rate()));
+        if (res == RASPA_SUCCESS)
+        {
+            res = _lock_rt_regions(_audio_tap, TAP_MEMORY_NAME);
+            if (res != RASPA_SUCCESS)
+            {
+                _audio_tap.terminate();
+            }
+        }
+        return res;
+    }
+
+    int tap_close()
+    {
+        _memory_lock.forget(TAP_MEMORY_NAME);
+        return _audio_tap.terminate();
+    }
+
+    int get_event_fd()
+    {
+        auto res = _event_queue.get_fd();
+        if (res < 0)
+        {
+            _raspa_error_code.set_error_val(RASPA_EEVENT_FD, errno);
+        }
+        return res;
+    }
+
+    int read_event(RaspaEvent* event)
+    {
+        return _event_queue.read(event);
+    }
+
+    int graph_add_node(RaspaGraphNodeCallback callback, void* data, const char* name)
+    {
+        return _graph.add_node(callback, data, name);
+    }
+
+    int graph_add_edge(int from_node, int to_node)
+    {
+        return _graph.add_edge(from_node, to_node);
+    }
+
+    int graph_clear()
+    {
+        return _graph.clear();
+    }
+
+    int graph_set_worker_cpus(const int* cpus, int num_cpus)
+    {
+        if (_graph.is_prepared())
+        {
+            return -RASPA_EGRAPH_RUNNING;
+        }
+        if (num_cpus < 0 || num_cpus > RASPA_GRAPH_MAX_WORKERS || (num_cpus > 0 && cpus == nullptr))
+        {
+            return -RASPA_EGRAPH_WORKER;
+        }
+
+        _graph_worker_cpus.assign(cpus, cpus + num_cpus);
+        return RASPA_SUCCESS;
+    }
+
+    int graph_process()
+    {
+        auto res = _graph.process();
+        if (res == RASPA_SUCCESS)
+        {
+            _log_graph_nodes(_graph, _interrupts_counter);
+        }
+        return res;
+    }
+
+    int graph_get_node_stats(int node, RaspaGraphNodeStats* stats)
+    {
+        return _graph.get_node_stats(node, stats);
+    }
+
+    /**
+     * @brief The processing graph worker loop
+     */
+    void graph_worker_loop(int worker)
+    {
+        set_thread_flush_denormals(_flush_denormals);
+#ifdef RASPA_WITH_EVL
+        auto res = evl_attach_self("/raspa_graph_worker:%d:%d", getpid(), worker);
+        if (res < 0)
+        {
+            error(1, -res, "evl_attach_self() failed");
+        }
+#endif
+        _graph.run_worker(worker);
+        pthread_exit(nullptr);
+    }
+
+protected:
+    /**
+     * @brief Open the device with one of the two process callback types.
+     *        With the channel callback, the user buffers are laid out with
+     *        padding between channels.
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise.
+     */
+    int _open_device(int buffer_size,
+                     RaspaProcessCallback process_callback,
+                     RaspaChannelProcessCallback channel_process_callback,
+                     void* user_data,
+                     unsigned int debug_flags)
+    {
+        // all the driver parameters in one go
+        driver_conf::DriverCapabilities driver_caps;
+        driver_conf::read_driver_capabilities(driver_caps);
+
+        // check if driver version is ok
+        auto ver_check = driver_conf::check_driver_version(driver_caps);
+        if (!ver_check.first)
+        {
+            // if unable to read parameter
+            if (ver_check.second < 0)
+            {
+                _raspa_error_code.set_error_val(RASPA_EPARAM_VERSION,
+                                            ver_check.second);
+                return -RASPA_EPARAM_VERSION;
+            }
+
+            // version mismatch
+            return -RASPA_EVERSION;
+        }
+
+        auto res = _get_audio_info_from_driver(driver_caps);
+        if (res != RASPA_SUCCESS)
+        {
+            return res;
+        }
+
+        // check driver buffer size, the callback gets it divided by the decimation factor
+        if (RaspaResampler::validate(_decimation_factor, buffer_size) != RASPA_SUCCESS)
+        {
+            return -RASPA_EDECIMATION;
+        }
+        _buffer_size_in_frames = buffer_size;
+        _user_buffer_size_in_frames = buffer_size / _decimation_factor;
+        _user_chan_stride = channel_process_callback ? get_padded_channel_stride(_user_buffer_size_in_frames)
+                                                     : _user_buffer_size_in_frames;
+        res = _validate_buffer_size(driver_caps);
+        if (res != RASPA_SUCCESS)
+        {
+            return res;
+        }
+
+        if (debug_flags & RASPA_DEBUG_SIGNAL_ON_MODE_SW)
+        {
+            _detect_mode_sw = true;
+        }
+
+        if (debug_flags & RASPA_DEBUG_ENABLE_RUN_LOG_TO_FILE)
+        {
+            _run_logger_enable = true;
+        }
+
+        if (debug_flags & RASPA_DEBUG_ENABLE_SESSION_CAPTURE)
+        {
+            _session_capture_enable = true;
+        }
+
+        if (debug_flags & RASPA_DEBUG_RT_SANITIZER)
+        {
+#ifdef RASPA_WITH_RT_SANITIZER
+            RaspaRtSanitizer::init();
+            _rt_sanitizer_enable = true;
+#else
+            return -RASPA_ERT_SANITIZER;
+#endif
+        }
+
+        if (debug_flags & RASPA_DEBUG_COUNT_DENORMALS)
+        {
+            _denormal_count_enable = true;
+        }
+
+        if (debug_flags & RASPA_DEBUG_ENABLE_SERVO_TRACE)
+        {
+            _servo_trace_enable = true;
+        }
+
+        if (debug_flags & RASPA_DEBUG_ENABLE_CTRL_PKT_CAPTURE)
+        {
+            _ctrl_pkt_capture_enable = true;
+        }
+
+        if (debug_flags & RASPA_DEBUG_AUDIT_ISOLATION)
+        {
+            _isolation_audit_enable = true;
+        }
+
+        // Bring up the subsystems which only depend on the driver parameters
+        // on helper threads, while the device is opened and mapped here.
+        // Helper threads must be joined before returning, errors included.
+        // They return their linux error value instead of storing it, as
+        // _raspa_error_code is only written from this thread.
+        std::vector<std::thread> init_threads;
+        int gpio_com_res = RASPA_SUCCESS;
+        int gpio_com_error_val = 0;
+        int alsa_usb_res = RASPA_SUCCESS;
+        int run_logger_res = RASPA_SUCCESS;
+
+        if (_platform_type != driver_conf::PlatformType::NATIVE)
+        {
+            init_threads.emplace_back([&]()
+            {
+                gpio_com_res = _init_gpio_com(gpio_com_error_val);
+            });
+        }
+
+        // init alsa usb if driver says UsbAudioType is NATIVE_ALSA
+        if (_usb_audio_type == driver_conf::UsbAudioType::NATIVE_ALSA)
+        {
+            init_threads.emplace_back([&]()
+            {
+                alsa_usb_res = _init_alsa_usb() ? -RASPA_EALSA_INIT_FAILED : RASPA_SUCCESS;
+            });
+        }
+
+        if (_run_logger_enable)
+        {
+            init_threads.emplace_back([&]()
+            {
+                run_logger_res = _run_logger.start(_run_logger_file_name);
+                if (run_logger_res == RASPA_SUCCESS)
+                {
+                    run_logger_res = _system_sampler.start(_run_logger_file_name + SYSTEM_SAMPLER_FILE_SUFFIX,
+                                                           _cpu_affinity);
+                }
+            });
+        }
+
+        res = _init_device();
+
+        for (auto& thread : init_threads)
+        {
+            thread.join();
+        }
+        if (gpio_com_res != RASPA_SUCCESS)
+        {
+            _raspa_error_code.set_error_val(-gpio_com_res, gpio_com_error_val);
+        }
+
+        // report the device error first, then in the sequential order
+        for (auto subsystem_res : {res, gpio_com_res, alsa_usb_res, run_logger_res})
+        {
+            if (subsystem_res != RASPA_SUCCESS)
+            {
+                _cleanup();
+                return subsystem_res;
+            }
+        }
+
+        if (_memory_lock_mode == RASPA_MEMORY_LOCK_TARGETED)
+        {
+            auto callback = process_callback ? reinterpret_cast<const void*>(process_callback) :
+                                               reinterpret_cast<const void*>(channel_process_callback);
+            res = _lock_rt_memory(callback, user_data);
+            if (res != RASPA_SUCCESS)
+            {
+                _cleanup();
+                return res;
+            }
+        }
+
+        if (_session_capture_enable)
+        {
+            res = _start_session_capture();
+            if (res != RASPA_SUCCESS)
+            {
+                _cleanup();
+                return res;
+            }
+        }
+
+        if (_servo_trace_enable && _platform_type == driver_conf::PlatformType::SYNC)
+        {
+            res = _start_servo_trace();
+            if (res != RASPA_SUCCESS)
+            {
+                _cleanup();
+                return res;
+            }
+        }
+
+        if (_ctrl_pkt_capture_enable && _platform_type != driver_conf::PlatformType::NATIVE)
+        {
+            res = _start_ctrl_pkt_capture();
+            if (res != RASPA_SUCCESS)
+            {
+                _cleanup();
+                return res;
+            }
+        }
+
+        // after the device init, which sets the audio cpu. The audit only
+        // reports, so a system where /proc/irq can't be read is not an error
+        if (_isolation_audit_enable || _irq_steering_enable)
+        {
+            RaspaIsolationReport report;
+            _isolation_audit.audit(_cpu_affinity, _irq_steering_enable, &report, _isolation_audit_enable);
+        }
+
+        _user_data = user_data;
+        _interrupts_counter = 0;
+        _user_callback = process_callback;
+        _user_channel_callback = channel_process_callback;
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Open the device, map its buffers and create the sample
+     *        converters. Runs concurrently with the helper threads started
+     *        by _open_device().
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise.
+     *         The caller cleans up on errors.
+     */
+    int _init_device()
+    {
+        auto res = _open_device();
+        if (res < 0)
+        {
+            return res;
+        }
+
+        res = _get_driver_buffers();
+        if (res < 0)
+        {
+            return res;
+        }
+
+        _init_driver_buffers();
+
+        res = _init_user_buffers();
+        if (res < 0)
+        {
+            return res;
+        }
+
+        res = _init_sample_converter();
+        if (res != RASPA_SUCCESS)
+        {
+            return res;
+        }
+
+        // Delay filter is needed for synchronization
+        if (_platform_type == driver_conf::PlatformType::SYNC)
+        {
+            _init_delay_error_filter();
+        }
+
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Lock the memory the rt thread uses, in targeted memory lock mode:
+     *        the user and driver buffers, the resampler buffers and the code
+     *        of the process callback. The sample converters and the user data
+     *        are only checked by the memory report. The recorder, player, tap
+     *        and graph memory is locked when it is allocated.
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise.
+     */
+    int _lock_rt_memory(const void* process_callback, void* user_data)
+    {
+        size_t user_buffer_size = _get_num_user_audio_samples() * sizeof(float);
+        int res = _memory_lock.lock(_user_audio_in, user_buffer_size, "raspa input buffer");
+        if (res == RASPA_SUCCESS)
+        {
+            res = _memory_lock.lock(_user_audio_out, user_buffer_size, "raspa output buffer");
+        }
+        if (res == RASPA_SUCCESS)
+        {
+            res = _memory_lock.lock_object_file(process_callback, "process callback");
+        }
+        _memory_lock.forget(RESAMPLER_MEMORY_NAME);
+        if (res == RASPA_SUCCESS && _decimation_factor > 1)
+        {
+            res = _lock_rt_regions(_resampler, RESAMPLER_MEMORY_NAME);
+        }
+        if (res != RASPA_SUCCESS)
+        {
+            _raspa_error_code.set_error_val(RASPA_EMLOCK, errno);
+            return res;
+        }
+
+        // driver memory is not pageable, the lock is only there for the report
+        _memory_lock.lock(_driver_buffer, _kernel_buffer_mem_size, "driver buffers");
+
+        _memory_lock.remove_rt_addresses("user data");
+        _memory_lock.remove_rt_addresses("sample converters");
+        _memory_lock.remove_rt_addresses("channel pointers");
+        _memory_lock.add_rt_address(user_data, "user data");
+        _memory_lock.add_rt_address(_user_audio_in_channels.data(), "channel pointers");
+        _memory_lock.add_rt_address(_user_audio_out_channels.data(), "channel pointers");
+        for (const auto& converter : _input_sample_converter)
+        {
+            _memory_lock.add_rt_address(converter.get(), "sample converters");
+        }
+        for (const auto& converter : _output_sample_converter)
+        {
+            _memory_lock.add_rt_address(converter.get(), "sample converters");
+        }
+
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Lock the allocations a subsystem touches from the rt thread, in
+     *        targeted memory lock mode. Does nothing in the other modes.
+     * @param subsystem An object with a for_each_rt_region() function
+     * @param name Name of the regions in the memory report
+     * @return RASPA_SUCCESS upon success, -RASPA_EMLOCK otherwise.
+     */
+    template<typename Subsystem>
+    int _lock_rt_regions(const Subsystem& subsystem, const char* name)
+    {
+        if (_memory_lock_mode != RASPA_MEMORY_LOCK_TARGETED)
+        {
+            return RASPA_SUCCESS;
+        }
+
+        int res = RASPA_SUCCESS;
+        subsystem.for_each_rt_region([&](const void* address, size_t size)
+        {
+            if (res == RASPA_SUCCESS && address != nullptr && size > 0)
+            {
+                res = _memory_lock.lock(address, size, name);
+            }
+        });
+        if (res != RASPA_SUCCESS)
+        {
+            _raspa_error_code.set_error_val(RASPA_EMLOCK, errno);
+            _memory_lock.forget(name);
+        }
+        return res;
+    }
+
+    /**
+     * @brief Move the calling thread to SCHED_DEADLINE, if a reservation was
+     *        set with set_deadline_reservation(). Called by the rt thread.
+     * @return 0 upon success or without a reservation, errno otherwise.
+     */
+    int _set_deadline_reservation()
+    {
+#ifdef RASPA_WITH_PREEMPT_RT
+        if (_deadline_runtime_fraction > 0.0f)
+        {
+            auto period_ns = static_cast<uint64_t>(_buffer_size_in_frames * 1000000000.0 / _sample_rate);
+            return set_thread_sched_deadline(get_sched_deadline_params(_deadline_runtime_fraction, period_ns));
+        }
+#endif
+        return 0;
     }
 
-    int request_out_gpio(int pin_num)
+    /**
+     * @brief Wait for the rt thread to report the result of
+     *        _set_deadline_reservation(). The thread exits on failure.
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise.
+     */
+    int _wait_for_deadline_reservation()
     {
-        RtGpio rtgpio_requested;
-        rtgpio_requested.num = pin_num;
-        rtgpio_requested.val = 0;
+        for (int i = 0; _deadline_res == SCHED_DEADLINE_PENDING && i < SCHED_DEADLINE_MAX_WAITS; i++)
+        {
+            usleep(THREAD_CREATE_DELAY_US);
+        }
 
-        auto res = __RASPA(ioctl(_device_handle, RASPA_GPIO_GET_PIN,
-                                    &rtgpio_requested));
-        if (res)
+        if (_deadline_res != 0)
         {
-            return -RASPA_EGPIO_UNSUPPORTED;
+            _raspa_error_code.set_error_val(RASPA_ESCHED_DEADLINE, _deadline_res);
+            return -RASPA_ESCHED_DEADLINE;
         }
-        res = __RASPA(ioctl(_device_handle, RASPA_GPIO_SET_DIR_OUT,
-                                &rtgpio_requested));
-        return 0;
+        return RASPA_SUCCESS;
     }
 
-    int set_gpio(int pin_num, int val)
+    /**
+     * @brief Allocate and lock the rt thread stack, in targeted memory lock
+     *        mode.
+     * @param task_attributes The rt thread attributes, the stack is set there
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise.
+     */
+    int _alloc_rt_thread_stack(pthread_attr_t* task_attributes)
     {
-        RtGpio rtgpio_requested;
-        rtgpio_requested.num = pin_num;
-        rtgpio_requested.val = val;
+        _free_rt_thread_stack();
 
-        auto res = __RASPA_IOCTL_RT(ioctl(_device_handle, RASPA_GPIO_SET_VAL,
-                                    &rtgpio_requested));
-        if (res)
+        auto res = posix_memalign(&_rt_thread_stack, getpagesize(), RT_THREAD_STACK_SIZE);
+        if (res != 0)
         {
-            return -RASPA_EGPIO_UNSUPPORTED;
+            _rt_thread_stack = nullptr;
+            _raspa_error_code.set_error_val(RASPA_EMLOCK, res);
+            return -RASPA_EMLOCK;
         }
-        return 0;
+
+        res = _memory_lock.lock(_rt_thread_stack, RT_THREAD_STACK_SIZE, "rt thread stack");
+        if (res != RASPA_SUCCESS)
+        {
+            _raspa_error_code.set_error_val(RASPA_EMLOCK, errno);
+            return res;
+        }
+
+        pthread_attr_setstack(task_attributes, _rt_thread_stack, RT_THREAD_STACK_SIZE);
+        return RASPA_SUCCESS;
     }
 
-    int free_gpio(int pin_num)
+    /**
+     * @brief Free the rt thread stack, the rt thread must be stopped.
+     */
+    void _free_rt_thread_stack()
     {
-        RtGpio rtgpio_requested;
-        rtgpio_requested.num = pin_num;
-        auto res = __RASPA(ioctl(_device_handle, RASPA_GPIO_RELEASE,
-                                    &rtgpio_requested));
-        if (res)
+        if (_rt_thread_stack)
         {
-            printf("RASPA_GPIO_RELEASE ret = %d\n", res);
-            return -RASPA_EGPIO_UNSUPPORTED;
+            _memory_lock.unlock(_rt_thread_stack);
+            free(_rt_thread_stack);
+            _rt_thread_stack = nullptr;
         }
-        return 0;
     }
 
-protected:
     /**
      * @brief Get the various info from the drivers parameter
+     * @param caps The driver parameters
      * @return RASPA_SUCCESS upon success, different raspa error code otherwise
      */
-    int _get_audio_info_from_driver()
+    int _get_audio_info_from_driver(const driver_conf::DriverCapabilities& caps)
     {
-        auto sample_rate = driver_conf::get_sample_rate();
-        _num_driver_input_chans = driver_conf::get_num_input_chan();
-        _num_driver_output_chans = driver_conf::get_num_output_chan();
-        auto platform_type = driver_conf::get_platform_type();
-        auto usb_audio_type = driver_conf::get_usb_audio_type();
-        _cpu_affinity = driver_conf::get_audio_irq_affinity();
+        auto sample_rate = caps.sample_rate;
+        _num_driver_input_chans = caps.num_input_chans;
+        _num_driver_output_chans = caps.num_output_chans;
+        auto platform_type = caps.platform_type;
+        auto usb_audio_type = caps.usb_audio_type;
+        _cpu_affinity = caps.irq_affinity;
 
         // sanity checks on the parameters
         if (sample_rate < 0)
@@ -707,12 +1444,13 @@ protected:
     /**
      * @brief Checks if a buffer size specified matches with that of the driver.
      *
+     * @param caps The driver parameters
      * @return int RASPA_SUCCESS upon success, negative raspa error code
      *         otherwise
      */
-    int _validate_buffer_size()
+    int _validate_buffer_size(const driver_conf::DriverCapabilities& caps)
     {
-        auto driver_buffer_size = driver_conf::get_buffer_size();
+        auto driver_buffer_size = caps.buffer_size;
         if (driver_buffer_size < 0)
         {
             _raspa_error_code.set_error_val(RASPA_EPARAM_BUFFER_SIZE,
@@ -825,6 +1563,10 @@ protected:
     {
         if (_mmap_initialized)
         {
+            if (_memory_lock_mode == RASPA_MEMORY_LOCK_TARGETED)
+            {
+                _memory_lock.unlock(_driver_buffer);
+            }
             auto res = munmap(_driver_buffer, _kernel_buffer_mem_size);
             _mmap_initialized = false;
             if (res < 0)
@@ -927,22 +1669,35 @@ protected:
      * @brief Create audio buffers for the user.
      * @return RASPA_SUCCESS upon success, different raspa error code otherwise
      */
-    int _init_user_buffers()
+    int _get_num_user_audio_samples()
     {
-        _user_buffers_allocated = false;
-        int num_user_audio_samples = _driver_buffer_size_in_samples;
+        int num_user_chans = std::max(_num_driver_input_chans, _num_driver_output_chans);
 
         // if UsbAudioType::NATIVE_ALSA, then allocate 2 more "virtual" channels
         if (_usb_audio_type == driver_conf::UsbAudioType::NATIVE_ALSA)
         {
-            num_user_audio_samples += (NUM_ALSA_USB_CHANNELS * _buffer_size_in_frames);
+            num_user_chans += NUM_ALSA_USB_CHANNELS;
+        }
+        return num_user_chans * _user_chan_stride;
+    }
+
+    int _init_user_buffers()
+    {
+        _user_buffers_allocated = false;
+        int num_user_audio_samples = _get_num_user_audio_samples();
+
+        // page aligned when locked, so that unlocking does not affect other data
+        size_t alignment = CACHE_LINE_SIZE_IN_SAMPLES * sizeof(float);
+        if (_memory_lock_mode == RASPA_MEMORY_LOCK_TARGETED)
+        {
+            alignment = getpagesize();
         }
 
         int res = posix_memalign(reinterpret_cast<void**>(&_user_audio_in),
-                                 16,
+                                 alignment,
                                  num_user_audio_samples * sizeof(float)) ||
                   posix_memalign(reinterpret_cast<void**>(&_user_audio_out),
-                                 16,
+                                 alignment,
                                  num_user_audio_samples * sizeof(float));
 
         std::fill_n(_user_audio_in, num_user_audio_samples, 0);
@@ -951,8 +1706,38 @@ protected:
         // fix the right location of the 2 virtual usb channels
         if (_usb_audio_type == driver_conf::UsbAudioType::NATIVE_ALSA)
         {
-            _user_audio_in_usb = _user_audio_in + (_num_driver_input_chans * _buffer_size_in_frames);
-            _user_audio_out_usb = _user_audio_out + (_num_driver_output_chans * _buffer_size_in_frames);
+            _user_audio_in_usb = _user_audio_in + (_num_driver_input_chans * _user_chan_stride);
+            _user_audio_out_usb = _user_audio_out + (_num_driver_output_chans * _user_chan_stride);
+        }
+
+        // the sample converters work on the full rate buffers of the resampler
+        // when decimating, with the same channel layout as the user buffers
+        _converter_audio_in = _user_audio_in;
+        _converter_audio_out = _user_audio_out;
+        _converter_chan_stride = _user_chan_stride;
+        if (_decimation_factor > 1)
+        {
+            _resampler.init(_decimation_factor,
+                            _buffer_size_in_frames,
+                            num_user_audio_samples / _user_chan_stride,
+                            _num_input_chans,
+                            _num_output_chans);
+            _converter_audio_in = _resampler.get_full_rate_input();
+            _converter_audio_out = _resampler.get_full_rate_output();
+            _converter_chan_stride = _buffer_size_in_frames;
+        }
+        _converter_audio_in_usb = _converter_audio_in + (_num_driver_input_chans * _converter_chan_stride);
+        _converter_audio_out_usb = _converter_audio_out + (_num_driver_output_chans * _converter_chan_stride);
+
+        _user_audio_in_channels.resize(_num_input_chans);
+        _user_audio_out_channels.resize(_num_output_chans);
+        for (int i = 0; i < _num_input_chans; i++)
+        {
+            _user_audio_in_channels[i] = _user_audio_in + i * _user_chan_stride;
+        }
+        for (int i = 0; i < _num_output_chans; i++)
+        {
+            _user_audio_out_channels[i] = _user_audio_out + i * _user_chan_stride;
         }
 
         if (res < 0)
@@ -961,6 +1746,11 @@ protected:
             return -RASPA_EUSER_BUFFERS;
         }
 
+        if (_denormal_count_enable)
+        {
+            _denormal_counter.init(_num_input_chans, _num_output_chans);
+        }
+
         _user_buffers_allocated = true;
         return RASPA_SUCCESS;
     }
@@ -972,6 +1762,11 @@ protected:
     {
         if (_user_buffers_allocated)
         {
+            if (_memory_lock_mode == RASPA_MEMORY_LOCK_TARGETED)
+            {
+                _memory_lock.unlock(_user_audio_in);
+                _memory_lock.unlock(_user_audio_out);
+            }
             free(_user_audio_in);
             free(_user_audio_out);
             _user_buffers_allocated = false;
@@ -983,17 +1778,11 @@ protected:
      */
     int _init_sample_converter()
     {
-        _input_sample_converter.resize(_num_driver_input_chans);
-        _output_sample_converter.resize(_num_driver_output_chans);
-
-        std::vector<struct driver_conf::ChannelInfo> input_chan_info;
-        std::vector<struct driver_conf::ChannelInfo> output_chan_info;
-
         // get input chan info
-        input_chan_info.resize(_num_driver_input_chans);
+        _input_chan_info.resize(_num_driver_input_chans);
         auto res = __RASPA(ioctl(_device_handle,
                                     RASPA_GET_INPUT_CHAN_INFO,
-                                    input_chan_info.data()));
+                                    _input_chan_info.data()));
         if (res < 0)
         {
             _raspa_error_code.set_error_val(RASPA_EPARAM_INPUT_AUDIO_INFO, res);
@@ -1001,63 +1790,32 @@ protected:
         }
 
         // get output chan info
-        output_chan_info.resize(_num_driver_output_chans);
+        _output_chan_info.resize(_num_driver_output_chans);
         res = __RASPA(ioctl(_device_handle,
                                 RASPA_GET_OUTPUT_CHAN_INFO,
-                                output_chan_info.data()));
+                                _output_chan_info.data()));
         if (res < 0)
         {
             _raspa_error_code.set_error_val(RASPA_EPARAM_OUTPUT_AUDIO_INFO, res);
             return -RASPA_EPARAM_OUTPUT_AUDIO_INFO;
         }
 
-        int chan_id = 0;
-        for (const auto& info : input_chan_info)
+        res = create_sample_converters(_input_sample_converter,
+                                       _input_chan_info,
+                                       _buffer_size_in_frames,
+                                       _converter_chan_stride);
+        if (res != RASPA_SUCCESS)
         {
-            auto format_info = driver_conf::check_codec_format(info.sample_format);
-            if (!format_info.first)
-            {
-                // invalid codec format passed by the driver
-                return -RASPA_ECODEC_FORMAT;
-            }
-
-            _input_sample_converter[chan_id] = get_sample_converter(chan_id,
-                                                             _buffer_size_in_frames,
-                                                             format_info.second,
-                                                             info.start_offset_in_words,
-                                                             info.stride_in_words);
-
-            if (!_input_sample_converter[chan_id])
-            {
-                return -RASPA_EBUFFER_SIZE_SC;
-            }
-
-            chan_id++;
+            return res;
         }
 
-        chan_id = 0;
-        for (const auto& info : output_chan_info)
+        res = create_sample_converters(_output_sample_converter,
+                                       _output_chan_info,
+                                       _buffer_size_in_frames,
+                                       _converter_chan_stride);
+        if (res != RASPA_SUCCESS)
         {
-            auto format_info = driver_conf::check_codec_format(info.sample_format);
-            if (!format_info.first)
-            {
-                // invalid codec format passed by the driver
-                return -RASPA_ECODEC_FORMAT;
-            }
-
-            _output_sample_converter[chan_id] = get_sample_converter(chan_id,
-                                                             _buffer_size_in_frames,
-                                                             format_info.second,
-                                                             info.start_offset_in_words,
-                                                             info.stride_in_words);
-
-            if (!_output_sample_converter[chan_id])
-            {
-                // invalid buffer size
-                return -RASPA_EBUFFER_SIZE_SC;
-            }
-
-            chan_id++;
+            return res;
         }
 
         /**
@@ -1066,7 +1824,7 @@ protected:
          * the following attributes
          *  - They will occupy the last sw chan ids,i.e, they are virtual channels
          *    padded in the end. However, this is taken care of by _init_user_buffers
-         *    i.e by _user_audio_in_usb and _user_audio_out_usb. Hence their
+         *    i.e by _converter_audio_in_usb and _converter_audio_out_usb. Hence their
          *    sw_chan_ids are relative to to the location in those buffers
          *  - The codec format is ALSA_USB_CODEC_FORMAT
          *  - samples of each usb channels are spaced out by a distance of
@@ -1086,13 +1844,15 @@ protected:
                                                                 _buffer_size_in_frames,
                                                                 ALSA_USB_CODEC_FORMAT,
                                                                 i, // start index = usb chan num
-                                                                NUM_ALSA_USB_CHANNELS); // stride = NUM_ALSA_USB_CHANNELS
+                                                                NUM_ALSA_USB_CHANNELS, // stride = NUM_ALSA_USB_CHANNELS
+                                                                _converter_chan_stride);
 
                 _output_usb_sample_converter[i] = get_sample_converter(i,
                                                                 _buffer_size_in_frames,
                                                                 ALSA_USB_CODEC_FORMAT,
                                                                 i, // start index = usb chan num
-                                                                NUM_ALSA_USB_CHANNELS); // stride = NUM_ALSA_USB_CHANNELS
+                                                                NUM_ALSA_USB_CHANNELS, // stride = NUM_ALSA_USB_CHANNELS
+                                                                _converter_chan_stride);
             }
         }
 
@@ -1111,13 +1871,13 @@ protected:
     /**
      * @brief Init the gpio com object.
      *
+     * @param error_val Set to the linux error code upon failure
      * @return int RASPA_SUCCESS upon success, different error code otherwise.
      */
-    int _init_gpio_com()
+    int _init_gpio_com(int& error_val)
     {
-        _gpio_com = std::make_unique<RaspaGpioCom>(SENSEI_SOCKET,
-                                                   &_raspa_error_code);
-        return _gpio_com->init();
+        _gpio_com = std::make_unique<RaspaGpioCom>(SENSEI_SOCKET);
+        return _gpio_com->init(error_val);
     }
 
     /**
@@ -1132,6 +1892,64 @@ protected:
         return _alsa_usb->init(srate, _buffer_size_in_frames, NUM_ALSA_USB_CHANNELS);
     }
 
+    /**
+     * @brief Start the session capture, writing the current configuration in
+     *        the capture file header.
+     *
+     * @return int RASPA_SUCCESS upon success, different error code otherwise.
+     */
+    int _start_session_capture()
+    {
+        SessionCaptureHeader header = {};
+        header.sample_rate = static_cast<uint32_t>(_sample_rate);
+        header.buffer_size_in_frames = _buffer_size_in_frames;
+        header.platform_type = static_cast<uint32_t>(_platform_type);
+        header.num_driver_input_chans = _num_driver_input_chans;
+        header.num_driver_output_chans = _num_driver_output_chans;
+        header.num_input_chans = _num_input_chans;
+        header.num_output_chans = _num_output_chans;
+        header.driver_buffer_size_in_samples = _driver_buffer_size_in_samples;
+        header.ctrl_pkt_size_in_words = 0;
+        if (_platform_type != driver_conf::PlatformType::NATIVE)
+        {
+            header.ctrl_pkt_size_in_words = AUDIO_CTRL_PKT_SIZE_WORDS;
+        }
+
+        return _session_capture.start(_session_capture_file_name,
+                                      header,
+                                      _input_chan_info,
+                                      _output_chan_info);
+    }
+
+    /**
+     * @brief Start the servo trace, with the settings of the delay error
+     *        filter in the header.
+     */
+    int _start_servo_trace()
+    {
+        ServoTraceHeader header = {};
+        header.sample_rate = static_cast<uint32_t>(_sample_rate);
+        header.buffer_size_in_frames = _buffer_size_in_frames;
+        header.settling_periods = DELAY_FILTER_SETTLING_CONSTANT;
+        header.downsample_rate = DELAY_FILTER_DOWNSAMPLE_RATE;
+        header.t60_in_periods = DELAY_FILTER_SETTLING_CONSTANT;
+        return _servo_trace.start(_servo_trace_file_name, header);
+    }
+
+    /**
+     * @brief Start the audio control packet capture.
+     */
+    int _start_ctrl_pkt_capture()
+    {
+        CtrlPktCaptureHeader header = {};
+        header.sample_rate = static_cast<uint32_t>(_sample_rate);
+        header.buffer_size_in_frames = _buffer_size_in_frames;
+        header.platform_type = static_cast<uint32_t>(_platform_type);
+        header.pkt_size_in_bytes = sizeof(audio_ctrl::AudioCtrlPkt);
+        header.payload_capacity_in_bytes = sizeof(audio_ctrl::AudioCtrlPkt::payload);
+        return _ctrl_pkt_capture.start(_ctrl_pkt_capture_file_name, header);
+    }
+
     /**
      * @brief De init the sample converter instance.
      */
@@ -1204,6 +2022,71 @@ protected:
         return RASPA_SUCCESS;
     }
 
+    /**
+     * @brief Prepare the processing graph and create its worker threads,
+     *        pinned to the cpus set with graph_set_worker_cpus(). Nothing is
+     *        done if the graph has no nodes.
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise
+     */
+    int _start_graph_workers()
+    {
+        if (_graph.get_num_nodes() == 0)
+        {
+            return RASPA_SUCCESS;
+        }
+
+        _graph.set_platform_functions(&raspa_graph_get_time_ns, &raspa_graph_worker_idle);
+        auto res = _graph.prepare(static_cast<int>(_graph_worker_cpus.size()));
+        if (res == RASPA_SUCCESS)
+        {
+            res = _lock_rt_regions(_graph, GRAPH_MEMORY_NAME);
+        }
+        if (res != RASPA_SUCCESS)
+        {
+            return res;
+        }
+
+        for (size_t i = 0; i < _graph_worker_cpus.size(); i++)
+        {
+            pthread_attr_t task_attributes;
+            res = init_rt_thread_attributes(&task_attributes, RASPA_PROCESSING_TASK_PRIO, _graph_worker_cpus[i]);
+            if (res == 0)
+            {
+                _graph_worker_args[i] = {this, static_cast<int>(i) + 1};
+                res = __RASPA(pthread_create(&_graph_workers[i],
+                                             &task_attributes,
+                                             &raspa_graph_worker_entry,
+                                             &_graph_worker_args[i]));
+            }
+            pthread_attr_destroy(&task_attributes);
+
+            if (res != 0)
+            {
+                _raspa_error_code.set_error_val(RASPA_EGRAPH_WORKER, res);
+                return -RASPA_EGRAPH_WORKER;
+            }
+            _num_graph_workers_started++;
+        }
+
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Stop the processing graph worker threads, after the rt thread
+     *        so that no period is left waiting for them.
+     */
+    void _stop_graph_workers()
+    {
+        _graph.stop_workers();
+        for (int i = 0; i < _num_graph_workers_started; i++)
+        {
+            __RASPA(pthread_join(_graph_workers[i], NULL));
+        }
+        _num_graph_workers_started = 0;
+        _graph.release();
+        _memory_lock.forget(GRAPH_MEMORY_NAME);
+    }
+
     /**
      * @brief Free up memory, delete instances and stops the rt thread
      * @return RASPA_SUCCESS upon success, different raspa error code otherwise
@@ -1213,6 +2096,17 @@ protected:
         // The order is very important. Its the reverse order of instantiation,
 
         auto res = _stop_rt_task();
+        _stop_graph_workers();
+
+#ifdef RASPA_WITH_RT_SANITIZER
+        if (_rt_sanitizer_enable)
+        {
+            RaspaRtSanitizer::print_report();
+            _rt_sanitizer_enable = false;
+        }
+#endif
+
+        _free_rt_thread_stack();
         _free_user_buffers();
         res |= _release_driver_buffers();
         res |= _close_device();
@@ -1228,11 +2122,35 @@ protected:
             _deinit_gpio_com();
         }
 
+        // the object is kept, usb worker threads might still reference it
+        if (_alsa_usb)
+        {
+            _alsa_usb->close();
+        }
+
         if (_run_logger_enable)
         {
+            _system_sampler.terminate();
             _run_logger.terminate();
         }
 
+        if (_session_capture_enable)
+        {
+            _session_capture.terminate();
+        }
+
+        _servo_trace.terminate();
+        _ctrl_pkt_capture.terminate();
+        _isolation_audit.restore_irqs();
+
+        _memory_lock.forget(RECORDER_MEMORY_NAME);
+        _memory_lock.forget(PLAYER_MEMORY_NAME);
+        _memory_lock.forget(TAP_MEMORY_NAME);
+        _disk_recorder.terminate();
+        _disk_player.terminate();
+        _audio_tap.terminate();
+        _event_queue.terminate();
+
         return res;
     }
 
@@ -1294,16 +2212,37 @@ protected:
      * @brief helper function ro clear input usb samples
      * 
      * @param buffer 
+     * @param num_samples The number of samples to clear
      */
     template <typename T>
-    void _clear_alsa_usb_buffer(T* buffer)
+    void _clear_alsa_usb_buffer(T* buffer, int num_samples)
     {
-        for (int i = 0; i < _buffer_size_in_frames * NUM_ALSA_USB_CHANNELS; i++)
+        for (int i = 0; i < num_samples; i++)
         {
             buffer[i] = 0;
         }
     }
 
+    /**
+     * @brief Post an overrun event if the rt thread woke up more than half a
+     *        period late, i.e. at least one period was lost.
+     *
+     * @param period_start_time The wake up time of the current period
+     */
+    int64_t _check_for_overrun(RaspaMicroSec period_start_time)
+    {
+        int64_t num_lost_periods = 0;
+        auto elapsed = period_start_time - _last_period_start_time;
+        if (_last_period_start_time > 0 && _period_time_us > 0 &&
+            elapsed > _period_time_us + _period_time_us / 2)
+        {
+            num_lost_periods = std::max<int64_t>((elapsed + _period_time_us / 2) / _period_time_us - 1, 1);
+            _event_queue.post(RASPA_EVENT_OVERRUN, num_lost_periods, period_start_time, _interrupts_counter);
+        }
+        _last_period_start_time = period_start_time;
+        return num_lost_periods;
+    }
+
     /**
      * @brief Helper function to perform user callback.
      *
@@ -1313,45 +2252,40 @@ protected:
      */
     void _perform_user_callback(int32_t* input_samples, int32_t* output_samples)
     {
-        RaspaMicroSec t_start = 0;  // suppress compiler warnings
-
-        if (_run_logger_enable)
-        {
-             t_start = get_time();
-        }
+        auto t_start = get_time();
+        auto num_lost_periods = _check_for_overrun(t_start);
 
         if (_usb_audio_type == driver_conf::UsbAudioType::NATIVE_ALSA)
         {
             int32_t* usb_in;
             if (_alsa_usb->get_usb_input_samples(usb_in))
             {
-                _clear_alsa_usb_buffer<float>(_user_audio_in_usb);
+                _clear_alsa_usb_buffer<float>(_converter_audio_in_usb, _converter_chan_stride * NUM_ALSA_USB_CHANNELS);
+                if (_usb_input_state == UsbInputState::RUNNING)
+                {
+                    _event_queue.post(RASPA_EVENT_USB_INPUT_LOST, 0, t_start, _interrupts_counter);
+                    _usb_input_state = UsbInputState::LOST;
+                }
             }
             else
             {
+                if (_usb_input_state == UsbInputState::LOST)
+                {
+                    _event_queue.post(RASPA_EVENT_USB_INPUT_RESTORED, 0, t_start, _interrupts_counter);
+                }
+                _usb_input_state = UsbInputState::RUNNING;
+
                 for(auto& converter : _input_usb_sample_converter)
                 {
-                    converter->codec_format_to_float32n(_user_audio_in_usb,
+                    converter->codec_format_to_float32n(_converter_audio_in_usb,
                                                             usb_in);
                 }
 
-                _clear_alsa_usb_buffer<int32_t>(usb_in);
+                _clear_alsa_usb_buffer<int32_t>(usb_in, _buffer_size_in_frames * NUM_ALSA_USB_CHANNELS);
             }
         }
 
-
-        for(auto& converter : _input_sample_converter)
-        {
-            converter->codec_format_to_float32n(_user_audio_in, input_samples);
-        }
-
-        _user_callback(_user_audio_in, _user_audio_out, _user_data);
-
-        for(auto& converter : _output_sample_converter)
-        {
-            converter->float32n_to_codec_format(output_samples,
-                                                _user_audio_out);
-        }
+        _process_period(input_samples, output_samples, _interrupts_counter);
 
         if (_usb_audio_type == driver_conf::UsbAudioType::NATIVE_ALSA)
         {
@@ -1359,17 +2293,32 @@ protected:
 
             for(auto& converter : _output_usb_sample_converter)
             {
-                converter->float32n_to_codec_format(usb_out, _user_audio_out_usb);
+                converter->float32n_to_codec_format(usb_out, _converter_audio_out_usb);
             }
 
             _alsa_usb->put_usb_output_samples(usb_out);
             _alsa_usb->increment_buf_indices();
         }
 
-        if (_run_logger_enable)
-        {
-            _run_logger.put(t_start, get_time());
-        }
+        auto t_end = get_time();
+        _end_period(t_start, t_end, num_lost_periods, _interrupts_counter);
+    }
+
+    /**
+     * @brief Helper function to capture the raw driver data of the current
+     *        period. Must be called before the input buffer is processed.
+     */
+    void _capture_period()
+    {
+        SessionCapturePeriod period;
+        period.period_count = _interrupts_counter;
+        period.irq_time_us = get_time();
+        period.buf_idx = _buf_idx;
+        period.gate_in = _user_gate_in;
+
+        _session_capture.put(period,
+                             _driver_buffer_audio_in[_buf_idx],
+                             _rx_pkt[_buf_idx]);
     }
 
     /**
@@ -1378,23 +2327,21 @@ protected:
      *        into the payload
      *
      * @param pkt The packet which is meant to contain the gpio command and data
+     * @return The number of gpio data blobs in the payload
      */
-    void _prepare_gpio_cmd_pkt(audio_ctrl::AudioCtrlPkt* const pkt)
+    int _prepare_gpio_cmd_pkt(audio_ctrl::AudioCtrlPkt* const pkt)
     {
-        int num_blobs = 0;
         audio_ctrl::GpioDataBlob* data = pkt->payload.gpio_data_blob;
 
         // clear packet first
         audio_ctrl::create_default_audio_ctrl_pkt(pkt);
 
         // retreive packets from com task and insert into audio packet payload
-        while (num_blobs < AUDIO_CTRL_PKT_MAX_NUM_GPIO_DATA_BLOBS &&
-               _gpio_com->get_gpio_data_from_nrt(data[num_blobs]))
-        {
-            num_blobs++;
-        }
+        int num_blobs = _gpio_com->get_gpio_data_from_nrt(data,
+                                        AUDIO_CTRL_PKT_MAX_NUM_GPIO_DATA_BLOBS);
 
         audio_ctrl::prepare_gpio_cmd_pkt(pkt, num_blobs);
+        return num_blobs;
     }
 
     /**
@@ -1406,6 +2353,7 @@ protected:
     {
         if (audio_ctrl::check_audio_pkt_for_magic_words(pkt) == 0)
         {
+            _ctrl_pkt_capture.put(_interrupts_counter, CTRL_PKT_RX, CTRL_PKT_INVALID, 0, pkt);
             return;
         }
 
@@ -1413,21 +2361,27 @@ protected:
         auto num_blobs = audio_ctrl::check_for_gpio_data(pkt);
         if (num_blobs > 0)
         {
-            for (int i = 0; i < num_blobs; i++)
+            _ctrl_pkt_capture.put(_interrupts_counter, CTRL_PKT_RX, CTRL_PKT_GPIO,
+                                  num_blobs * sizeof(audio_ctrl::GpioDataBlob), pkt);
+            auto num_sent = _gpio_com->send_gpio_data_to_nrt(pkt->payload.gpio_data_blob,
+                                                             num_blobs);
+            if (num_sent < num_blobs)
             {
-                const audio_ctrl::GpioDataBlob& data =
-                                    pkt->payload.gpio_data_blob[i];
-                _gpio_com->send_gpio_data_to_nrt(data);
+                _event_queue.post(RASPA_EVENT_GPIO_OVERFLOW, num_blobs - num_sent, get_time(),
+                                  _interrupts_counter);
             }
-
             return;
         }
 
         auto num_midi_bytes = check_for_midi_data(pkt);
         if (num_midi_bytes > 0)
         {
+            _ctrl_pkt_capture.put(_interrupts_counter, CTRL_PKT_RX, CTRL_PKT_MIDI, num_midi_bytes, pkt);
             // TODO : process midi data
+            return;
         }
+
+        _ctrl_pkt_capture.put(_interrupts_counter, CTRL_PKT_RX, CTRL_PKT_DEFAULT, 0, pkt);
     }
 
     /**
@@ -1442,18 +2396,22 @@ protected:
         if (_stop_request_flag)
         {
             audio_ctrl::prepare_audio_cease_pkt(pkt, _audio_packet_seq_num);
+            _ctrl_pkt_capture.put(_interrupts_counter, CTRL_PKT_TX, CTRL_PKT_CEASE, 0, pkt);
             return;
         }
 
         // if gpio packets need to be sent, then pack payload with them
         if (_gpio_com->rx_gpio_data_available())
         {
-            _prepare_gpio_cmd_pkt(pkt);
+            auto num_blobs = _prepare_gpio_cmd_pkt(pkt);
+            _ctrl_pkt_capture.put(_interrupts_counter, CTRL_PKT_TX, CTRL_PKT_GPIO,
+                                  num_blobs * sizeof(audio_ctrl::GpioDataBlob), pkt);
             return;
         }
 
         // Create default packet if nothing is there to be sent.
         audio_ctrl::create_default_audio_ctrl_pkt(pkt);
+        _ctrl_pkt_capture.put(_interrupts_counter, CTRL_PKT_TX, CTRL_PKT_DEFAULT, 0, pkt);
 
         // TODO : round robin between gpio and midi data
     }
@@ -1461,17 +2419,19 @@ protected:
     /**
      * @brief Main real time loop when platform type is native
      */
-    void _rt_loop_native()
+    int _rt_loop_native()
     {
+#ifdef RASPA_WITH_EVL
         bool clear_thread_mode_on_stop = 0;
         int evl_thread_mode_mask = T_WOSS;
+#endif
         while (true)
         {
             auto res = __RASPA_IOCTL_RT(ioctl(_device_handle,
                                 RASPA_IRQ_WAIT, &_buf_idx));
             if (res)
             {
-                break;
+                return res;
             }
 
             if (_detect_mode_sw)
@@ -1485,6 +2445,9 @@ protected:
                 }
                 clear_thread_mode_on_stop = true;
                 _detect_mode_sw = false;
+#elif defined(RASPA_WITH_PREEMPT_RT)
+                // all in-band, there are no mode switches to detect
+                _detect_mode_sw = false;
 #else
                 pthread_setmode_np(0, PTHREAD_WARNSW, NULL);
                 _detect_mode_sw = false;
@@ -1511,6 +2474,10 @@ protected:
             else
             {
                 _user_gate_in = *_driver_cv_in;
+                if (_session_capture_enable)
+                {
+                    _capture_period();
+                }
                 _perform_user_callback(_driver_buffer_audio_in[_buf_idx],
                                        _driver_buffer_audio_out[_buf_idx]);
                 *_driver_cv_out = _user_gate_out;
@@ -1520,15 +2487,18 @@ protected:
                                     NULL));
             _interrupts_counter++;
         }
+        return RASPA_SUCCESS;
     }
 
     /**
      * @brief main rt loop when platform type is asynchronous
      */
-    void _rt_loop_async()
+    int _rt_loop_async()
     {
+#ifdef RASPA_WITH_EVL
         bool clear_thread_mode_on_stop = 0;
         int evl_thread_mode_mask = T_WOSS;
+#endif
 
         while (true)
         {
@@ -1536,7 +2506,7 @@ protected:
                                 RASPA_IRQ_WAIT, &_buf_idx));
             if (res)
             {
-                break;
+                return res;
             }
 
             if (_detect_mode_sw)
@@ -1550,6 +2520,9 @@ protected:
                 }
                 clear_thread_mode_on_stop = true;
                 _detect_mode_sw = false;
+#elif defined(RASPA_WITH_PREEMPT_RT)
+                // all in-band, there are no mode switches to detect
+                _detect_mode_sw = false;
 #else
                 pthread_setmode_np(0, PTHREAD_WARNSW, NULL);
                 _detect_mode_sw = false;
@@ -1576,6 +2549,10 @@ protected:
             {
                 // Store CV gate in
                 _user_gate_in = audio_ctrl::get_gate_in_val(_rx_pkt[_buf_idx]);
+                if (_session_capture_enable)
+                {
+                    _capture_period();
+                }
 
                 _parse_rx_pkt(_rx_pkt[_buf_idx]);
                 _perform_user_callback(_driver_buffer_audio_in[_buf_idx],
@@ -1591,15 +2568,18 @@ protected:
                            NULL));
             _interrupts_counter++;
         }
+        return RASPA_SUCCESS;
     }
 
     /**
      * @brief Main rt loop when platform type is synchronous
      */
-    void _rt_loop_sync()
+    int _rt_loop_sync()
     {
+#ifdef RASPA_WITH_EVL
         bool clear_thread_mode_on_stop = 0;
         int evl_thread_mode_mask = T_WOSS;
+#endif
 
         // do not perform userspace callback before delay filter is settled
         while (_interrupts_counter < DELAY_FILTER_SETTLING_CONSTANT)
@@ -1616,6 +2596,7 @@ protected:
                                 audio_ctrl::get_timing_error(_rx_pkt[_buf_idx]);
             auto correction_ns = _process_timing_error_with_downsampling(
                                 timing_error_ns);
+            _servo_trace.put(_interrupts_counter, timing_error_ns, correction_ns);
 
             _parse_rx_pkt(_rx_pkt[_buf_idx]);
             _get_next_tx_pkt_data(_tx_pkt[_buf_idx]);
@@ -1637,10 +2618,13 @@ protected:
             if (res)
             {
                 error(1, -res, "evl_set_thread_mode failed");
-                return;
+                return res;
             }
             clear_thread_mode_on_stop = true;
             _detect_mode_sw = false;
+#elif defined(RASPA_WITH_PREEMPT_RT)
+            // all in-band, there are no mode switches to detect
+            _detect_mode_sw = false;
 #else
             pthread_setmode_np(0, PTHREAD_WARNSW, NULL);
             _detect_mode_sw = false;
@@ -1654,7 +2638,7 @@ protected:
                                 RASPA_IRQ_WAIT, &_buf_idx));
             if (res)
             {
-                break;
+                return res;
             }
 
             // Timing error
@@ -1662,6 +2646,7 @@ protected:
                                 audio_ctrl::get_timing_error(_rx_pkt[_buf_idx]);
             auto correction_ns = _process_timing_error_with_downsampling(
                                 timing_error_ns);
+            _servo_trace.put(_interrupts_counter, timing_error_ns, correction_ns);
 
             if (_stop_request_flag)
             {
@@ -1683,6 +2668,10 @@ protected:
             {
                 // Store CV gate in
                 _user_gate_in = audio_ctrl::get_gate_in_val(_rx_pkt[_buf_idx]);
+                if (_session_capture_enable)
+                {
+                    _capture_period();
+                }
 
                 _parse_rx_pkt(_rx_pkt[_buf_idx]);
                 _perform_user_callback(_driver_buffer_audio_in[_buf_idx],
@@ -1698,10 +2687,11 @@ protected:
                            &correction_ns));
             if (res)
             {
-                break;
+                return res;
             }
             _interrupts_counter++;
         }
+        return RASPA_SUCCESS;
     }
 
     // Pointers for driver data
@@ -1715,46 +2705,61 @@ protected:
     size_t _kernel_buffer_mem_size;
 
     // User buffers for audio
-    float* _user_audio_in;
-    float* _user_audio_out;
     float* _user_audio_in_usb;
     float* _user_audio_out_usb;
     uint32_t _user_gate_in;
     uint32_t _user_gate_out;
     int _buf_idx;
 
+    // Buffers the sample converters work on, the user buffers unless decimating
+    float* _converter_audio_in_usb;
+    float* _converter_audio_out_usb;
+    int _converter_chan_stride;
+
     // device handle identifier
     int _device_handle;
 
-    // counter to count the number of interrupts
-    int _interrupts_counter;
+    // counter to count the number of interrupts, written by the rt thread
+    // and read by the event relay and the api
+    std::atomic<int> _interrupts_counter;
 
     // flag to denote that a stop has been requested
-    bool _stop_request_flag;
+    std::atomic<bool> _stop_request_flag;
 
     // flag to break on mode switch occurrence
     bool _detect_mode_sw;
 
-    // flag to enable logging of run data to file
-    bool _run_logger_enable;
+    // flag to enable capture of the raw driver data of every period
+    bool _session_capture_enable;
+    std::string _session_capture_file_name;
 
-    // configuration data
-    std::string _run_logger_file_name;
+    // flag to enable the trace of the delay error filter on sync platforms
+    bool _servo_trace_enable;
+    std::string _servo_trace_file_name;
+
+    // flag to enable the capture of the audio control packets
+    bool _ctrl_pkt_capture_enable;
+    std::string _ctrl_pkt_capture_file_name;
+
+    // flags to audit the isolation of the audio cpu and move other interrupts away from it
+    bool _isolation_audit_enable;
+    bool _irq_steering_enable;
+
+    // floating point mode of the rt threads
+    bool _flush_denormals;
 
     // configuration data
     int _cpu_affinity;
 
     // audio buffer parameters
     float _sample_rate;
-    int _num_input_chans;           // total num of input chans
-    int _num_output_chans;          // total num of output chans
     int _num_driver_input_chans;    // num of input chans given by the driver
     int _num_driver_output_chans;   // num of output chans given by the driver
     int _buffer_size_in_frames;     // the buffer size in frames
     int _driver_buffer_size_in_samples; // size of the driver buffer in samples
 
-    std::vector<std::unique_ptr<BaseSampleConverter>> _input_sample_converter;
-    std::vector<std::unique_ptr<BaseSampleConverter>> _output_sample_converter;
+    std::vector<struct driver_conf::ChannelInfo> _input_chan_info;
+    std::vector<struct driver_conf::ChannelInfo> _output_chan_info;
     std::vector<std::unique_ptr<BaseSampleConverter>> _input_usb_sample_converter;
     std::vector<std::unique_ptr<BaseSampleConverter>> _output_usb_sample_converter;
 
@@ -1765,8 +2770,6 @@ protected:
     bool _task_started;
 
     // rt task data
-    void* _user_data;
-    RaspaProcessCallback _user_callback;
     pthread_t _processing_task;
 
     // Error code helper class
@@ -1788,9 +2791,47 @@ protected:
     // seq number for audio control packets
     uint32_t _audio_packet_seq_num;
 
-    // run logger instance
-    RaspaRunLogger _run_logger;
+    // system state sampled next to the run log
+    RaspaSystemSampler _system_sampler;
+
+    // session capture instance
+    RaspaSessionCapture _session_capture;
+
+    // servo trace instance
+    RaspaServoTrace _servo_trace;
+
+    // audio control packet capture instance
+    RaspaCtrlPktCapture _ctrl_pkt_capture;
+
+    // isolation audit of the audio cpu, keeps the interrupts it moved
+    RaspaIsolationAudit _isolation_audit;
+
+    // disk recorder instance
+    RaspaDiskRecorder _disk_recorder;
+
+    // disk player instance
+    RaspaDiskPlayer _disk_player;
+
+    RaspaMicroSec _last_period_start_time;
+    RaspaMicroSec _period_time_us;
+    UsbInputState _usb_input_state;
+
+    // targeted memory lock
+    int _memory_lock_mode;
+    RaspaMemoryLock _memory_lock;
+    void* _rt_thread_stack;
     int _rt_task_id;
+
+    // SCHED_DEADLINE reservation of the rt thread, PREEMPT_RT builds only
+    float _deadline_runtime_fraction;
+    std::atomic<int> _deadline_res;
+
+    // processing graph and its worker threads
+    RaspaGraphExecutor _graph;
+    std::vector<int> _graph_worker_cpus;
+    pthread_t _graph_workers[RASPA_GRAPH_MAX_WORKERS];
+    GraphWorkerArgs _graph_worker_args[RASPA_GRAPH_MAX_WORKERS];
+    int _num_graph_workers_started;
 };
 
 static void* raspa_pimpl_task_entry(void* data)
@@ -1801,6 +2842,28 @@ static void* raspa_pimpl_task_entry(void* data)
     return nullptr;
 }
 
+static void* raspa_graph_worker_entry(void* data)
+{
+    auto args = static_cast<GraphWorkerArgs*>(data);
+    args->pimpl->graph_worker_loop(args->worker);
+    return nullptr;
+}
+
+static int64_t raspa_graph_get_time_ns()
+{
+    return get_rt_time_ns();
+}
+
+static void raspa_graph_worker_idle()
+{
+#ifdef RASPA_WITH_EVL
+    evl_usleep(GRAPH_WORKER_IDLE_SLEEP_NS / 1000);
+#else
+    struct timespec ts = {0, GRAPH_WORKER_IDLE_SLEEP_NS};
+    __RASPA(clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, nullptr));
+#endif
+}
+
 }  // namespace raspa
 
 #endif  // RASPA_RASPA_PIMPL_H
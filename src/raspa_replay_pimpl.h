@@ -0,0 +1,997 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class RaspaReplayPimpl, which implements the api found
+ *        in raspa.h on top of a session capture file instead of the audio
+ *        driver. Each captured period goes through the same sample
+ *        conversion and control packet parsing as on the device, and the
+ *        user callback is called as fast as possible on a normal thread, so
+ *        that a session can be reproduced and profiled on any machine.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_RASPA_REPLAY_PIMPL_H
+#define RASPA_RASPA_REPLAY_PIMPL_H
+
+#include <cinttypes>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_control_protocol/audio_control_protocol.h"
+#include "audio_control_protocol/audio_packet_helper.h"
+#include "driver_config.h"
+#include "raspa/raspa.h"
+#include "raspa_audio_tap.h"
+#include "raspa_disk_player.h"
+#include "raspa_disk_recorder.h"
+#include "raspa_error_codes.h"
+#include "raspa_event_queue.h"
+#include "raspa_fpu_mode.h"
+#include "raspa_graph_executor.h"
+#include "raspa_load_policy.h"
+#include "raspa_memory_lock.h"
+#include "raspa_period_processor.h"
+#include "raspa_resampler.h"
+#ifdef RASPA_WITH_RT_SANITIZER
+    #include "raspa_rt_sanitizer.h"
+#endif
+#include "raspa_session_capture.h"
+#include "sample_conversion.h"
+
+namespace raspa {
+
+// Environment variable with the path of the capture file to replay
+constexpr char REPLAY_FILE_ENV[] = "RASPA_REPLAY_FILE";
+
+// Environment variable with the number of times the capture is replayed
+constexpr char REPLAY_LOOPS_ENV[] = "RASPA_REPLAY_LOOPS";
+
+/**
+ * @brief Drop-in replacement of RaspaPimpl which replays a session capture.
+ *        Linking an application with the raspa_replay library instead of raspa
+ *        makes raspa_open() load the capture file given by RASPA_REPLAY_FILE
+ *        (RASPA_DEFAULT_SESSION_CAPTURE_FILE if not set). At the end of the
+ *        replay a summary is printed and SIGINT is raised, so that the
+ *        application goes through its normal shutdown path.
+ */
+class RaspaReplayPimpl : public RaspaPeriodProcessor
+{
+public:
+    RaspaReplayPimpl() :
+            _replay_file_name(RASPA_DEFAULT_SESSION_CAPTURE_FILE),
+            _num_loops(1),
+            _header{},
+            _user_gate_in(0),
+            _user_gate_out(0),
+            _converter_chan_stride(0),
+            _period_count(0),
+            _period_time(0),
+            _stop_request_flag(false),
+            _device_opened(false),
+            _task_started(false),
+            _flush_denormals(true),
+            _num_graph_workers(0)
+    {}
+
+    ~RaspaReplayPimpl()
+    {
+        _cleanup();
+    }
+
+    int init()
+    {
+        auto file_name = std::getenv(REPLAY_FILE_ENV);
+        if (file_name)
+        {
+            _replay_file_name = file_name;
+        }
+
+        auto num_loops = std::getenv(REPLAY_LOOPS_ENV);
+        if (num_loops)
+        {
+            _num_loops = std::max(1, std::atoi(num_loops));
+        }
+
+        return RASPA_SUCCESS;
+    }
+
+    void set_memory_lock_mode(int /*mode*/)
+    {}
+
+    int lock_memory_region(const void* address, size_t size)
+    {
+        return _memory_lock.lock(address, size, "user region");
+    }
+
+    int get_memory_report(RaspaMemoryReport* report, bool print)
+    {
+        return _memory_lock.get_report(report, print);
+    }
+
+    void set_session_capture_file(const char* /*path*/)
+    {}
+
+    void set_servo_trace_file(const char* /*path*/)
+    {}
+
+    void set_ctrl_pkt_capture_file(const char* /*path*/)
+    {}
+
+    void set_cpu_affinity(int /*affinity*/)
+    {}
+
+    int set_decimation(int factor)
+    {
+        if (_device_opened || factor < 1 || factor > RASPA_MAX_DECIMATION)
+        {
+            return -RASPA_EDECIMATION;
+        }
+        _decimation_factor = factor;
+        return RASPA_SUCCESS;
+    }
+
+    int get_decimation() const
+    {
+        return _decimation_factor;
+    }
+
+    int get_callback_buffer_size() const
+    {
+        return _device_opened ? _user_buffer_size_in_frames : 0;
+    }
+
+    int get_callback_channel_stride() const
+    {
+        return _device_opened ? _user_chan_stride : 0;
+    }
+
+    int set_load_policy(float high_load, float low_load, int hold_time_ms)
+    {
+        if (_device_opened)
+        {
+            return -RASPA_ELOAD_POLICY;
+        }
+
+        auto res = _load_policy.configure(high_load, low_load, hold_time_ms);
+        _load_policy_enable = res == RASPA_SUCCESS;
+        return res;
+    }
+
+    int get_policy_buffer_size()
+    {
+        if (!_device_opened)
+        {
+            return 0;
+        }
+        return _load_policy_enable ? _load_policy.get_requested_buffer_size()
+                                   : static_cast<int>(_header.buffer_size_in_frames);
+    }
+
+    void set_flush_denormals(bool enabled)
+    {
+        _flush_denormals = enabled;
+    }
+
+    int get_denormal_report(RaspaDenormalReport* report, bool print)
+    {
+        if (!_denormal_count_enable)
+        {
+            return -RASPA_EDENORMAL_COUNT;
+        }
+        _denormal_counter.get_report(report, print);
+        return RASPA_SUCCESS;
+    }
+
+    // the replay thread is not run under a deadline reservation
+    int set_deadline_reservation(float /*runtime_fraction*/)
+    {
+        return RASPA_SUCCESS;
+    }
+
+    void set_irq_steering(bool /*enabled*/)
+    {}
+
+    // the replay is not bound to an audio cpu, there is nothing to audit
+    int audit_isolation(RaspaIsolationReport* report, bool /*print*/)
+    {
+        *report = {};
+        return RASPA_SUCCESS;
+    }
+
+    RaspaMicroSec get_decimation_latency()
+    {
+        if (_header.sample_rate > 0)
+        {
+            return (static_cast<RaspaMicroSec>(RaspaResampler::get_delay_in_frames(_decimation_factor)) * 1000000) /
+                   _header.sample_rate;
+        }
+
+        return 0;
+    }
+
+    int open_device(int buffer_size,
+                    RaspaProcessCallback process_callback,
+                    void* user_data,
+                    unsigned int debug_flags)
+    {
+        return _open_device(buffer_size, process_callback, nullptr, user_data, debug_flags);
+    }
+
+    int open_device_channels(int buffer_size,
+                             RaspaChannelProcessCallback process_callback,
+                             void* user_data,
+                             unsigned int debug_flags)
+    {
+        return _open_device(buffer_size, nullptr, process_callback, user_data, debug_flags);
+    }
+
+    int start_realtime()
+    {
+        _stop_request_flag = false;
+
+        // replay does not run in real time, the rt loop is not watched
+        _event_queue.start([]() -> int64_t
+        {
+            return -1;
+        });
+
+        // the load policy judges the replayed load against the captured period time
+        if (_header.sample_rate > 0)
+        {
+            _start_load_policy(static_cast<int>(_header.buffer_size_in_frames), _get_period_time());
+        }
+
+        // graph workers are regular threads, not pinned
+        if (_graph.get_num_nodes() > 0)
+        {
+            auto res = _graph.prepare(_num_graph_workers);
+            if (res != RASPA_SUCCESS)
+            {
+                _cleanup();
+                return res;
+            }
+            for (int i = 1; i <= _num_graph_workers; i++)
+            {
+                _graph_workers.emplace_back([this, i]()
+                {
+                    set_thread_flush_denormals(_flush_denormals);
+                    _graph.run_worker(i);
+                });
+            }
+        }
+
+        _thread = std::thread(&RaspaReplayPimpl::_replay_loop, this);
+        _task_started = true;
+        return RASPA_SUCCESS;
+    }
+
+    float get_sampling_rate()
+    {
+        return static_cast<float>(_header.sample_rate) / _decimation_factor;
+    }
+
+    int get_num_input_channels()
+    {
+        return _header.num_input_chans;
+    }
+
+    int get_num_output_channels()
+    {
+        return _header.num_output_chans;
+    }
+
+    const char* get_error_msg(int code)
+    {
+        return _raspa_error_code.get_error_text(code);
+    }
+
+    uint32_t get_gate_values()
+    {
+        return _user_gate_in;
+    }
+
+    void set_gate_values(uint32_t gate_out_val)
+    {
+        _user_gate_out = gate_out_val;
+    }
+
+    /**
+     * @brief Returns the captured wake up time of the current period, so that
+     *        time based processing behaves as it did on the device.
+     */
+    RaspaMicroSec get_time()
+    {
+        return _period_time;
+    }
+
+    int64_t get_samplecount()
+    {
+        return _period_count * _user_buffer_size_in_frames;
+    }
+
+    RaspaMicroSec get_output_latency()
+    {
+        if (_header.sample_rate > 0)
+        {
+            // the interpolator adds half of the decimation filters delay
+            int resampler_delay = RaspaResampler::get_delay_in_frames(_decimation_factor) / 2;
+            return (static_cast<RaspaMicroSec>(_header.driver_buffer_size_in_samples + resampler_delay) * 1000000) /
+                   _header.sample_rate;
+        }
+
+        return 0;
+    }
+
+    int close_device()
+    {
+        if (_task_started)
+        {
+            _fade_out_outputs(_get_period_time());
+        }
+        return _cleanup();
+    }
+
+    int request_out_gpio(int /*pin_num*/)
+    {
+        return 0;
+    }
+
+    int set_gpio(int /*pin_num*/, int /*val*/)
+    {
+        return 0;
+    }
+
+    int free_gpio(int /*pin_num*/)
+    {
+        return 0;
+    }
+
+    int recorder_open(const char* file_name, const int* channels, int num_channels)
+    {
+        if (!_device_opened || num_channels <= 0)
+        {
+            return -RASPA_ERECORDER_CHANNELS;
+        }
+
+        std::vector<int> channel_list(channels, channels + num_channels);
+        for (auto channel : channel_list)
+        {
+            if (channel < 0 || channel >= static_cast<int>(_header.num_input_chans))
+            {
+                return -RASPA_ERECORDER_CHANNELS;
+            }
+        }
+
+        return _disk_recorder.start(file_name,
+                                    channel_list,
+                                    _user_buffer_size_in_frames,
+                                    _user_chan_stride,
+                                    static_cast<int>(get_sampling_rate()));
+    }
+
+    void recorder_push(const float* input)
+    {
+        _disk_recorder.push(input);
+    }
+
+    int recorder_close()
+    {
+        return _disk_recorder.terminate();
+    }
+
+    int64_t recorder_get_num_overruns()
+    {
+        return _disk_recorder.get_num_overruns();
+    }
+
+    int player_open(const char* file_name, const int* channels, int num_channels)
+    {
+        if (!_device_opened || num_channels <= 0)
+        {
+            return -RASPA_EPLAYER_CHANNELS;
+        }
+
+        return _disk_player.start(file_name,
+                                  std::vector<int>(channels, channels + num_channels),
+                                  static_cast<int>(_header.num_output_chans),
+                                  _user_buffer_size_in_frames,
+                                  _user_chan_stride,
+                                  static_cast<int>(get_sampling_rate()));
+    }
+
+    void player_pull(float* output)
+    {
+        _disk_player.pull(output);
+    }
+
+    int player_seek(int64_t frame)
+    {
+        return _disk_player.seek(frame) ? RASPA_SUCCESS : -RASPA_EPLAYER_QUEUE_FULL;
+    }
+
+    int player_set_loop(int enabled)
+    {
+        return _disk_player.set_loop(enabled != 0) ? RASPA_SUCCESS : -RASPA_EPLAYER_QUEUE_FULL;
+    }
+
+    int player_close()
+    {
+        return _disk_player.terminate();
+    }
+
+    int64_t player_get_num_starvations()
+    {
+        return _disk_player.get_num_starvations();
+    }
+
+    int tap_open(const char* name,
+                 const int* input_channels,
+                 int num_inputs,
+                 const int* output_channels,
+                 int num_outputs)
+    {
+        if (!_device_opened || num_inputs < 0 || num_outputs < 0)
+        {
+            return -RASPA_ETAP_CHANNELS;
+        }
+
+        std::vector<int> input_list(input_channels, input_channels + num_inputs);
+        std::vector<int> output_list(output_channels, output_channels + num_outputs);
+        for (auto channel : input_list)
+        {
+            if (channel < 0 || channel >= static_cast<int>(_header.num_input_chans))
+            {
+                return -RASPA_ETAP_CHANNELS;
+            }
+        }
+        for (auto channel : output_list)
+        {
+            if (channel < 0 || channel >= static_cast<int>(_header.num_output_chans))
+            {
+                return -RASPA_ETAP_CHANNELS;
+            }
+        }
+
+        return _audio_tap.start(name, input_list, output_list, _user_buffer_size_in_frames,
+                                _user_chan_stride, static_cast<int>(get_sampling_rate()));
+    }
+
+    int tap_close()
+    {
+        return _audio_tap.terminate();
+    }
+
+    int get_event_fd()
+    {
+        auto res = _event_queue.get_fd();
+        if (res < 0)
+        {
+            _raspa_error_code.set_error_val(RASPA_EEVENT_FD, errno);
+        }
+        return res;
+    }
+
+    int read_event(RaspaEvent* event)
+    {
+        return _event_queue.read(event);
+    }
+
+    int graph_add_node(RaspaGraphNodeCallback callback, void* data, const char* name)
+    {
+        return _graph.add_node(callback, data, name);
+    }
+
+    int graph_add_edge(int from_node, int to_node)
+    {
+        return _graph.add_edge(from_node, to_node);
+    }
+
+    int graph_clear()
+    {
+        return _graph.clear();
+    }
+
+    int graph_set_worker_cpus(const int* cpus, int num_cpus)
+    {
+        if (_graph.is_prepared())
+        {
+            return -RASPA_EGRAPH_RUNNING;
+        }
+        if (num_cpus < 0 || num_cpus > RASPA_GRAPH_MAX_WORKERS || (num_cpus > 0 && cpus == nullptr))
+        {
+            return -RASPA_EGRAPH_WORKER;
+        }
+
+        _num_graph_workers = num_cpus;
+        return RASPA_SUCCESS;
+    }
+
+    int graph_process()
+    {
+        auto res = _graph.process();
+        if (res == RASPA_SUCCESS)
+        {
+            _log_graph_nodes(_graph, _period_count);
+        }
+        return res;
+    }
+
+    int graph_get_node_stats(int node, RaspaGraphNodeStats* stats)
+    {
+        return _graph.get_node_stats(node, stats);
+    }
+
+protected:
+    /**
+     * @brief Open the capture with one of the two process callback types.
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise
+     */
+    int _open_device(int buffer_size,
+                     RaspaProcessCallback process_callback,
+                     RaspaChannelProcessCallback channel_process_callback,
+                     void* user_data,
+                     unsigned int debug_flags)
+    {
+        auto res = _read_capture_header();
+        if (res != RASPA_SUCCESS)
+        {
+            _cleanup();
+            return res;
+        }
+
+        if (debug_flags & RASPA_DEBUG_RT_SANITIZER)
+        {
+#ifdef RASPA_WITH_RT_SANITIZER
+            RaspaRtSanitizer::init();
+            _rt_sanitizer_enable = true;
+#else
+            _cleanup();
+            return -RASPA_ERT_SANITIZER;
+#endif
+        }
+
+        if (debug_flags & RASPA_DEBUG_COUNT_DENORMALS)
+        {
+            _denormal_count_enable = true;
+        }
+
+        if (debug_flags & RASPA_DEBUG_ENABLE_RUN_LOG_TO_FILE)
+        {
+            _run_logger_enable = true;
+        }
+
+        if (static_cast<uint32_t>(buffer_size) != _header.buffer_size_in_frames)
+        {
+            _cleanup();
+            return -RASPA_EBUFFER_SIZE_MISMATCH;
+        }
+
+        if (RaspaResampler::validate(_decimation_factor, buffer_size) != RASPA_SUCCESS)
+        {
+            _cleanup();
+            return -RASPA_EDECIMATION;
+        }
+
+        // when decimating, the converters work on the full rate buffers of the resampler
+        _user_buffer_size_in_frames = buffer_size / _decimation_factor;
+        _user_chan_stride = channel_process_callback ? get_padded_channel_stride(_user_buffer_size_in_frames)
+                                                     : _user_buffer_size_in_frames;
+        _converter_chan_stride = _decimation_factor > 1 ? buffer_size : _user_chan_stride;
+        res = create_sample_converters(_input_sample_converter,
+                                       _input_chan_info,
+                                       buffer_size,
+                                       _converter_chan_stride);
+        if (res == RASPA_SUCCESS)
+        {
+            res = create_sample_converters(_output_sample_converter,
+                                           _output_chan_info,
+                                           buffer_size,
+                                           _converter_chan_stride);
+        }
+        if (res != RASPA_SUCCESS)
+        {
+            _cleanup();
+            return res;
+        }
+
+        res = _init_buffers();
+        if (res != RASPA_SUCCESS)
+        {
+            _cleanup();
+            return res;
+        }
+
+        if (_run_logger_enable)
+        {
+            res = _run_logger.start(_run_logger_file_name);
+            if (res != RASPA_SUCCESS)
+            {
+                _cleanup();
+                return res;
+            }
+        }
+
+        _device_opened = true;
+        _user_data = user_data;
+        _user_callback = process_callback;
+        _user_channel_callback = channel_process_callback;
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Open the capture file and read the session configuration.
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise
+     */
+    int _read_capture_header()
+    {
+        _replay_stream.open(_replay_file_name.c_str(), std::ifstream::binary | std::ifstream::in);
+        if (_replay_stream.fail())
+        {
+            return -RASPA_ECAPTURE_FILE_OPEN;
+        }
+
+        _replay_stream.read(reinterpret_cast<char*>(&_header), sizeof(_header));
+        if (!_replay_stream ||
+            std::memcmp(_header.magic, SESSION_CAPTURE_MAGIC, sizeof(_header.magic)) != 0 ||
+            _header.version != SESSION_CAPTURE_VERSION)
+        {
+            return -RASPA_ECAPTURE_FILE_INVALID;
+        }
+
+        size_t pkt_size_in_bytes = _header.ctrl_pkt_size_in_words * sizeof(int32_t);
+        if (_header.record_size_in_bytes != sizeof(SessionCapturePeriod) +
+                                            _header.driver_buffer_size_in_samples * sizeof(int32_t) +
+                                            pkt_size_in_bytes ||
+            pkt_size_in_bytes > sizeof(audio_ctrl::AudioCtrlPkt))
+        {
+            return -RASPA_ECAPTURE_FILE_INVALID;
+        }
+
+        _input_chan_info.resize(_header.num_driver_input_chans);
+        _output_chan_info.resize(_header.num_driver_output_chans);
+        _replay_stream.read(reinterpret_cast<char*>(_input_chan_info.data()),
+                            _input_chan_info.size() * sizeof(driver_conf::ChannelInfo));
+        _replay_stream.read(reinterpret_cast<char*>(_output_chan_info.data()),
+                            _output_chan_info.size() * sizeof(driver_conf::ChannelInfo));
+        if (!_replay_stream)
+        {
+            return -RASPA_ECAPTURE_FILE_INVALID;
+        }
+
+        _records_start = _replay_stream.tellg();
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Returns the period time of the capture, 0 if its sample rate is
+     *        unknown.
+     */
+    RaspaMicroSec _get_period_time()
+    {
+        if (_header.sample_rate > 0)
+        {
+            return (static_cast<RaspaMicroSec>(_header.buffer_size_in_frames) * 1000000) / _header.sample_rate;
+        }
+
+        return 0;
+    }
+
+    /**
+     * @brief Allocate the driver side and user side buffers. User buffers
+     *        include the virtual usb channels, which are replayed as silence.
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise
+     */
+    int _init_buffers()
+    {
+        _num_input_chans = _header.num_input_chans;
+        _num_output_chans = _header.num_output_chans;
+        int num_user_input_samples = _header.num_input_chans * _user_chan_stride;
+        int num_user_output_samples = _header.num_output_chans * _user_chan_stride;
+        int num_driver_samples = std::max<int>(_header.driver_buffer_size_in_samples,
+                                               _header.num_driver_output_chans *
+                                               _header.buffer_size_in_frames);
+
+        int res = posix_memalign(reinterpret_cast<void**>(&_user_audio_in),
+                                 CACHE_LINE_SIZE_IN_SAMPLES * sizeof(float),
+                                 num_user_input_samples * sizeof(float)) ||
+                  posix_memalign(reinterpret_cast<void**>(&_user_audio_out),
+                                 CACHE_LINE_SIZE_IN_SAMPLES * sizeof(float),
+                                 num_user_output_samples * sizeof(float));
+        if (res != 0)
+        {
+            _raspa_error_code.set_error_val(RASPA_EUSER_BUFFERS, res);
+            return -RASPA_EUSER_BUFFERS;
+        }
+
+        std::fill_n(_user_audio_in, num_user_input_samples, 0);
+        std::fill_n(_user_audio_out, num_user_output_samples, 0);
+
+        _user_audio_in_channels.resize(_header.num_input_chans);
+        _user_audio_out_channels.resize(_header.num_output_chans);
+        for (uint32_t i = 0; i < _header.num_input_chans; i++)
+        {
+            _user_audio_in_channels[i] = _user_audio_in + i * _user_chan_stride;
+        }
+        for (uint32_t i = 0; i < _header.num_output_chans; i++)
+        {
+            _user_audio_out_channels[i] = _user_audio_out + i * _user_chan_stride;
+        }
+
+        if (_denormal_count_enable)
+        {
+            _denormal_counter.init(_header.num_input_chans, _header.num_output_chans);
+        }
+
+        _converter_audio_in = _user_audio_in;
+        _converter_audio_out = _user_audio_out;
+        if (_decimation_factor > 1)
+        {
+            _resampler.init(_decimation_factor,
+                            static_cast<int>(_header.buffer_size_in_frames),
+                            std::max<int>(_header.num_input_chans, _header.num_output_chans),
+                            static_cast<int>(_header.num_input_chans),
+                            static_cast<int>(_header.num_output_chans));
+            _converter_audio_in = _resampler.get_full_rate_input();
+            _converter_audio_out = _resampler.get_full_rate_output();
+        }
+
+        _driver_audio_in.assign(num_driver_samples, 0);
+        _driver_audio_out.assign(num_driver_samples, 0);
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Read the next captured period into the driver side buffers.
+     * @return true if a period was read, false at the end of the capture.
+     */
+    bool _read_period(SessionCapturePeriod& period)
+    {
+        _replay_stream.read(reinterpret_cast<char*>(&period), sizeof(period));
+        _replay_stream.read(reinterpret_cast<char*>(_driver_audio_in.data()),
+                            _header.driver_buffer_size_in_samples * sizeof(int32_t));
+        if (_header.ctrl_pkt_size_in_words > 0)
+        {
+            _replay_stream.read(reinterpret_cast<char*>(&_rx_pkt),
+                                _header.ctrl_pkt_size_in_words * sizeof(int32_t));
+        }
+
+        return static_cast<bool>(_replay_stream);
+    }
+
+    /**
+     * @brief Parse the captured rx packet the same way the rt loop does.
+     *        Gpio and midi data are only counted, as there is nothing to
+     *        forward them to.
+     */
+    void _parse_rx_pkt(const audio_ctrl::AudioCtrlPkt* const pkt)
+    {
+        if (audio_ctrl::check_audio_pkt_for_magic_words(pkt) == 0)
+        {
+            _num_invalid_pkts++;
+            return;
+        }
+
+        auto num_blobs = audio_ctrl::check_for_gpio_data(pkt);
+        if (num_blobs > 0)
+        {
+            _num_gpio_blobs += num_blobs;
+            return;
+        }
+
+        auto num_midi_bytes = audio_ctrl::check_for_midi_data(pkt);
+        if (num_midi_bytes > 0)
+        {
+            _num_midi_bytes += num_midi_bytes;
+        }
+    }
+
+    void _replay_loop()
+    {
+        SessionCapturePeriod period;
+        int64_t last_period_count = -1;
+        int64_t num_periods = 0;
+        int64_t num_missing_periods = 0;
+        int64_t total_callback_ns = 0;
+        int64_t max_callback_ns = 0;
+
+        _num_invalid_pkts = 0;
+        _num_gpio_blobs = 0;
+        _num_midi_bytes = 0;
+
+        set_thread_flush_denormals(_flush_denormals);
+
+        for (int loop = 0; loop < _num_loops && !_stop_request_flag; loop++)
+        {
+            _replay_stream.clear();
+            _replay_stream.seekg(_records_start);
+            last_period_count = -1;
+
+            while (!_stop_request_flag && _read_period(period))
+            {
+                int64_t num_lost_periods = 0;
+                if (last_period_count >= 0 && period.period_count > last_period_count + 1)
+                {
+                    // periods lost by the captured session, or by the capture itself
+                    num_lost_periods = period.period_count - last_period_count - 1;
+                    num_missing_periods += num_lost_periods;
+                    _event_queue.post(RASPA_EVENT_OVERRUN, num_lost_periods,
+                                      period.irq_time_us, period.period_count);
+                }
+                last_period_count = period.period_count;
+
+                _period_count = period.period_count;
+                _period_time = period.irq_time_us;
+                _user_gate_in = period.gate_in;
+
+                if (_header.ctrl_pkt_size_in_words > 0)
+                {
+                    _parse_rx_pkt(&_rx_pkt);
+                }
+
+                auto start = std::chrono::steady_clock::now();
+                _process_period(_driver_audio_in.data(), _driver_audio_out.data(), period.period_count);
+                auto callback_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now() - start).count();
+                total_callback_ns += callback_ns;
+                max_callback_ns = std::max<int64_t>(max_callback_ns, callback_ns);
+                num_periods++;
+
+                // times on the captured timeline, as returned by get_time()
+                _end_period(period.irq_time_us, period.irq_time_us + callback_ns / 1000,
+                            num_lost_periods, period.period_count);
+            }
+        }
+
+        if (!_stop_request_flag)
+        {
+            fprintf(stdout, "Raspa replay: %" PRId64 " periods from %s, %" PRId64
+                            " missing from capture\n",
+                    num_periods, _replay_file_name.c_str(), num_missing_periods);
+            if (num_periods > 0)
+            {
+                fprintf(stdout, "Raspa replay: process time avg %" PRId64 " ns, max %" PRId64 " ns\n",
+                        total_callback_ns / num_periods, max_callback_ns);
+            }
+            if (_header.ctrl_pkt_size_in_words > 0)
+            {
+                fprintf(stdout, "Raspa replay: %" PRId64 " invalid packets, %" PRId64
+                                " gpio blobs, %" PRId64 " midi bytes\n",
+                        _num_invalid_pkts, _num_gpio_blobs, _num_midi_bytes);
+            }
+
+            // let the application shut down as it would on the device
+            std::raise(SIGINT);
+        }
+    }
+
+    int _cleanup()
+    {
+        _stop_request_flag = true;
+        if (_task_started)
+        {
+            if (_thread.joinable())
+            {
+                _thread.join();
+            }
+            _task_started = false;
+        }
+
+        _graph.stop_workers();
+        for (auto& worker : _graph_workers)
+        {
+            worker.join();
+        }
+        _graph_workers.clear();
+        _graph.release();
+
+#ifdef RASPA_WITH_RT_SANITIZER
+        if (_rt_sanitizer_enable)
+        {
+            RaspaRtSanitizer::print_report();
+            _rt_sanitizer_enable = false;
+        }
+#endif
+
+        _disk_recorder.terminate();
+        _disk_player.terminate();
+        _audio_tap.terminate();
+        _event_queue.terminate();
+        if (_run_logger_enable)
+        {
+            _run_logger.terminate();
+            _run_logger_enable = false;
+        }
+
+        if (_replay_stream.is_open())
+        {
+            _replay_stream.close();
+        }
+
+        _input_sample_converter.clear();
+        _output_sample_converter.clear();
+
+        free(_user_audio_in);
+        free(_user_audio_out);
+        _user_audio_in = nullptr;
+        _user_audio_out = nullptr;
+
+        _device_opened = false;
+        return RASPA_SUCCESS;
+    }
+
+    std::string _replay_file_name;
+    int _num_loops;
+
+    std::ifstream _replay_stream;
+    std::streampos _records_start;
+    SessionCaptureHeader _header;
+    std::vector<driver_conf::ChannelInfo> _input_chan_info;
+    std::vector<driver_conf::ChannelInfo> _output_chan_info;
+
+    // driver side buffers
+    std::vector<int32_t> _driver_audio_in;
+    std::vector<int32_t> _driver_audio_out;
+    audio_ctrl::AudioCtrlPkt _rx_pkt;
+
+    // user side buffers
+    uint32_t _user_gate_in;
+    uint32_t _user_gate_out;
+
+    // buffers the sample converters work on, the user buffers unless decimating
+    int _converter_chan_stride;
+
+    // state of the current period
+    int64_t _period_count;
+    RaspaMicroSec _period_time;
+
+    // rx packet statistics
+    int64_t _num_invalid_pkts;
+    int64_t _num_gpio_blobs;
+    int64_t _num_midi_bytes;
+
+    std::atomic<bool> _stop_request_flag;
+    bool _device_opened;
+    bool _task_started;
+    std::thread _thread;
+
+    // floating point mode of the replay threads
+    bool _flush_denormals;
+
+    RaspaDiskRecorder _disk_recorder;
+    RaspaDiskPlayer _disk_player;
+    RaspaMemoryLock _memory_lock;
+
+    // processing graph and its worker threads
+    RaspaGraphExecutor _graph;
+    int _num_graph_workers;
+    std::vector<std::thread> _graph_workers;
+
+    RaspaErrorCode _raspa_error_code;
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_RASPA_REPLAY_PIMPL_H
@@ -0,0 +1,356 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Polyphase decimation and interpolation filters used to run the
+ *        process callback at an integer fraction of the codec sampling rate.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_RESAMPLER_H
+#define RASPA_RESAMPLER_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "raspa/raspa.h"
+#include "raspa_error_codes.h"
+
+namespace raspa {
+
+// Taps of each polyphase sub-filter, the prototype filter has factor times as many
+constexpr int RESAMPLER_TAPS_PER_PHASE = 24;
+
+// Cutoff of the prototype filter, relative to the nyquist frequency of the decimated rate
+constexpr double RESAMPLER_CUTOFF = 0.9;
+
+/**
+ * @brief Design the linear phase, windowed sinc, low pass prototype filter
+ *        shared by the decimator and the interpolator, normalized to unity
+ *        gain at DC.
+ * @param factor The decimation factor
+ * @return The factor * RESAMPLER_TAPS_PER_PHASE coefficients of the filter
+ */
+inline std::vector<float> design_resampler_filter(int factor)
+{
+    int num_taps = factor * RESAMPLER_TAPS_PER_PHASE;
+    double cutoff = RESAMPLER_CUTOFF * 0.5 / factor;  // in cycles per sample
+    double center = 0.5 * (num_taps - 1);
+
+    std::vector<double> taps(num_taps);
+    double sum = 0.0;
+    for (int i = 0; i < num_taps; i++)
+    {
+        double t = i - center;
+        double sinc = std::abs(t) < 1e-9 ? 2.0 * cutoff :
+                      std::sin(2.0 * M_PI * cutoff * t) / (M_PI * t);
+
+        // blackman window
+        double phase = 2.0 * M_PI * i / (num_taps - 1);
+        double window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+        taps[i] = sinc * window;
+        sum += taps[i];
+    }
+
+    std::vector<float> filter(num_taps);
+    for (int i = 0; i < num_taps; i++)
+    {
+        filter[i] = static_cast<float>(taps[i] / sum);
+    }
+    return filter;
+}
+
+/**
+ * @brief Filters and decimates one channel. Only the kept output samples are
+ *        computed, and the history is kept contiguous with the new input so
+ *        that each output is a plain dot product the compiler can vectorize.
+ */
+class PolyphaseDecimator
+{
+public:
+    /**
+     * @brief Construct the decimator.
+     * @param factor The decimation factor
+     * @param num_frames Number of frames at the full rate in each call to process()
+     */
+    PolyphaseDecimator(int factor, int num_frames) : _factor(factor),
+                                                     _num_frames(num_frames)
+    {
+        // the filter is symmetric, so the reversed coefficients are the same
+        _coeffs = design_resampler_filter(factor);
+        _history_length = static_cast<int>(_coeffs.size()) - 1;
+        _history.assign(_history_length + num_frames, 0.0f);
+    }
+
+    /**
+     * @brief Decimate one buffer. Rt safe.
+     * @param input num_frames samples at the full rate
+     * @param output num_frames / factor samples at the decimated rate
+     */
+    void process(const float* input, float* output)
+    {
+        float* history = _history.data();
+        const float* coeffs = _coeffs.data();
+        int num_taps = static_cast<int>(_coeffs.size());
+
+        std::copy_n(input, _num_frames, history + _history_length);
+
+        int num_output_frames = _num_frames / _factor;
+        for (int n = 0; n < num_output_frames; n++)
+        {
+            // output n is aligned with input n * factor, at index _history_length + n * factor
+            const float* x = history + n * _factor;
+            float acc = 0.0f;
+            for (int k = 0; k < num_taps; k++)
+            {
+                acc += coeffs[k] * x[k];
+            }
+            output[n] = acc;
+        }
+
+        std::copy_n(history + _num_frames, _history_length, history);
+    }
+
+    template<typename Function>
+    void for_each_rt_region(Function function) const
+    {
+        function(_coeffs.data(), _coeffs.size() * sizeof(float));
+        function(_history.data(), _history.size() * sizeof(float));
+    }
+
+private:
+    int _factor;
+    int _num_frames;
+    int _history_length;
+    std::vector<float> _coeffs;
+    std::vector<float> _history;
+};
+
+/**
+ * @brief Upsamples and filters one channel, running one sub-filter per output
+ *        phase on the decimated input so that no zeros are multiplied.
+ */
+class PolyphaseInterpolator
+{
+public:
+    /**
+     * @brief Construct the interpolator.
+     * @param factor The interpolation factor
+     * @param num_frames Number of frames at the full rate in each call to process()
+     */
+    PolyphaseInterpolator(int factor, int num_frames) : _factor(factor),
+                                                        _num_frames(num_frames)
+    {
+        auto filter = design_resampler_filter(factor);
+
+        // phase p of sub-filter, reversed and scaled by the factor to keep unity gain
+        _coeffs.resize(filter.size());
+        for (int p = 0; p < factor; p++)
+        {
+            for (int k = 0; k < RESAMPLER_TAPS_PER_PHASE; k++)
+            {
+                _coeffs[p * RESAMPLER_TAPS_PER_PHASE + k] =
+                        factor * filter[p + (RESAMPLER_TAPS_PER_PHASE - 1 - k) * factor];
+            }
+        }
+        _history.assign(RESAMPLER_TAPS_PER_PHASE - 1 + num_frames / factor, 0.0f);
+    }
+
+    /**
+     * @brief Interpolate one buffer. Rt safe.
+     * @param input num_frames / factor samples at the decimated rate
+     * @param output num_frames samples at the full rate
+     */
+    void process(const float* input, float* output)
+    {
+        float* history = _history.data();
+        int num_input_frames = _num_frames / _factor;
+
+        std::copy_n(input, num_input_frames, history + RESAMPLER_TAPS_PER_PHASE - 1);
+
+        for (int n = 0; n < num_input_frames; n++)
+        {
+            const float* x = history + n;
+            for (int p = 0; p < _factor; p++)
+            {
+                const float* coeffs = _coeffs.data() + p * RESAMPLER_TAPS_PER_PHASE;
+                float acc = 0.0f;
+                for (int k = 0; k < RESAMPLER_TAPS_PER_PHASE; k++)
+                {
+                    acc += coeffs[k] * x[k];
+                }
+                output[n * _factor + p] = acc;
+            }
+        }
+
+        std::copy_n(history + num_input_frames, RESAMPLER_TAPS_PER_PHASE - 1, history);
+    }
+
+    template<typename Function>
+    void for_each_rt_region(Function function) const
+    {
+        function(_coeffs.data(), _coeffs.size() * sizeof(float));
+        function(_history.data(), _history.size() * sizeof(float));
+    }
+
+private:
+    int _factor;
+    int _num_frames;
+    std::vector<float> _coeffs;
+    std::vector<float> _history;
+};
+
+/**
+ * @brief Runs the process callback at the codec rate divided by an integer
+ *        factor. The sample converters write to and read from the full rate
+ *        buffers of this class, one channel after the other, and the
+ *        decimators and interpolators move the audio between these and the
+ *        user buffers.
+ */
+class RaspaResampler
+{
+public:
+    RaspaResampler() = default;
+
+    /**
+     * @brief Check that the factor can be used with a buffer size.
+     * @return RASPA_SUCCESS if valid, -RASPA_EDECIMATION otherwise
+     */
+    static int validate(int factor, int buffer_size_in_frames)
+    {
+        if (factor < 1 || factor > RASPA_MAX_DECIMATION ||
+            buffer_size_in_frames <= 0 || buffer_size_in_frames % factor != 0)
+        {
+            return -RASPA_EDECIMATION;
+        }
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Create the filters and the full rate buffers. Not rt safe.
+     * @param factor The decimation factor, greater than 1
+     * @param buffer_size_in_frames The buffer size at the full rate
+     * @param num_chans Number of channels of the full rate buffers
+     * @param num_input_chans Number of channels decimated
+     * @param num_output_chans Number of channels interpolated
+     */
+    int init(int factor, int buffer_size_in_frames, int num_chans, int num_input_chans, int num_output_chans)
+    {
+        auto res = validate(factor, buffer_size_in_frames);
+        if (res != RASPA_SUCCESS)
+        {
+            return res;
+        }
+
+        _buffer_size_in_frames = buffer_size_in_frames;
+        _full_rate_in.assign(num_chans * buffer_size_in_frames, 0.0f);
+        _full_rate_out.assign(num_chans * buffer_size_in_frames, 0.0f);
+
+        _decimators.clear();
+        _interpolators.clear();
+        for (int i = 0; i < num_input_chans; i++)
+        {
+            _decimators.emplace_back(factor, buffer_size_in_frames);
+        }
+        for (int i = 0; i < num_output_chans; i++)
+        {
+            _interpolators.emplace_back(factor, buffer_size_in_frames);
+        }
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Decimate the full rate input buffer into the user input buffer.
+     * @param user_audio_in User buffer, with user_chan_stride between channels
+     */
+    void decimate(float* user_audio_in, int user_chan_stride)
+    {
+        for (size_t i = 0; i < _decimators.size(); i++)
+        {
+            _decimators[i].process(_full_rate_in.data() + i * _buffer_size_in_frames,
+                                   user_audio_in + i * user_chan_stride);
+        }
+    }
+
+    /**
+     * @brief Interpolate the user output buffer into the full rate output buffer.
+     * @param user_audio_out User buffer, with user_chan_stride between channels
+     */
+    void interpolate(const float* user_audio_out, int user_chan_stride)
+    {
+        for (size_t i = 0; i < _interpolators.size(); i++)
+        {
+            _interpolators[i].process(user_audio_out + i * user_chan_stride,
+                                      _full_rate_out.data() + i * _buffer_size_in_frames);
+        }
+    }
+
+    float* get_full_rate_input()
+    {
+        return _full_rate_in.data();
+    }
+
+    float* get_full_rate_output()
+    {
+        return _full_rate_out.data();
+    }
+
+    /**
+     * @brief Call function(address, size) on each allocation decimate() and
+     *        interpolate() touch, so that the targeted memory lock mode can
+     *        lock them.
+     */
+    template<typename Function>
+    void for_each_rt_region(Function function) const
+    {
+        function(_full_rate_in.data(), _full_rate_in.size() * sizeof(float));
+        function(_full_rate_out.data(), _full_rate_out.size() * sizeof(float));
+        function(_decimators.data(), _decimators.size() * sizeof(PolyphaseDecimator));
+        function(_interpolators.data(), _interpolators.size() * sizeof(PolyphaseInterpolator));
+        for (const auto& decimator : _decimators)
+        {
+            decimator.for_each_rt_region(function);
+        }
+        for (const auto& interpolator : _interpolators)
+        {
+            interpolator.for_each_rt_region(function);
+        }
+    }
+
+    /**
+     * @brief Get the delay added by a decimator and an interpolator in
+     *        series, i.e. the group delay of two prototype filters.
+     * @return The delay in frames at the full rate
+     */
+    static int get_delay_in_frames(int factor)
+    {
+        if (factor <= 1)
+        {
+            return 0;
+        }
+        return factor * RESAMPLER_TAPS_PER_PHASE - 1;
+    }
+
+private:
+    int _buffer_size_in_frames{0};
+    std::vector<float> _full_rate_in;
+    std::vector<float> _full_rate_out;
+    std::vector<PolyphaseDecimator> _decimators;
+    std::vector<PolyphaseInterpolator> _interpolators;
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_RESAMPLER_H
@@ -0,0 +1,428 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Implementation of RaspaRtSanitizer and the libc functions it
+ *        interposes. Defining them in the library linked into the application
+ *        makes the application and the shared libraries it uses call them
+ *        instead of the libc ones, which they forward to.
+ *
+ *        The allocator functions forward to the glibc __libc_* entry points,
+ *        since dlsym() itself may allocate. operator new and delete are
+ *        caught through malloc() and free(), which libstdc++ calls.
+ *        Calls glibc makes internally, e.g. write() from printf(), and
+ *        fortified variants such as __printf_chk() are not interposed.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#include "raspa_rt_sanitizer.h"
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t num, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace raspa {
+
+namespace {
+
+constexpr const char* CALL_NAMES[] = {"malloc", "free", "mutex", "sleep", "file io", "print"};
+
+static_assert(sizeof(CALL_NAMES) / sizeof(CALL_NAMES[0]) == static_cast<int>(RtSanitizerCall::NUM_CALLS),
+              "A name is needed for each kind of call");
+
+struct CallSite
+{
+    RtSanitizerCall call;
+    uint64_t hash;
+    int num_frames;
+    void* frames[RT_SANITIZER_MAX_FRAMES];
+    int64_t count;
+};
+
+// only written by the armed thread, read by print_report() once it stopped
+CallSite call_sites[RT_SANITIZER_MAX_SITES];
+int num_call_sites = 0;
+int64_t num_untracked_calls = 0;
+std::atomic<int64_t> call_counts[static_cast<int>(RtSanitizerCall::NUM_CALLS)];
+
+thread_local bool is_armed = false;
+thread_local bool is_recording = false;
+
+uint64_t hash_frames(void* const* frames, int num_frames)
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (int i = 0; i < num_frames; i++)
+    {
+        hash = (hash ^ reinterpret_cast<uintptr_t>(frames[i])) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Get the next definition of an interposed function, resolved once.
+ */
+template<typename T>
+T get_real(std::atomic<T>& function, const char* name)
+{
+    auto real = function.load(std::memory_order_acquire);
+    if (real == nullptr)
+    {
+        real = reinterpret_cast<T>(dlsym(RTLD_NEXT, name));
+        function.store(real, std::memory_order_release);
+    }
+    return real;
+}
+
+std::atomic<int (*)(pthread_mutex_t*)> real_pthread_mutex_lock{nullptr};
+std::atomic<int (*)(pthread_cond_t*, pthread_mutex_t*)> real_pthread_cond_wait{nullptr};
+std::atomic<int (*)(pthread_cond_t*, pthread_mutex_t*, const struct timespec*)> real_pthread_cond_timedwait{nullptr};
+std::atomic<int (*)(sem_t*)> real_sem_wait{nullptr};
+std::atomic<int (*)(const struct timespec*, struct timespec*)> real_nanosleep{nullptr};
+std::atomic<int (*)(useconds_t)> real_usleep{nullptr};
+std::atomic<unsigned int (*)(unsigned int)> real_sleep{nullptr};
+std::atomic<ssize_t (*)(int, void*, size_t)> real_read{nullptr};
+std::atomic<ssize_t (*)(int, const void*, size_t)> real_write{nullptr};
+std::atomic<int (*)(const char*, int, ...)> real_open{nullptr};
+std::atomic<int (*)(int)> real_close{nullptr};
+std::atomic<FILE* (*)(const char*, const char*)> real_fopen{nullptr};
+std::atomic<int (*)(FILE*)> real_fclose{nullptr};
+std::atomic<size_t (*)(const void*, size_t, size_t, FILE*)> real_fwrite{nullptr};
+std::atomic<int (*)(const char*)> real_puts{nullptr};
+
+}  // namespace
+
+void RaspaRtSanitizer::init()
+{
+    num_call_sites = 0;
+    num_untracked_calls = 0;
+    for (auto& count : call_counts)
+    {
+        count = 0;
+    }
+
+    // the first backtrace() loads libgcc, which allocates
+    void* frames[RT_SANITIZER_MAX_FRAMES];
+    backtrace(frames, RT_SANITIZER_MAX_FRAMES);
+
+    get_real(real_pthread_mutex_lock, "pthread_mutex_lock");
+    get_real(real_pthread_cond_wait, "pthread_cond_wait");
+    get_real(real_pthread_cond_timedwait, "pthread_cond_timedwait");
+    get_real(real_sem_wait, "sem_wait");
+    get_real(real_nanosleep, "nanosleep");
+    get_real(real_usleep, "usleep");
+    get_real(real_sleep, "sleep");
+    get_real(real_read, "read");
+    get_real(real_write, "write");
+    get_real(real_open, "open");
+    get_real(real_close, "close");
+    get_real(real_fopen, "fopen");
+    get_real(real_fclose, "fclose");
+    get_real(real_fwrite, "fwrite");
+    get_real(real_puts, "puts");
+}
+
+void RaspaRtSanitizer::arm()
+{
+    is_armed = true;
+}
+
+void RaspaRtSanitizer::disarm()
+{
+    is_armed = false;
+}
+
+void RaspaRtSanitizer::record(RtSanitizerCall call)
+{
+    if (!is_armed || is_recording)
+    {
+        return;
+    }
+    is_recording = true;
+
+    call_counts[static_cast<int>(call)].fetch_add(1, std::memory_order_relaxed);
+
+    void* frames[RT_SANITIZER_MAX_FRAMES];
+    int num_frames = backtrace(frames, RT_SANITIZER_MAX_FRAMES);
+    auto hash = hash_frames(frames, num_frames);
+
+    bool found = false;
+    for (int i = 0; i < num_call_sites && !found; i++)
+    {
+        if (call_sites[i].hash == hash && call_sites[i].call == call)
+        {
+            call_sites[i].count++;
+            found = true;
+        }
+    }
+    if (!found)
+    {
+        if (num_call_sites < RT_SANITIZER_MAX_SITES)
+        {
+            auto& site = call_sites[num_call_sites++];
+            site.call = call;
+            site.hash = hash;
+            site.num_frames = num_frames;
+            for (int i = 0; i < num_frames; i++)
+            {
+                site.frames[i] = frames[i];
+            }
+            site.count = 1;
+        }
+        else
+        {
+            num_untracked_calls++;
+        }
+    }
+
+    is_recording = false;
+}
+
+int64_t RaspaRtSanitizer::get_num_calls()
+{
+    int64_t num_calls = 0;
+    for (const auto& count : call_counts)
+    {
+        num_calls += count.load(std::memory_order_relaxed);
+    }
+    return num_calls;
+}
+
+void RaspaRtSanitizer::print_report()
+{
+    fprintf(stderr, "Raspa rt sanitizer report: %lld calls from the process callback\n",
+            static_cast<long long>(get_num_calls()));
+    for (int i = 0; i < static_cast<int>(RtSanitizerCall::NUM_CALLS); i++)
+    {
+        auto count = call_counts[i].load(std::memory_order_relaxed);
+        if (count > 0)
+        {
+            fprintf(stderr, "  %s: %lld\n", CALL_NAMES[i], static_cast<long long>(count));
+        }
+    }
+
+    for (int i = 0; i < num_call_sites; i++)
+    {
+        const auto& site = call_sites[i];
+        fprintf(stderr, "\n%s called %lld times from:\n", CALL_NAMES[static_cast<int>(site.call)],
+                static_cast<long long>(site.count));
+        fflush(stderr);
+        // does not allocate, the first frames are the sanitizer ones
+        backtrace_symbols_fd(site.frames, site.num_frames, STDERR_FILENO);
+    }
+    if (num_untracked_calls > 0)
+    {
+        fprintf(stderr, "\n%lld calls from other sites\n", static_cast<long long>(num_untracked_calls));
+    }
+}
+
+}  // namespace raspa
+
+using raspa::RaspaRtSanitizer;
+using raspa::RtSanitizerCall;
+
+extern "C" {
+
+void* malloc(size_t size)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::MALLOC);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t num, size_t size)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::MALLOC);
+    return __libc_calloc(num, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::MALLOC);
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::MALLOC);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::MALLOC);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::MALLOC);
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+    {
+        return EINVAL;
+    }
+    auto memory = __libc_memalign(alignment, size);
+    if (memory == nullptr)
+    {
+        return ENOMEM;
+    }
+    *ptr = memory;
+    return 0;
+}
+
+void free(void* ptr)
+{
+    if (ptr != nullptr)
+    {
+        RaspaRtSanitizer::record(RtSanitizerCall::FREE);
+    }
+    __libc_free(ptr);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::MUTEX);
+    return raspa::get_real(raspa::real_pthread_mutex_lock, "pthread_mutex_lock")(mutex);
+}
+
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::MUTEX);
+    return raspa::get_real(raspa::real_pthread_cond_wait, "pthread_cond_wait")(cond, mutex);
+}
+
+int pthread_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* abstime)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::MUTEX);
+    return raspa::get_real(raspa::real_pthread_cond_timedwait, "pthread_cond_timedwait")(cond, mutex, abstime);
+}
+
+int sem_wait(sem_t* sem)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::MUTEX);
+    return raspa::get_real(raspa::real_sem_wait, "sem_wait")(sem);
+}
+
+int nanosleep(const struct timespec* req, struct timespec* rem)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::SLEEP);
+    return raspa::get_real(raspa::real_nanosleep, "nanosleep")(req, rem);
+}
+
+int usleep(useconds_t usec)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::SLEEP);
+    return raspa::get_real(raspa::real_usleep, "usleep")(usec);
+}
+
+unsigned int sleep(unsigned int seconds)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::SLEEP);
+    return raspa::get_real(raspa::real_sleep, "sleep")(seconds);
+}
+
+ssize_t read(int fd, void* buf, size_t count)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::FILE_IO);
+    return raspa::get_real(raspa::real_read, "read")(fd, buf, count);
+}
+
+ssize_t write(int fd, const void* buf, size_t count)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::FILE_IO);
+    return raspa::get_real(raspa::real_write, "write")(fd, buf, count);
+}
+
+int open(const char* path, int flags, ...)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::FILE_IO);
+    mode_t mode = 0;
+    if (flags & (O_CREAT | O_TMPFILE))
+    {
+        va_list args;
+        va_start(args, flags);
+        mode = va_arg(args, mode_t);
+        va_end(args);
+    }
+    return raspa::get_real(raspa::real_open, "open")(path, flags, mode);
+}
+
+int close(int fd)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::FILE_IO);
+    return raspa::get_real(raspa::real_close, "close")(fd);
+}
+
+FILE* fopen(const char* path, const char* mode)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::FILE_IO);
+    return raspa::get_real(raspa::real_fopen, "fopen")(path, mode);
+}
+
+int fclose(FILE* stream)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::FILE_IO);
+    return raspa::get_real(raspa::real_fclose, "fclose")(stream);
+}
+
+size_t fwrite(const void* ptr, size_t size, size_t count, FILE* stream)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::FILE_IO);
+    return raspa::get_real(raspa::real_fwrite, "fwrite")(ptr, size, count, stream);
+}
+
+int printf(const char* format, ...)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::PRINT);
+    va_list args;
+    va_start(args, format);
+    auto res = vfprintf(stdout, format, args);
+    va_end(args);
+    return res;
+}
+
+int fprintf(FILE* stream, const char* format, ...)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::PRINT);
+    va_list args;
+    va_start(args, format);
+    auto res = vfprintf(stream, format, args);
+    va_end(args);
+    return res;
+}
+
+int puts(const char* str)
+{
+    RaspaRtSanitizer::record(RtSanitizerCall::PRINT);
+    return raspa::get_real(raspa::real_puts, "puts")(str);
+}
+
+}  // extern "C"
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class RaspaRtSanitizer, which reports the calls to the
+ *        allocator, to locks and to blocking libc functions made from the
+ *        process callback. Only available when raspa is built with
+ *        RASPA_WITH_RT_SANITIZER, the interposed functions are defined in
+ *        raspa_rt_sanitizer.cpp.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_RT_SANITIZER_H
+#define RASPA_RT_SANITIZER_H
+
+#include <cstdint>
+
+namespace raspa {
+
+// Number of distinct call sites recorded, further ones are only counted
+constexpr int RT_SANITIZER_MAX_SITES = 64;
+
+// Depth of the backtrace recorded for each call site
+constexpr int RT_SANITIZER_MAX_FRAMES = 16;
+
+/**
+ * @brief Kinds of calls caught by the sanitizer
+ */
+enum class RtSanitizerCall
+{
+    MALLOC,
+    FREE,
+    MUTEX,
+    SLEEP,
+    FILE_IO,
+    PRINT,
+    NUM_CALLS
+};
+
+/**
+ * @brief Internal class used by raspa for the RASPA_DEBUG_RT_SANITIZER debug
+ *        flag. The process callback is run between arm() and disarm(), and
+ *        the interposed functions call record() while armed on that thread.
+ *        The state is global, as the interposed functions are.
+ */
+class RaspaRtSanitizer
+{
+public:
+    /**
+     * @brief Resolve the interposed functions and clear the records. Called
+     *        from a non rt thread before the rt thread starts.
+     */
+    static void init();
+
+    /**
+     * @brief Start catching calls from the calling thread.
+     */
+    static void arm();
+
+    /**
+     * @brief Stop catching calls from the calling thread.
+     */
+    static void disarm();
+
+    /**
+     * @brief Count a call and record the backtrace of its call site, if the
+     *        calling thread is armed.
+     */
+    static void record(RtSanitizerCall call);
+
+    /**
+     * @brief Get the number of calls caught since init().
+     */
+    static int64_t get_num_calls();
+
+    /**
+     * @brief Print the calls caught, grouped by call site, to stderr. Called
+     *        once the rt thread has stopped.
+     */
+    static void print_report();
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_RT_SANITIZER_H
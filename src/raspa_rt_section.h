@@ -0,0 +1,103 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class RtSection, which lets a non rt thread wait until
+ *        the rt thread is out of a function before freeing or replacing the
+ *        state it reads.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_RT_SECTION_H
+#define RASPA_RT_SECTION_H
+
+#include <atomic>
+#include <thread>
+
+namespace raspa {
+
+/**
+ * @brief The rt side brackets its access to the shared state with enter() and
+ *        leave(), and skips it when enter() returns false. The non rt side
+ *        calls enable() once the state is ready, and disable() before
+ *        touching it again. disable() returns only once no rt thread is
+ *        between enter() and leave(), the rt side never waits.
+ */
+class RtSection
+{
+public:
+    RtSection() : _enabled(false),
+                  _num_users(0)
+    {}
+
+    /**
+     * @brief Let the rt side in. Not rt safe.
+     */
+    void enable()
+    {
+        _enabled = true;
+    }
+
+    /**
+     * @brief Keep the rt side out and wait until it has left. Not rt safe.
+     *        It is always safe to call this function.
+     */
+    void disable()
+    {
+        _enabled = false;
+        while (_num_users > 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * @brief Enter the section. Rt safe.
+     * @return true if entered, leave() must then be called, false if the
+     *         section is disabled.
+     */
+    bool enter()
+    {
+        // the user count must be visible before the flag is read, so that
+        // disable() either sees it or is seen
+        _num_users.fetch_add(1);
+        if (_enabled)
+        {
+            return true;
+        }
+        _num_users.fetch_sub(1);
+        return false;
+    }
+
+    /**
+     * @brief Leave the section. Rt safe.
+     */
+    void leave()
+    {
+        _num_users.fetch_sub(1, std::memory_order_release);
+    }
+
+    bool is_enabled() const
+    {
+        return _enabled;
+    }
+
+private:
+    std::atomic<bool> _enabled;
+    std::atomic<int> _num_users;
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_RT_SECTION_H
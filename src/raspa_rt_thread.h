@@ -0,0 +1,210 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Setup of the rt threads and access to the rt core, for EVL, Xenomai
+ *        Cobalt and PREEMPT_RT builds. Shared by raspa and misc/rt_probe, so
+ *        that the probe runs under the exact attributes of the raspa threads.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_RT_THREAD_H
+#define RASPA_RT_THREAD_H
+
+#include <sched.h>
+#include <sys/sysinfo.h>
+#include <pthread.h>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+
+#ifdef RASPA_WITH_EVL
+    #include <unistd.h>
+    #include <evl/evl.h>
+    #include <sys/ioctl.h>
+    #include <evl/syscall.h>
+    #include <evl/clock.h>
+    #include <evl/thread.h>
+#elif defined(RASPA_WITH_PREEMPT_RT)
+    #include <unistd.h>
+    #include <sys/ioctl.h>
+    #include <time.h>
+#else
+    #include <cobalt/pthread.h>
+    #include <cobalt/sys/ioctl.h>
+    #include <cobalt/time.h>
+    #include <rtdm/rtdm.h>
+    #include <xenomai/init.h>
+#endif
+
+#pragma GCC diagnostic pop
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef RASPA_WITH_EVL
+    #define __RASPA_IOCTL_RT(call)		oob_ ## call
+    #define __RASPA(call)		        call
+#elif defined(RASPA_WITH_PREEMPT_RT)
+    #define __RASPA_IOCTL_RT(call)		call
+    #define __RASPA(call)		        call
+#else
+    #define __RASPA_IOCTL_RT(call)		__cobalt_ ## call
+    #define __RASPA(call)		        __cobalt_ ## call
+#endif
+
+/*
+ * This variable is defined by xenomai init. It is used to index the number
+ * of command line arguments passed to xenomai. Since these arguments are passed
+ * manually, this variable is incremented in init_rt_core().
+ */
+extern int optind;
+
+namespace raspa {
+
+// manually passed "commandline args" to xenomai
+constexpr char XENOMAI_ARG_APP_NAME[] = "raspa";
+constexpr char XENOMAI_ARG_CPU_AFFINITY_DUAL_CORE[] = "--cpu-affinity=0,1";
+constexpr char XENOMAI_ARG_CPU_AFFINITY_QUAD_CORE[] = "--cpu-affinity=0,1,2,3";
+
+/**
+ * @brief Init the rt core library of the process, before any rt thread is
+ *        created. Nothing to do on PREEMPT_RT.
+ */
+inline void init_rt_core()
+{
+#if defined(RASPA_WITH_EVL)
+    evl_init();
+#elif !defined(RASPA_WITH_PREEMPT_RT)
+    /*
+     * Fake command line arguments to pass to xenomai_init(). For some
+     * obscure reasons, xenomai_init() crashes if argv is allocated here on
+     * the stack, so we alloc it beforehand.
+     */
+    int argc = 2;
+    auto argv = new char*[argc + 1];
+    for (int i = 0; i < argc; i++)
+    {
+        argv[i] = new char[32];
+    }
+    argv[argc] = nullptr;
+
+    std::snprintf(argv[0],
+                  sizeof(XENOMAI_ARG_APP_NAME),
+                  XENOMAI_ARG_APP_NAME);
+
+    // dual core
+    if (get_nprocs() == 2)
+    {
+        std::snprintf(argv[1],
+                      sizeof(XENOMAI_ARG_CPU_AFFINITY_DUAL_CORE),
+                      XENOMAI_ARG_CPU_AFFINITY_DUAL_CORE);
+    }
+    // quad core
+    else if (get_nprocs() == 4)
+    {
+        std::snprintf(argv[1],
+                      sizeof(XENOMAI_ARG_CPU_AFFINITY_QUAD_CORE),
+                      XENOMAI_ARG_CPU_AFFINITY_QUAD_CORE);
+    }
+
+    optind = 1;
+
+    xenomai_init(&argc, (char* const**) &argv);
+
+    for (int i = 0; i < argc; i++)
+    {
+        free(argv[i]);
+    }
+    free(argv);
+#endif
+}
+
+/**
+ * @brief Init the attributes of a raspa rt thread: joinable, SCHED_FIFO at
+ *        the given priority and pinned to one cpu.
+ * @param task_attributes The attributes, initialized here
+ * @param priority The SCHED_FIFO priority
+ * @param cpu The cpu the thread is pinned to, or -1 to not pin it
+ * @return 0 upon success, error of pthread_attr_setaffinity_np() otherwise.
+ */
+inline int init_rt_thread_attributes(pthread_attr_t* task_attributes, int priority, int cpu)
+{
+    struct sched_param rt_params = {
+                        .sched_priority = priority};
+    pthread_attr_init(task_attributes);
+    pthread_attr_setdetachstate(task_attributes, PTHREAD_CREATE_JOINABLE);
+    pthread_attr_setinheritsched(task_attributes, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(task_attributes, SCHED_FIFO);
+    pthread_attr_setschedparam(task_attributes, &rt_params);
+
+    if (cpu < 0)
+    {
+        return 0;
+    }
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    return pthread_attr_setaffinity_np(task_attributes, sizeof(cpu_set_t), &cpuset);
+}
+
+/**
+ * @brief Attach the calling thread to the rt core, on EVL only. The name is
+ *        suffixed with the pid to be unique in the system.
+ * @return The EVL thread id or 0 upon success, negative errno otherwise.
+ */
+#ifdef RASPA_WITH_EVL
+inline int attach_rt_thread(const char* name)
+{
+    return evl_attach_self("/%s:%d", name, getpid());
+}
+#else
+inline int attach_rt_thread(const char* /*name*/)
+{
+    return 0;
+}
+#endif
+
+/**
+ * @brief Read the monotonic clock of the rt core.
+ */
+inline int64_t get_rt_time_ns()
+{
+    struct timespec tp;
+#ifdef RASPA_WITH_EVL
+    evl_read_clock(EVL_CLOCK_MONOTONIC, &tp);
+#else
+    __RASPA(clock_gettime(CLOCK_MONOTONIC, &tp));
+#endif
+    return static_cast<int64_t>(tp.tv_sec) * 1000000000 + tp.tv_nsec;
+}
+
+/**
+ * @brief Sleep until an absolute time of get_rt_time_ns().
+ */
+inline void sleep_rt_until_ns(int64_t time_ns)
+{
+    struct timespec ts = {static_cast<time_t>(time_ns / 1000000000),
+                          static_cast<long>(time_ns % 1000000000)};
+#ifdef RASPA_WITH_EVL
+    evl_sleep_until(EVL_CLOCK_MONOTONIC, &ts);
+#else
+    __RASPA(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr));
+#endif
+}
+
+}  // namespace raspa
+
+#endif  // RASPA_RT_THREAD_H
@@ -33,6 +33,7 @@
 #include "driver_config.h"
 #include "raspa/raspa.h"
 #include "raspa_error_codes.h"
+#include "raspa_spsc_ring.h"
 
 namespace raspa {
 
@@ -43,6 +44,20 @@ constexpr int PERIOD_LOGGER_BUFFER_SIZE = 0x1 << PERIOD_LOGGER_BUFFER_SIZE_BITS;
 // run logger writer thread sleep period (should be small enough depending on buffer size, sample rate and system speed)
 constexpr std::chrono::milliseconds PERIOD_LOGGER_WRITER_SLEEP(500);
 
+// the processing graph node records are written more often, as the rt thread
+// pushes one per node every period
+constexpr std::chrono::milliseconds GRAPH_LOGGER_WRITER_SLEEP(5);
+constexpr int GRAPH_LOGGER_WRITES_PER_PERIOD_WRITE = PERIOD_LOGGER_WRITER_SLEEP / GRAPH_LOGGER_WRITER_SLEEP;
+
+// periods in two graph writer sleeps at 8 frames and 96 kHz, the shortest period
+constexpr size_t GRAPH_LOGGER_MAX_PERIODS = 2 * 96000 / 8 * GRAPH_LOGGER_WRITER_SLEEP.count() / 1000;
+
+// number of processing graph node records buffered between two writes
+constexpr size_t GRAPH_LOGGER_RING_SIZE = RASPA_GRAPH_MAX_NODES * GRAPH_LOGGER_MAX_PERIODS;
+
+// the processing graph node records go to a file next to the run log, with this suffix
+constexpr char GRAPH_LOGGER_FILE_SUFFIX[] = ".graph";
+
 /**
  * @brief Internal class used by raspa to log the run period data to file.
  */
@@ -70,6 +85,9 @@ public:
             return -RASPA_ERUNLOG_FILE_OPEN;
         }
 
+        _graph_log_file_name = file_name + GRAPH_LOGGER_FILE_SUFFIX;
+        _graph_overrun = false;
+
         _write_count = 0;
         _read_count = 0;
         _overrun = false;
@@ -97,6 +115,16 @@ public:
             }
         }
 
+        int res = RASPA_SUCCESS;
+        if (_graph_log_stream.is_open())
+        {
+            _graph_log_stream.close();
+            if (_graph_log_stream.fail())
+            {
+                res = -RASPA_ERUNLOG_FILE_CLOSE;
+            }
+        }
+
         if (_log_stream.is_open())
         {
             _log_stream.close();
@@ -106,7 +134,7 @@ public:
             }
         }
 
-        return RASPA_SUCCESS;
+        return res;
     }
 
     /**
@@ -135,21 +163,73 @@ public:
         }
     }
 
+    /**
+     * @brief Put the timing of a processing graph node in the last period.
+     *        The records are written to the run log file name followed by
+     *        GRAPH_LOGGER_FILE_SUFFIX, created on the first record. Records
+     *        lost to a full ring are replaced by one with node -1 and the
+     *        period of the first record pushed after them.
+     */
+    void put_graph_node(int64_t period, int node, int worker, int64_t start_ns, int64_t end_ns)
+    {
+        if (_is_running)
+        {
+            if (_graph_overrun)
+            {
+                if (!_graph_ring.push({period, -1, 0, 0, 0}))
+                {
+                    return;
+                }
+                _graph_overrun = false;
+            }
+            if (!_graph_ring.push({period, node, worker, start_ns, end_ns}))
+            {
+                _graph_overrun = true;
+            }
+        }
+    }
+
 private:
 
     void _run()
     {
+        int num_graph_writes = 0;
         while (_is_running)
         {
-            std::this_thread::sleep_for(PERIOD_LOGGER_WRITER_SLEEP);
-            _write_buffer_to_file(false);
+            std::this_thread::sleep_for(GRAPH_LOGGER_WRITER_SLEEP);
+            _write_graph_records_to_file();
+            if (++num_graph_writes == GRAPH_LOGGER_WRITES_PER_PERIOD_WRITE)
+            {
+                _write_buffer_to_file(false);
+                num_graph_writes = 0;
+            }
         }
 
         // write last buffer in case there is any more data pending
         _write_buffer_to_file(true);
+        _write_graph_records_to_file();
         pthread_exit(nullptr);
     }
 
+    void _write_graph_records_to_file()
+    {
+        graph_log_item items[256];
+        size_t count;
+        while ((count = _graph_ring.pop(items, 256)) > 0)
+        {
+            if (!_graph_log_stream.is_open())
+            {
+                _graph_log_stream.open(_graph_log_file_name.c_str(), std::ofstream::binary | std::ofstream::out);
+            }
+            _graph_log_stream.write(reinterpret_cast<char*>(items), count * sizeof(graph_log_item));
+            if (!_graph_log_stream)
+            {
+                fprintf(stderr, "Logger file write error\n");
+                break;
+            }
+        }
+    }
+
     void _write_buffer_to_file(bool flush)
     {
         auto threshold = flush ? 1 : PERIOD_LOGGER_BUFFER_SIZE;
@@ -203,6 +283,21 @@ private:
     std::atomic<int> _write_count;
     std::atomic<int> _read_count;
     std::atomic<bool> _overrun;
+
+    struct graph_log_item
+    {
+        int64_t period;
+        int32_t node;
+        int32_t worker;
+        int64_t start_ns;
+        int64_t end_ns;
+    };
+    std::string _graph_log_file_name;
+    std::ofstream _graph_log_stream;
+    SpscRing<graph_log_item, GRAPH_LOGGER_RING_SIZE> _graph_ring;
+
+    // only accessed by the rt thread once started
+    bool _graph_overrun;
 };
 
 }  // namespace raspa
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Helpers to run the rt thread under SCHED_DEADLINE on PREEMPT_RT
+ *        kernels, with a reservation derived from the buffer period.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_SCHED_DEADLINE_H
+#define RASPA_SCHED_DEADLINE_H
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+
+namespace raspa {
+
+// policy value of the kernel, not exported by all libc versions
+constexpr uint32_t SCHED_DEADLINE_POLICY = 6;
+
+// the kernel rejects reservations with a shorter runtime
+constexpr uint64_t SCHED_DEADLINE_MIN_RUNTIME_NS = 1024;
+
+struct SchedDeadlineParams
+{
+    uint64_t runtime_ns;
+    uint64_t deadline_ns;
+    uint64_t period_ns;
+};
+
+/**
+ * @brief struct sched_attr of the kernel, glibc only wraps sched_setattr()
+ *        from version 2.41.
+ */
+struct RaspaSchedAttr
+{
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
+
+/**
+ * @brief Check a runtime fraction given to raspa_set_deadline_reservation().
+ * @return True if the fraction is in (0, 1].
+ */
+inline bool is_valid_runtime_fraction(float runtime_fraction)
+{
+    return runtime_fraction > 0.0f && runtime_fraction <= 1.0f;
+}
+
+/**
+ * @brief Get the reservation of one buffer period. The deadline is the end of
+ *        the period, as the driver expects the buffers back by the next
+ *        interrupt.
+ * @param runtime_fraction Share of the period reserved to the thread, in (0, 1]
+ * @param period_ns The buffer period
+ */
+inline SchedDeadlineParams get_sched_deadline_params(float runtime_fraction, uint64_t period_ns)
+{
+    auto runtime_ns = static_cast<uint64_t>(static_cast<double>(period_ns) * runtime_fraction);
+    runtime_ns = std::min(std::max(runtime_ns, SCHED_DEADLINE_MIN_RUNTIME_NS), period_ns);
+    return {runtime_ns, period_ns, period_ns};
+}
+
+/**
+ * @brief Move the calling thread to SCHED_DEADLINE. Fails with EPERM if the
+ *        affinity of the thread does not span its whole root domain, so the
+ *        thread should not be pinned unless its cpu is an exclusive cpuset
+ *        partition, and with EBUSY if the reservation does not pass the
+ *        admission test of the kernel.
+ * @return 0 upon success, errno of the sched_setattr() call otherwise.
+ */
+inline int set_thread_sched_deadline(const SchedDeadlineParams& params)
+{
+    RaspaSchedAttr attr = {};
+    attr.size = sizeof(attr);
+    attr.sched_policy = SCHED_DEADLINE_POLICY;
+    attr.sched_runtime = params.runtime_ns;
+    attr.sched_deadline = params.deadline_ns;
+    attr.sched_period = params.period_ns;
+
+    if (syscall(SYS_sched_setattr, 0, &attr, 0) < 0)
+    {
+        return errno;
+    }
+    return 0;
+}
+
+}  // namespace raspa
+
+#endif  // RASPA_SCHED_DEADLINE_H
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class RaspaServoTrace, which records the timing error
+ *        reported by the micro-controller and the correction applied by the
+ *        delay error filter on every period of a sync platform, for offline
+ *        tuning of the filter with misc/servo_tuner.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_SERVO_TRACE_H
+#define RASPA_SERVO_TRACE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "raspa_error_codes.h"
+#include "raspa_trace_writer.h"
+
+namespace raspa {
+
+// number of periods buffered between two writes
+constexpr size_t SERVO_TRACE_RING_SIZE = 8192;
+
+/**
+ * Servo trace file format: a ServoTraceHeader followed by one ServoTraceRecord
+ * per period, from the first period of the session. A record with period -1
+ * marks records lost because the writer thread fell behind. All the fields
+ * are in the native byte order of the target.
+ */
+constexpr char SERVO_TRACE_MAGIC[8] = {'R', 'A', 'S', 'P', 'A', 'S', 'V', 'T'};
+constexpr uint32_t SERVO_TRACE_VERSION = 1;
+
+struct ServoTraceHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t sample_rate;
+    uint32_t buffer_size_in_frames;
+    uint32_t settling_periods;          // periods run before the callback is started
+    uint32_t downsample_rate;           // a correction is applied every this many periods
+    uint32_t t60_in_periods;            // setting of the delay error filter
+};
+
+struct ServoTraceRecord
+{
+    int64_t period;             // value of the interrupt counter
+    int32_t timing_error_ns;    // as reported by the micro-controller
+    int32_t correction_ns;      // as given to the driver, 0 between downsampled periods
+};
+
+/**
+ * @brief Internal class used by raspa to record the servo trace. The rt
+ *        thread only pushes records to a lock-free ring, a writer thread
+ *        moves them to file.
+ */
+class RaspaServoTrace : public RaspaTraceWriter<ServoTraceHeader, ServoTraceRecord, SERVO_TRACE_RING_SIZE>
+{
+public:
+    RaspaServoTrace() : RaspaTraceWriter(RASPA_ESERVO_TRACE_FILE_OPEN, RASPA_ESERVO_TRACE_FILE_CLOSE)
+    {}
+
+    /**
+     * @brief Write the header and start the writer thread.
+     * @param file_name The file the trace is written to
+     * @param header The header, magic and version are filled in here
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise.
+     */
+    int start(const std::string& file_name, ServoTraceHeader header)
+    {
+        std::memcpy(header.magic, SERVO_TRACE_MAGIC, sizeof(header.magic));
+        header.version = SERVO_TRACE_VERSION;
+        return RaspaTraceWriter::start(file_name, header);
+    }
+
+    /**
+     * @brief Record one period. Rt safe.
+     */
+    void put(int64_t period, int32_t timing_error_ns, int32_t correction_ns)
+    {
+        RaspaTraceWriter::put({period, timing_error_ns, correction_ns});
+    }
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_SERVO_TRACE_H
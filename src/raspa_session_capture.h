@@ -0,0 +1,290 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class RaspaSessionCapture, which records the raw driver
+ *        data of every period to file so that a session can be replayed
+ *        offline, and of the capture file format.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_SESSION_CAPTURE_H
+#define RASPA_SESSION_CAPTURE_H
+
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "driver_config.h"
+#include "raspa/raspa.h"
+#include "raspa_error_codes.h"
+
+namespace raspa {
+
+/**
+ * Capture file format. The file starts with a SessionCaptureHeader, followed
+ * by num_driver_input_chans and num_driver_output_chans driver_conf::ChannelInfo
+ * entries. Then one record per period follows, each record_size_in_bytes
+ * long, made of:
+ *  - a SessionCapturePeriod
+ *  - the raw input DMA block, driver_buffer_size_in_samples words
+ *  - the rx audio control packet, ctrl_pkt_size_in_words words (0 on
+ *    PlatformType::NATIVE)
+ * All the fields are in the native byte order of the target.
+ */
+constexpr char SESSION_CAPTURE_MAGIC[8] = {'R', 'A', 'S', 'P', 'A', 'C', 'A', 'P'};
+constexpr uint32_t SESSION_CAPTURE_VERSION = 1;
+
+struct SessionCaptureHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t sample_rate;
+    uint32_t buffer_size_in_frames;
+    uint32_t platform_type;
+    uint32_t num_driver_input_chans;
+    uint32_t num_driver_output_chans;
+    uint32_t num_input_chans;           // including virtual usb channels
+    uint32_t num_output_chans;          // including virtual usb channels
+    uint32_t driver_buffer_size_in_samples;
+    uint32_t ctrl_pkt_size_in_words;
+    uint32_t record_size_in_bytes;
+    uint32_t reserved;
+};
+
+struct SessionCapturePeriod
+{
+    int64_t period_count;       // value of the interrupt counter
+    int64_t irq_time_us;        // wake up time of the rt thread after the irq
+    int32_t buf_idx;            // driver buffer index of the period
+    uint32_t gate_in;           // cv gate in values
+};
+
+// Capture ring buffer size. The number of records is the largest power of
+// two fitting in it.
+constexpr size_t SESSION_CAPTURE_RING_SIZE_BYTES = 8 * 1024 * 1024;
+constexpr size_t SESSION_CAPTURE_MIN_RECORDS = 64;
+
+// Writer thread sleep period, should be small enough for the ring to not fill
+// up in between.
+constexpr std::chrono::milliseconds SESSION_CAPTURE_WRITER_SLEEP(50);
+
+/**
+ * @brief Internal class used by raspa to capture the raw driver data of every
+ *        period to file. The rt thread copies the data of each period into a
+ *        preallocated lock-free ring of fixed size records, a non rt writer
+ *        thread streams the ring to the capture file.
+ */
+class RaspaSessionCapture
+{
+public:
+    RaspaSessionCapture() : _is_running(false),
+                            _record_size(0),
+                            _num_records(0),
+                            _input_size_in_samples(0),
+                            _pkt_size_in_words(0),
+                            _write_count(0),
+                            _read_count(0),
+                            _dropped_periods(0)
+    {}
+
+    ~RaspaSessionCapture()
+    {
+        terminate();
+    }
+
+    /**
+     * @brief Start the capture. Writes the file header, allocates the ring
+     *        buffer and creates the writer thread.
+     *
+     * @param file_name Path of the capture file
+     * @param header Header with the session configuration. record_size_in_bytes
+     *        is filled in by this function.
+     * @param input_chan_info Driver info of the input channels
+     * @param output_chan_info Driver info of the output channels
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise.
+     */
+    int start(const std::string& file_name,
+              SessionCaptureHeader header,
+              const std::vector<driver_conf::ChannelInfo>& input_chan_info,
+              const std::vector<driver_conf::ChannelInfo>& output_chan_info)
+    {
+        _input_size_in_samples = header.driver_buffer_size_in_samples;
+        _pkt_size_in_words = header.ctrl_pkt_size_in_words;
+        _record_size = sizeof(SessionCapturePeriod) +
+                       (_input_size_in_samples + _pkt_size_in_words) * sizeof(int32_t);
+
+        _num_records = SESSION_CAPTURE_MIN_RECORDS;
+        while (_num_records * 2 * _record_size <= SESSION_CAPTURE_RING_SIZE_BYTES)
+        {
+            _num_records *= 2;
+        }
+        _ring = std::make_unique<uint8_t[]>(_num_records * _record_size);
+
+        _capture_stream.open(file_name.c_str(), std::ofstream::binary | std::ofstream::out);
+        if (_capture_stream.fail())
+        {
+            return -RASPA_ECAPTURE_FILE_OPEN;
+        }
+
+        std::memcpy(header.magic, SESSION_CAPTURE_MAGIC, sizeof(header.magic));
+        header.version = SESSION_CAPTURE_VERSION;
+        header.record_size_in_bytes = _record_size;
+        _capture_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        _capture_stream.write(reinterpret_cast<const char*>(input_chan_info.data()),
+                              input_chan_info.size() * sizeof(driver_conf::ChannelInfo));
+        _capture_stream.write(reinterpret_cast<const char*>(output_chan_info.data()),
+                              output_chan_info.size() * sizeof(driver_conf::ChannelInfo));
+
+        _write_count = 0;
+        _read_count = 0;
+        _dropped_periods = 0;
+        _is_running = true;
+        _thread = std::thread(&RaspaSessionCapture::_run, this);
+
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Stop the writer thread after flushing the pending records and
+     *        close the capture file. It is always safe to call this function.
+     *
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise.
+     */
+    int terminate()
+    {
+        if (_is_running)
+        {
+            _is_running = false;
+            if (_thread.joinable())
+            {
+                _thread.join();
+            }
+        }
+
+        if (_capture_stream.is_open())
+        {
+            _capture_stream.close();
+            if (_capture_stream.fail())
+            {
+                return -RASPA_ECAPTURE_FILE_CLOSE;
+            }
+        }
+
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Copy the data of one period into the capture ring. Called from
+     *        the rt thread, does not block. If the ring is full the period is
+     *        dropped, which shows as a gap in period_count in the file.
+     *
+     * @param period Period info
+     * @param input The raw input DMA block of the period
+     * @param rx_pkt The rx audio control packet, ignored if the capture has
+     *        no control packets
+     */
+    void put(const SessionCapturePeriod& period, const int32_t* input, const void* rx_pkt)
+    {
+        auto write_count = _write_count.load(std::memory_order_relaxed);
+        if (write_count - _read_count.load(std::memory_order_acquire) >= _num_records)
+        {
+            _dropped_periods.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        auto record = &_ring[(write_count & (_num_records - 1)) * _record_size];
+        std::memcpy(record, &period, sizeof(period));
+        record += sizeof(period);
+        std::memcpy(record, input, _input_size_in_samples * sizeof(int32_t));
+        if (_pkt_size_in_words > 0)
+        {
+            record += _input_size_in_samples * sizeof(int32_t);
+            std::memcpy(record, rx_pkt, _pkt_size_in_words * sizeof(int32_t));
+        }
+
+        _write_count.store(write_count + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Get the number of periods that were not captured because the
+     *        writer thread did not keep up.
+     */
+    uint64_t get_dropped_periods() const
+    {
+        return _dropped_periods;
+    }
+
+private:
+    void _run()
+    {
+        while (_is_running)
+        {
+            std::this_thread::sleep_for(SESSION_CAPTURE_WRITER_SLEEP);
+            _write_ring_to_file();
+        }
+
+        // write any pending record
+        _write_ring_to_file();
+    }
+
+    void _write_ring_to_file()
+    {
+        auto read_count = _read_count.load(std::memory_order_relaxed);
+        auto count = _write_count.load(std::memory_order_acquire) - read_count;
+
+        while (count > 0)
+        {
+            // write contiguous chunks, up to the end of the ring
+            auto index = read_count & (_num_records - 1);
+            auto chunk = std::min<uint64_t>(count, _num_records - index);
+
+            _capture_stream.write(reinterpret_cast<const char*>(&_ring[index * _record_size]),
+                                  chunk * _record_size);
+            if (!_capture_stream)
+            {
+                fprintf(stderr, "Session capture file write error\n");
+            }
+
+            read_count += chunk;
+            count -= chunk;
+            _read_count.store(read_count, std::memory_order_release);
+        }
+    }
+
+    std::atomic<bool> _is_running;
+    std::thread _thread;
+    std::ofstream _capture_stream;
+
+    std::unique_ptr<uint8_t[]> _ring;
+    size_t _record_size;
+    uint64_t _num_records;
+    size_t _input_size_in_samples;
+    size_t _pkt_size_in_words;
+
+    std::atomic<uint64_t> _write_count;
+    std::atomic<uint64_t> _read_count;
+    std::atomic<uint64_t> _dropped_periods;
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_SESSION_CAPTURE_H
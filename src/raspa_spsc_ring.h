@@ -0,0 +1,216 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class SpscRing, a wait free single producer / single
+ *        consumer ring buffer used for the queues between the real time and
+ *        the non real time threads.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_SPSC_RING_H
+#define RASPA_SPSC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace raspa {
+
+// Size of the cache line the producer and consumer indices are padded to
+constexpr size_t SPSC_RING_CACHE_LINE_SIZE = 64;
+
+/**
+ * @brief Returns the smallest power of two greater or equal to value.
+ */
+constexpr size_t next_power_of_two(size_t value)
+{
+    size_t power = 1;
+    while (power < value)
+    {
+        power <<= 1;
+    }
+    return power;
+}
+
+/**
+ * @brief Wait free single producer / single consumer ring buffer.
+ *
+ *        The capacity is rounded up to a power of two, so that indices wrap
+ *        with a mask. Indices are free running counters, so all the slots
+ *        are usable. The producer and consumer indices live on separate cache
+ *        lines, and each side keeps a cached copy of the opposite index which
+ *        is only refreshed when the ring looks full (producer) or empty
+ *        (consumer). Batch operations publish several elements with a single
+ *        release store.
+ *
+ * @tparam T The element type, must be trivially copyable
+ * @tparam MinSize The minimum number of elements the ring can hold
+ */
+template<typename T, size_t MinSize>
+class SpscRing
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRing elements must be trivially copyable");
+    static_assert(MinSize > 0, "SpscRing size must be greater than 0");
+
+public:
+    static constexpr size_t CAPACITY = next_power_of_two(MinSize);
+
+    SpscRing() : _write_index(0),
+                 _cached_read_index(0),
+                 _read_index(0),
+                 _cached_write_index(0),
+                 _buffer{}
+    {}
+
+    // Producer side
+
+    /**
+     * @brief Push one element. Producer side only.
+     *
+     * @param item The element to push
+     * @return true upon success, false if the ring is full.
+     */
+    bool push(const T& item)
+    {
+        auto write_index = _write_index.load(std::memory_order_relaxed);
+        if (write_index - _cached_read_index == CAPACITY)
+        {
+            _cached_read_index = _read_index.load(std::memory_order_acquire);
+            if (write_index - _cached_read_index == CAPACITY)
+            {
+                return false;
+            }
+        }
+
+        _buffer[write_index & MASK] = item;
+        _write_index.store(write_index + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Push up to num elements. Producer side only.
+     *
+     * @param items Array of elements to push
+     * @param num The number of elements in items
+     * @return The number of elements pushed, less than num if the ring filled up.
+     */
+    size_t push(const T* items, size_t num)
+    {
+        auto write_index = _write_index.load(std::memory_order_relaxed);
+        if (CAPACITY - (write_index - _cached_read_index) < num)
+        {
+            _cached_read_index = _read_index.load(std::memory_order_acquire);
+        }
+
+        auto count = std::min(num, CAPACITY - (write_index - _cached_read_index));
+        for (size_t i = 0; i < count; i++)
+        {
+            _buffer[(write_index + i) & MASK] = items[i];
+        }
+
+        if (count > 0)
+        {
+            _write_index.store(write_index + count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    // Consumer side
+
+    /**
+     * @brief Pop one element. Consumer side only.
+     *
+     * @param item Where the popped element is stored
+     * @return true upon success, false if the ring is empty.
+     */
+    bool pop(T& item)
+    {
+        auto read_index = _read_index.load(std::memory_order_relaxed);
+        if (read_index == _cached_write_index)
+        {
+            _cached_write_index = _write_index.load(std::memory_order_acquire);
+            if (read_index == _cached_write_index)
+            {
+                return false;
+            }
+        }
+
+        item = _buffer[read_index & MASK];
+        _read_index.store(read_index + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Pop up to max_num elements. Consumer side only.
+     *
+     * @param items Array where the popped elements are stored
+     * @param max_num The maximum number of elements to pop
+     * @return The number of elements popped.
+     */
+    size_t pop(T* items, size_t max_num)
+    {
+        auto read_index = _read_index.load(std::memory_order_relaxed);
+        if (_cached_write_index - read_index < max_num)
+        {
+            _cached_write_index = _write_index.load(std::memory_order_acquire);
+        }
+
+        auto count = std::min(max_num, _cached_write_index - read_index);
+        for (size_t i = 0; i < count; i++)
+        {
+            items[i] = _buffer[(read_index + i) & MASK];
+        }
+
+        if (count > 0)
+        {
+            _read_index.store(read_index + count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    /**
+     * @brief Check if the ring is empty. Consumer side only, the result can
+     *        be outdated as soon as it is returned if the producer is active.
+     *
+     * @return true if there is no element to pop.
+     */
+    bool was_empty()
+    {
+        auto read_index = _read_index.load(std::memory_order_relaxed);
+        if (read_index == _cached_write_index)
+        {
+            _cached_write_index = _write_index.load(std::memory_order_acquire);
+        }
+        return read_index == _cached_write_index;
+    }
+
+private:
+    static constexpr size_t MASK = CAPACITY - 1;
+
+    // producer owned
+    alignas(SPSC_RING_CACHE_LINE_SIZE) std::atomic<size_t> _write_index;
+    size_t _cached_read_index;
+
+    // consumer owned
+    alignas(SPSC_RING_CACHE_LINE_SIZE) std::atomic<size_t> _read_index;
+    size_t _cached_write_index;
+
+    alignas(SPSC_RING_CACHE_LINE_SIZE) T _buffer[CAPACITY];
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_SPSC_RING_H
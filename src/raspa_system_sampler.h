@@ -0,0 +1,299 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class RaspaSystemSampler, which periodically samples
+ *        the system state around the rt thread from a non rt thread, so that
+ *        spikes in the run log can be correlated with page faults, cpu
+ *        frequency changes, thermal throttling and interrupts.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_SYSTEM_SAMPLER_H
+#define RASPA_SYSTEM_SAMPLER_H
+
+#include <time.h>
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "raspa/raspa.h"
+#include "raspa_error_codes.h"
+
+namespace raspa {
+
+// interval between two samples of the system state
+constexpr std::chrono::milliseconds SYSTEM_SAMPLER_PERIOD(10);
+
+// the samples go to a file next to the run log, with this suffix
+constexpr char SYSTEM_SAMPLER_FILE_SUFFIX[] = ".sys";
+
+// thermal zone read for the temperature
+constexpr char SYSTEM_SAMPLER_THERMAL_ZONE[] = "/sys/class/thermal/thermal_zone0/temp";
+
+/**
+ * @brief One sample of the system state, as written to file. Counters are
+ *        cumulative, fields which could not be read are -1.
+ */
+struct SystemSample
+{
+    RaspaMicroSec time;         // CLOCK_MONOTONIC, same time base as the run log
+    int64_t rt_minor_faults;    // minor page faults of the rt thread
+    int64_t rt_major_faults;    // major page faults of the rt thread
+    int64_t cpu_interrupts;     // interrupts served by the rt cpu, all sources
+    int32_t cpu_freq_khz;       // current frequency of the rt cpu
+    int32_t temperature_mc;     // temperature in millidegrees celsius
+    int64_t throttle_count;     // thermal throttling events of the rt cpu
+};
+
+/**
+ * @brief Internal class used by raspa to sample the system state while the
+ *        run log is enabled. The rt thread only stores its thread id once,
+ *        everything else is read by the sampler thread.
+ */
+class RaspaSystemSampler
+{
+public:
+    RaspaSystemSampler() : _is_running(false),
+                           _rt_thread_id(0),
+                           _cpu(0)
+    {}
+
+    ~RaspaSystemSampler()
+    {
+        terminate();
+    }
+
+    /**
+     * @brief Start the sampler thread.
+     * @param file_name The file the samples are written to
+     * @param cpu The cpu the rt thread runs on
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise.
+     */
+    int start(const std::string& file_name, int cpu)
+    {
+        _stream.open(file_name.c_str(), std::ofstream::binary | std::ofstream::out);
+        if (_stream.fail())
+        {
+            return -RASPA_ERUNLOG_FILE_OPEN;
+        }
+
+        _cpu = cpu;
+        _cpu_path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        _is_running = true;
+        _thread = std::thread(&RaspaSystemSampler::_run, this);
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Stop the sampler thread and close the file. It is always safe to
+     *        call this function.
+     * @return RASPA_SUCCESS upon success, different raspa error code otherwise.
+     */
+    int terminate()
+    {
+        if (_is_running)
+        {
+            _is_running = false;
+            if (_thread.joinable())
+            {
+                _thread.join();
+            }
+        }
+
+        if (_stream.is_open())
+        {
+            _stream.close();
+            if (_stream.fail())
+            {
+                return -RASPA_ERUNLOG_FILE_CLOSE;
+            }
+        }
+        _rt_thread_id = 0;
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Called once by the rt thread, before it enters the rt domain.
+     * @param thread_id The linux thread id of the rt thread
+     */
+    void set_rt_thread_id(int thread_id)
+    {
+        _rt_thread_id = thread_id;
+    }
+
+    /**
+     * @brief Get the page fault counters from the content of /proc/<pid>/task/<tid>/stat
+     * @return true if the counters were found
+     */
+    static bool parse_task_stat(const std::string& stat, int64_t& minor_faults, int64_t& major_faults)
+    {
+        // the thread name can contain spaces and parentheses, fields start after the last one
+        auto name_end = stat.rfind(')');
+        if (name_end == std::string::npos)
+        {
+            return false;
+        }
+
+        // state is field 3, minflt field 10 and majflt field 12
+        std::istringstream fields(stat.substr(name_end + 1));
+        std::string field;
+        for (int i = 3; i <= 12 && fields >> field; i++)
+        {
+            if (i == 10)
+            {
+                minor_faults = std::atoll(field.c_str());
+            }
+            else if (i == 12)
+            {
+                major_faults = std::atoll(field.c_str());
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Sum the interrupts served by a cpu, from the content of /proc/interrupts
+     * @return The number of interrupts, -1 if the cpu is not listed
+     */
+    static int64_t parse_interrupts(const std::string& interrupts, int cpu)
+    {
+        std::istringstream lines(interrupts);
+        std::string line;
+        if (!std::getline(lines, line))
+        {
+            return -1;
+        }
+
+        // the header lists the online cpus, which can have gaps
+        std::istringstream header(line);
+        std::string name;
+        int column = -1;
+        int num_columns = 0;
+        for (; header >> name; num_columns++)
+        {
+            if (name == "CPU" + std::to_string(cpu))
+            {
+                column = num_columns;
+            }
+        }
+        if (column < 0)
+        {
+            return -1;
+        }
+
+        int64_t total = 0;
+        while (std::getline(lines, line))
+        {
+            std::istringstream fields(line);
+            std::string source;
+            fields >> source;
+
+            // rows like ERR: have a single count, not one per cpu, and are skipped
+            std::string count;
+            int64_t cpu_count = 0;
+            int i = 0;
+            for (; i < num_columns && fields >> count && std::isdigit(static_cast<unsigned char>(count[0])); i++)
+            {
+                if (i == column)
+                {
+                    cpu_count = std::atoll(count.c_str());
+                }
+            }
+            if (i == num_columns)
+            {
+                total += cpu_count;
+            }
+        }
+        return total;
+    }
+
+private:
+    void _run()
+    {
+        while (_is_running)
+        {
+            SystemSample sample;
+            _take_sample(sample);
+            _stream.write(reinterpret_cast<char*>(&sample), sizeof(sample));
+            if (!_stream)
+            {
+                fprintf(stderr, "System sampler file write error\n");
+                break;
+            }
+            std::this_thread::sleep_for(SYSTEM_SAMPLER_PERIOD);
+        }
+    }
+
+    void _take_sample(SystemSample& sample)
+    {
+        struct timespec tp;
+        clock_gettime(CLOCK_MONOTONIC, &tp);
+        sample.time = static_cast<RaspaMicroSec>(tp.tv_sec) * 1000000 + tp.tv_nsec / 1000;
+
+        sample.rt_minor_faults = -1;
+        sample.rt_major_faults = -1;
+        int thread_id = _rt_thread_id;
+        if (thread_id > 0)
+        {
+            parse_task_stat(_read_file("/proc/self/task/" + std::to_string(thread_id) + "/stat"),
+                            sample.rt_minor_faults,
+                            sample.rt_major_faults);
+        }
+
+        sample.cpu_interrupts = parse_interrupts(_read_file("/proc/interrupts"), _cpu);
+        sample.cpu_freq_khz = static_cast<int32_t>(_read_number(_cpu_path + "/cpufreq/scaling_cur_freq"));
+        sample.temperature_mc = static_cast<int32_t>(_read_number(SYSTEM_SAMPLER_THERMAL_ZONE));
+        sample.throttle_count = _read_number(_cpu_path + "/thermal_throttle/core_throttle_count");
+    }
+
+    static std::string _read_file(const std::string& path)
+    {
+        std::ifstream file(path);
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    static int64_t _read_number(const std::string& path)
+    {
+        std::ifstream file(path);
+        int64_t value;
+        if (file >> value)
+        {
+            return value;
+        }
+        return -1;
+    }
+
+    std::atomic<bool> _is_running;
+    std::atomic<int> _rt_thread_id;
+    int _cpu;
+    std::string _cpu_path;
+    std::thread _thread;
+    std::ofstream _stream;
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_SYSTEM_SAMPLER_H
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2022-2025 Elk Audio AB, dba Elk
+ * RASPA is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * RASPA is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * RASPA. If not, see http://www.gnu.org/licenses/ .
+ */
+
+/**
+ * @brief Definition of class template RaspaTraceWriter, the common part of the
+ *        debug traces which write a header and one fixed size record per
+ *        period to file.
+ * @copyright 2022-2025 Elk Audio AB, dba Elk, Stockholm
+ */
+#ifndef RASPA_TRACE_WRITER_H
+#define RASPA_TRACE_WRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "raspa_error_codes.h"
+#include "raspa_spsc_ring.h"
+
+namespace raspa {
+
+// trace writer thread sleep period
+constexpr std::chrono::milliseconds TRACE_WRITER_SLEEP(100);
+
+/**
+ * @brief The rt thread pushes records to a lock-free ring, a writer thread
+ *        moves them to file. When records are dropped on a ring overrun, a
+ *        record with period -1 is pushed in their place by the first push
+ *        which succeeds afterwards.
+ *
+ * @tparam Header The file header, written once by start()
+ * @tparam Record The record type, must be trivially copyable and have an
+ *         int64_t period member
+ * @tparam RingSize The minimum number of records buffered between two writes
+ */
+template<typename Header, typename Record, size_t RingSize>
+class RaspaTraceWriter
+{
+public:
+    /**
+     * @brief Construct the writer.
+     * @param open_error Raspa error code returned if the file can't be opened
+     * @param close_error Raspa error code returned if the file can't be closed
+     */
+    RaspaTraceWriter(int open_error, int close_error) : _is_running(false),
+                                                        _overrun(false),
+                                                        _open_error(open_error),
+                                                        _close_error(close_error)
+    {}
+
+    ~RaspaTraceWriter()
+    {
+        terminate();
+    }
+
+    /**
+     * @brief Write the header and start the writer thread.
+     * @return RASPA_SUCCESS upon success, -open_error otherwise.
+     */
+    int start(const std::string& file_name, const Header& header)
+    {
+        _stream.open(file_name.c_str(), std::ofstream::binary | std::ofstream::out);
+        if (_stream.fail())
+        {
+            return -_open_error;
+        }
+        _stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        _overrun = false;
+        _is_running = true;
+        _thread = std::thread(&RaspaTraceWriter::_run, this);
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief Stop the writer thread, write the pending records and close the
+     *        file. It is always safe to call this function.
+     * @return RASPA_SUCCESS upon success, -close_error otherwise.
+     */
+    int terminate()
+    {
+        if (_is_running)
+        {
+            _is_running = false;
+            if (_thread.joinable())
+            {
+                _thread.join();
+            }
+        }
+
+        if (_stream.is_open())
+        {
+            _stream.close();
+            if (_stream.fail())
+            {
+                return -_close_error;
+            }
+        }
+        return RASPA_SUCCESS;
+    }
+
+    /**
+     * @brief True between start() and terminate().
+     */
+    bool is_running() const
+    {
+        return _is_running;
+    }
+
+    /**
+     * @brief Push one record. Rt safe.
+     */
+    void put(const Record& record)
+    {
+        if (_is_running)
+        {
+            if (_overrun)
+            {
+                Record marker = {};
+                marker.period = -1;
+                if (!_ring.push(marker))
+                {
+                    return;
+                }
+                _overrun = false;
+            }
+            if (!_ring.push(record))
+            {
+                _overrun = true;
+            }
+        }
+    }
+
+private:
+    void _run()
+    {
+        while (_is_running)
+        {
+            std::this_thread::sleep_for(TRACE_WRITER_SLEEP);
+            _write_records_to_file();
+        }
+
+        // write the records pushed before the stop
+        _write_records_to_file();
+    }
+
+    void _write_records_to_file()
+    {
+        Record records[256];
+        size_t count;
+        while ((count = _ring.pop(records, 256)) > 0)
+        {
+            _stream.write(reinterpret_cast<char*>(records), count * sizeof(Record));
+            if (!_stream)
+            {
+                fprintf(stderr, "Trace file write error\n");
+                break;
+            }
+        }
+    }
+
+    std::atomic<bool> _is_running;
+    // only accessed by the rt thread once started
+    bool _overrun;
+    int _open_error;
+    int _close_error;
+    std::thread _thread;
+    std::ofstream _stream;
+    SpscRing<Record, RingSize> _ring;
+};
+
+}  // namespace raspa
+
+#endif  // RASPA_TRACE_WRITER_H
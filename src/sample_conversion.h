@@ -25,9 +25,11 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 #include <cstring>
 
 #include "driver_config.h"
+#include "raspa_error_codes.h"
 
 namespace raspa {
 
@@ -57,81 +59,106 @@ constexpr float FLOAT_MAX = 9.999999e-01; // this is nextafterf(1.0f, 0), do not
 constexpr int SUPPORTED_BUFFER_SIZES[] = {8, 16, 32, 48, 64, 128, 192, 256, 512};
 constexpr int SUPPORTED_STRIDES[] = {2, 4, 6, 8, 10, 12, 14, 16, 24, 32};
 
+/**
+ * cache line size, in samples, used for the layout of the float buffers
+ */
+constexpr int CACHE_LINE_SIZE_IN_SAMPLES = 64 / sizeof(float);
+
+/**
+ * @brief Get the distance in samples between the start of consecutive channels
+ *        in a float buffer, so that the channels do not alias in the cache.
+ *        With contiguous channels of a power of two size, the start of every
+ *        channel maps to the same few cache sets. Padding each channel to an
+ *        odd number of cache lines spreads the channel starts over all sets.
+ *
+ * @param buffer_size_in_frames The buffer size in frames
+ * @return The padded channel stride in samples, a multiple of the cache line
+ */
+constexpr int get_padded_channel_stride(int buffer_size_in_frames)
+{
+    int num_lines = (buffer_size_in_frames + CACHE_LINE_SIZE_IN_SAMPLES - 1) / CACHE_LINE_SIZE_IN_SAMPLES;
+    if (num_lines % 2 == 0)
+    {
+        num_lines++;
+    }
+    return num_lines * CACHE_LINE_SIZE_IN_SAMPLES;
+}
+
 // Macro to iterate through all possible buffer size and stride combinations and return the right instantiation of
 // the sample converter. SUPPORTED_BUFFER_SIZES and SUPPORTED_STRIDES must reflect the supported values.
-#define GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_id, buffer_size, format, hw_chan_start_index, stride)     \
-switch (buffer_size)                                                                                     \
-{                                                                                                        \
-    case 8:                                                                                              \
-        return std::make_unique<SampleConverter<8, format, stride>>(sw_chan_id, hw_chan_start_index);    \
-        break;                                                                                           \
-    case 16:                                                                                             \
-        return std::make_unique<SampleConverter<16, format, stride>>(sw_chan_id, hw_chan_start_index);   \
-        break;                                                                                           \
-    case 32:                                                                                             \
-        return std::make_unique<SampleConverter<32, format, stride>>(sw_chan_id, hw_chan_start_index);   \
-        break;                                                                                           \
-    case 48:                                                                                             \
-        return std::make_unique<SampleConverter<48, format, stride>>(sw_chan_id, hw_chan_start_index);   \
-        break;                                                                                           \
-    case 64:                                                                                             \
-        return std::make_unique<SampleConverter<64, format, stride>>(sw_chan_id, hw_chan_start_index);   \
-        break;                                                                                           \
-    case 128:                                                                                            \
-        return std::make_unique<SampleConverter<128, format, stride>>(sw_chan_id, hw_chan_start_index);  \
-        break;                                                                                           \
-    case 192:                                                                                            \
-        return std::make_unique<SampleConverter<192, format, stride>>(sw_chan_id, hw_chan_start_index);  \
-        break;                                                                                           \
-    case 256:                                                                                            \
-        return std::make_unique<SampleConverter<256, format, stride>>(sw_chan_id, hw_chan_start_index);  \
-        break;                                                                                           \
-    case 512:                                                                                            \
-        return std::make_unique<SampleConverter<512, format, stride>>(sw_chan_id, hw_chan_start_index);  \
-        break;                                                                                           \
-                                                                                                         \
-default:                                                                                                 \
-    return std::unique_ptr<BaseSampleConverter>(nullptr);                                                \
-    break;                                                                                               \
-}                                                                                                        \
-
-#define GET_CONVERTER_WITH_STRIDES(sw_chan_id, buffer_size, format, hw_chan_start_index, stride)         \
-switch(stride)                                                                                           \
-{                                                                                                        \
-    case 2:                                                                                              \
-        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_id, buffer_size, format, hw_chan_start_index, 2);         \
-        break;                                                                                           \
-    case 4:                                                                                              \
-        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_id, buffer_size, format, hw_chan_start_index, 4);         \
-        break;                                                                                           \
-    case 6:                                                                                              \
-        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_id, buffer_size, format, hw_chan_start_index, 6);         \
-        break;                                                                                           \
-    case 8:                                                                                              \
-        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_id, buffer_size, format, hw_chan_start_index, 8);         \
-        break;                                                                                           \
-    case 10:                                                                                             \
-        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_id, buffer_size, format, hw_chan_start_index, 10);        \
-        break;                                                                                           \
-    case 12:                                                                                             \
-        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_id, buffer_size, format, hw_chan_start_index, 12);        \
-        break;                                                                                           \
-    case 14:                                                                                             \
-        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_id, buffer_size, format, hw_chan_start_index, 14);        \
-        break;                                                                                           \
-    case 16:                                                                                             \
-        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_id, buffer_size, format, hw_chan_start_index, 16);        \
-        break;                                                                                           \
-    case 24:                                                                                             \
-        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_id, buffer_size, format, hw_chan_start_index, 24);        \
-        break;                                                                                           \
-    case 32:                                                                                             \
-        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_id, buffer_size, format, hw_chan_start_index, 32);        \
-        break;                                                                                           \
-default:                                                                                                 \
-    return std::unique_ptr<BaseSampleConverter>(nullptr);                                                \
-    break;                                                                                               \
-}                                                                                                        \
+#define GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_start_index, buffer_size, format, hw_chan_start_index, stride)    \
+switch (buffer_size)                                                                                             \
+{                                                                                                                \
+    case 8:                                                                                                      \
+        return std::make_unique<SampleConverter<8, format, stride>>(sw_chan_start_index, hw_chan_start_index);   \
+        break;                                                                                                   \
+    case 16:                                                                                                     \
+        return std::make_unique<SampleConverter<16, format, stride>>(sw_chan_start_index, hw_chan_start_index);  \
+        break;                                                                                                   \
+    case 32:                                                                                                     \
+        return std::make_unique<SampleConverter<32, format, stride>>(sw_chan_start_index, hw_chan_start_index);  \
+        break;                                                                                                   \
+    case 48:                                                                                                     \
+        return std::make_unique<SampleConverter<48, format, stride>>(sw_chan_start_index, hw_chan_start_index);  \
+        break;                                                                                                   \
+    case 64:                                                                                                     \
+        return std::make_unique<SampleConverter<64, format, stride>>(sw_chan_start_index, hw_chan_start_index);  \
+        break;                                                                                                   \
+    case 128:                                                                                                    \
+        return std::make_unique<SampleConverter<128, format, stride>>(sw_chan_start_index, hw_chan_start_index); \
+        break;                                                                                                   \
+    case 192:                                                                                                    \
+        return std::make_unique<SampleConverter<192, format, stride>>(sw_chan_start_index, hw_chan_start_index); \
+        break;                                                                                                   \
+    case 256:                                                                                                    \
+        return std::make_unique<SampleConverter<256, format, stride>>(sw_chan_start_index, hw_chan_start_index); \
+        break;                                                                                                   \
+    case 512:                                                                                                    \
+        return std::make_unique<SampleConverter<512, format, stride>>(sw_chan_start_index, hw_chan_start_index); \
+        break;                                                                                                   \
+                                                                                                                 \
+default:                                                                                                         \
+    return std::unique_ptr<BaseSampleConverter>(nullptr);                                                        \
+    break;                                                                                                       \
+}                                                                                                                \
+
+#define GET_CONVERTER_WITH_STRIDES(sw_chan_start_index, buffer_size, format, hw_chan_start_index, stride)        \
+switch(stride)                                                                                                   \
+{                                                                                                                \
+    case 2:                                                                                                      \
+        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_start_index, buffer_size, format, hw_chan_start_index, 2);        \
+        break;                                                                                                   \
+    case 4:                                                                                                      \
+        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_start_index, buffer_size, format, hw_chan_start_index, 4);        \
+        break;                                                                                                   \
+    case 6:                                                                                                      \
+        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_start_index, buffer_size, format, hw_chan_start_index, 6);        \
+        break;                                                                                                   \
+    case 8:                                                                                                      \
+        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_start_index, buffer_size, format, hw_chan_start_index, 8);        \
+        break;                                                                                                   \
+    case 10:                                                                                                     \
+        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_start_index, buffer_size, format, hw_chan_start_index, 10);       \
+        break;                                                                                                   \
+    case 12:                                                                                                     \
+        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_start_index, buffer_size, format, hw_chan_start_index, 12);       \
+        break;                                                                                                   \
+    case 14:                                                                                                     \
+        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_start_index, buffer_size, format, hw_chan_start_index, 14);       \
+        break;                                                                                                   \
+    case 16:                                                                                                     \
+        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_start_index, buffer_size, format, hw_chan_start_index, 16);       \
+        break;                                                                                                   \
+    case 24:                                                                                                     \
+        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_start_index, buffer_size, format, hw_chan_start_index, 24);       \
+        break;                                                                                                   \
+    case 32:                                                                                                     \
+        GET_CONVERTER_WITH_BUFFER_SIZE(sw_chan_start_index, buffer_size, format, hw_chan_start_index, 32);       \
+        break;                                                                                                   \
+default:                                                                                                         \
+    return std::unique_ptr<BaseSampleConverter>(nullptr);                                                        \
+    break;                                                                                                       \
+}                                                                                                                \
 
 /**
  * @brief Interface class for sample conversion
@@ -178,17 +205,16 @@ public:
     /**
      * @brief Construct a new Input Sample Converter object.
      *
-     * @param chan_stride THe number of words between each sample of a channel
-     * @param sw_chan_id Represents which sw channel this sample converter is
-     *                   responsible for.
+     * @param sw_chan_start_index The index of the first sample of the sw channel
+     *                   this sample converter is responsible for, in the float
+     *                   buffer
      * @param hw_chan_start_index The index of the first sample of the hw channel in the
      *                    integer buffer
      */
-    SampleConverter(int sw_chan_id, int hw_chan_start_index) :
-                                    _hw_chan_start_index(hw_chan_start_index)
-    {
-        _sw_chan_start_index = sw_chan_id * buffer_size_in_frames;
-    }
+    SampleConverter(int sw_chan_start_index, int hw_chan_start_index) :
+                                    _hw_chan_start_index(hw_chan_start_index),
+                                    _sw_chan_start_index(sw_chan_start_index)
+    {}
 
     ~SampleConverter() = default;
 
@@ -382,38 +408,48 @@ private:
  *  - after int to float conversion, the resulting sample will be put in the float_buffer[sw_chan_id].
  *   -for float t0 int conversion, samples are taken from float_buffer[sw_chan_id]
  * @param hw_chan_start_index The index in the integer buffer where the first sample of the channel is
+ * @param sw_chan_stride The distance in samples between the start of consecutive
+ *                       channels in the float buffer, 0 if they are contiguous,
+ *                       i.e. buffer_size_in_frames apart
  * @return std::unique_ptr<BaseSampleConverter> Instance to SampleConverter
  */
 std::unique_ptr<BaseSampleConverter> get_sample_converter(int sw_chan_id,
                                                           int buffer_size_in_frames,
                                                           driver_conf::CodecFormat codec_format,
                                                           int hw_chan_start_index,
-                                                          int chan_stride)
+                                                          int chan_stride,
+                                                          int sw_chan_stride = 0)
 {
+    if (sw_chan_stride == 0)
+    {
+        sw_chan_stride = buffer_size_in_frames;
+    }
+    int sw_chan_start_index = sw_chan_id * sw_chan_stride;
+
     switch (codec_format)
     {
     case driver_conf::CodecFormat::INT24_LJ:
-        GET_CONVERTER_WITH_STRIDES(sw_chan_id, buffer_size_in_frames, driver_conf::CodecFormat::INT24_LJ, hw_chan_start_index, chan_stride);
+        GET_CONVERTER_WITH_STRIDES(sw_chan_start_index, buffer_size_in_frames, driver_conf::CodecFormat::INT24_LJ, hw_chan_start_index, chan_stride);
         break;
 
     case driver_conf::CodecFormat::INT24_I2S:
-        GET_CONVERTER_WITH_STRIDES(sw_chan_id, buffer_size_in_frames, driver_conf::CodecFormat::INT24_I2S, hw_chan_start_index, chan_stride);
+        GET_CONVERTER_WITH_STRIDES(sw_chan_start_index, buffer_size_in_frames, driver_conf::CodecFormat::INT24_I2S, hw_chan_start_index, chan_stride);
         break;
 
     case driver_conf::CodecFormat::INT24_RJ:
-        GET_CONVERTER_WITH_STRIDES(sw_chan_id, buffer_size_in_frames, driver_conf::CodecFormat::INT24_RJ, hw_chan_start_index, chan_stride);
+        GET_CONVERTER_WITH_STRIDES(sw_chan_start_index, buffer_size_in_frames, driver_conf::CodecFormat::INT24_RJ, hw_chan_start_index, chan_stride);
         break;
 
     case driver_conf::CodecFormat::INT24_32RJ:
-        GET_CONVERTER_WITH_STRIDES(sw_chan_id, buffer_size_in_frames, driver_conf::CodecFormat::INT24_32RJ, hw_chan_start_index, chan_stride);
+        GET_CONVERTER_WITH_STRIDES(sw_chan_start_index, buffer_size_in_frames, driver_conf::CodecFormat::INT24_32RJ, hw_chan_start_index, chan_stride);
         break;
 
     case driver_conf::CodecFormat::INT32:
-        GET_CONVERTER_WITH_STRIDES(sw_chan_id, buffer_size_in_frames, driver_conf::CodecFormat::INT32, hw_chan_start_index, chan_stride);
+        GET_CONVERTER_WITH_STRIDES(sw_chan_start_index, buffer_size_in_frames, driver_conf::CodecFormat::INT32, hw_chan_start_index, chan_stride);
         break;
 
     case driver_conf::CodecFormat::BINARY:
-        GET_CONVERTER_WITH_STRIDES(sw_chan_id, buffer_size_in_frames, driver_conf::CodecFormat::BINARY, hw_chan_start_index, chan_stride);
+        GET_CONVERTER_WITH_STRIDES(sw_chan_start_index, buffer_size_in_frames, driver_conf::CodecFormat::BINARY, hw_chan_start_index, chan_stride);
         break;
 
     default:
@@ -422,6 +458,54 @@ std::unique_ptr<BaseSampleConverter> get_sample_converter(int sw_chan_id,
     }
 }
 
+/**
+ * @brief Create one sample converter per channel, as described by the channel
+ *        info given by the driver. The sw channel id of each converter is its
+ *        index in chan_info.
+ *
+ * @param converters Vector which will hold the sample converters
+ * @param chan_info The channel info of every channel
+ * @param buffer_size_in_frames The buffer size in frames
+ * @param sw_chan_stride The distance in samples between the start of consecutive
+ *                       channels in the float buffer, 0 if they are contiguous
+ * @return int RASPA_SUCCESS upon success, negative raspa error code otherwise
+ */
+inline int create_sample_converters(std::vector<std::unique_ptr<BaseSampleConverter>>& converters,
+                                    const std::vector<driver_conf::ChannelInfo>& chan_info,
+                                    int buffer_size_in_frames,
+                                    int sw_chan_stride = 0)
+{
+    converters.resize(chan_info.size());
+
+    int chan_id = 0;
+    for (const auto& info : chan_info)
+    {
+        auto format_info = driver_conf::check_codec_format(info.sample_format);
+        if (!format_info.first)
+        {
+            // invalid codec format passed by the driver
+            return -RASPA_ECODEC_FORMAT;
+        }
+
+        converters[chan_id] = get_sample_converter(chan_id,
+                                                   buffer_size_in_frames,
+                                                   format_info.second,
+                                                   info.start_offset_in_words,
+                                                   info.stride_in_words,
+                                                   sw_chan_stride);
+
+        if (!converters[chan_id])
+        {
+            // invalid buffer size
+            return -RASPA_EBUFFER_SIZE_SC;
+        }
+
+        chan_id++;
+    }
+
+    return RASPA_SUCCESS;
+}
+
 }  // namespace raspa
 
 #endif  // RASPA_SAMPLE_CONVERSION_H
@@ -0,0 +1,178 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "raspa_audio_tap.h"
+
+using namespace raspa;
+
+constexpr char TEST_TAP_NAME[] = "/raspa_tap_unit_test";
+constexpr int TEST_BUFFER_SIZE = 8;
+constexpr int TEST_NUM_CHANNELS = 4;
+constexpr int TEST_SAMPLE_RATE = 48000;
+
+class TestAudioTap : public ::testing::Test
+{
+protected:
+    TestAudioTap()
+    {
+    }
+
+    void SetUp()
+    {
+        _input.resize(TEST_NUM_CHANNELS * TEST_BUFFER_SIZE);
+        _output.resize(TEST_NUM_CHANNELS * TEST_BUFFER_SIZE);
+    }
+
+    void TearDown()
+    {
+        _module_under_test.terminate();
+    }
+
+    // sample i of channel c in period p is p * 1000 + c * 100 + i, outputs are negated
+    void _write_period(uint64_t period)
+    {
+        for (int c = 0; c < TEST_NUM_CHANNELS; c++)
+        {
+            for (int i = 0; i < TEST_BUFFER_SIZE; i++)
+            {
+                float value = period * 1000.0f + c * 100.0f + i;
+                _input[c * TEST_BUFFER_SIZE + i] = value;
+                _output[c * TEST_BUFFER_SIZE + i] = -value;
+            }
+        }
+        _module_under_test.write(_input.data(), _output.data(), period + 10);
+    }
+
+    std::vector<float> _input;
+    std::vector<float> _output;
+    RaspaAudioTap _module_under_test;
+};
+
+TEST_F(TestAudioTap, TestChannelValidation)
+{
+    ASSERT_EQ(-RASPA_ETAP_CHANNELS, _module_under_test.start(TEST_TAP_NAME, {}, {}, TEST_BUFFER_SIZE, TEST_BUFFER_SIZE,
+                                                             TEST_SAMPLE_RATE));
+    std::vector<int> too_many(RASPA_TAP_MAX_CHANNELS + 1, 0);
+    ASSERT_EQ(-RASPA_ETAP_CHANNELS, _module_under_test.start(TEST_TAP_NAME, too_many, {}, TEST_BUFFER_SIZE, TEST_BUFFER_SIZE,
+                                                             TEST_SAMPLE_RATE));
+    ASSERT_FALSE(_module_under_test.is_running());
+
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.start(TEST_TAP_NAME, {0}, {}, TEST_BUFFER_SIZE, TEST_BUFFER_SIZE,
+                                                      TEST_SAMPLE_RATE));
+    ASSERT_EQ(-RASPA_ETAP_ALREADY_OPEN, _module_under_test.start(TEST_TAP_NAME, {0}, {}, TEST_BUFFER_SIZE, TEST_BUFFER_SIZE,
+                                                                 TEST_SAMPLE_RATE));
+}
+
+TEST_F(TestAudioTap, TestReadPeriods)
+{
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.start(TEST_TAP_NAME, {1, 3}, {2}, TEST_BUFFER_SIZE, TEST_BUFFER_SIZE,
+                                                      TEST_SAMPLE_RATE));
+
+    RaspaTap tap;
+    ASSERT_EQ(0, raspa_tap_attach(&tap, TEST_TAP_NAME));
+    ASSERT_EQ(TEST_SAMPLE_RATE, static_cast<int>(tap.header->sample_rate));
+    ASSERT_EQ(2u, tap.header->num_input_channels);
+    ASSERT_EQ(1u, tap.header->num_output_channels);
+    ASSERT_EQ(3, tap.header->input_channels[1]);
+    ASSERT_EQ(3 * TEST_BUFFER_SIZE * sizeof(float), raspa_tap_get_period_size(&tap));
+
+    // at least 500 ms of history, in a power of two number of slots
+    auto num_slots = tap.header->num_slots;
+    ASSERT_GE(num_slots * TEST_BUFFER_SIZE, static_cast<uint32_t>(TEST_SAMPLE_RATE / 2));
+    ASSERT_EQ(0u, num_slots & (num_slots - 1));
+
+    std::vector<float> samples(3 * TEST_BUFFER_SIZE);
+    ASSERT_EQ(0u, raspa_tap_get_write_count(&tap));
+    ASSERT_EQ(RASPA_TAP_NOT_READY, raspa_tap_read_period(&tap, 0, samples.data()));
+
+    _write_period(0);
+    _write_period(1);
+    ASSERT_EQ(2u, raspa_tap_get_write_count(&tap));
+
+    uint64_t raspa_period = 0;
+    ASSERT_EQ(RASPA_TAP_OK, raspa_tap_read_period_ex(&tap, 1, samples.data(), &raspa_period));
+    ASSERT_EQ(11u, raspa_period);
+    ASSERT_FLOAT_EQ(1100.0f, samples[0]);
+    ASSERT_FLOAT_EQ(1300.0f + TEST_BUFFER_SIZE - 1, samples[2 * TEST_BUFFER_SIZE - 1]);
+    ASSERT_FLOAT_EQ(-1200.0f, samples[2 * TEST_BUFFER_SIZE]);
+    ASSERT_EQ(RASPA_TAP_NOT_READY, raspa_tap_read_period(&tap, 2, samples.data()));
+
+    // wrap around once, period 1 is replaced by period num_slots + 1
+    for (uint64_t period = 2; period <= num_slots + 1; period++)
+    {
+        _write_period(period);
+    }
+    ASSERT_EQ(RASPA_TAP_OVERWRITTEN, raspa_tap_read_period(&tap, 1, samples.data()));
+    ASSERT_EQ(RASPA_TAP_OK, raspa_tap_read_period(&tap, num_slots + 1, samples.data()));
+    ASSERT_FLOAT_EQ((num_slots + 1) * 1000.0f + 100.0f, samples[0]);
+
+    raspa_tap_detach(&tap);
+}
+
+TEST_F(TestAudioTap, TestTerminate)
+{
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.start(TEST_TAP_NAME, {0}, {0}, TEST_BUFFER_SIZE, TEST_BUFFER_SIZE,
+                                                      TEST_SAMPLE_RATE));
+    RaspaTap tap;
+    ASSERT_EQ(0, raspa_tap_attach(&tap, TEST_TAP_NAME));
+
+    _module_under_test.terminate();
+    ASSERT_FALSE(_module_under_test.is_running());
+
+    // writes are ignored and new readers can not attach, existing ones keep their mapping
+    _write_period(0);
+    ASSERT_EQ(0u, raspa_tap_get_write_count(&tap));
+    RaspaTap second_tap;
+    ASSERT_EQ(-1, raspa_tap_attach(&second_tap, TEST_TAP_NAME));
+
+    raspa_tap_detach(&tap);
+}
+
+TEST_F(TestAudioTap, TestReopenWhileWriting)
+{
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.start(TEST_TAP_NAME, {0}, {}, TEST_BUFFER_SIZE, TEST_BUFFER_SIZE,
+                                                      TEST_SAMPLE_RATE));
+
+    // the rt thread keeps writing while the tap is closed and reopened with a different layout
+    std::atomic<bool> stop(false);
+    std::thread rt_thread([&]()
+    {
+        std::vector<float> input(TEST_NUM_CHANNELS * TEST_BUFFER_SIZE, 1.0f);
+        std::vector<float> output(TEST_NUM_CHANNELS * TEST_BUFFER_SIZE, -1.0f);
+        uint64_t period = 0;
+        while (!stop)
+        {
+            _module_under_test.write(input.data(), output.data(), period++);
+        }
+    });
+
+    for (int i = 0; i < 200; i++)
+    {
+        ASSERT_EQ(RASPA_SUCCESS, _module_under_test.terminate());
+        std::vector<int> channels(1 + i % TEST_NUM_CHANNELS);
+        for (size_t c = 0; c < channels.size(); c++)
+        {
+            channels[c] = c;
+        }
+        ASSERT_EQ(RASPA_SUCCESS, _module_under_test.start(TEST_TAP_NAME, channels, channels, TEST_BUFFER_SIZE,
+                                                          TEST_BUFFER_SIZE, TEST_SAMPLE_RATE));
+    }
+
+    // the last layout is written to
+    RaspaTap tap;
+    ASSERT_EQ(0, raspa_tap_attach(&tap, TEST_TAP_NAME));
+    ASSERT_EQ(static_cast<uint32_t>(TEST_NUM_CHANNELS), tap.header->num_input_channels);
+    for (int i = 0; i < 1000 && raspa_tap_get_write_count(&tap) == 0; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    stop = true;
+    rt_thread.join();
+    ASSERT_GT(raspa_tap_get_write_count(&tap), 0u);
+    raspa_tap_detach(&tap);
+}
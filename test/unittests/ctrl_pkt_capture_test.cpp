@@ -0,0 +1,121 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "raspa_ctrl_pkt_capture.h"
+
+using namespace raspa;
+
+constexpr char TEST_CAPTURE_FILE[] = "/tmp/raspa_ctrl_pkt_capture_test.cap";
+constexpr int TEST_NUM_PERIODS = 2000;
+constexpr int TEST_PKT_SIZE_WORDS = 32;
+
+class TestCtrlPktCapture : public ::testing::Test
+{
+protected:
+    TestCtrlPktCapture()
+    {
+    }
+
+    void SetUp()
+    {
+    }
+
+    void TearDown()
+    {
+        _module_under_test.terminate();
+        std::remove(TEST_CAPTURE_FILE);
+    }
+
+    RaspaCtrlPktCapture _module_under_test;
+};
+
+TEST_F(TestCtrlPktCapture, TestPacketsWritten)
+{
+    CtrlPktCaptureHeader header = {};
+    header.sample_rate = 48000;
+    header.buffer_size_in_frames = 64;
+    header.pkt_size_in_bytes = TEST_PKT_SIZE_WORDS * sizeof(uint32_t);
+    header.payload_capacity_in_bytes = 96;
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.start(TEST_CAPTURE_FILE, header));
+
+    uint32_t pkt[TEST_PKT_SIZE_WORDS];
+    for (int i = 0; i < TEST_PKT_SIZE_WORDS; i++)
+    {
+        pkt[i] = 0x1000 + i;
+    }
+    for (int period = 0; period < TEST_NUM_PERIODS; period++)
+    {
+        _module_under_test.put(period, CTRL_PKT_RX, period % 10 == 0 ? CTRL_PKT_GPIO : CTRL_PKT_DEFAULT,
+                               period % 10 == 0 ? 8 : 0, pkt);
+        _module_under_test.put(period, CTRL_PKT_TX, CTRL_PKT_DEFAULT, 0, pkt);
+    }
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.terminate());
+
+    std::ifstream stream(TEST_CAPTURE_FILE, std::ifstream::binary);
+    CtrlPktCaptureHeader read_header;
+    ASSERT_TRUE(stream.read(reinterpret_cast<char*>(&read_header), sizeof(read_header)));
+    ASSERT_EQ(0, std::memcmp(CTRL_PKT_CAPTURE_MAGIC, read_header.magic, sizeof(read_header.magic)));
+    ASSERT_EQ(CTRL_PKT_CAPTURE_VERSION, read_header.version);
+    ASSERT_EQ(96u, read_header.payload_capacity_in_bytes);
+
+    std::vector<CtrlPktCaptureRecord> records;
+    CtrlPktCaptureRecord record;
+    while (stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+    {
+        records.push_back(record);
+    }
+    ASSERT_EQ(static_cast<size_t>(2 * TEST_NUM_PERIODS), records.size());
+
+    ASSERT_EQ(0, records[0].period);
+    ASSERT_EQ(CTRL_PKT_RX, records[0].direction);
+    ASSERT_EQ(CTRL_PKT_GPIO, records[0].type);
+    ASSERT_EQ(8, records[0].payload_bytes);
+    ASSERT_EQ(CTRL_PKT_TX, records[1].direction);
+    ASSERT_EQ(CTRL_PKT_DEFAULT, records[3].type);
+    ASSERT_EQ(TEST_NUM_PERIODS - 1, records.back().period);
+    for (int i = 0; i < CTRL_PKT_CAPTURE_HEADER_WORDS; i++)
+    {
+        ASSERT_EQ(pkt[i], records[5].header_words[i]);
+    }
+}
+
+TEST_F(TestCtrlPktCapture, TestOverrunMarker)
+{
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.start(TEST_CAPTURE_FILE, {}));
+
+    // more than the ring holds before the writer thread wakes up
+    uint32_t pkt[CTRL_PKT_CAPTURE_HEADER_WORDS] = {};
+    int num_pkts = static_cast<int>(CTRL_PKT_CAPTURE_RING_SIZE) + 100;
+    for (int i = 0; i < num_pkts; i++)
+    {
+        _module_under_test.put(i, CTRL_PKT_RX, CTRL_PKT_DEFAULT, 0, pkt);
+    }
+
+    // the marker is pushed with the first packet after the ring is drained
+    std::this_thread::sleep_for(3 * TRACE_WRITER_SLEEP);
+    _module_under_test.put(num_pkts, CTRL_PKT_RX, CTRL_PKT_DEFAULT, 0, pkt);
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.terminate());
+
+    std::ifstream stream(TEST_CAPTURE_FILE, std::ifstream::binary);
+    stream.seekg(sizeof(CtrlPktCaptureHeader));
+    std::vector<CtrlPktCaptureRecord> records;
+    CtrlPktCaptureRecord record;
+    int num_markers = 0;
+    while (stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+    {
+        num_markers += record.period == -1;
+        records.push_back(record);
+    }
+    ASSERT_EQ(1, num_markers);
+    ASSERT_EQ(CTRL_PKT_CAPTURE_RING_SIZE + 2, records.size());
+
+    // the marker sits at the gap, between the last packet kept and the next one
+    ASSERT_EQ(static_cast<int64_t>(CTRL_PKT_CAPTURE_RING_SIZE) - 1, records[records.size() - 3].period);
+    ASSERT_EQ(-1, records[records.size() - 2].period);
+    ASSERT_EQ(num_pkts, records.back().period);
+}
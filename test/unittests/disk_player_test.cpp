@@ -0,0 +1,233 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "raspa_disk_player.h"
+#include "raspa_disk_recorder.h"
+
+using namespace raspa;
+
+constexpr char TEST_PLAYER_FILE[] = "/tmp/raspa_disk_player_test.wav";
+constexpr int TEST_BUFFER_SIZE = 64;
+constexpr int TEST_NUM_OUTPUTS = 4;
+constexpr int TEST_SAMPLE_RATE = 48000;
+constexpr int TEST_NUM_FRAMES = 1000;
+
+class TestDiskPlayer : public ::testing::Test
+{
+protected:
+    TestDiskPlayer()
+    {
+    }
+
+    void SetUp()
+    {}
+
+    void TearDown()
+    {
+        _module_under_test.terminate();
+        std::remove(TEST_PLAYER_FILE);
+    }
+
+    template<typename T>
+    void _append(std::vector<uint8_t>& file, T value)
+    {
+        auto bytes = reinterpret_cast<const uint8_t*>(&value);
+        file.insert(file.end(), bytes, bytes + sizeof(T));
+    }
+
+    // 16 bit stereo file, sample value encodes channel and frame
+    void _write_int16_file()
+    {
+        uint32_t data_size = TEST_NUM_FRAMES * 2 * sizeof(int16_t);
+        std::vector<uint8_t> file = {'R', 'I', 'F', 'F'};
+        _append<uint32_t>(file, 36 + data_size);
+        file.insert(file.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+        _append<uint32_t>(file, 16);
+        _append<uint16_t>(file, 1);
+        _append<uint16_t>(file, 2);
+        _append<uint32_t>(file, TEST_SAMPLE_RATE);
+        _append<uint32_t>(file, TEST_SAMPLE_RATE * 2 * sizeof(int16_t));
+        _append<uint16_t>(file, 2 * sizeof(int16_t));
+        _append<uint16_t>(file, 16);
+        file.insert(file.end(), {'d', 'a', 't', 'a'});
+        _append<uint32_t>(file, data_size);
+        for (int i = 0; i < TEST_NUM_FRAMES; i++)
+        {
+            _append<int16_t>(file, i);
+            _append<int16_t>(file, -i);
+        }
+
+        std::ofstream stream(TEST_PLAYER_FILE, std::ios::binary);
+        stream.write(reinterpret_cast<const char*>(file.data()), file.size());
+    }
+
+    // float mono file as written by the disk recorder
+    void _write_float_file()
+    {
+        uint8_t header[RECORDER_WAV_HEADER_SIZE];
+        build_wav_header(header, 1, TEST_SAMPLE_RATE, TEST_NUM_FRAMES);
+        std::ofstream stream(TEST_PLAYER_FILE, std::ios::binary);
+        stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+        for (int i = 0; i < TEST_NUM_FRAMES; i++)
+        {
+            float sample = static_cast<float>(i);
+            stream.write(reinterpret_cast<const char*>(&sample), sizeof(sample));
+        }
+    }
+
+    void _wait_for_frames(uint64_t num_frames)
+    {
+        for (int i = 0; i < 1000 && _module_under_test.get_num_buffered_frames() < num_frames; i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    RaspaDiskPlayer _module_under_test;
+};
+
+TEST_F(TestDiskPlayer, TestPlayback)
+{
+    _write_int16_file();
+    std::vector<int> channels = {3, 1};
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.start(TEST_PLAYER_FILE,
+                                                      channels,
+                                                      TEST_NUM_OUTPUTS,
+                                                      TEST_BUFFER_SIZE,
+                                                      TEST_BUFFER_SIZE,
+                                                      TEST_SAMPLE_RATE));
+    ASSERT_EQ(-RASPA_EPLAYER_ALREADY_OPEN, _module_under_test.start(TEST_PLAYER_FILE,
+                                                                    channels,
+                                                                    TEST_NUM_OUTPUTS,
+                                                                    TEST_BUFFER_SIZE,
+                                                                    TEST_BUFFER_SIZE,
+                                                                    TEST_SAMPLE_RATE));
+    _wait_for_frames(TEST_NUM_FRAMES);
+
+    std::vector<float> output(TEST_BUFFER_SIZE * TEST_NUM_OUTPUTS);
+    int num_periods = TEST_NUM_FRAMES / TEST_BUFFER_SIZE + 2;
+    for (int period = 0; period < num_periods; period++)
+    {
+        std::fill(output.begin(), output.end(), 5.0f);
+        _module_under_test.pull(output.data());
+
+        for (int i = 0; i < TEST_BUFFER_SIZE; i++)
+        {
+            int frame = period * TEST_BUFFER_SIZE + i;
+            float expected = frame < TEST_NUM_FRAMES ? frame / 32768.0f : 0.0f;
+            ASSERT_FLOAT_EQ(expected, output[3 * TEST_BUFFER_SIZE + i]);
+            ASSERT_FLOAT_EQ(-expected, output[1 * TEST_BUFFER_SIZE + i]);
+
+            // channels not mapped are left untouched
+            ASSERT_FLOAT_EQ(5.0f, output[i]);
+            ASSERT_FLOAT_EQ(5.0f, output[2 * TEST_BUFFER_SIZE + i]);
+        }
+    }
+
+    // the end of the file is not a starvation
+    ASSERT_EQ(0u, _module_under_test.get_num_starvations());
+}
+
+TEST_F(TestDiskPlayer, TestSeekAndLoop)
+{
+    _write_float_file();
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.start(TEST_PLAYER_FILE,
+                                                      {0},
+                                                      TEST_NUM_OUTPUTS,
+                                                      TEST_BUFFER_SIZE,
+                                                      TEST_BUFFER_SIZE,
+                                                      TEST_SAMPLE_RATE));
+    ASSERT_TRUE(_module_under_test.set_loop(true));
+    ASSERT_TRUE(_module_under_test.seek(500));
+
+    // let the reader process the commands
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    _wait_for_frames(TEST_NUM_FRAMES * 2);
+
+    std::vector<float> output(TEST_BUFFER_SIZE * TEST_NUM_OUTPUTS);
+    for (int period = 0; period < 20; period++)
+    {
+        _module_under_test.pull(output.data());
+        for (int i = 0; i < TEST_BUFFER_SIZE; i++)
+        {
+            int frame = (500 + period * TEST_BUFFER_SIZE + i) % TEST_NUM_FRAMES;
+            ASSERT_FLOAT_EQ(static_cast<float>(frame), output[i]);
+        }
+    }
+    ASSERT_EQ(0u, _module_under_test.get_num_starvations());
+}
+
+TEST_F(TestDiskPlayer, TestReopenWhilePulling)
+{
+    // the rt thread keeps pulling while files with different channel counts are opened
+    std::atomic<bool> stop(false);
+    std::thread rt_thread([&]()
+    {
+        std::vector<float> output(TEST_BUFFER_SIZE * TEST_NUM_OUTPUTS);
+        while (!stop)
+        {
+            _module_under_test.pull(output.data());
+        }
+    });
+
+    for (int i = 0; i < 50; i++)
+    {
+        std::vector<int> channels = {0};
+        if (i % 2 == 0)
+        {
+            _write_int16_file();
+            channels.push_back(1);
+        }
+        else
+        {
+            _write_float_file();
+        }
+        ASSERT_EQ(RASPA_SUCCESS, _module_under_test.start(TEST_PLAYER_FILE,
+                                                          channels,
+                                                          TEST_NUM_OUTPUTS,
+                                                          TEST_BUFFER_SIZE,
+                                                          TEST_BUFFER_SIZE,
+                                                          TEST_SAMPLE_RATE));
+        ASSERT_EQ(RASPA_SUCCESS, _module_under_test.terminate());
+    }
+
+    stop = true;
+    rt_thread.join();
+}
+
+TEST_F(TestDiskPlayer, TestInvalidOpen)
+{
+    ASSERT_EQ(-RASPA_EPLAYER_FILE_OPEN, _module_under_test.start("/nonexistent/file.wav",
+                                                                 {0},
+                                                                 TEST_NUM_OUTPUTS,
+                                                                 TEST_BUFFER_SIZE,
+                                                                 TEST_BUFFER_SIZE,
+                                                                 TEST_SAMPLE_RATE));
+    _write_int16_file();
+    ASSERT_EQ(-RASPA_EPLAYER_SAMPLE_RATE, _module_under_test.start(TEST_PLAYER_FILE,
+                                                                   {0},
+                                                                   TEST_NUM_OUTPUTS,
+                                                                   TEST_BUFFER_SIZE,
+                                                                   TEST_BUFFER_SIZE,
+                                                                   44100));
+    ASSERT_EQ(-RASPA_EPLAYER_CHANNELS, _module_under_test.start(TEST_PLAYER_FILE,
+                                                                {0, 1, 2},
+                                                                TEST_NUM_OUTPUTS,
+                                                                TEST_BUFFER_SIZE,
+                                                                TEST_BUFFER_SIZE,
+                                                                TEST_SAMPLE_RATE));
+    ASSERT_EQ(-RASPA_EPLAYER_CHANNELS, _module_under_test.start(TEST_PLAYER_FILE,
+                                                                {TEST_NUM_OUTPUTS},
+                                                                TEST_NUM_OUTPUTS,
+                                                                TEST_BUFFER_SIZE,
+                                                                TEST_BUFFER_SIZE,
+                                                                TEST_SAMPLE_RATE));
+    ASSERT_FALSE(_module_under_test.is_running());
+}
@@ -0,0 +1,154 @@
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "raspa_disk_recorder.h"
+
+using namespace raspa;
+
+constexpr char TEST_RECORDING_FILE[] = "/tmp/raspa_disk_recorder_test.wav";
+constexpr int TEST_BUFFER_SIZE = 64;
+constexpr int TEST_NUM_INPUTS = 4;
+constexpr int TEST_SAMPLE_RATE = 48000;
+constexpr int TEST_NUM_PERIODS = 1000;
+
+class TestDiskRecorder : public ::testing::Test
+{
+protected:
+    TestDiskRecorder()
+    {
+    }
+
+    void SetUp()
+    {}
+
+    void TearDown()
+    {
+        std::remove(TEST_RECORDING_FILE);
+    }
+
+    template<typename T>
+    T _read(const std::vector<uint8_t>& file, size_t offset)
+    {
+        T value;
+        std::memcpy(&value, file.data() + offset, sizeof(T));
+        return value;
+    }
+
+    RaspaDiskRecorder _module_under_test;
+};
+
+TEST_F(TestDiskRecorder, TestRecording)
+{
+    std::vector<int> channels = {3, 0, 2};
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.start(TEST_RECORDING_FILE,
+                                                      channels,
+                                                      TEST_BUFFER_SIZE,
+                                                      TEST_BUFFER_SIZE,
+                                                      TEST_SAMPLE_RATE));
+    ASSERT_EQ(-RASPA_ERECORDER_ALREADY_OPEN, _module_under_test.start(TEST_RECORDING_FILE,
+                                                                      channels,
+                                                                      TEST_BUFFER_SIZE,
+                                                                      TEST_BUFFER_SIZE,
+                                                                      TEST_SAMPLE_RATE));
+
+    // sample value encodes period, channel and frame
+    std::vector<float> input(TEST_BUFFER_SIZE * TEST_NUM_INPUTS);
+    for (int period = 0; period < TEST_NUM_PERIODS; period++)
+    {
+        for (int c = 0; c < TEST_NUM_INPUTS; c++)
+        {
+            for (int i = 0; i < TEST_BUFFER_SIZE; i++)
+            {
+                input[c * TEST_BUFFER_SIZE + i] = static_cast<float>(period * 1000 + c * 100 + i);
+            }
+        }
+        _module_under_test.push(input.data());
+    }
+
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.terminate());
+    ASSERT_EQ(0u, _module_under_test.get_num_overruns());
+
+    std::ifstream stream(TEST_RECORDING_FILE, std::ios::binary);
+    std::vector<uint8_t> file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    uint32_t data_size = TEST_NUM_PERIODS * TEST_BUFFER_SIZE * channels.size() * sizeof(float);
+    ASSERT_EQ(RECORDER_WAV_HEADER_SIZE + data_size, file.size());
+
+    ASSERT_EQ(0, std::memcmp(file.data(), "RIFF", 4));
+    ASSERT_EQ(file.size() - 8, _read<uint32_t>(file, 4));
+    ASSERT_EQ(0, std::memcmp(file.data() + 8, "WAVE", 4));
+    ASSERT_EQ(0, std::memcmp(file.data() + RECORDER_WAV_HEADER_SIZE - 8, "data", 4));
+    ASSERT_EQ(data_size, _read<uint32_t>(file, RECORDER_WAV_HEADER_SIZE - 4));
+
+    // fmt chunk right after the JUNK chunk
+    size_t fmt = 12 + 8 + _read<uint32_t>(file, 16);
+    ASSERT_EQ(0, std::memcmp(file.data() + fmt, "fmt ", 4));
+    ASSERT_EQ(channels.size(), _read<uint16_t>(file, fmt + 10));
+    ASSERT_EQ(static_cast<uint32_t>(TEST_SAMPLE_RATE), _read<uint32_t>(file, fmt + 12));
+
+    // interleaved samples
+    size_t offset = RECORDER_WAV_HEADER_SIZE;
+    for (int period = 0; period < TEST_NUM_PERIODS; period++)
+    {
+        for (int i = 0; i < TEST_BUFFER_SIZE; i++)
+        {
+            for (auto c : channels)
+            {
+                ASSERT_FLOAT_EQ(static_cast<float>(period * 1000 + c * 100 + i), _read<float>(file, offset));
+                offset += sizeof(float);
+            }
+        }
+    }
+}
+
+TEST_F(TestDiskRecorder, TestReopenWhilePushing)
+{
+    // the rt thread keeps pushing while the recorder is closed and reopened
+    std::atomic<bool> stop(false);
+    std::thread rt_thread([&]()
+    {
+        std::vector<float> input(TEST_BUFFER_SIZE * TEST_NUM_INPUTS, 1.0f);
+        while (!stop)
+        {
+            _module_under_test.push(input.data());
+        }
+    });
+
+    for (int i = 0; i < 50; i++)
+    {
+        std::vector<int> channels(1 + i % TEST_NUM_INPUTS);
+        for (size_t c = 0; c < channels.size(); c++)
+        {
+            channels[c] = c;
+        }
+        ASSERT_EQ(RASPA_SUCCESS, _module_under_test.start(TEST_RECORDING_FILE,
+                                                          channels,
+                                                          TEST_BUFFER_SIZE,
+                                                          TEST_BUFFER_SIZE,
+                                                          TEST_SAMPLE_RATE));
+        ASSERT_EQ(RASPA_SUCCESS, _module_under_test.terminate());
+    }
+
+    stop = true;
+    rt_thread.join();
+}
+
+TEST_F(TestDiskRecorder, TestRf64Header)
+{
+    uint8_t header[RECORDER_WAV_HEADER_SIZE];
+    uint64_t num_frames = 1ull << 30;
+    build_wav_header(header, 2, TEST_SAMPLE_RATE, num_frames);
+
+    ASSERT_EQ(0, std::memcmp(header, "RF64", 4));
+    ASSERT_EQ(0, std::memcmp(header + 12, "ds64", 4));
+
+    uint64_t data_size;
+    std::memcpy(&data_size, header + 28, sizeof(data_size));
+    ASSERT_EQ(num_frames * 2 * sizeof(float), data_size);
+}
@@ -0,0 +1,126 @@
+#include <poll.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "raspa_event_queue.h"
+
+using namespace raspa;
+
+// Longer than the relay sleep, so that events are delivered
+constexpr int TEST_POLL_TIMEOUT_MS = 500;
+
+class TestEventQueue : public ::testing::Test
+{
+protected:
+    TestEventQueue()
+    {
+    }
+
+    void SetUp()
+    {
+        _period_count = -1;
+        _fd = _module_under_test.get_fd();
+        ASSERT_GE(_fd, 0);
+        _module_under_test.start([this]() -> int64_t
+        {
+            return _period_count;
+        });
+    }
+
+    void TearDown()
+    {
+        _module_under_test.terminate();
+    }
+
+    bool _wait_for_fd(int timeout_ms)
+    {
+        struct pollfd poll_fd = {_fd, POLLIN, 0};
+        return poll(&poll_fd, 1, timeout_ms) == 1 && (poll_fd.revents & POLLIN);
+    }
+
+    int _fd;
+    std::atomic<int64_t> _period_count;
+    RaspaEventQueue _module_under_test;
+};
+
+TEST_F(TestEventQueue, TestPostAndRead)
+{
+    RaspaEvent event;
+    ASSERT_FALSE(_wait_for_fd(0));
+    ASSERT_EQ(0, _module_under_test.read(&event));
+
+    _module_under_test.post(RASPA_EVENT_OVERRUN, 2, 1000, 10);
+    _module_under_test.post(RASPA_EVENT_USB_INPUT_LOST, 0, 2000, 11);
+    ASSERT_TRUE(_wait_for_fd(TEST_POLL_TIMEOUT_MS));
+
+    // the descriptor does not change across calls
+    ASSERT_EQ(_fd, _module_under_test.get_fd());
+
+    ASSERT_EQ(1, _module_under_test.read(&event));
+    ASSERT_EQ(RASPA_EVENT_OVERRUN, event.type);
+    ASSERT_EQ(2, event.value);
+    ASSERT_EQ(1000, event.timestamp);
+    ASSERT_EQ(10, event.period);
+
+    // still readable until the queue is empty
+    ASSERT_TRUE(_wait_for_fd(0));
+    ASSERT_EQ(1, _module_under_test.read(&event));
+    ASSERT_EQ(RASPA_EVENT_USB_INPUT_LOST, event.type);
+    ASSERT_FALSE(_wait_for_fd(0));
+    ASSERT_EQ(0, _module_under_test.read(&event));
+}
+
+TEST_F(TestEventQueue, TestDroppedEvents)
+{
+    // the relay thread might drain the ring during the loop, so post enough to fill it anyway
+    for (size_t i = 0; i < EVENT_RING_SIZE * 4; i++)
+    {
+        _module_under_test.post(RASPA_EVENT_GPIO_OVERFLOW, 1, 0, i);
+    }
+    _module_under_test.terminate();
+
+    RaspaEvent event;
+    int num_events = 0;
+    int64_t num_dropped = 0;
+    while (_module_under_test.read(&event) == 1)
+    {
+        if (event.type == RASPA_EVENT_DROPPED)
+        {
+            num_dropped += event.value;
+        }
+        else
+        {
+            num_events++;
+        }
+    }
+    ASSERT_GT(num_dropped, 0);
+    ASSERT_EQ(static_cast<int64_t>(EVENT_RING_SIZE * 4), num_events + num_dropped);
+}
+
+TEST_F(TestEventQueue, TestWatchdog)
+{
+    RaspaEvent event;
+    _period_count = 1;
+    ASSERT_FALSE(_wait_for_fd(EVENT_RT_STALL_TIMEOUT_US / 2000));
+
+    ASSERT_TRUE(_wait_for_fd(EVENT_RT_STALL_TIMEOUT_US / 1000 + TEST_POLL_TIMEOUT_MS));
+    ASSERT_EQ(1, _module_under_test.read(&event));
+    ASSERT_EQ(RASPA_EVENT_RT_LOOP_STALLED, event.type);
+    ASSERT_EQ(1, event.period);
+    ASSERT_GT(event.value, EVENT_RT_STALL_TIMEOUT_US);
+
+    _period_count = 2;
+    ASSERT_TRUE(_wait_for_fd(TEST_POLL_TIMEOUT_MS));
+    ASSERT_EQ(1, _module_under_test.read(&event));
+    ASSERT_EQ(RASPA_EVENT_RT_LOOP_RESUMED, event.type);
+    ASSERT_EQ(2, event.period);
+
+    // not watched while stopped
+    _period_count = -1;
+    std::this_thread::sleep_for(std::chrono::microseconds(EVENT_RT_STALL_TIMEOUT_US * 2));
+    ASSERT_EQ(0, _module_under_test.read(&event));
+}
@@ -0,0 +1,97 @@
+#include <cfloat>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "raspa_fpu_mode.h"
+
+using namespace raspa;
+
+constexpr int TEST_NUM_FRAMES = 32;
+constexpr int TEST_CHAN_STRIDE = 40;
+
+class TestFpuMode : public ::testing::Test
+{
+protected:
+    TestFpuMode()
+    {
+    }
+
+    void SetUp()
+    {
+        _module_under_test.init(2, 1);
+    }
+
+    void TearDown()
+    {
+    }
+
+    RaspaDenormalCounter _module_under_test;
+};
+
+TEST_F(TestFpuMode, TestIsDenormal)
+{
+    ASSERT_FALSE(is_denormal(0.0f));
+    ASSERT_FALSE(is_denormal(-0.0f));
+    ASSERT_FALSE(is_denormal(FLT_MIN));
+    ASSERT_FALSE(is_denormal(1.0f));
+    ASSERT_TRUE(is_denormal(FLT_MIN / 2.0f));
+    ASSERT_TRUE(is_denormal(-FLT_MIN / 4.0f));
+}
+
+TEST_F(TestFpuMode, TestFlushDenormals)
+{
+    // on a separate thread, so that the mode does not leak into other tests
+    bool supported = false;
+    bool result = false;
+    std::thread thread([&]()
+    {
+        supported = set_thread_flush_denormals(true);
+        volatile float small = FLT_MIN;
+        volatile float half = 0.5f;
+        volatile float flushed = small * half;
+        set_thread_flush_denormals(false);
+        volatile float kept = small * half;
+        result = flushed == 0.0f && is_denormal(kept);
+    });
+    thread.join();
+    if (!supported)
+    {
+        GTEST_SKIP();
+    }
+    ASSERT_TRUE(result);
+}
+
+TEST_F(TestFpuMode, TestCountDenormals)
+{
+    std::vector<float> input(2 * TEST_CHAN_STRIDE, 0.0f);
+    std::vector<float> output(TEST_CHAN_STRIDE, 0.0f);
+    input[TEST_CHAN_STRIDE + 3] = FLT_MIN / 2.0f;
+    input[TEST_CHAN_STRIDE + 5] = FLT_MIN / 8.0f;
+    output[1] = -FLT_MIN / 2.0f;
+
+    // padding between the channels is not checked
+    input[TEST_NUM_FRAMES] = FLT_MIN / 2.0f;
+
+    ASSERT_TRUE(RaspaDenormalCounter::is_sampled(0));
+    ASSERT_FALSE(RaspaDenormalCounter::is_sampled(1));
+    ASSERT_TRUE(RaspaDenormalCounter::is_sampled(DENORMAL_SAMPLE_INTERVAL));
+
+    for (int i = 0; i < 3; i++)
+    {
+        _module_under_test.count_inputs(input.data(), TEST_CHAN_STRIDE, TEST_NUM_FRAMES);
+        _module_under_test.count_outputs(output.data(), TEST_CHAN_STRIDE, TEST_NUM_FRAMES);
+    }
+
+    RaspaDenormalReport report;
+    _module_under_test.get_report(&report, false);
+    ASSERT_EQ(3, report.num_sampled_periods);
+    ASSERT_EQ(6, report.input_denormals);
+    ASSERT_EQ(3, report.output_denormals);
+
+    _module_under_test.init(2, 1);
+    _module_under_test.get_report(&report, false);
+    ASSERT_EQ(0, report.num_sampled_periods);
+    ASSERT_EQ(0, report.input_denormals);
+}
@@ -0,0 +1,199 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "raspa_graph_executor.h"
+
+using namespace raspa;
+
+constexpr int TEST_NUM_WORKERS = 2;
+constexpr int TEST_NUM_PERIODS = 200;
+
+namespace {
+
+/**
+ * @brief Records the order in which the nodes complete
+ */
+struct TestNode
+{
+    static void process(void* data)
+    {
+        auto node = static_cast<TestNode*>(data);
+        node->order = node->counter->fetch_add(1);
+        node->num_runs++;
+    }
+
+    std::atomic<int>* counter;
+    int order{-1};
+    int num_runs{0};
+};
+
+}  // namespace
+
+class TestGraphExecutor : public ::testing::Test
+{
+protected:
+    TestGraphExecutor()
+    {
+    }
+
+    void SetUp()
+    {
+        _counter = 0;
+        for (auto& node : _nodes)
+        {
+            node.counter = &_counter;
+        }
+    }
+
+    void TearDown()
+    {
+        _stop_workers();
+    }
+
+    int _add_node(int index)
+    {
+        return _module_under_test.add_node(&TestNode::process, &_nodes[index], "test");
+    }
+
+    void _start_workers(int num_workers)
+    {
+        ASSERT_EQ(RASPA_SUCCESS, _module_under_test.prepare(num_workers));
+        for (int i = 1; i <= num_workers; i++)
+        {
+            _workers.emplace_back(&RaspaGraphExecutor::run_worker, &_module_under_test, i);
+        }
+    }
+
+    void _stop_workers()
+    {
+        _module_under_test.stop_workers();
+        for (auto& worker : _workers)
+        {
+            worker.join();
+        }
+        _workers.clear();
+        _module_under_test.release();
+    }
+
+    RaspaGraphExecutor _module_under_test;
+    TestNode _nodes[16];
+    std::atomic<int> _counter;
+    std::vector<std::thread> _workers;
+};
+
+TEST_F(TestGraphExecutor, TestBuildErrors)
+{
+    ASSERT_EQ(-RASPA_EGRAPH_NOT_READY, _module_under_test.process());
+    ASSERT_EQ(-RASPA_EGRAPH_NODE, _module_under_test.add_node(nullptr, nullptr, "null"));
+
+    ASSERT_EQ(0, _add_node(0));
+    ASSERT_EQ(1, _add_node(1));
+    ASSERT_EQ(-RASPA_EGRAPH_NODE, _module_under_test.add_edge(0, 2));
+    ASSERT_EQ(-RASPA_EGRAPH_NODE, _module_under_test.add_edge(1, 1));
+
+    // cycles are rejected
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.add_edge(0, 1));
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.add_edge(1, 0));
+    ASSERT_EQ(-RASPA_EGRAPH_CYCLE, _module_under_test.prepare(0));
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.clear());
+    ASSERT_EQ(0, _module_under_test.get_num_nodes());
+
+    // the graph is frozen while prepared
+    ASSERT_EQ(0, _add_node(0));
+    ASSERT_EQ(-RASPA_EGRAPH_WORKER, _module_under_test.prepare(RASPA_GRAPH_MAX_WORKERS + 1));
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.prepare(0));
+    ASSERT_EQ(-RASPA_EGRAPH_RUNNING, _add_node(1));
+    ASSERT_EQ(-RASPA_EGRAPH_RUNNING, _module_under_test.add_edge(0, 0));
+    ASSERT_EQ(-RASPA_EGRAPH_RUNNING, _module_under_test.clear());
+    _module_under_test.release();
+    ASSERT_EQ(1, _add_node(1));
+}
+
+TEST_F(TestGraphExecutor, TestDependencies)
+{
+    // 0 -> (1, 2, 3) -> 4 -> (5, 6), 2 -> 6
+    for (int i = 0; i < 7; i++)
+    {
+        ASSERT_EQ(i, _add_node(i));
+    }
+    for (auto edge : std::vector<std::pair<int, int>>{{0, 1}, {0, 2}, {0, 3}, {1, 4}, {2, 4},
+                                                       {3, 4}, {4, 5}, {4, 6}, {2, 6}})
+    {
+        ASSERT_EQ(RASPA_SUCCESS, _module_under_test.add_edge(edge.first, edge.second));
+    }
+    _start_workers(TEST_NUM_WORKERS);
+
+    for (int period = 0; period < TEST_NUM_PERIODS; period++)
+    {
+        _counter = 0;
+        ASSERT_EQ(RASPA_SUCCESS, _module_under_test.process());
+        ASSERT_EQ(7, _counter);
+
+        ASSERT_LT(_nodes[0].order, _nodes[1].order);
+        ASSERT_LT(_nodes[0].order, _nodes[2].order);
+        ASSERT_LT(_nodes[0].order, _nodes[3].order);
+        ASSERT_LT(_nodes[1].order, _nodes[4].order);
+        ASSERT_LT(_nodes[2].order, _nodes[4].order);
+        ASSERT_LT(_nodes[3].order, _nodes[4].order);
+        ASSERT_LT(_nodes[4].order, _nodes[5].order);
+        ASSERT_LT(_nodes[4].order, _nodes[6].order);
+    }
+
+    for (int i = 0; i < 7; i++)
+    {
+        ASSERT_EQ(TEST_NUM_PERIODS, _nodes[i].num_runs);
+
+        RaspaGraphNodeStats stats;
+        ASSERT_EQ(RASPA_SUCCESS, _module_under_test.get_node_stats(i, &stats));
+        ASSERT_GE(stats.last_worker, 0);
+        ASSERT_LE(stats.last_worker, TEST_NUM_WORKERS);
+        ASSERT_GE(stats.max_ns, stats.last_ns);
+        ASSERT_GT(stats.critical_path_ns, 0);
+    }
+    RaspaGraphNodeStats stats;
+    ASSERT_EQ(-RASPA_EGRAPH_NODE, _module_under_test.get_node_stats(7, &stats));
+}
+
+TEST_F(TestGraphExecutor, TestCriticalPathFirst)
+{
+    // a single node, then a chain of three nodes added after it
+    ASSERT_EQ(0, _add_node(0));
+    ASSERT_EQ(1, _add_node(1));
+    ASSERT_EQ(2, _add_node(2));
+    ASSERT_EQ(3, _add_node(3));
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.add_edge(1, 2));
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.add_edge(2, 3));
+    _start_workers(0);
+
+    // with one thread, the head of the longest chain runs first
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.process());
+    ASSERT_EQ(0, _nodes[1].order);
+
+    RaspaGraphNodeStats short_stats;
+    RaspaGraphNodeStats long_stats;
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.get_node_stats(0, &short_stats));
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.get_node_stats(1, &long_stats));
+    ASSERT_GT(long_stats.critical_path_ns, short_stats.critical_path_ns);
+}
+
+TEST_F(TestGraphExecutor, TestIndependentNodes)
+{
+    for (int i = 0; i < 16; i++)
+    {
+        ASSERT_EQ(i, _add_node(i));
+    }
+    _start_workers(TEST_NUM_WORKERS);
+
+    for (int period = 0; period < TEST_NUM_PERIODS; period++)
+    {
+        ASSERT_EQ(RASPA_SUCCESS, _module_under_test.process());
+    }
+    for (auto& node : _nodes)
+    {
+        ASSERT_EQ(TEST_NUM_PERIODS, node.num_runs);
+    }
+    ASSERT_EQ(16 * TEST_NUM_PERIODS, _counter);
+}
@@ -0,0 +1,160 @@
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "raspa_isolation_audit.h"
+
+using namespace raspa;
+
+constexpr char TEST_ROOT[] = "/tmp/raspa_isolation_audit_test";
+constexpr int TEST_NUM_CPUS = 4;
+constexpr int TEST_AUDIO_CPU = 3;
+
+class TestIsolationAudit : public ::testing::Test
+{
+protected:
+    TestIsolationAudit() : _module_under_test(TEST_ROOT, TEST_NUM_CPUS)
+    {
+    }
+
+    void SetUp()
+    {
+        std::system((std::string("rm -rf ") + TEST_ROOT).c_str());
+        _write_file("/sys/devices/system/cpu/isolated", "3\n");
+        _write_file("/sys/devices/system/cpu/nohz_full", "\n");
+
+        _add_irq(1, "ethernet", "f\n");         // allowed everywhere, moved
+        _add_irq(2, "mmc0", "7\n");             // not on the audio cpu
+        _add_irq(3, "audio_evl", "8\n");        // the audio interrupt
+        _add_irq(4, "spi0", "8\n");             // pinned on purpose, left there
+        _add_irq(5, "", "f\n");                 // no handler, unused
+
+        _add_thread(2, 2, "kthreadd", 0, "0-3");
+        _add_thread(20, 20, "ksoftirqd/3", 2, "3");
+        _add_thread(21, 21, "kworker/u8:0", 2, "0-3");
+        _add_thread(100, 100, "sshd", 1, "0-2");
+        _add_thread(200, 200, "app", 1, "0-3");
+        _add_thread(200, 201, "app_worker", 1, "2-3");
+    }
+
+    void TearDown()
+    {
+        _module_under_test.restore_irqs();
+        std::system((std::string("rm -rf ") + TEST_ROOT).c_str());
+    }
+
+    void _make_dirs(const std::string& path)
+    {
+        std::system(("mkdir -p " + std::string(TEST_ROOT) + path).c_str());
+    }
+
+    void _write_file(const std::string& path, const std::string& content)
+    {
+        _make_dirs(path.substr(0, path.find_last_of('/')));
+        std::ofstream stream(TEST_ROOT + path);
+        stream << content;
+    }
+
+    std::string _read_file(const std::string& path)
+    {
+        std::ifstream stream(TEST_ROOT + path);
+        std::string content;
+        std::getline(stream, content);
+        return content;
+    }
+
+    void _add_irq(int irq, const std::string& handler, const std::string& mask)
+    {
+        auto irq_dir = "/proc/irq/" + std::to_string(irq);
+        _write_file(irq_dir + "/smp_affinity", mask);
+        if (!handler.empty())
+        {
+            _make_dirs(irq_dir + "/" + handler);
+        }
+    }
+
+    void _add_thread(int pid, int tid, const std::string& name, int parent_pid, const std::string& allowed)
+    {
+        _write_file("/proc/" + std::to_string(pid) + "/task/" + std::to_string(tid) + "/status",
+                    "Name:\t" + name + "\nState:\tS (sleeping)\nPPid:\t" + std::to_string(parent_pid) +
+                    "\nCpus_allowed:\tf\nCpus_allowed_list:\t" + allowed + "\n");
+    }
+
+    RaspaIsolationAudit _module_under_test;
+};
+
+TEST(TestCpuSets, TestParseAndFormat)
+{
+    auto cpus = parse_cpu_list("1-3,6", 8);
+    ASSERT_EQ(4, count_cpus(cpus));
+    ASSERT_FALSE(cpus[0]);
+    ASSERT_TRUE(cpus[1]);
+    ASSERT_TRUE(cpus[3]);
+    ASSERT_TRUE(cpus[6]);
+    ASSERT_EQ(0, count_cpus(parse_cpu_list("\n", 8)));
+
+    // cpus out of range are dropped
+    ASSERT_EQ(2, count_cpus(parse_cpu_list("2-5", 4)));
+
+    cpus = parse_cpu_mask("1,0000000a\n", 40);
+    ASSERT_EQ(3, count_cpus(cpus));
+    ASSERT_TRUE(cpus[1]);
+    ASSERT_TRUE(cpus[3]);
+    ASSERT_TRUE(cpus[32]);
+    ASSERT_EQ("00000001,0000000a", format_cpu_mask(cpus));
+
+    ASSERT_EQ("0000000f", format_cpu_mask(parse_cpu_mask("F", 4)));
+}
+
+TEST_F(TestIsolationAudit, TestReport)
+{
+    RaspaIsolationReport report;
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.audit(TEST_AUDIO_CPU, false, &report, false));
+    ASSERT_EQ(TEST_AUDIO_CPU, report.cpu);
+    ASSERT_EQ(1, report.isolated);
+    ASSERT_EQ(0, report.nohz_full);
+
+    // the ethernet and the pinned spi interrupts
+    ASSERT_EQ(2, report.num_foreign_irqs);
+    ASSERT_EQ(0, report.num_moved_irqs);
+
+    // app and app_worker, kthreadd and the unbound kworker
+    ASSERT_EQ(2, report.num_user_threads);
+    ASSERT_EQ(2, report.num_kernel_threads);
+    ASSERT_EQ("f", _read_file("/proc/irq/1/smp_affinity"));
+
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.audit(1, false, &report, false));
+    ASSERT_EQ(0, report.isolated);
+    ASSERT_EQ(2, report.num_foreign_irqs);
+}
+
+TEST_F(TestIsolationAudit, TestIrqSteering)
+{
+    RaspaIsolationReport report;
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.audit(TEST_AUDIO_CPU, true, &report, false));
+    ASSERT_EQ(2, report.num_foreign_irqs);
+    ASSERT_EQ(1, report.num_moved_irqs);
+    ASSERT_EQ("00000007", _read_file("/proc/irq/1/smp_affinity"));
+    ASSERT_EQ("8", _read_file("/proc/irq/3/smp_affinity"));
+    ASSERT_EQ("8", _read_file("/proc/irq/4/smp_affinity"));
+
+    // a second audit finds only the pinned interrupt
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.audit(TEST_AUDIO_CPU, true, &report, false));
+    ASSERT_EQ(1, report.num_foreign_irqs);
+    ASSERT_EQ(0, report.num_moved_irqs);
+
+    ASSERT_EQ(0, _module_under_test.restore_irqs());
+    ASSERT_EQ("f", _read_file("/proc/irq/1/smp_affinity"));
+}
+
+TEST_F(TestIsolationAudit, TestErrors)
+{
+    RaspaIsolationReport report;
+    ASSERT_EQ(-RASPA_EISOLATION_AUDIT, _module_under_test.audit(TEST_NUM_CPUS, false, &report, false));
+    ASSERT_EQ(-RASPA_EISOLATION_AUDIT, _module_under_test.audit(-1, false, &report, false));
+
+    RaspaIsolationAudit missing_proc("/tmp/raspa_isolation_audit_test_missing", TEST_NUM_CPUS);
+    ASSERT_EQ(-RASPA_EISOLATION_AUDIT, missing_proc.audit(0, false, &report, false));
+}
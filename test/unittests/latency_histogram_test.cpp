@@ -0,0 +1,65 @@
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "raspa_latency_histogram.h"
+
+using namespace raspa;
+
+constexpr float TEST_SAMPLE_RATE = 48000.0f;
+
+class TestLatencyHistogram : public ::testing::Test
+{
+protected:
+    TestLatencyHistogram()
+    {
+    }
+
+    void SetUp()
+    {
+    }
+
+    void TearDown()
+    {
+    }
+
+    RaspaLatencyHistogram _module_under_test;
+};
+
+TEST_F(TestLatencyHistogram, TestStatistics)
+{
+    // 98 latencies of 10.5 us, one of 50 us and one above the last bin
+    for (int i = 0; i < 98; i++)
+    {
+        _module_under_test.add(10500);
+    }
+    _module_under_test.add(50000);
+    _module_under_test.add(LATENCY_HISTOGRAM_NUM_BINS * 1000 + 300);
+
+    ASSERT_EQ(100, _module_under_test.get_count());
+    ASSERT_EQ(98, _module_under_test.get_bin(10));
+    ASSERT_EQ(1, _module_under_test.get_bin(50));
+    ASSERT_EQ(1, _module_under_test.get_overflows());
+    ASSERT_EQ(11, _module_under_test.get_percentile_us(50.0));
+    ASSERT_EQ(51, _module_under_test.get_percentile_us(98.0));
+    ASSERT_EQ(LATENCY_HISTOGRAM_NUM_BINS + 1, _module_under_test.get_percentile_us(99.5));
+    ASSERT_EQ(LATENCY_HISTOGRAM_NUM_BINS + 1, _module_under_test.get_max_us());
+
+    // negative latencies count as 0
+    _module_under_test.reset();
+    _module_under_test.add(-500);
+    ASSERT_EQ(1, _module_under_test.get_bin(0));
+    ASSERT_EQ(0, _module_under_test.get_max_us());
+}
+
+TEST_F(TestLatencyHistogram, TestSafeBufferSize)
+{
+    std::vector<int> sizes = {16, 32, 64, 128};
+
+    // periods of 333, 667, 1333 and 2667 us
+    ASSERT_EQ(16, get_smallest_safe_buffer_size(sizes, TEST_SAMPLE_RATE, 50, 0.25f));
+    ASSERT_EQ(32, get_smallest_safe_buffer_size(sizes, TEST_SAMPLE_RATE, 100, 0.25f));
+    ASSERT_EQ(128, get_smallest_safe_buffer_size(sizes, TEST_SAMPLE_RATE, 500, 0.25f));
+    ASSERT_EQ(0, get_smallest_safe_buffer_size(sizes, TEST_SAMPLE_RATE, 1000, 0.25f));
+    ASSERT_EQ(64, get_smallest_safe_buffer_size(sizes, TEST_SAMPLE_RATE, 1000, 0.75f));
+}
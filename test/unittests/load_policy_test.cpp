@@ -0,0 +1,142 @@
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "raspa_load_policy.h"
+
+using namespace raspa;
+
+constexpr int TEST_BUFFER_SIZE = 64;
+constexpr RaspaMicroSec TEST_PERIOD_TIME_US = 1000;
+constexpr int TEST_HOLD_TIME_MS = 200;
+
+const std::vector<int> TEST_BUFFER_SIZES = {8, 16, 32, 48, 64, 128, 192, 256, 512};
+
+// periods in a load window, and in the time the load must stay high
+constexpr int TEST_WINDOW_PERIODS = LOAD_POLICY_WINDOW_US / TEST_PERIOD_TIME_US;
+constexpr int TEST_HOLD_PERIODS = TEST_HOLD_TIME_MS * 1000 / TEST_PERIOD_TIME_US;
+
+class TestLoadPolicy : public ::testing::Test
+{
+protected:
+    TestLoadPolicy() : _module_under_test(TEST_BUFFER_SIZES)
+    {
+    }
+
+    void SetUp()
+    {
+        ASSERT_EQ(RASPA_SUCCESS, _module_under_test.configure(0.7f, 0.3f, TEST_HOLD_TIME_MS));
+        _module_under_test.start(TEST_BUFFER_SIZE, TEST_PERIOD_TIME_US);
+    }
+
+    void TearDown()
+    {
+    }
+
+    /**
+     * @brief Run periods with a constant load
+     * @return The first buffer size asked for, 0 if none
+     */
+    int _run(int num_periods, float load, int64_t num_missed_periods = 0)
+    {
+        int new_size = 0;
+        for (int i = 0; i < num_periods; i++)
+        {
+            auto res = _module_under_test.update(static_cast<RaspaMicroSec>(load * TEST_PERIOD_TIME_US),
+                                                 num_missed_periods);
+            if (res > 0 && new_size == 0)
+            {
+                new_size = res;
+            }
+        }
+        return new_size;
+    }
+
+    RaspaLoadPolicy _module_under_test;
+};
+
+TEST_F(TestLoadPolicy, TestConfiguration)
+{
+    ASSERT_EQ(-RASPA_ELOAD_POLICY, _module_under_test.configure(0.0f, 0.0f, TEST_HOLD_TIME_MS));
+    ASSERT_EQ(-RASPA_ELOAD_POLICY, _module_under_test.configure(1.5f, 0.3f, TEST_HOLD_TIME_MS));
+    ASSERT_EQ(-RASPA_ELOAD_POLICY, _module_under_test.configure(0.5f, 0.6f, TEST_HOLD_TIME_MS));
+    ASSERT_EQ(-RASPA_ELOAD_POLICY, _module_under_test.configure(0.7f, 0.3f, 0));
+
+    ASSERT_EQ(128, _module_under_test.get_next_buffer_size(64, true));
+    ASSERT_EQ(48, _module_under_test.get_next_buffer_size(64, false));
+    ASSERT_EQ(512, _module_under_test.get_next_buffer_size(512, true));
+    ASSERT_EQ(8, _module_under_test.get_next_buffer_size(8, false));
+    ASSERT_EQ(64, _module_under_test.get_next_buffer_size(50, true));
+}
+
+TEST_F(TestLoadPolicy, TestSustainedHighLoad)
+{
+    // a short burst is not enough
+    ASSERT_EQ(0, _run(TEST_HOLD_PERIODS - TEST_WINDOW_PERIODS, 0.9f));
+    ASSERT_EQ(0, _run(TEST_WINDOW_PERIODS, 0.5f));
+    ASSERT_EQ(TEST_BUFFER_SIZE, _module_under_test.get_requested_buffer_size());
+
+    ASSERT_EQ(128, _run(TEST_HOLD_PERIODS, 0.9f));
+    ASSERT_EQ(128, _module_under_test.get_requested_buffer_size());
+    ASSERT_NEAR(0.9f, _module_under_test.get_last_load(), 0.01f);
+
+    // only one change pending until the device runs with the new size
+    ASSERT_EQ(0, _run(4 * TEST_HOLD_PERIODS, 0.9f));
+    ASSERT_EQ(128, _module_under_test.get_requested_buffer_size());
+}
+
+TEST_F(TestLoadPolicy, TestMissedPeriods)
+{
+    ASSERT_EQ(128, _run(TEST_HOLD_PERIODS, 0.1f, 1));
+}
+
+TEST_F(TestLoadPolicy, TestHysteresis)
+{
+    ASSERT_EQ(128, _run(TEST_HOLD_PERIODS, 0.9f));
+    _module_under_test.start(128, 2 * TEST_PERIOD_TIME_US);
+
+    // load between the thresholds keeps the size
+    ASSERT_EQ(0, _run(20 * TEST_HOLD_PERIODS, 0.5f * 2));
+
+    // going down takes longer than going up
+    ASSERT_EQ(0, _run(TEST_HOLD_PERIODS / 2, 0.1f * 2));
+    ASSERT_EQ(TEST_BUFFER_SIZE, _run(LOAD_POLICY_DOWN_HOLD_MULTIPLIER * TEST_HOLD_PERIODS / 2, 0.1f * 2));
+
+    // never below the size first opened
+    _module_under_test.start(TEST_BUFFER_SIZE, TEST_PERIOD_TIME_US);
+    ASSERT_EQ(0, _run(20 * TEST_HOLD_PERIODS, 0.1f));
+    ASSERT_EQ(TEST_BUFFER_SIZE, _module_under_test.get_requested_buffer_size());
+}
+
+TEST(TestOutputFade, TestFadeInAndOut)
+{
+    constexpr int num_frames = 16;
+    constexpr int stride = 32;
+    std::vector<float> buffer(2 * stride, 1.0f);
+    RaspaOutputFade fade;
+
+    fade.start(true, 2 * num_frames);
+    fade.process(buffer.data(), 2, stride, num_frames);
+    ASSERT_LT(buffer[0], buffer[num_frames - 1]);
+    ASSERT_NEAR(0.5f, buffer[stride + num_frames - 1], 0.01f);
+
+    std::fill(buffer.begin(), buffer.end(), 1.0f);
+    fade.process(buffer.data(), 2, stride, num_frames);
+    ASSERT_FLOAT_EQ(1.0f, buffer[num_frames - 1]);
+    std::fill(buffer.begin(), buffer.end(), 1.0f);
+    fade.process(buffer.data(), 2, stride, num_frames);
+    ASSERT_FLOAT_EQ(1.0f, buffer[0]);
+
+    fade.start(false, num_frames);
+    ASSERT_FALSE(fade.is_muted());
+    fade.process(buffer.data(), 2, stride, num_frames);
+    ASSERT_FLOAT_EQ(0.0f, buffer[stride + num_frames - 1]);
+    ASSERT_TRUE(fade.is_muted());
+
+    // muted until the next fade in, the padding is left alone
+    std::fill(buffer.begin(), buffer.end(), 1.0f);
+    fade.process(buffer.data(), 2, stride, num_frames);
+    ASSERT_FLOAT_EQ(0.0f, buffer[0]);
+    ASSERT_FLOAT_EQ(0.0f, buffer[stride + num_frames - 1]);
+    ASSERT_FLOAT_EQ(1.0f, buffer[num_frames]);
+}
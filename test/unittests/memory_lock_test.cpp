@@ -0,0 +1,104 @@
+#include <sys/mman.h>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+
+#include "raspa_memory_lock.h"
+
+using namespace raspa;
+
+constexpr int TEST_NUM_PAGES = 4;
+
+class TestMemoryLock : public ::testing::Test
+{
+protected:
+    TestMemoryLock()
+    {
+    }
+
+    void SetUp()
+    {
+        _page_size = getpagesize();
+        ASSERT_EQ(0, posix_memalign(&_buffer, _page_size, TEST_NUM_PAGES * _page_size));
+    }
+
+    void TearDown()
+    {
+        _module_under_test.unlock(_buffer);
+        free(_buffer);
+    }
+
+    size_t _page_size;
+    void* _buffer;
+    RaspaMemoryLock _module_under_test;
+};
+
+TEST_F(TestMemoryLock, TestReadMappings)
+{
+    std::vector<MemoryMapping> mappings;
+    ASSERT_TRUE(read_memory_mappings(mappings));
+    ASSERT_FALSE(mappings.empty());
+
+    // the test code itself is mapped from the test binary
+    auto code = reinterpret_cast<uintptr_t>(&read_memory_mappings);
+    bool found = false;
+    for (const auto& mapping : mappings)
+    {
+        if (code >= mapping.start && code < mapping.end)
+        {
+            found = true;
+            ASSERT_EQ('/', mapping.path[0]);
+            ASSERT_GT(mapping.rss_bytes, 0);
+        }
+    }
+    ASSERT_TRUE(found);
+}
+
+TEST_F(TestMemoryLock, TestLockAndReport)
+{
+    RaspaMemoryReport report;
+    _module_under_test.add_rt_address(_buffer, "test buffer");
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.get_report(&report, false));
+    ASSERT_EQ(1, report.num_unlocked_rt_mappings);
+
+    auto locked_before = report.locked_bytes;
+    _module_under_test.remove_rt_addresses("test buffer");
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.lock(_buffer, TEST_NUM_PAGES * _page_size, "test buffer"));
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.get_report(&report, false));
+    ASSERT_EQ(0, report.num_unlocked_rt_mappings);
+    ASSERT_EQ(0, report.unlocked_rt_bytes);
+    ASSERT_EQ(locked_before + static_cast<int64_t>(TEST_NUM_PAGES * _page_size), report.locked_bytes);
+
+    _module_under_test.unlock(_buffer);
+    _module_under_test.add_rt_address(_buffer, "test buffer");
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.get_report(&report, false));
+    ASSERT_EQ(locked_before, report.locked_bytes);
+    ASSERT_EQ(1, report.num_unlocked_rt_mappings);
+}
+
+TEST_F(TestMemoryLock, TestForget)
+{
+    RaspaMemoryReport report;
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.get_report(&report, false));
+    auto locked_before = report.locked_bytes;
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.lock(_buffer, TEST_NUM_PAGES * _page_size, "test buffer"));
+    _module_under_test.add_rt_address(_buffer, "test buffer");
+
+    // the pages stay locked, but are not tracked nor checked anymore
+    _module_under_test.forget("test buffer");
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.get_report(&report, false));
+    ASSERT_EQ(locked_before + static_cast<int64_t>(TEST_NUM_PAGES * _page_size), report.locked_bytes);
+    ASSERT_EQ(0, report.num_unlocked_rt_mappings);
+
+    _module_under_test.unlock(_buffer);
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.get_report(&report, false));
+    ASSERT_GT(report.locked_bytes, locked_before);
+    munlock(_buffer, TEST_NUM_PAGES * _page_size);
+}
+
+TEST_F(TestMemoryLock, TestInvalidRegion)
+{
+    ASSERT_EQ(-RASPA_EMLOCK, _module_under_test.lock(nullptr, _page_size, "null"));
+    ASSERT_EQ(-RASPA_EMLOCK, _module_under_test.lock(_buffer, 0, "empty"));
+}
@@ -0,0 +1,219 @@
+#include <type_traits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "raspa/raspa.hpp"
+
+/*
+ * Mocked C API, records the registered callback so that the tests can call
+ * it as the rt thread would.
+ */
+namespace {
+    RaspaProcessCallback mock_callback = nullptr;
+    void* mock_user_data = nullptr;
+    int mock_num_input_chans = 2;
+    int mock_num_output_chans = 4;
+    int mock_decimation = 1;
+    int mock_chan_padding = 0;
+    int mock_callback_buffer_size = 0;
+    bool mock_closed = false;
+}
+
+int raspa_open(int buffer_size, RaspaProcessCallback process_callback, void* user_data, unsigned int /*debug_flags*/)
+{
+    mock_callback = process_callback;
+    mock_user_data = user_data;
+    mock_callback_buffer_size = buffer_size / mock_decimation;
+    mock_closed = false;
+    return 0;
+}
+
+int raspa_get_decimation()
+{
+    return mock_decimation;
+}
+
+int raspa_get_callback_buffer_size()
+{
+    return mock_callback_buffer_size;
+}
+
+int raspa_get_callback_channel_stride()
+{
+    return mock_callback_buffer_size + mock_chan_padding;
+}
+
+int raspa_get_num_input_channels()
+{
+    return mock_num_input_chans;
+}
+
+int raspa_get_num_output_channels()
+{
+    return mock_num_output_chans;
+}
+
+int raspa_start_realtime()
+{
+    return 0;
+}
+
+int raspa_close()
+{
+    mock_closed = true;
+    return 0;
+}
+
+using namespace raspa;
+
+struct TestProcessor
+{
+    template<typename Input, typename Output>
+    void operator()(Input input, Output output)
+    {
+        static_assert(std::is_const<typename std::remove_pointer<decltype(input.data())>::type>::value);
+        last_buffer_size = Input::BUFFER_SIZE;
+        last_num_inputs = Input::NUM_CHANNELS;
+
+        // copy input channel 1 to every output channel, scaled by channel index
+        auto in = input.channel(1);
+        for (int c = 0; c < output.num_channels(); c++)
+        {
+            auto out = output.channel(c);
+            for (int i = 0; i < out.size(); i++)
+            {
+                out[i] = in[i] * static_cast<float>(c);
+            }
+        }
+        num_calls++;
+    }
+
+    int last_buffer_size = 0;
+    int last_num_inputs = 0;
+    int num_calls = 0;
+};
+
+class TestRaspaCppApi : public ::testing::Test
+{
+protected:
+    TestRaspaCppApi()
+    {
+    }
+
+    void SetUp()
+    {
+        mock_num_input_chans = 2;
+        mock_num_output_chans = 4;
+        mock_decimation = 1;
+        mock_chan_padding = 0;
+    }
+
+    void TearDown()
+    {}
+
+    void _run_callback(int buffer_size, int chan_stride)
+    {
+        _input.assign(chan_stride * mock_num_input_chans, 0.0f);
+        _output.assign(chan_stride * mock_num_output_chans, -1.0f);
+        for (int i = 0; i < buffer_size; i++)
+        {
+            _input[chan_stride + i] = static_cast<float>(i);
+        }
+        mock_callback(_input.data(), _output.data(), mock_user_data);
+    }
+
+    void _check_output(int buffer_size, int chan_stride)
+    {
+        for (int c = 0; c < mock_num_output_chans; c++)
+        {
+            for (int i = 0; i < buffer_size; i++)
+            {
+                ASSERT_FLOAT_EQ(static_cast<float>(i * c), _output[c * chan_stride + i]);
+            }
+            // the padding is left untouched
+            for (int i = buffer_size; i < chan_stride; i++)
+            {
+                ASSERT_FLOAT_EQ(-1.0f, _output[c * chan_stride + i]);
+            }
+        }
+    }
+
+    TestProcessor _processor;
+    std::vector<float> _input;
+    std::vector<float> _output;
+};
+
+TEST_F(TestRaspaCppApi, TestChannelSpan)
+{
+    float data[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    ChannelBuffers<float, 4, 2> buffers(data, 4, 2);
+    static_assert(decltype(buffers.channel(0))::SIZE == 4);
+
+    auto channel = buffers.channel(1);
+    ASSERT_EQ(4, channel.size());
+    ASSERT_EQ(data + 4, channel.data());
+    float sum = 0;
+    for (auto sample : channel)
+    {
+        sum += sample;
+    }
+    ASSERT_FLOAT_EQ(22.0f, sum);
+
+    ChannelBuffers<float> dynamic_buffers(data, 2, 4);
+    ASSERT_EQ(2, dynamic_buffers.buffer_size());
+    ASSERT_EQ(4, dynamic_buffers.num_channels());
+    ASSERT_FLOAT_EQ(6.0f, dynamic_buffers.channel(3)[0]);
+
+    ChannelBuffers<float> strided_buffers(data, 2, 2, 4);
+    ASSERT_EQ(data + 4, strided_buffers.channel(1).data());
+    ASSERT_EQ(2, strided_buffers.channel(1).size());
+}
+
+TEST_F(TestRaspaCppApi, TestCompileTimeBufferSize)
+{
+    ProcessorHost<TestProcessor, 2> host(_processor);
+    ASSERT_EQ(0, (host.open<16, 32, 64>(32)));
+    ASSERT_EQ(2, host.num_input_channels());
+    ASSERT_EQ(4, host.num_output_channels());
+
+    _run_callback(32, 32);
+    ASSERT_EQ(1, _processor.num_calls);
+    ASSERT_EQ(32, _processor.last_buffer_size);
+    ASSERT_EQ(2, _processor.last_num_inputs);
+    _check_output(32, 32);
+}
+
+TEST_F(TestRaspaCppApi, TestDynamicBufferSizeFallback)
+{
+    ProcessorHost<TestProcessor> host(_processor);
+    ASSERT_EQ(0, (host.open<16, 64>(48)));
+
+    _run_callback(48, 48);
+    ASSERT_EQ(1, _processor.num_calls);
+    ASSERT_EQ(DYNAMIC_SIZE, _processor.last_buffer_size);
+    ASSERT_EQ(DYNAMIC_SIZE, _processor.last_num_inputs);
+    _check_output(48, 48);
+}
+
+TEST_F(TestRaspaCppApi, TestDecimatedBuffers)
+{
+    mock_decimation = 4;
+    mock_chan_padding = 8;
+    ProcessorHost<TestProcessor> host(_processor);
+    ASSERT_EQ(0, (host.open<16, 64>(64)));
+    ASSERT_EQ(16, host.buffer_size());
+
+    // the callback is selected for the decimated buffer size
+    _run_callback(16, 24);
+    ASSERT_EQ(1, _processor.num_calls);
+    ASSERT_EQ(16, _processor.last_buffer_size);
+    _check_output(16, 24);
+}
+
+TEST_F(TestRaspaCppApi, TestChannelCountMismatch)
+{
+    ProcessorHost<TestProcessor, 2, 2> host(_processor);
+    ASSERT_EQ(-ECHANNEL_COUNT_MISMATCH, host.open(64));
+    ASSERT_TRUE(mock_closed);
+}
@@ -0,0 +1,180 @@
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "raspa_resampler.h"
+
+using namespace raspa;
+
+constexpr int TEST_BUFFER_SIZE = 48;
+constexpr int TEST_NUM_BUFFERS = 40;
+
+class TestResampler : public ::testing::Test
+{
+protected:
+    TestResampler()
+    {
+    }
+
+    void SetUp()
+    {
+    }
+
+    void TearDown()
+    {
+    }
+
+    /**
+     * @brief Run a signal through a decimator and an interpolator in series
+     * @return The full rate output
+     */
+    std::vector<float> _run(int factor, const std::vector<float>& input)
+    {
+        PolyphaseDecimator decimator(factor, TEST_BUFFER_SIZE);
+        PolyphaseInterpolator interpolator(factor, TEST_BUFFER_SIZE);
+        std::vector<float> decimated(TEST_BUFFER_SIZE / factor);
+        std::vector<float> output(input.size());
+
+        for (size_t i = 0; i < input.size(); i += TEST_BUFFER_SIZE)
+        {
+            decimator.process(input.data() + i, decimated.data());
+            interpolator.process(decimated.data(), output.data() + i);
+        }
+        return output;
+    }
+
+    std::vector<float> _sine(float cycles_per_sample)
+    {
+        std::vector<float> signal(TEST_BUFFER_SIZE * TEST_NUM_BUFFERS);
+        for (size_t i = 0; i < signal.size(); i++)
+        {
+            signal[i] = std::sin(2.0f * static_cast<float>(M_PI) * cycles_per_sample * i);
+        }
+        return signal;
+    }
+
+    /**
+     * @brief Amplitude of a sine from its rms value, skipping the start
+     */
+    float _amplitude_after_settling(const std::vector<float>& signal)
+    {
+        double sum = 0.0;
+        size_t start = signal.size() / 2;
+        for (size_t i = start; i < signal.size(); i++)
+        {
+            sum += signal[i] * signal[i];
+        }
+        return static_cast<float>(std::sqrt(2.0 * sum / (signal.size() - start)));
+    }
+};
+
+TEST_F(TestResampler, TestValidate)
+{
+    ASSERT_EQ(RASPA_SUCCESS, RaspaResampler::validate(1, 64));
+    ASSERT_EQ(RASPA_SUCCESS, RaspaResampler::validate(3, 48));
+    ASSERT_EQ(RASPA_SUCCESS, RaspaResampler::validate(RASPA_MAX_DECIMATION, 64));
+    ASSERT_EQ(-RASPA_EDECIMATION, RaspaResampler::validate(0, 64));
+    ASSERT_EQ(-RASPA_EDECIMATION, RaspaResampler::validate(3, 64));
+    ASSERT_EQ(-RASPA_EDECIMATION, RaspaResampler::validate(RASPA_MAX_DECIMATION + 1, 64));
+    ASSERT_EQ(0, RaspaResampler::get_delay_in_frames(1));
+}
+
+TEST_F(TestResampler, TestDcGain)
+{
+    for (int factor = 2; factor <= RASPA_MAX_DECIMATION; factor++)
+    {
+        std::vector<float> input(TEST_BUFFER_SIZE * TEST_NUM_BUFFERS, 0.5f);
+        auto output = _run(factor, input);
+        for (size_t i = output.size() / 2; i < output.size(); i++)
+        {
+            ASSERT_NEAR(0.5f, output[i], 0.01f);
+        }
+    }
+}
+
+TEST_F(TestResampler, TestPassbandAndAliasRejection)
+{
+    for (int factor = 2; factor <= RASPA_MAX_DECIMATION; factor++)
+    {
+        // well within the decimated band
+        float passband = 0.2f / factor;
+        ASSERT_NEAR(1.0f, _amplitude_after_settling(_run(factor, _sine(passband))), 0.02f);
+
+        // would alias into the decimated band, must be below -60 dB
+        float stopband = 1.0f / factor - passband;
+        ASSERT_LT(_amplitude_after_settling(_run(factor, _sine(stopband))), 0.001f);
+    }
+}
+
+TEST_F(TestResampler, TestLatency)
+{
+    for (int factor = 2; factor <= RASPA_MAX_DECIMATION; factor++)
+    {
+        // a slow ramp comes out delayed by the group delay of the two filters
+        std::vector<float> input(TEST_BUFFER_SIZE * TEST_NUM_BUFFERS);
+        for (size_t i = 0; i < input.size(); i++)
+        {
+            input[i] = 0.001f * i;
+        }
+        auto output = _run(factor, input);
+
+        int delay = RaspaResampler::get_delay_in_frames(factor);
+        ASSERT_GT(delay, 0);
+        for (size_t i = output.size() / 2; i < output.size(); i++)
+        {
+            ASSERT_NEAR(input[i - delay], output[i], 0.001f);
+        }
+    }
+}
+
+TEST_F(TestResampler, TestMultichannel)
+{
+    constexpr int factor = 2;
+    constexpr int num_chans = 3;
+    constexpr int user_stride = 32;
+    RaspaResampler module_under_test;
+    ASSERT_EQ(RASPA_SUCCESS, module_under_test.init(factor, TEST_BUFFER_SIZE, num_chans, num_chans, num_chans));
+
+    std::vector<float> user_buffer(num_chans * user_stride, -1.0f);
+    for (int n = 0; n < TEST_NUM_BUFFERS; n++)
+    {
+        float* full_rate_in = module_under_test.get_full_rate_input();
+        for (int c = 0; c < num_chans; c++)
+        {
+            std::fill_n(full_rate_in + c * TEST_BUFFER_SIZE, TEST_BUFFER_SIZE, static_cast<float>(c));
+        }
+        module_under_test.decimate(user_buffer.data(), user_stride);
+        module_under_test.interpolate(user_buffer.data(), user_stride);
+    }
+
+    float* full_rate_out = module_under_test.get_full_rate_output();
+    for (int c = 0; c < num_chans; c++)
+    {
+        ASSERT_NEAR(c, user_buffer[c * user_stride], 0.01f);
+        ASSERT_NEAR(c, user_buffer[c * user_stride + TEST_BUFFER_SIZE / factor - 1], 0.01f);
+        ASSERT_NEAR(c, full_rate_out[c * TEST_BUFFER_SIZE + TEST_BUFFER_SIZE - 1], 0.01f);
+
+        // the padding between the user channels is left alone
+        ASSERT_EQ(-1.0f, user_buffer[c * user_stride + TEST_BUFFER_SIZE / factor]);
+    }
+}
+
+TEST_F(TestResampler, TestRtRegions)
+{
+    constexpr int factor = 2;
+    constexpr int num_chans = 2;
+    RaspaResampler module_under_test;
+    ASSERT_EQ(RASPA_SUCCESS, module_under_test.init(factor, TEST_BUFFER_SIZE, num_chans, num_chans, num_chans));
+
+    // both full rate buffers, the filter arrays, and the coefficients and history of each filter
+    std::vector<const void*> regions;
+    module_under_test.for_each_rt_region([&](const void* address, size_t size)
+    {
+        ASSERT_GT(size, 0u);
+        regions.push_back(address);
+    });
+    ASSERT_EQ(static_cast<size_t>(4 + 2 * 2 * num_chans), regions.size());
+    ASSERT_EQ(module_under_test.get_full_rate_input(), regions[0]);
+    ASSERT_EQ(module_under_test.get_full_rate_output(), regions[1]);
+}
@@ -0,0 +1,128 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "raspa/raspa_rt_handoff.hpp"
+
+using namespace raspa;
+
+namespace {
+
+std::atomic<int> num_destroyed(0);
+
+struct TestObject
+{
+    explicit TestObject(int value) : value(value) {}
+
+    ~TestObject()
+    {
+        num_destroyed++;
+    }
+
+    int value;
+};
+
+}  // namespace
+
+class TestRtHandoff : public ::testing::Test
+{
+protected:
+    TestRtHandoff() : _module_under_test(_reclaimer, std::make_unique<TestObject>(0))
+    {
+    }
+
+    void SetUp()
+    {
+        num_destroyed = 0;
+    }
+
+    void TearDown()
+    {}
+
+    RtReclaimer _reclaimer;
+    RtSlot<TestObject> _module_under_test;
+};
+
+TEST_F(TestRtHandoff, TestPublishAcquire)
+{
+    ASSERT_EQ(0, _module_under_test.acquire()->value);
+
+    _module_under_test.publish(std::make_unique<TestObject>(1));
+    ASSERT_EQ(1, _module_under_test.acquire()->value);
+    ASSERT_EQ(1, _module_under_test.acquire()->value);
+
+    // the replaced object is only destroyed by the reclaimer
+    ASSERT_EQ(0, num_destroyed);
+    ASSERT_EQ(1, _reclaimer.collect());
+    ASSERT_EQ(1, num_destroyed);
+    ASSERT_EQ(0, _reclaimer.collect());
+
+    // publishing no object releases the current one
+    _module_under_test.publish(nullptr);
+    ASSERT_EQ(nullptr, _module_under_test.acquire());
+    ASSERT_EQ(1, _reclaimer.collect());
+    ASSERT_EQ(2, num_destroyed);
+}
+
+TEST_F(TestRtHandoff, TestPublishTwice)
+{
+    // an object never acquired is destroyed by the publishing thread
+    _module_under_test.publish(std::make_unique<TestObject>(1));
+    _module_under_test.publish(std::make_unique<TestObject>(2));
+    ASSERT_EQ(1, num_destroyed);
+
+    ASSERT_EQ(2, _module_under_test.acquire()->value);
+    ASSERT_EQ(1, _reclaimer.collect());
+    ASSERT_EQ(2, num_destroyed);
+}
+
+TEST_F(TestRtHandoff, TestReclaimerFull)
+{
+    for (size_t i = 0; i < RT_RECLAIMER_CAPACITY; i++)
+    {
+        _module_under_test.publish(std::make_unique<TestObject>(static_cast<int>(i) + 1));
+        ASSERT_EQ(static_cast<int>(i) + 1, _module_under_test.acquire()->value);
+    }
+    ASSERT_FALSE(_reclaimer.can_retire());
+
+    // the handover waits for the reclaimer to make room
+    _module_under_test.publish(std::make_unique<TestObject>(-1));
+    ASSERT_EQ(static_cast<int>(RT_RECLAIMER_CAPACITY), _module_under_test.acquire()->value);
+    ASSERT_EQ(static_cast<int>(RT_RECLAIMER_CAPACITY), _reclaimer.collect());
+    ASSERT_EQ(-1, _module_under_test.acquire()->value);
+}
+
+TEST_F(TestRtHandoff, TestReclaimerThread)
+{
+    _reclaimer.start(std::chrono::milliseconds(1));
+    std::atomic<bool> running(true);
+    std::thread rt_thread([&]()
+    {
+        int last_value = 0;
+        while (running)
+        {
+            // values only increase, the rt side never sees an older object
+            auto value = _module_under_test.acquire()->value;
+            EXPECT_GE(value, last_value);
+            last_value = value;
+        }
+    });
+
+    constexpr int NUM_OBJECTS = 1000;
+    for (int i = 1; i <= NUM_OBJECTS; i++)
+    {
+        _module_under_test.publish(std::make_unique<TestObject>(i));
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    running = false;
+    rt_thread.join();
+    _reclaimer.stop();
+    _reclaimer.collect();
+
+    // all but the current one are destroyed
+    ASSERT_EQ(NUM_OBJECTS, num_destroyed);
+}
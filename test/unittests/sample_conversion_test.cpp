@@ -441,4 +441,60 @@ TEST_F(TestSampleConversion, test_zero_conversion_int_float)
             }
         }
     }
-}
\ No newline at end of file
+}
+
+TEST_F(TestSampleConversion, padded_channel_stride)
+{
+    for (auto buffer_size : raspa::SUPPORTED_BUFFER_SIZES)
+    {
+        auto chan_stride = raspa::get_padded_channel_stride(buffer_size);
+        ASSERT_GE(chan_stride, buffer_size);
+        ASSERT_EQ(0, chan_stride % raspa::CACHE_LINE_SIZE_IN_SAMPLES);
+
+        // an odd number of cache lines, so channel starts do not share cache sets
+        ASSERT_EQ(1, (chan_stride / raspa::CACHE_LINE_SIZE_IN_SAMPLES) % 2);
+    }
+    ASSERT_EQ(512 + raspa::CACHE_LINE_SIZE_IN_SAMPLES, raspa::get_padded_channel_stride(512));
+    ASSERT_EQ(48, raspa::get_padded_channel_stride(48));
+}
+
+TEST_F(TestSampleConversion, identity_conversion_padded_channels)
+{
+    auto codec_format = driver_conf::CodecFormat::INT24_LJ;
+    int buffer_size = 64;
+    int stride = 8;
+    int chan_stride = raspa::get_padded_channel_stride(buffer_size);
+
+    std::vector<int32_t> int_data(buffer_size * stride, 0);
+    std::vector<float> expected_float_data;
+    _init_data_ramp_float(expected_float_data, buffer_size * stride);
+
+    // padding is never written
+    std::vector<float> padded_float_data(chan_stride * stride, 2.0f);
+    std::vector<float> float_data(chan_stride * stride, 2.0f);
+
+    for (int channel = 0; channel < stride; channel++)
+    {
+        std::copy_n(&expected_float_data[channel * buffer_size], buffer_size,
+                    &padded_float_data[channel * chan_stride]);
+
+        auto sample_converter = raspa::get_sample_converter(channel,
+                                                            buffer_size,
+                                                            codec_format,
+                                                            channel,
+                                                            stride,
+                                                            chan_stride);
+        ASSERT_TRUE(sample_converter);
+
+        sample_converter->float32n_to_codec_format(int_data.data(), padded_float_data.data());
+        sample_converter->codec_format_to_float32n(float_data.data(), int_data.data());
+    }
+
+    for (int channel = 0; channel < stride; channel++)
+    {
+        assert_buffers_equal(&expected_float_data[channel * buffer_size],
+                             &float_data[channel * chan_stride],
+                             buffer_size);
+        ASSERT_FLOAT_EQ(2.0f, float_data[channel * chan_stride + buffer_size]);
+    }
+}
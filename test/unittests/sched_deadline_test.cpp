@@ -0,0 +1,34 @@
+#include <cstdint>
+
+#include "gtest/gtest.h"
+
+#include "raspa_sched_deadline.h"
+
+using namespace raspa;
+
+// 64 frames at 48 kHz
+constexpr uint64_t TEST_PERIOD_NS = 1333333;
+
+TEST(TestSchedDeadline, TestRuntimeFraction)
+{
+    ASSERT_FALSE(is_valid_runtime_fraction(0.0f));
+    ASSERT_FALSE(is_valid_runtime_fraction(-0.5f));
+    ASSERT_FALSE(is_valid_runtime_fraction(1.5f));
+    ASSERT_TRUE(is_valid_runtime_fraction(0.5f));
+    ASSERT_TRUE(is_valid_runtime_fraction(1.0f));
+}
+
+TEST(TestSchedDeadline, TestParams)
+{
+    auto params = get_sched_deadline_params(0.5f, TEST_PERIOD_NS);
+    ASSERT_EQ(TEST_PERIOD_NS / 2, params.runtime_ns);
+    ASSERT_EQ(TEST_PERIOD_NS, params.deadline_ns);
+    ASSERT_EQ(TEST_PERIOD_NS, params.period_ns);
+
+    // clamped to the kernel minimum and to the period
+    params = get_sched_deadline_params(0.0001f, TEST_PERIOD_NS);
+    ASSERT_EQ(SCHED_DEADLINE_MIN_RUNTIME_NS, params.runtime_ns);
+    params = get_sched_deadline_params(1.0f, TEST_PERIOD_NS);
+    ASSERT_EQ(TEST_PERIOD_NS, params.runtime_ns);
+    ASSERT_LE(params.runtime_ns, params.deadline_ns);
+}
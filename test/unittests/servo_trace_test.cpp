@@ -0,0 +1,88 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "raspa_servo_trace.h"
+
+using namespace raspa;
+
+constexpr char TEST_TRACE_FILE[] = "/tmp/raspa_servo_trace_test.trace";
+constexpr int TEST_NUM_PERIODS = 1000;
+
+class TestServoTrace : public ::testing::Test
+{
+protected:
+    TestServoTrace()
+    {
+    }
+
+    void SetUp()
+    {
+    }
+
+    void TearDown()
+    {
+        _module_under_test.terminate();
+        std::remove(TEST_TRACE_FILE);
+    }
+
+    bool _read_trace(ServoTraceHeader& header, std::vector<ServoTraceRecord>& records)
+    {
+        std::ifstream stream(TEST_TRACE_FILE, std::ifstream::binary);
+        if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        {
+            return false;
+        }
+        ServoTraceRecord record;
+        while (stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+        {
+            records.push_back(record);
+        }
+        return true;
+    }
+
+    RaspaServoTrace _module_under_test;
+};
+
+TEST_F(TestServoTrace, TestRecordsWritten)
+{
+    ServoTraceHeader header = {};
+    header.sample_rate = 48000;
+    header.buffer_size_in_frames = 32;
+    header.downsample_rate = 16;
+    header.t60_in_periods = 100;
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.start(TEST_TRACE_FILE, header));
+
+    for (int i = 0; i < TEST_NUM_PERIODS; i++)
+    {
+        _module_under_test.put(i, 1000 - i, i % 16 == 15 ? -i : 0);
+    }
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.terminate());
+
+    ServoTraceHeader read_header;
+    std::vector<ServoTraceRecord> records;
+    ASSERT_TRUE(_read_trace(read_header, records));
+    ASSERT_EQ(0, std::memcmp(SERVO_TRACE_MAGIC, read_header.magic, sizeof(read_header.magic)));
+    ASSERT_EQ(SERVO_TRACE_VERSION, read_header.version);
+    ASSERT_EQ(48000u, read_header.sample_rate);
+    ASSERT_EQ(16u, read_header.downsample_rate);
+    ASSERT_EQ(100u, read_header.t60_in_periods);
+
+    ASSERT_EQ(static_cast<size_t>(TEST_NUM_PERIODS), records.size());
+    ASSERT_EQ(0, records[0].period);
+    ASSERT_EQ(1000, records[0].timing_error_ns);
+    ASSERT_EQ(-15, records[15].correction_ns);
+    ASSERT_EQ(0, records[16].correction_ns);
+    ASSERT_EQ(TEST_NUM_PERIODS - 1, records.back().period);
+}
+
+TEST_F(TestServoTrace, TestNotStarted)
+{
+    // records put before start are dropped, terminate is always safe
+    _module_under_test.put(0, 1, 2);
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.terminate());
+    ASSERT_EQ(-RASPA_ESERVO_TRACE_FILE_OPEN, _module_under_test.start("/nonexistent/dir/trace", {}));
+}
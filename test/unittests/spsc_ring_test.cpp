@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "raspa_spsc_ring.h"
+
+using namespace raspa;
+
+constexpr size_t TEST_RING_SIZE = 100;
+
+class TestSpscRing : public ::testing::Test
+{
+protected:
+    TestSpscRing()
+    {
+    }
+
+    void SetUp()
+    {}
+
+    void TearDown()
+    {}
+
+    SpscRing<int, TEST_RING_SIZE> _module_under_test;
+};
+
+TEST_F(TestSpscRing, TestCapacity)
+{
+    static_assert(SpscRing<int, 100>::CAPACITY == 128);
+    static_assert(SpscRing<int, 128>::CAPACITY == 128);
+    static_assert(SpscRing<int, 1>::CAPACITY == 1);
+
+    // all the slots are usable
+    for (size_t i = 0; i < SpscRing<int, TEST_RING_SIZE>::CAPACITY; i++)
+    {
+        ASSERT_TRUE(_module_under_test.push(static_cast<int>(i)));
+    }
+    ASSERT_FALSE(_module_under_test.push(0));
+
+    int item;
+    ASSERT_TRUE(_module_under_test.pop(item));
+    ASSERT_EQ(0, item);
+    ASSERT_TRUE(_module_under_test.push(0));
+}
+
+TEST_F(TestSpscRing, TestPushPop)
+{
+    int item = -1;
+    ASSERT_TRUE(_module_under_test.was_empty());
+    ASSERT_FALSE(_module_under_test.pop(item));
+
+    // wrap around the ring a few times
+    for (int i = 0; i < 1000; i++)
+    {
+        ASSERT_TRUE(_module_under_test.push(i));
+        ASSERT_FALSE(_module_under_test.was_empty());
+        ASSERT_TRUE(_module_under_test.pop(item));
+        ASSERT_EQ(i, item);
+    }
+    ASSERT_TRUE(_module_under_test.was_empty());
+}
+
+TEST_F(TestSpscRing, TestBatchPushPop)
+{
+    constexpr size_t capacity = SpscRing<int, TEST_RING_SIZE>::CAPACITY;
+    std::vector<int> input(capacity + 10);
+    std::vector<int> output(capacity + 10, -1);
+    for (size_t i = 0; i < input.size(); i++)
+    {
+        input[i] = static_cast<int>(i);
+    }
+
+    // partial push when the ring fills up
+    ASSERT_EQ(capacity - 3, _module_under_test.push(input.data(), capacity - 3));
+    ASSERT_EQ(3u, _module_under_test.push(input.data() + capacity - 3, 10));
+    ASSERT_EQ(0u, _module_under_test.push(input.data(), 1));
+
+    // partial pop when the ring empties
+    ASSERT_EQ(5u, _module_under_test.pop(output.data(), 5));
+    ASSERT_EQ(capacity - 5, _module_under_test.pop(output.data() + 5, capacity));
+    ASSERT_EQ(0u, _module_under_test.pop(output.data(), 1));
+
+    for (size_t i = 0; i < capacity; i++)
+    {
+        ASSERT_EQ(input[i], output[i]);
+    }
+
+    // batch across the end of the buffer
+    ASSERT_EQ(10u, _module_under_test.push(input.data(), 10));
+    ASSERT_EQ(10u, _module_under_test.pop(output.data(), 10));
+    for (size_t i = 0; i < 10; i++)
+    {
+        ASSERT_EQ(input[i], output[i]);
+    }
+}
+
+TEST_F(TestSpscRing, TestProducerConsumerThreads)
+{
+    constexpr int num_items = 100000;
+    std::thread producer([&]()
+    {
+        int items[7];
+        int next = 0;
+        while (next < num_items)
+        {
+            int num = std::min(7, num_items - next);
+            for (int i = 0; i < num; i++)
+            {
+                items[i] = next + i;
+            }
+            int pushed = _module_under_test.push(items, num);
+            if (pushed == 0)
+            {
+                std::this_thread::yield();
+            }
+            next += pushed;
+        }
+    });
+
+    int expected = 0;
+    int items[5];
+    while (expected < num_items)
+    {
+        auto count = _module_under_test.pop(items, 5);
+        if (count == 0)
+        {
+            std::this_thread::yield();
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            ASSERT_EQ(expected++, items[i]);
+        }
+    }
+
+    producer.join();
+    ASSERT_TRUE(_module_under_test.was_empty());
+}
@@ -0,0 +1,90 @@
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "raspa_system_sampler.h"
+
+using namespace raspa;
+
+constexpr char TEST_SAMPLES_FILE[] = "/tmp/raspa_system_sampler_test.sys";
+
+constexpr char TEST_TASK_STAT[] = "4242 (raspa (rt) task) S 1 4242 4242 0 -1 4194368 1234 0 56 0 "
+                                  "10 20 0 0 -2 0 1 0 100 0 0 18446744073709551615";
+
+constexpr char TEST_INTERRUPTS[] = "           CPU0       CPU1       CPU3\n"
+                                   "  1:         10          0          5   GICv2  25 Level     vgic\n"
+                                   " 39:          0        100       2000   GICv2  39 Level     audio\n"
+                                   "IPI0:        30         40         50       Rescheduling interrupts\n"
+                                   "Err:          7\n";
+
+class TestSystemSampler : public ::testing::Test
+{
+protected:
+    TestSystemSampler()
+    {
+    }
+
+    void SetUp()
+    {
+    }
+
+    void TearDown()
+    {
+        _module_under_test.terminate();
+        std::remove(TEST_SAMPLES_FILE);
+    }
+
+    RaspaSystemSampler _module_under_test;
+};
+
+TEST_F(TestSystemSampler, TestParseTaskStat)
+{
+    int64_t minor_faults = 0;
+    int64_t major_faults = 0;
+    ASSERT_TRUE(RaspaSystemSampler::parse_task_stat(TEST_TASK_STAT, minor_faults, major_faults));
+    ASSERT_EQ(1234, minor_faults);
+    ASSERT_EQ(56, major_faults);
+
+    ASSERT_FALSE(RaspaSystemSampler::parse_task_stat("", minor_faults, major_faults));
+    ASSERT_FALSE(RaspaSystemSampler::parse_task_stat("1 (short) S 1 2", minor_faults, major_faults));
+}
+
+TEST_F(TestSystemSampler, TestParseInterrupts)
+{
+    ASSERT_EQ(40, RaspaSystemSampler::parse_interrupts(TEST_INTERRUPTS, 0));
+    ASSERT_EQ(140, RaspaSystemSampler::parse_interrupts(TEST_INTERRUPTS, 1));
+
+    // offline cpus are not listed, columns follow the header
+    ASSERT_EQ(-1, RaspaSystemSampler::parse_interrupts(TEST_INTERRUPTS, 2));
+    ASSERT_EQ(2055, RaspaSystemSampler::parse_interrupts(TEST_INTERRUPTS, 3));
+    ASSERT_EQ(-1, RaspaSystemSampler::parse_interrupts("", 0));
+}
+
+TEST_F(TestSystemSampler, TestSampling)
+{
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.start(TEST_SAMPLES_FILE, 0));
+    _module_under_test.set_rt_thread_id(static_cast<int>(syscall(SYS_gettid)));
+    std::this_thread::sleep_for(SYSTEM_SAMPLER_PERIOD * 5);
+    ASSERT_EQ(RASPA_SUCCESS, _module_under_test.terminate());
+
+    std::ifstream file(TEST_SAMPLES_FILE, std::ifstream::binary);
+    std::vector<SystemSample> samples;
+    SystemSample sample;
+    while (file.read(reinterpret_cast<char*>(&sample), sizeof(sample)))
+    {
+        samples.push_back(sample);
+    }
+    ASSERT_GE(samples.size(), 2u);
+
+    auto& last = samples.back();
+    ASSERT_GT(last.time, samples.front().time);
+    ASSERT_GE(last.rt_minor_faults, 0);
+    ASSERT_GE(last.rt_major_faults, 0);
+    ASSERT_GE(last.cpu_interrupts, samples.front().cpu_interrupts);
+}